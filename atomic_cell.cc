@@ -133,18 +133,54 @@ atomic_cell::atomic_cell(const abstract_type& type, atomic_cell_view other)
                   copy_cell(type.imr_state(), other._view.raw_pointer()))
 { }
 
+std::optional<size_t> atomic_cell_or_collection::inline_size(const data::type_imr_descriptor& imr_data, const uint8_t* ptr)
+{
+    auto f = data::cell::structure::get_member<data::cell::tags::flags>(ptr);
+    if (f.template get<data::cell::tags::external_data>()) {
+        return { };
+    }
+    data::cell::context ctx(f, imr_data.type_info());
+    auto size = data::cell::structure::serialized_object_size(ptr, ctx);
+    if (size > max_inline_size) {
+        return { };
+    }
+    return size;
+}
+
+atomic_cell_or_collection atomic_cell_or_collection::make_inline(const uint8_t* ptr, size_t size) noexcept
+{
+    atomic_cell_or_collection cell;
+    std::copy_n(ptr, size, cell._u.small.data);
+    cell._u.small.size = size;
+    return cell;
+}
+
+atomic_cell_or_collection atomic_cell_or_collection::copy_of(const data::type_imr_descriptor& imr_data, const uint8_t* ptr)
+{
+    if (auto size = inline_size(imr_data, ptr)) {
+        return make_inline(ptr, *size);
+    }
+    return atomic_cell_or_collection(copy_cell(imr_data, ptr));
+}
+
+atomic_cell_or_collection atomic_cell_or_collection::from_atomic_cell(const abstract_type& type, atomic_cell data)
+{
+    auto ptr = data._data.get();
+    if (auto size = inline_size(type.imr_state(), ptr)) {
+        return make_inline(ptr, *size);
+    }
+    return atomic_cell_or_collection(std::move(data._data));
+}
+
 atomic_cell_or_collection atomic_cell_or_collection::copy(const abstract_type& type) const {
-    if (!_data.get()) {
+    if (!*this) {
         return atomic_cell_or_collection();
     }
-    auto& imr_data = type.imr_state();
-    return atomic_cell_or_collection(
-        copy_cell(imr_data, _data.get())
-    );
+    return copy_of(type.imr_state(), data());
 }
 
 atomic_cell_or_collection::atomic_cell_or_collection(const abstract_type& type, atomic_cell_view acv)
-    : _data(copy_cell(type.imr_state(), acv._view.raw_pointer()))
+    : atomic_cell_or_collection(copy_of(type.imr_state(), acv._view.raw_pointer()))
 {
 }
 
@@ -159,7 +195,7 @@ static collection_mutation_view get_collection_mutation_view(const uint8_t* ptr)
 }
 
 collection_mutation_view atomic_cell_or_collection::as_collection_mutation() const {
-    return get_collection_mutation_view(_data.get());
+    return get_collection_mutation_view(data());
 }
 
 collection_mutation::collection_mutation(const collection_type_impl& type, collection_mutation_view v)
@@ -179,16 +215,16 @@ collection_mutation::operator collection_mutation_view() const
 
 bool atomic_cell_or_collection::equals(const abstract_type& type, const atomic_cell_or_collection& other) const
 {
-    auto ptr_a = _data.get();
-    auto ptr_b = other._data.get();
+    auto ptr_a = data();
+    auto ptr_b = other.data();
 
     if (!ptr_a || !ptr_b) {
         return !ptr_a && !ptr_b;
     }
 
     if (type.is_atomic()) {
-        auto a = atomic_cell_view::from_bytes(type.imr_state().type_info(), _data);
-        auto b = atomic_cell_view::from_bytes(type.imr_state().type_info(), other._data);
+        auto a = atomic_cell_view(type.imr_state().type_info(), ptr_a);
+        auto b = atomic_cell_view(type.imr_state().type_info(), ptr_b);
         if (a.timestamp() != b.timestamp()) {
             return false;
         }
@@ -220,18 +256,19 @@ bool atomic_cell_or_collection::equals(const abstract_type& type, const atomic_c
 
 size_t atomic_cell_or_collection::external_memory_usage(const abstract_type& t) const
 {
-    if (!_data.get()) {
+    if (is_inline() || !_u.object) {
         return 0;
     }
-    auto ctx = data::cell::context(_data.get(), t.imr_state().type_info());
+    auto ptr = _u.object.get();
+    auto ctx = data::cell::context(ptr, t.imr_state().type_info());
 
-    auto view = data::cell::structure::make_view(_data.get(), ctx);
+    auto view = data::cell::structure::make_view(ptr, ctx);
     auto flags = view.get<data::cell::tags::flags>();
 
     size_t external_value_size = 0;
     if (flags.get<data::cell::tags::external_data>()) {
         if (flags.get<data::cell::tags::collection>()) {
-            external_value_size = get_collection_mutation_view(_data.get()).data.size_bytes();
+            external_value_size = get_collection_mutation_view(ptr).data.size_bytes();
         } else {
             auto cell_view = data::cell::atomic_cell_view(t.imr_state().type_info(), view);
             external_value_size = cell_view.value_size();
@@ -240,17 +277,17 @@ size_t atomic_cell_or_collection::external_memory_usage(const abstract_type& t)
         external_value_size += (external_value_size - 1) / data::cell::maximum_external_chunk_length * data::cell::external_chunk_overhead;
         external_value_size += data::cell::external_last_chunk_overhead;
     }
-    return data::cell::structure::serialized_object_size(_data.get(), ctx)
+    return data::cell::structure::serialized_object_size(ptr, ctx)
         + imr_object_type::size_overhead + external_value_size;
 }
 
 std::ostream& operator<<(std::ostream& os, const atomic_cell_or_collection::printer& p) {
-    if (!p._cell._data.get()) {
+    if (!p._cell) {
         return os << "{ null atomic_cell_or_collection }";
     }
     using dc = data::cell;
     os << "{ ";
-    if (dc::structure::get_member<dc::tags::flags>(p._cell._data.get()).get<dc::tags::collection>()) {
+    if (dc::structure::get_member<dc::tags::flags>(p._cell.data()).get<dc::tags::collection>()) {
         os << "collection ";
         auto cmv = p._cell.as_collection_mutation();
         os << to_hex(cmv.data.linearize());
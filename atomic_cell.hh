@@ -143,6 +143,7 @@ class atomic_cell_view final : public basic_atomic_cell_view<mutable_view::no> {
     atomic_cell_view(data::cell::basic_atomic_cell_view<is_mutable> view)
         : basic_atomic_cell_view<mutable_view::no>(view) { }
     friend class atomic_cell;
+    friend class atomic_cell_or_collection;
 public:
     static atomic_cell_view from_bytes(const data::type_info& ti, const imr::utils::object<data::cell::structure>& data) {
         return atomic_cell_view(ti, data.get());
@@ -158,6 +159,7 @@ class atomic_cell_view final : public basic_atomic_cell_view<mutable_view::no> {
 class atomic_cell_mutable_view final : public basic_atomic_cell_view<mutable_view::yes> {
     atomic_cell_mutable_view(const data::type_info& ti, uint8_t* data)
         : basic_atomic_cell_view<mutable_view::yes>(ti, data) {}
+    friend class atomic_cell_or_collection;
 public:
     static atomic_cell_mutable_view from_bytes(const data::type_info& ti, imr::utils::object<data::cell::structure>& data) {
         return atomic_cell_mutable_view(ti, data.get());
@@ -29,40 +29,98 @@
 
 // A variant type that can hold either an atomic_cell, or a serialized collection.
 // Which type is stored is determined by the schema.
+//
+// Copies of cells which don't own external memory and are small enough are
+// stored inline, rather than in an LSA object of their own with a back pointer.
+// Rows keep cells of low column ids in a vector, so such cells end up either
+// in the row itself or in a single allocation per row, next to the bitmap of
+// present cells.
 class atomic_cell_or_collection final {
-    // FIXME: This has made us lose small-buffer optimisation. Unfortunately,
-    // due to the changed cell format it would be less effective now, anyway.
-    // Measure the actual impact because any attempts to fix this will become
-    // irrelevant once rows are converted to the IMR as well, so maybe we can
-    // live with this like that.
     using imr_object_type = imr::utils::object<data::cell::structure>;
-    imr_object_type _data;
+public:
+    static constexpr size_t max_inline_size = 23;
+private:
+    struct small_cell {
+        uint8_t data[max_inline_size];
+        uint8_t size; // 0 -> use object
+    };
+    union u {
+        u() {}
+        ~u() {}
+        imr_object_type object;
+        small_cell small;
+    } _u;
+    static_assert(sizeof(small_cell) > sizeof(imr_object_type), "inline size too small");
 private:
-    atomic_cell_or_collection(imr::utils::object<data::cell::structure>&& data) : _data(std::move(data)) {}
+    atomic_cell_or_collection(imr_object_type&& data) noexcept {
+        new (&_u.object) imr_object_type(std::move(data));
+        _u.small.size = 0;
+    }
+    bool is_inline() const noexcept {
+        return _u.small.size != 0;
+    }
+    const uint8_t* data() const noexcept {
+        return is_inline() ? _u.small.data : _u.object.get();
+    }
+    uint8_t* data() noexcept {
+        return is_inline() ? _u.small.data : _u.object.get();
+    }
+    // Size of the cell at ptr, if it can be stored inline.
+    static std::optional<size_t> inline_size(const data::type_imr_descriptor&, const uint8_t* ptr);
+    static atomic_cell_or_collection make_inline(const uint8_t* ptr, size_t size) noexcept;
+    // Doesn't allocate if the cell can be stored inline.
+    static atomic_cell_or_collection copy_of(const data::type_imr_descriptor&, const uint8_t* ptr);
 public:
-    atomic_cell_or_collection() = default;
-    atomic_cell_or_collection(atomic_cell_or_collection&&) = default;
+    atomic_cell_or_collection() noexcept : atomic_cell_or_collection(imr_object_type()) { }
+    atomic_cell_or_collection(atomic_cell_or_collection&& o) noexcept {
+        if (o.is_inline()) {
+            _u.small = o._u.small;
+            new (&o._u.object) imr_object_type();
+            o._u.small.size = 0;
+        } else {
+            new (&_u.object) imr_object_type(std::move(o._u.object));
+            _u.small.size = 0;
+        }
+    }
     atomic_cell_or_collection(const atomic_cell_or_collection&) = delete;
-    atomic_cell_or_collection& operator=(atomic_cell_or_collection&&) = default;
+    ~atomic_cell_or_collection() {
+        if (!is_inline()) {
+            _u.object.~imr_object_type();
+        }
+    }
+    atomic_cell_or_collection& operator=(atomic_cell_or_collection&& o) noexcept {
+        swap(o);
+        return *this;
+    }
     atomic_cell_or_collection& operator=(const atomic_cell_or_collection&) = delete;
-    atomic_cell_or_collection(atomic_cell ac) : _data(std::move(ac._data)) {}
+    atomic_cell_or_collection(atomic_cell ac) : atomic_cell_or_collection(std::move(ac._data)) {}
     atomic_cell_or_collection(const abstract_type& at, atomic_cell_view acv);
     static atomic_cell_or_collection from_atomic_cell(atomic_cell data) { return { std::move(data._data) }; }
-    atomic_cell_view as_atomic_cell(const column_definition& cdef) const { return atomic_cell_view::from_bytes(cdef.type->imr_state().type_info(), _data); }
-    atomic_cell_ref as_atomic_cell_ref(const column_definition& cdef) { return atomic_cell_mutable_view::from_bytes(cdef.type->imr_state().type_info(), _data); }
-    atomic_cell_mutable_view as_mutable_atomic_cell(const column_definition& cdef) { return atomic_cell_mutable_view::from_bytes(cdef.type->imr_state().type_info(), _data); }
-    atomic_cell_or_collection(collection_mutation cm) : _data(std::move(cm._data)) { }
+    // Like from_atomic_cell(), but stores the cell inline, freeing its object, if it's small enough.
+    static atomic_cell_or_collection from_atomic_cell(const abstract_type& type, atomic_cell data);
+    atomic_cell_view as_atomic_cell(const column_definition& cdef) const { return atomic_cell_view(cdef.type->imr_state().type_info(), data()); }
+    atomic_cell_ref as_atomic_cell_ref(const column_definition& cdef) { return atomic_cell_mutable_view(cdef.type->imr_state().type_info(), data()); }
+    atomic_cell_mutable_view as_mutable_atomic_cell(const column_definition& cdef) { return atomic_cell_mutable_view(cdef.type->imr_state().type_info(), data()); }
+    atomic_cell_or_collection(collection_mutation cm) : atomic_cell_or_collection(std::move(cm._data)) { }
     atomic_cell_or_collection copy(const abstract_type&) const;
     explicit operator bool() const {
-        return bool(_data);
+        return is_inline() || bool(_u.object);
     }
     static constexpr bool can_use_mutable_view() {
         return true;
     }
     void swap(atomic_cell_or_collection& other) noexcept {
-        _data.swap(other._data);
+        if (!is_inline() && !other.is_inline()) {
+            _u.object.swap(other._u.object);
+        } else if (this != &other) {
+            atomic_cell_or_collection tmp(std::move(other));
+            other.~atomic_cell_or_collection();
+            new (&other) atomic_cell_or_collection(std::move(*this));
+            this->~atomic_cell_or_collection();
+            new (this) atomic_cell_or_collection(std::move(tmp));
+        }
     }
-    static atomic_cell_or_collection from_collection_mutation(collection_mutation data) { return std::move(data._data); }
+    static atomic_cell_or_collection from_collection_mutation(collection_mutation data) { return atomic_cell_or_collection(std::move(data._data)); }
     collection_mutation_view as_collection_mutation() const;
     bytes_view serialize() const;
     bool equals(const abstract_type& type, const atomic_cell_or_collection& other) const;
@@ -99,6 +99,8 @@ class backlog_controller {
 public:
     backlog_controller(backlog_controller&&) = default;
     float backlog_of_shares(float shares) const;
+    // The shares the controller sets for the given backlog.
+    float controller_output(float backlog) const;
     seastar::scheduling_group sg() {
         return _scheduling_group;
     }
@@ -36,14 +36,22 @@ class caching_options {
     // this (and maybe we shouldn't)
     static constexpr auto default_key = "ALL";
     static constexpr auto default_row = "ALL";
+    // Scylla-specific. "FREQUENT" makes reads populate the row cache only
+    // with partitions which were read frequently enough, see row_cache.
+    static constexpr auto default_admission = "ALL";
 
     sstring _key_cache;
     sstring _row_cache;
-    caching_options(sstring k, sstring r) : _key_cache(k), _row_cache(r) {
+    sstring _admission;
+    caching_options(sstring k, sstring r, sstring a = default_admission) : _key_cache(k), _row_cache(r), _admission(a) {
         if ((k != "ALL") && (k != "NONE")) {
             throw exceptions::configuration_exception("Invalid key value: " + k); 
         }
 
+        if ((a != "ALL") && (a != "FREQUENT")) {
+            throw exceptions::configuration_exception("Invalid admission value: " + a);
+        }
+
         if ((r == "ALL") || (r == "NONE")) {
             return;
         } else {
@@ -56,11 +64,19 @@ class caching_options {
     }
 
     friend class schema;
-    caching_options() : _key_cache(default_key), _row_cache(default_row) {}
+    caching_options() : _key_cache(default_key), _row_cache(default_row), _admission(default_admission) {}
 public:
 
     std::map<sstring, sstring> to_map() const {
-        return {{ "keys", _key_cache }, { "rows_per_partition", _row_cache }};
+        std::map<sstring, sstring> res = {{ "keys", _key_cache }, { "rows_per_partition", _row_cache }};
+        if (_admission != default_admission) {
+            res.emplace("admission", _admission);
+        }
+        return res;
+    }
+
+    bool admit_frequent_only() const {
+        return _admission == "FREQUENT";
     }
 
     sstring to_sstring() const {
@@ -71,24 +87,27 @@ class caching_options {
     static caching_options from_map(const Map & map) {
         sstring k = default_key;
         sstring r = default_row;
+        sstring a = default_admission;
 
         for (auto& p : map) {
             if (p.first == "keys") {
                 k = p.second;
             } else if (p.first == "rows_per_partition") {
                 r = p.second;
+            } else if (p.first == "admission") {
+                a = p.second;
             } else {
                 throw exceptions::configuration_exception("Invalid caching option: " + p.first);
             }
         }
-        return caching_options(k, r);
+        return caching_options(k, r, a);
     }
     static caching_options from_sstring(const sstring& str) {
         return from_map(json::to_map(str));
     }
 
     bool operator==(const caching_options& other) const {
-        return _key_cache == other._key_cache && _row_cache == other._row_cache;
+        return _key_cache == other._key_cache && _row_cache == other._row_cache && _admission == other._admission;
     }
     bool operator!=(const caching_options& other) const {
         return !(*this == other);
@@ -39,6 +39,7 @@ enum class compaction_strategy_type {
     leveled,
     date_tiered,
     time_window,
+    incremental,
 };
 
 class compaction_strategy_impl;
@@ -59,12 +60,19 @@ class compaction_strategy {
     compaction_strategy& operator=(compaction_strategy&&);
 
     // Return a list of sstables to be compacted after applying the strategy.
+    // Repaired and unrepaired sstables are never compacted together, the strategy is applied
+    // to either set on its own, unrepaired first.
     compaction_descriptor get_sstables_for_compaction(column_family& cfs, std::vector<shared_sstable> candidates);
 
     compaction_descriptor get_major_compaction_job(column_family& cf, std::vector<shared_sstable> candidates);
 
     std::vector<resharding_descriptor> get_resharding_jobs(column_family& cf, std::vector<shared_sstable> candidates);
 
+    // Return the jobs compacting sstables which were added off-strategy, like the ones received
+    // by streaming, into the layout the strategy would have given them. Input sstables left out
+    // of all jobs are fine as they are. Like above, repaired and unrepaired sstables are kept apart.
+    std::vector<compaction_descriptor> get_reshaping_jobs(column_family& cf, std::vector<shared_sstable> input);
+
     // Some strategies may look at the compacted and resulting sstables to
     // get some useful information for subsequent compactions.
     void notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added);
@@ -78,6 +86,9 @@ class compaction_strategy {
     // Return true if compaction strategy ignores sstables coming from partial runs.
     bool ignore_partial_runs() const;
 
+    // Return if compaction should write tombstones which can't be purged yet to a garbage collected sstable.
+    bool use_garbage_collected_sstable() const;
+
     // An estimation of number of compaction for strategy to be satisfied.
     int64_t estimated_pending_compactions(column_family& cf) const;
 
@@ -95,6 +106,8 @@ class compaction_strategy {
             return "DateTieredCompactionStrategy";
         case compaction_strategy_type::time_window:
             return "TimeWindowCompactionStrategy";
+        case compaction_strategy_type::incremental:
+            return "IncrementalCompactionStrategy";
         default:
             throw std::runtime_error("Invalid Compaction Strategy");
         }
@@ -115,6 +128,8 @@ class compaction_strategy {
             return compaction_strategy_type::date_tiered;
         } else if (short_name == "TimeWindowCompactionStrategy") {
             return compaction_strategy_type::time_window;
+        } else if (short_name == "IncrementalCompactionStrategy") {
+            return compaction_strategy_type::incremental;
         } else {
             throw exceptions::configuration_exception(format("Unable to find compaction strategy class '{}'", name));
         }
@@ -22,6 +22,8 @@
 #include <lz4.h>
 #include <zlib.h>
 #include <snappy-c.h>
+#include <zstd.h>
+#include <zdict.h>
 
 #include "compress.hh"
 #include "utils/class_registrator.hh"
@@ -61,6 +63,51 @@ class deflate_processor: public compressor {
     size_t compress_max_size(size_t input_len) const override;
 };
 
+class zstd_processor: public compressor {
+public:
+    static constexpr int DEFAULT_COMPRESSION_LEVEL = 3;
+
+    static const sstring COMPRESSION_LEVEL;
+    static const sstring DICTIONARY_SIZE_KB;
+private:
+    struct cdict_deleter {
+        void operator()(ZSTD_CDict* d) const { ZSTD_freeCDict(d); }
+    };
+    struct ddict_deleter {
+        void operator()(ZSTD_DDict* d) const { ZSTD_freeDDict(d); }
+    };
+
+    int _level;
+    size_t _dictionary_size;
+    bytes _dictionary;
+    // Digested forms of _dictionary, created on first use since readers
+    // only ever need the one and writers the other.
+    mutable std::unique_ptr<ZSTD_CDict, cdict_deleter> _cdict;
+    mutable std::unique_ptr<ZSTD_DDict, ddict_deleter> _ddict;
+
+    const ZSTD_CDict* cdict() const;
+    const ZSTD_DDict* ddict() const;
+public:
+    zstd_processor(const opt_getter&);
+    zstd_processor(const zstd_processor&, bytes_view dictionary);
+
+    size_t uncompress(const char* input, size_t input_len, char* output,
+                    size_t output_len) const override;
+    size_t compress(const char* input, size_t input_len, char* output,
+                    size_t output_len) const override;
+    size_t compress_max_size(size_t input_len) const override;
+
+    std::set<sstring> option_names() const override;
+    std::map<sstring, sstring> options() const override;
+
+    size_t dictionary_size() const override;
+    bytes train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const override;
+    shared_ptr<compressor> with_dictionary(bytes_view dictionary) const override;
+};
+
+static const class_registrator<compressor, zstd_processor, const compressor::opt_getter&>
+    zstd_registrator(compressor::namespace_prefix + "ZstdCompressor");
+
 compressor::compressor(sstring name)
     : _name(std::move(name))
 {}
@@ -73,6 +120,18 @@ std::map<sstring, sstring> compressor::options() const {
     return {};
 }
 
+size_t compressor::dictionary_size() const {
+    return 0;
+}
+
+bytes compressor::train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const {
+    return bytes();
+}
+
+shared_ptr<compressor> compressor::with_dictionary(bytes_view dictionary) const {
+    throw std::runtime_error(format("{} does not support compression dictionaries", name()));
+}
+
 shared_ptr<compressor> compressor::create(const sstring& name, const opt_getter& opts) {
     if (name.empty()) {
         return {};
@@ -183,7 +242,13 @@ std::map<sstring, sstring> compression_parameters::get_options() const {
 }
 
 bool compression_parameters::operator==(const compression_parameters& other) const {
-    return _compressor == other._compressor
+    // Compressors with options are created anew for each set of parameters,
+    // so they have to be compared by value.
+    auto same_compressor = _compressor == other._compressor
+            || (_compressor && other._compressor
+                && _compressor->name() == other._compressor->name()
+                && _compressor->options() == other._compressor->options());
+    return same_compressor
            && _chunk_length == other._chunk_length
            && _crc_check_chance == other._crc_check_chance;
 }
@@ -349,3 +414,160 @@ size_t snappy_processor::compress_max_size(size_t input_len) const {
     return snappy_max_compressed_length(input_len);
 }
 
+
+const sstring zstd_processor::COMPRESSION_LEVEL = "compression_level";
+const sstring zstd_processor::DICTIONARY_SIZE_KB = "dictionary_size_in_kb";
+
+zstd_processor::zstd_processor(const opt_getter& opts)
+    : compressor(namespace_prefix + "ZstdCompressor")
+    , _level(DEFAULT_COMPRESSION_LEVEL)
+    , _dictionary_size(0)
+{
+    auto level = opts(COMPRESSION_LEVEL);
+    if (level) {
+        try {
+            _level = std::stoi(*level);
+        } catch (const std::exception& e) {
+            throw exceptions::syntax_exception(sstring("Invalid integer value ") + *level + " for " + COMPRESSION_LEVEL);
+        }
+        if (_level < 1 || _level > ZSTD_maxCLevel()) {
+            throw exceptions::configuration_exception(
+                format("{} must be between 1 and {}.", COMPRESSION_LEVEL, ZSTD_maxCLevel()));
+        }
+    }
+    auto dictionary_size = opts(DICTIONARY_SIZE_KB);
+    if (dictionary_size) {
+        int kb;
+        try {
+            kb = std::stoi(*dictionary_size);
+        } catch (const std::exception& e) {
+            throw exceptions::syntax_exception(sstring("Invalid integer value ") + *dictionary_size + " for " + DICTIONARY_SIZE_KB);
+        }
+        // Dictionaries are stored in a single component, keep them small
+        // enough not to be a burden to load.
+        if (kb < 0 || kb > 1024) {
+            throw exceptions::configuration_exception(format("{} must be between 0 and 1024.", DICTIONARY_SIZE_KB));
+        }
+        _dictionary_size = size_t(kb) * 1024;
+    }
+}
+
+zstd_processor::zstd_processor(const zstd_processor& o, bytes_view dictionary)
+    : compressor(o.name())
+    , _level(o._level)
+    , _dictionary_size(o._dictionary_size)
+    , _dictionary(dictionary)
+{}
+
+const ZSTD_CDict* zstd_processor::cdict() const {
+    if (_dictionary.empty()) {
+        return nullptr;
+    }
+    if (!_cdict) {
+        _cdict.reset(ZSTD_createCDict(_dictionary.data(), _dictionary.size(), _level));
+        if (!_cdict) {
+            throw std::bad_alloc();
+        }
+    }
+    return _cdict.get();
+}
+
+const ZSTD_DDict* zstd_processor::ddict() const {
+    if (_dictionary.empty()) {
+        return nullptr;
+    }
+    if (!_ddict) {
+        _ddict.reset(ZSTD_createDDict(_dictionary.data(), _dictionary.size()));
+        if (!_ddict) {
+            throw std::bad_alloc();
+        }
+    }
+    return _ddict.get();
+}
+
+// Compression contexts are expensive to create, so each shard keeps one
+// of each and reuses it for all zstd (un)compression done on that shard.
+static ZSTD_CCtx* local_zstd_cctx() {
+    struct deleter {
+        void operator()(ZSTD_CCtx* c) const { ZSTD_freeCCtx(c); }
+    };
+    static thread_local std::unique_ptr<ZSTD_CCtx, deleter> cctx(ZSTD_createCCtx());
+    if (!cctx) {
+        throw std::bad_alloc();
+    }
+    return cctx.get();
+}
+
+static ZSTD_DCtx* local_zstd_dctx() {
+    struct deleter {
+        void operator()(ZSTD_DCtx* c) const { ZSTD_freeDCtx(c); }
+    };
+    static thread_local std::unique_ptr<ZSTD_DCtx, deleter> dctx(ZSTD_createDCtx());
+    if (!dctx) {
+        throw std::bad_alloc();
+    }
+    return dctx.get();
+}
+
+size_t zstd_processor::uncompress(const char* input, size_t input_len,
+                char* output, size_t output_len) const {
+    auto dict = ddict();
+    auto ret = dict
+            ? ZSTD_decompress_usingDDict(local_zstd_dctx(), output, output_len, input, input_len, dict)
+            : ZSTD_decompressDCtx(local_zstd_dctx(), output, output_len, input, input_len);
+    if (ZSTD_isError(ret)) {
+        throw std::runtime_error(format("zstd uncompression failure: {}", ZSTD_getErrorName(ret)));
+    }
+    return ret;
+}
+
+size_t zstd_processor::compress(const char* input, size_t input_len,
+                char* output, size_t output_len) const {
+    auto dict = cdict();
+    auto ret = dict
+            ? ZSTD_compress_usingCDict(local_zstd_cctx(), output, output_len, input, input_len, dict)
+            : ZSTD_compressCCtx(local_zstd_cctx(), output, output_len, input, input_len, _level);
+    if (ZSTD_isError(ret)) {
+        throw std::runtime_error(format("zstd compression failure: {}", ZSTD_getErrorName(ret)));
+    }
+    return ret;
+}
+
+size_t zstd_processor::compress_max_size(size_t input_len) const {
+    return ZSTD_compressBound(input_len);
+}
+
+std::set<sstring> zstd_processor::option_names() const {
+    return { COMPRESSION_LEVEL, DICTIONARY_SIZE_KB };
+}
+
+std::map<sstring, sstring> zstd_processor::options() const {
+    return {
+        { COMPRESSION_LEVEL, std::to_string(_level) },
+        { DICTIONARY_SIZE_KB, std::to_string(_dictionary_size / 1024) },
+    };
+}
+
+size_t zstd_processor::dictionary_size() const {
+    return _dictionary_size;
+}
+
+bytes zstd_processor::train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const {
+    // zstd wants at least ten times the dictionary size in samples.
+    auto dictionary_size = std::min(_dictionary_size, samples.size() / 10);
+    if (!dictionary_size) {
+        return bytes();
+    }
+    bytes dictionary(bytes::initialized_later(), dictionary_size);
+    auto ret = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sample_sizes.data(), sample_sizes.size());
+    if (ZDICT_isError(ret)) {
+        // Not enough (or too uniform) samples, compress without a dictionary.
+        return bytes();
+    }
+    dictionary.resize(ret);
+    return dictionary;
+}
+
+shared_ptr<compressor> zstd_processor::with_dictionary(bytes_view dictionary) const {
+    return seastar::make_shared<zstd_processor>(*this, dictionary);
+}
@@ -23,11 +23,14 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include <seastar/core/future.hh>
 #include <seastar/core/shared_ptr.hh>
 #include <seastar/core/sstring.hh>
+#include <seastar/core/temporary_buffer.hh>
 
+#include "bytes.hh"
 #include "exceptions/exceptions.hh"
 
 
@@ -64,6 +67,24 @@ class compressor {
      */
     virtual std::map<sstring, sstring> options() const;
 
+    /**
+     * Returns the size of the dictionary this compressor wants trained
+     * from samples of the data it compresses, or 0 if it doesn't use one.
+     */
+    virtual size_t dictionary_size() const;
+    /**
+     * Trains a dictionary from the given samples, which are laid out one
+     * after the other in samples and whose sizes are in sample_sizes.
+     * Returns an empty dictionary if the samples are not sufficient to
+     * train one.
+     */
+    virtual bytes train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) const;
+    /**
+     * Returns a compressor with the same options as this one, which
+     * compresses and uncompresses using the given dictionary.
+     */
+    virtual shared_ptr<compressor> with_dictionary(bytes_view dictionary) const;
+
     /**
      * Compressor class name.
      */
@@ -257,6 +257,7 @@ scylla_tests = [
     'tests/row_cache_alloc_stress',
     'tests/perf_row_cache_update',
     'tests/perf/perf_hash',
+    'tests/perf/perf_compress',
     'tests/perf/perf_cql_parser',
     'tests/perf/perf_simple_query',
     'tests/perf/perf_fast_forward',
@@ -265,6 +266,7 @@ scylla_tests = [
     'tests/row_cache_stress_test',
     'tests/memory_footprint',
     'tests/perf/perf_sstable',
+    'tests/perf/perf_compaction_strategy',
     'tests/cql_query_test',
     'tests/secondary_index_test',
     'tests/json_cql_query_test',
@@ -356,6 +358,8 @@ scylla_tests = [
     'tests/top_k_test',
     'tests/utf8_test',
     'tests/small_vector_test',
+    'tests/bptree_test',
+    'tests/frequency_sketch_test',
     'tests/data_listeners_test',
     'tests/truncation_migration_test',
 ]
@@ -365,6 +369,7 @@ perf_tests = [
     'tests/perf/perf_checksum',
     'tests/perf/perf_mutation_fragment',
     'tests/perf/perf_idl',
+    'tests/perf/perf_bloom_filter',
 ]
 
 apps = [
@@ -475,6 +480,8 @@ scylla_core = (['database.cc',
                 'sstables/mc/writer.cc',
                 'sstables/sstable_version.cc',
                 'sstables/compress.cc',
+                'sstables/index_page_cache.cc',
+                'sstables/read_ahead.cc',
                 'sstables/partition.cc',
                 'sstables/compaction.cc',
                 'sstables/compaction_strategy.cc',
@@ -644,6 +651,7 @@ scylla_core = (['database.cc',
                 'service/migration_task.cc',
                 'service/storage_service.cc',
                 'service/misc_services.cc',
+                'service/cache_saver.cc',
                 'service/pager/paging_state.cc',
                 'service/pager/query_pagers.cc',
                 'streaming/stream_task.cc',
@@ -815,6 +823,8 @@ pure_boost_tests = set([
     'tests/auth_passwords_test',
     'tests/top_k_test',
     'tests/small_vector_test',
+    'tests/bptree_test',
+    'tests/frequency_sketch_test',
 ])
 
 tests_not_using_seastar_test_framework = set([
@@ -824,6 +834,7 @@ tests_not_using_seastar_test_framework = set([
     'tests/row_cache_alloc_stress',
     'tests/perf_row_cache_update',
     'tests/perf/perf_hash',
+    'tests/perf/perf_compress',
     'tests/perf/perf_cql_parser',
     'tests/message',
     'tests/perf/perf_simple_query',
@@ -833,6 +844,7 @@ tests_not_using_seastar_test_framework = set([
     'tests/memory_footprint',
     'tests/gossip',
     'tests/perf/perf_sstable',
+    'tests/perf/perf_compaction_strategy',
     'tests/small_vector_test',
 ]) | pure_boost_tests
 
@@ -872,6 +884,8 @@ deps['tests/imr_test'] = ['tests/imr_test.cc', 'utils/logalloc.cc', 'utils/dynam
 deps['tests/reusable_buffer_test'] = ['tests/reusable_buffer_test.cc']
 deps['tests/utf8_test'] = ['utils/utf8.cc', 'tests/utf8_test.cc']
 deps['tests/small_vector_test'] = ['tests/small_vector_test.cc']
+deps['tests/bptree_test'] = ['tests/bptree_test.cc', 'utils/logalloc.cc', 'utils/dynamic_bitset.cc']
+deps['tests/frequency_sketch_test'] = ['tests/frequency_sketch_test.cc']
 deps['tests/multishard_mutation_query_test'] += ['tests/test_table.cc']
 
 deps['utils/gz/gen_crc_combine_table'] = ['utils/gz/gen_crc_combine_table.cc']
@@ -1074,7 +1088,7 @@ for mode in build_modes:
 
 args.user_cflags += " " + pkg_config('jsoncpp', '--cflags')
 args.user_cflags += ' -march=' + args.target
-libs = ' '.join([maybe_static(args.staticyamlcpp, '-lyaml-cpp'), '-latomic', '-llz4', '-lz', '-lsnappy', pkg_config('jsoncpp', '--libs'),
+libs = ' '.join([maybe_static(args.staticyamlcpp, '-lyaml-cpp'), '-latomic', '-llz4', '-lz', '-lsnappy', '-lzstd', pkg_config('jsoncpp', '--libs'),
                  maybe_static(args.staticboost, '-lboost_filesystem'), ' -lstdc++fs', ' -lcrypt', ' -lcryptopp', ' -lpthread',
                  maybe_static(args.staticboost, '-lboost_date_time'), ])
 
@@ -41,6 +41,7 @@
 
 #include "cql3/statements/cf_prop_defs.hh"
 #include "db/extensions.hh"
+#include "service/storage_service.hh"
 
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -123,6 +124,11 @@ void cf_prop_defs::validate(const db::extensions& exts) {
         cp.validate();
     }
 
+    auto caching = get_caching_options();
+    if (caching && caching->admit_frequent_only() && !service::get_local_storage_service().cluster_supports_cache_admission()) {
+        throw exceptions::configuration_exception("Caching option 'admission' is not supported by all nodes in the cluster");
+    }
+
     validate_minimum_int(KW_DEFAULT_TIME_TO_LIVE, 0, DEFAULT_DEFAULT_TIME_TO_LIVE);
 
     auto min_index_interval = get_int(KW_MIN_INDEX_INTERVAL, DEFAULT_MIN_INDEX_INTERVAL);
@@ -163,6 +169,18 @@ int32_t cf_prop_defs::get_gc_grace_seconds() const
     return get_int(KW_GCGRACESECONDS, DEFAULT_GC_GRACE_SECONDS);
 }
 
+std::optional<caching_options> cf_prop_defs::get_caching_options() const {
+    auto it = _properties.find(KW_CACHING);
+    if (it == _properties.end()) {
+        return std::nullopt;
+    }
+    if (auto str = std::get_if<sstring>(&it->second)) {
+        // Legacy syntax, a JSON map in a string
+        return caching_options::from_sstring(*str);
+    }
+    return caching_options::from_map(std::get<map_type>(it->second));
+}
+
 std::optional<utils::UUID> cf_prop_defs::get_id() const {
     auto id = get_simple(KW_ID);
     if (id) {
@@ -245,11 +263,10 @@ void cf_prop_defs::apply_to_builder(schema_builder& builder, const db::extension
     if (compression_options) {
         builder.set_compressor_params(compression_parameters(*compression_options));
     }
-#if 0
-    CachingOptions cachingOptions = getCachingOptions();
-    if (cachingOptions != null)
-        cfm.caching(cachingOptions);
-#endif
+    auto caching = get_caching_options();
+    if (caching) {
+        builder.set_caching_options(std::move(*caching));
+    }
 
     schema::extensions_map er;
     for (auto& p : exts.schema_extensions()) {
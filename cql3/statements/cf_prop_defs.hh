@@ -45,6 +45,7 @@
  
 #include "schema.hh"
 #include "schema_builder.hh"
+#include "caching_options.hh"
 #include "compaction_strategy.hh"
 #include "utils/UUID.hh"
 
@@ -91,23 +92,7 @@ class cf_prop_defs : public property_definitions {
     void validate(const db::extensions&);
     std::map<sstring, sstring> get_compaction_options() const;
     std::optional<std::map<sstring, sstring>> get_compression_options() const;
-#if 0
-    public CachingOptions getCachingOptions() throws SyntaxException, ConfigurationException
-    {
-        CachingOptions options = null;
-        Object val = properties.get(KW_CACHING);
-        if (val == null)
-            return null;
-        else if (val instanceof Map)
-            options = CachingOptions.fromMap(getMap(KW_CACHING));
-        else if (val instanceof String) // legacy syntax
-        {
-            options = CachingOptions.fromString(getSimple(KW_CACHING));
-            logger.warn("Setting caching options with deprecated syntax.");
-        }
-        return options;
-    }
-#endif
+    std::optional<caching_options> get_caching_options() const;
     int32_t get_default_time_to_live() const;
     int32_t get_gc_grace_seconds() const;
     std::optional<utils::UUID> get_id() const;
@@ -234,7 +234,53 @@ select_statement::make_partition_slice(const query_options& options)
         ++_stats.reverse_queries;
     }
     return query::partition_slice(std::move(bounds),
-        std::move(static_columns), std::move(regular_columns), _opts, nullptr, options.get_cql_serialization_format(), get_per_partition_limit(options));
+        std::move(static_columns), std::move(regular_columns), _opts, nullptr, options.get_cql_serialization_format(), get_per_partition_limit(options),
+        get_value_ranges(options));
+}
+
+// Ranges of values which the filtered regular columns are restricted to, so
+// that replicas can skip sstables whose zone maps exclude them. Rows the
+// replicas skip are ones the filter would drop anyway. This only holds when
+// the result is not reconciled with other replicas, whose copy of a skipped
+// row could be stale and match, hence the consistency level restriction.
+query::column_value_ranges
+select_statement::get_value_ranges(const query_options& options) const {
+    query::column_value_ranges ranges;
+    auto cl = options.get_consistency();
+    if (!_restrictions->need_filtering() || (cl != db::consistency_level::ONE && cl != db::consistency_level::LOCAL_ONE)) {
+        return ranges;
+    }
+    for (auto&& [cdef, restriction] : _restrictions->get_non_pk_restriction()) {
+        if (!cdef->is_regular()) {
+            continue;
+        }
+        std::optional<nonwrapping_range<bytes>> range;
+        if (restriction->is_EQ()) {
+            auto value = restriction->value(options);
+            if (value) {
+                range = nonwrapping_range<bytes>::make_singular(std::move(*value));
+            }
+        } else if (restriction->is_slice()) {
+            auto make_bound = [&] (statements::bound b) -> std::optional<nonwrapping_range<bytes>::bound> {
+                if (!restriction->has_bound(b)) {
+                    return std::nullopt;
+                }
+                auto value = restriction->bounds(b, options)[0];
+                if (!value) {
+                    return std::nullopt;
+                }
+                return nonwrapping_range<bytes>::bound(std::move(*value), restriction->is_inclusive(b));
+            };
+            range = nonwrapping_range<bytes>(make_bound(statements::bound::START), make_bound(statements::bound::END));
+        }
+        // The filter evaluates a missing cell as an empty value, so ranges
+        // containing it could be satisfied by rows an sstable has no value for.
+        auto cmp = [cdef] (const bytes& a, const bytes& b) { return cdef->type->compare(a, b); };
+        if (range && !range->contains(bytes(), cmp)) {
+            ranges.push_back(query::column_value_range{cdef->id, std::move(*range)});
+        }
+    }
+    return ranges;
 }
 
 uint32_t select_statement::do_get_limit(const query_options& options, ::shared_ptr<term> limit) const {
@@ -137,6 +137,8 @@ protected :
 
     query::partition_slice make_partition_slice(const query_options& options);
 
+    query::column_value_ranges get_value_ranges(const query_options& options) const;
+
     ::shared_ptr<restrictions::statement_restrictions> get_restrictions() const;
 
 protected:
@@ -239,11 +239,12 @@ const db::extensions& database::extensions() const {
 }
 
 void backlog_controller::adjust() {
-    auto backlog = _current_backlog();
+    update_controller(controller_output(_current_backlog()));
+}
 
+float backlog_controller::controller_output(float backlog) const {
     if (backlog >= _control_points.back().input) {
-        update_controller(_control_points.back().output);
-        return;
+        return _control_points.back().output;
     }
 
     // interpolate to find out which region we are. This run infrequently and there are a fixed
@@ -253,10 +254,9 @@ void backlog_controller::adjust() {
         idx++;
     }
 
-    control_point& cp = _control_points[idx];
-    control_point& last = _control_points[idx - 1];
-    float result = last.output + (backlog - last.input) * (cp.output - last.output)/(cp.input - last.input);
-    update_controller(result);
+    const control_point& cp = _control_points[idx];
+    const control_point& last = _control_points[idx - 1];
+    return last.output + (backlog - last.input) * (cp.output - last.output)/(cp.input - last.input);
 }
 
 float backlog_controller::backlog_of_shares(float shares) const {
@@ -886,6 +886,7 @@ keyspace::make_column_family_config(const schema& s, const database& db) const {
     cfg.streaming_scheduling_group = _config.streaming_scheduling_group;
     cfg.statement_scheduling_group = _config.statement_scheduling_group;
     cfg.enable_metrics_reporting = db_config.enable_keyspace_column_family_metrics();
+    cfg.enable_sstable_zone_maps = db_config.enable_sstable_zone_maps();
 
     // avoid self-reporting
     if (is_system_table(s)) {
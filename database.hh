@@ -71,6 +71,7 @@
 #include "utils/estimated_histogram.hh"
 #include "sstables/sstable_set.hh"
 #include "sstables/progress_monitor.hh"
+#include "sstables/read_ahead.hh"
 #include "sstables/version.hh"
 #include <seastar/core/rwlock.hh>
 #include <seastar/core/shared_future.hh>
@@ -314,6 +315,7 @@ class table : public enable_lw_shared_from_this<table> {
         bool enable_cache = true;
         bool enable_commitlog = true;
         bool enable_incremental_backups = false;
+        bool enable_sstable_zone_maps = false;
         bool compaction_enforce_min_threshold = false;
         bool enable_dangerous_direct_import_of_cassandra_counters = false;
         ::dirty_memory_manager* dirty_memory_manager = &default_dirty_memory_manager;
@@ -344,6 +346,10 @@ class table : public enable_lw_shared_from_this<table> {
         int64_t live_sstable_count = 0;
         /** Estimated number of compactions pending for this column family */
         int64_t pending_compactions = 0;
+        /** Number of tombstones garbage collected by compaction */
+        int64_t purged_tombstones = 0;
+        /** Bytes of sstables cleanup found no need to rewrite */
+        int64_t cleanup_bytes_saved = 0;
         utils::timed_rate_moving_average_and_histogram reads{256};
         utils::timed_rate_moving_average_and_histogram writes{256};
         utils::estimated_histogram estimated_read;
@@ -368,6 +374,8 @@ class table : public enable_lw_shared_from_this<table> {
     mutable stats _stats;
     mutable db::view::stats _view_stats;
     mutable row_locker::stats _row_locker_stats;
+    // Shared with the table's sstables, which account their data reads in it.
+    lw_shared_ptr<sstables::data_read_stats> _data_read_stats = make_lw_shared<sstables::data_read_stats>();
 
     uint64_t _failed_counter_applies_to_memtable = 0;
 
@@ -444,6 +452,12 @@ class table : public enable_lw_shared_from_this<table> {
     // sstables that should not be compacted (e.g. because they need to be used
     // to generate view updates later)
     std::unordered_map<uint64_t, sstables::shared_sstable> _sstables_staging;
+    // sstables added off-strategy, e.g. received by streaming or repair. They're
+    // read from, but not compacted by the strategy, nor accounted in its backlog,
+    // until off-strategy compaction reshapes them into the strategy's layout.
+    std::unordered_map<uint64_t, sstables::shared_sstable> _sstables_maintenance;
+    // set while off-strategy compaction waits for the streams in progress to be submitted.
+    bool _offstrategy_compaction_pending = false;
     // Control background fibers waiting for sstables to be deleted
     seastar::gate _sstable_deletion_gate;
     // This semaphore ensures that an operation like snapshot won't have its selected
@@ -503,6 +517,9 @@ class table : public enable_lw_shared_from_this<table> {
     utils::phased_barrier _pending_streams_phaser;
 public:
     future<> add_sstable_and_update_cache(sstables::shared_sstable sst);
+    // Like add_sstable_and_update_cache(), but leaves the sstable out of the compaction
+    // strategy until off-strategy compaction.
+    future<> add_maintenance_sstable_and_update_cache(sstables::shared_sstable sst);
     void move_sstable_from_staging_in_thread(sstables::shared_sstable sst);
     sstables::shared_sstable get_staging_sstable(uint64_t generation) {
         auto it = _sstables_staging.find(generation);
@@ -577,6 +594,14 @@ class table : public enable_lw_shared_from_this<table> {
                                         streamed_mutation::forwarding fwd,
                                         mutation_reader::forwarding fwd_mr) const;
 
+    // Returns the sstables to read range from. For a single partition which
+    // only one source holds, that's none when the zone maps of its sstable
+    // rule value_ranges out. Otherwise, it's all sstables.
+    lw_shared_ptr<sstables::sstable_set> exclude_sstables_by_value_ranges(const schema& s,
+                                        const dht::partition_range& range,
+                                        const query::column_value_ranges& value_ranges,
+                                        const tracing::trace_state_ptr& trace_state) const;
+
     snapshot_source sstables_as_snapshot_source();
     partition_presence_checker make_partition_presence_checker(lw_shared_ptr<sstables::sstable_set>);
     std::chrono::steady_clock::time_point _sstable_writes_disabled_at;
@@ -783,6 +808,12 @@ class table : public enable_lw_shared_from_this<table> {
     // given sstable, e.g. after node loses part of its token range because
     // of a newly added node.
     future<> cleanup_sstables(sstables::compaction_descriptor descriptor, bool is_actual_cleanup);
+    // Submits the maintenance sstables for off-strategy compaction, which runs in the background,
+    // under the streaming scheduling group.
+    void trigger_offstrategy_compaction();
+    // Reshapes the maintenance sstables into the layout of the compaction strategy,
+    // and hands them over to it. Called by the compaction manager.
+    future<> run_offstrategy_compaction();
 
     future<bool> snapshot_exists(sstring name);
 
@@ -795,6 +826,10 @@ class table : public enable_lw_shared_from_this<table> {
         return _config.enable_incremental_backups;
     }
 
+    bool sstable_zone_maps_enabled() const {
+        return _config.enable_sstable_zone_maps;
+    }
+
     void set_incremental_backups(bool val) {
         _config.enable_incremental_backups = val;
     }
@@ -816,6 +851,7 @@ class table : public enable_lw_shared_from_this<table> {
     const std::vector<sstables::shared_sstable>& compacted_undeleted_sstables() const;
     std::vector<sstables::shared_sstable> select_sstables(const dht::partition_range& range) const;
     std::vector<sstables::shared_sstable> candidates_for_compaction() const;
+    std::vector<sstables::shared_sstable> maintenance_sstables() const;
     std::vector<sstables::shared_sstable> sstables_need_rewrite() const;
     size_t sstables_count() const;
     std::vector<uint64_t> sstable_count_per_level() const;
@@ -997,6 +1033,19 @@ flat_mutation_reader make_local_shard_sstable_reader(schema_ptr s,
         mutation_reader::forwarding fwd_mr,
         sstables::read_monitor_generator& monitor_generator = sstables::default_read_monitor_generator());
 
+// Like make_local_shard_sstable_reader(), without forwarding. Sstables which don't overlap with
+// any other are read straight from their own reader, and only the regions of the key space
+// where sstables overlap go through the merging of the combined reader. Meant for compaction,
+// where inputs are often mostly disjoint.
+flat_mutation_reader make_disjoint_pass_through_sstable_reader(schema_ptr s,
+        lw_shared_ptr<sstables::sstable_set> sstables,
+        const dht::partition_range& pr,
+        const query::partition_slice& slice,
+        const io_priority_class& pc,
+        reader_resource_tracker resource_tracker,
+        tracing::trace_state_ptr trace_state,
+        sstables::read_monitor_generator& monitor_generator = sstables::default_read_monitor_generator());
+
 flat_mutation_reader make_range_sstable_reader(schema_ptr s,
         lw_shared_ptr<sstables::sstable_set> sstables,
         const dht::partition_range& pr,
@@ -158,8 +158,8 @@ class config : public utils::config_file {
     val(view_hints_directory, sstring, "/var/lib/scylla/view_hints", Used,   \
             "The directory where materialized-view updates are stored while a view replica is unreachable."   \
     )                                           \
-    val(saved_caches_directory, sstring, "/var/lib/scylla/saved_caches", Unused, \
-            "The directory location where table key and row caches are stored."  \
+    val(saved_caches_directory, sstring, "/var/lib/scylla/saved_caches", Used, \
+            "The directory location where the keys of hot row cache partitions are saved, see row_cache_save_period."  \
     )                                                   \
     /* Commonly used properties */  \
     /* Properties most frequently used when configuring Scylla. */   \
@@ -336,6 +336,9 @@ class config : public utils::config_file {
     val(column_index_size_in_kb, uint32_t, 64, Used,     \
             "Granularity of the index of rows within a partition. For huge rows, decrease this setting to improve seek time. If you use key cache, be careful not to make this setting too large because key cache will be overwhelmed. If you're unsure of the size of the rows, it's best to use the default setting."  \
     )   \
+    val(promoted_index_bsearch_threshold_in_kb, uint32_t, 4, Used,     \
+            "Indexes of rows within a partition which are at least this big are searched by bisecting the offsets of their blocks, reading only a few blocks per lookup, instead of being parsed from the beginning. Applies to SSTables in the 'mc' format."  \
+    )   \
     val(index_summary_capacity_in_mb, uint32_t, 0, Unused,     \
             "Fixed memory pool size in MB for SSTable index summaries. If the memory usage of all index summaries exceeds this limit, any SSTables with low read rates shrink their index summaries to meet this limit. This is a best-effort process. In extreme conditions, Cassandra may need to use more than this amount of memory."  \
     )   \
@@ -424,14 +427,14 @@ class config : public utils::config_file {
             "A global cache setting for tables. It is the maximum size of the key cache in memory. To disable set to 0.\n"  \
             "Related information: nodetool setcachecapacity."   \
     )   \
-    val(row_cache_keys_to_save, uint32_t, 0, Unused,                \
-            "Number of keys from the row cache to save."  \
+    val(row_cache_keys_to_save, uint32_t, 10000, Used,                \
+            "Number of keys of the most recently read partitions in the row cache to save, per shard."  \
     )   \
     val(row_cache_size_in_mb, uint32_t, 0, Unused,                \
             "Maximum size of the row cache in memory. Row cache can save more time than key_cache_size_in_mb, but is space-intensive because it contains the entire row. Use the row cache only for hot rows or static rows. If you reduce the size, you may not get you hottest keys loaded on start up."  \
     )   \
-    val(row_cache_save_period, uint32_t, 0, Unused,     \
-            "Duration in seconds that rows are saved in cache. Caches are saved to saved_caches_directory."  \
+    val(row_cache_save_period, uint32_t, 0, Used,     \
+            "Period in seconds with which the keys of hot row cache partitions are saved to saved_caches_directory, and loaded back into the cache after a restart. (0: disabled)"  \
     )   \
     val(memory_allocator, sstring, "NativeAllocator", Invalid,     \
             "The off-heap memory allocator. In addition to caches, this property affects storage engine meta data. Supported values:\n"  \
@@ -709,6 +712,7 @@ class config : public utils::config_file {
     )                                                   \
     val(enable_in_memory_data_store, bool, false, Used, "Enable in memory mode (system tables are always persisted)") \
     val(enable_cache, bool, true, Used, "Enable cache") \
+    val(row_cache_warmup_rate, uint32_t, 100, Used, "Number of saved partitions per second and shard which are read into cache after startup, see row_cache_save_period") \
     val(enable_commitlog, bool, true, Used, "Enable commitlog") \
     val(volatile_system_keyspace_for_testing, bool, false, Used, "Don't persist system keyspace - testing only!") \
     val(api_port, uint16_t, 10000, Used, "Http Rest API port") \
@@ -749,6 +753,8 @@ class config : public utils::config_file {
     val(cpu_scheduler, bool, true, Used, "Enable cpu scheduling") \
     val(view_building, bool, true, Used, "Enable view building; should only be set to false when the node is experience issues due to view building") \
     val(enable_sstables_mc_format, bool, true, Used, "Enable SSTables 'mc' format to be used as the default file format") \
+    val(enable_sstables_blocked_bloom_filter, bool, false, Used, "Write the bloom filter of new 'mc' SSTables in the cache-line blocked format, which is faster to probe but cannot be read by Cassandra or by older Scylla versions") \
+    val(enable_sstable_zone_maps, bool, false, Used, "Record the minimum and maximum value of each regular column in the Scylla component of new 'mc' SSTables, so that BYPASS CACHE scans with ALLOW FILTERING can skip SSTables which cannot match") \
     val(enable_dangerous_direct_import_of_cassandra_counters, bool, false, Used, "Only turn this option on if you want to import tables from Cassandra containing counters, and you are SURE that no counters in that table were created in a version earlier than Cassandra 2.1." \
         " It is not enough to have ever since upgraded to newer versions of Cassandra. If you EVER used a version earlier than 2.1 in the cluster where these SSTables come from, DO NOT TURN ON THIS OPTION! You will corrupt your data. You have been warned.") \
     val(enable_shard_aware_drivers, bool, true, Used, "Enable native transport drivers to use connection-per-shard for better performance") \
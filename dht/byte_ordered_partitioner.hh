@@ -50,6 +50,14 @@ class byte_ordered_partitioner final : public i_partitioner {
     virtual int tri_compare(token_view t1, token_view t2) const override {
         return compare_unsigned(t1._data, t2._data);
     }
+    virtual uint64_t token_prefix(token_view t) const override {
+        uint64_t prefix = 0;
+        auto n = std::min(t._data.size(), sizeof(prefix));
+        for (size_t i = 0; i < n; ++i) {
+            prefix |= uint64_t(uint8_t(t._data[i])) << (56 - 8 * i);
+        }
+        return prefix;
+    }
     virtual token midpoint(const token& t1, const token& t2) const;
     virtual sstring to_sstring(const dht::token& t) const override {
         if (t._kind == dht::token::kind::before_all_keys) {
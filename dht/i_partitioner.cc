@@ -127,6 +127,18 @@ int tri_compare(token_view t1, token_view t2) {
     return 0;
 }
 
+uint64_t token_prefix(token_view t) {
+    switch (t._kind) {
+    case token_kind::before_all_keys:
+        return 0;
+    case token_kind::key:
+        return global_partitioner().token_prefix(t);
+    case token_kind::after_all_keys:
+        break;
+    }
+    return std::numeric_limits<uint64_t>::max();
+}
+
 bool operator==(token_view t1, token_view t2) {
     if (t1._kind != t2._kind) {
         return false;
@@ -156,6 +156,10 @@ bool operator==(token_view t1, token_view t2);
 bool operator<(token_view t1, token_view t2);
 int tri_compare(token_view t1, token_view t2);
 
+// Returns a 64-bit value ordered like tokens are, such that
+// t1 < t2 implies token_prefix(t1) <= token_prefix(t2).
+uint64_t token_prefix(token_view t);
+
 inline bool operator!=(const token& t1, const token& t2) { return std::rel_ops::operator!=(t1, t2); }
 inline bool operator>(const token& t1, const token& t2) { return std::rel_ops::operator>(t1, t2); }
 inline bool operator<=(const token& t1, const token& t2) { return std::rel_ops::operator<=(t1, t2); }
@@ -363,6 +367,14 @@ class i_partitioner {
      * @return < 0 if if t1's _data array is less, t2's. 0 if they are equal, and > 0 otherwise. _kind comparison should be done separately.
      */
     virtual int tri_compare(token_view t1, token_view t2) const = 0;
+    /**
+     * @return a 64-bit value such that if t1's _data array is less than t2's, the value for t1
+     * is not greater than the value for t2. Ordered containers keep it inline to avoid most
+     * calls to tri_compare(). _kind should be handled separately.
+     */
+    virtual uint64_t token_prefix(token_view t) const {
+        return 0;
+    }
     /**
      * @return true if t1's _data array is equal t2's. _kind comparison should be done separately.
      */
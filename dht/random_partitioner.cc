@@ -122,6 +122,10 @@ int random_partitioner::tri_compare(token_view t1, token_view t2) const {
     }
 }
 
+uint64_t random_partitioner::token_prefix(token_view t) const {
+    return uint64_t(token_to_cppint(t) >> 64);
+}
+
 token random_partitioner::get_random_token() {
     boost::multiprecision::uint128_t i = dht::get_random_number<uint64_t>();
     i = (i << 64) + dht::get_random_number<uint64_t>();
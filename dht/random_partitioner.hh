@@ -40,6 +40,7 @@ class random_partitioner final : public i_partitioner {
     virtual data_type get_token_validator() override { return varint_type; }
     virtual bytes token_to_bytes(const token& t) const override;
     virtual int tri_compare(token_view t1, token_view t2) const override;
+    virtual uint64_t token_prefix(token_view t) const override;
     virtual token midpoint(const token& t1, const token& t2) const;
     virtual sstring to_sstring(const dht::token& t) const override;
     virtual dht::token from_sstring(const sstring& t) const override;
@@ -30,6 +30,11 @@ class specific_ranges {
     std::vector<nonwrapping_range<clustering_key_prefix>> ranges();
 };
 
+struct column_value_range {
+    uint32_t column;
+    nonwrapping_range<bytes> range;
+};
+
 class partition_slice {
     std::vector<nonwrapping_range<clustering_key_prefix>> default_row_ranges();
     utils::small_vector<uint32_t, 8> static_columns;
@@ -38,6 +43,7 @@ class partition_slice {
     std::unique_ptr<query::specific_ranges> get_specific_ranges();
     cql_serialization_format cql_format();
     uint32_t partition_row_limit() [[version 1.3]] = std::numeric_limits<uint32_t>::max();
+    std::vector<query::column_value_range> value_ranges() [[version 3.2]] = std::vector<query::column_value_range>();
 };
 
 class read_command {
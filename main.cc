@@ -65,6 +65,7 @@
 
 #include "db/view/view_update_generator.hh"
 #include "service/cache_hitrate_calculator.hh"
+#include "service/cache_saver.hh"
 #include "sstables/compaction_manager.hh"
 #include "sstables/sstables.hh"
 #include "gms/feature_service.hh"
@@ -583,6 +584,12 @@ int main(int ac, char** av) {
                 directories.insert(std::move(shard_dir));
             }
 
+            if (db.local().get_config().row_cache_save_period()) {
+                supervisor::notify("creating saved caches directory");
+                dirs.touch_and_lock(db.local().get_config().saved_caches_directory()).get();
+                directories.insert(db.local().get_config().saved_caches_directory());
+            }
+
             supervisor::notify("verifying directories");
             parallel_for_each(directories, [&db] (sstring pathname) {
                 return disk_sanity(pathname, db.local().get_config().developer_mode());
@@ -804,6 +811,12 @@ int main(int ac, char** av) {
             engine().at_exit([&cf_cache_hitrate_calculator] { return cf_cache_hitrate_calculator.stop(); });
             cf_cache_hitrate_calculator.local().run_on(engine().cpu_id());
 
+            supervisor::notify("starting row cache saver");
+            static sharded<service::cache_saver> cache_saver;
+            cache_saver.start(std::ref(db), std::ref(*cfg)).get();
+            engine().at_exit([] { return cache_saver.stop(); });
+            cache_saver.invoke_on_all(&service::cache_saver::start).get();
+
             supervisor::notify("starting view update backlog broker");
             static sharded<service::view_update_backlog_broker> view_backlog_broker;
             view_backlog_broker.start(std::ref(proxy), std::ref(gms::get_gossiper())).get();
@@ -40,7 +40,8 @@ write_memtable_to_sstable(memtable& mt,
         db::large_data_handler* lp_handler,
         bool backup = false,
         const io_priority_class& pc = default_priority_class(),
-        bool leave_unsealed = false);
+        bool leave_unsealed = false,
+        bool zone_maps = false);
 
 future<>
 write_memtable_to_sstable(memtable& mt,
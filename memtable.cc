@@ -119,8 +119,7 @@ memtable::memtable(schema_ptr schema, dirty_memory_manager& dmm, memtable_list*
         , _dirty_mgr(dmm)
         , _cleaner(*this, no_cache_tracker, compaction_scheduling_group)
         , _memtable_list(memtable_list)
-        , _schema(std::move(schema))
-        , partitions(memtable_entry::compare(_schema)) {
+        , _schema(std::move(schema)) {
 }
 
 static thread_local dirty_memory_manager mgr_for_tests;
@@ -146,6 +145,7 @@ void memtable::clear() noexcept {
             current_deleter<memtable_entry>()(e);
         });
     });
+    _partition_count = 0;
     remove_flushed_memory(dirty_before - dirty_size());
 }
 
@@ -155,6 +155,7 @@ future<> memtable::clear_gently() noexcept {
             auto& alloc = allocator();
 
             auto p = std::move(partitions);
+            _partition_count = 0;
             while (!p.empty()) {
                 auto dirty_before = dirty_size();
                 with_allocator(alloc, [&] () noexcept {
@@ -208,10 +209,11 @@ memtable::find_or_create_partition(const dht::decorated_key& key) {
     // call lower_bound so we have a hint for the insert, just in case.
     auto i = partitions.lower_bound(key, memtable_entry::compare(_schema));
     if (i == partitions.end() || !key.equal(*_schema, i->key())) {
-        memtable_entry* entry = current_allocator().construct<memtable_entry>(
-            _schema, dht::decorated_key(key), mutation_partition(_schema));
+        auto entry = alloc_strategy_unique_ptr<memtable_entry>(current_allocator().construct<memtable_entry>(
+            _schema, dht::decorated_key(key), mutation_partition(_schema)));
         partitions.insert_before(i, *entry);
-        return entry->partition();
+        ++_partition_count;
+        return entry.release()->partition();
     } else {
         upgrade_entry(*i);
     }
@@ -761,18 +763,15 @@ mutation_source memtable::as_data_source() {
 }
 
 size_t memtable::partition_count() const {
-    return partitions.size();
+    return _partition_count;
 }
 
 memtable_entry::memtable_entry(memtable_entry&& o) noexcept
-    : _link()
+    : _link(std::move(o._link))
     , _schema(std::move(o._schema))
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
 {
-    using container_type = memtable::partitions_type;
-    container_type::node_algorithms::replace_node(o._link.this_ptr(), _link.this_ptr());
-    container_type::node_algorithms::init(o._link.this_ptr());
 }
 
 stop_iteration memtable_entry::clear_gently() noexcept {
@@ -33,6 +33,7 @@
 #include "db/commitlog/rp_set.hh"
 #include "utils/extremum_tracking.hh"
 #include "utils/logalloc.hh"
+#include "utils/bptree.hh"
 #include "partition_version.hh"
 #include "flat_mutation_reader.hh"
 #include "mutation_cleaner.hh"
@@ -44,7 +45,7 @@ class frozen_mutation;
 namespace bi = boost::intrusive;
 
 class memtable_entry {
-    bi::set_member_hook<> _link;
+    bplus::member_hook _link;
     schema_ptr _schema;
     dht::decorated_key _key;
     partition_entry _pe;
@@ -85,6 +86,17 @@ class memtable_entry {
         return size;
     }
 
+    // Orders entries by token only, consistently with compare.
+    // Kept inline in the partitions tree, see bplus::tree.
+    struct token_prefix {
+        uint64_t operator()(dht::ring_position_view pos) const noexcept {
+            return dht::token_prefix(pos.token());
+        }
+        uint64_t operator()(const memtable_entry& e) const noexcept {
+            return dht::token_prefix(e._key.token());
+        }
+    };
+
     struct compare {
         dht::decorated_key::less_comparator _c;
 
@@ -121,9 +133,7 @@ class dirty_memory_manager;
 // Managed by lw_shared_ptr<>.
 class memtable final : public enable_lw_shared_from_this<memtable>, private logalloc::region {
 public:
-    using partitions_type = bi::set<memtable_entry,
-        bi::member_hook<memtable_entry, bi::set_member_hook<>, &memtable_entry::_link>,
-        bi::compare<memtable_entry::compare>>;
+    using partitions_type = bplus::tree<memtable_entry, &memtable_entry::_link, memtable_entry::token_prefix>;
 private:
     dirty_memory_manager& _dirty_mgr;
     mutation_cleaner _cleaner;
@@ -132,6 +142,8 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     logalloc::allocating_section _read_section;
     logalloc::allocating_section _allocating_section;
     partitions_type partitions;
+    // The tree doesn't keep its size.
+    size_t _partition_count = 0;
     db::replay_position _replay_position;
     db::rp_set _rp_set;
     // mutation source to which reads fall-back after mark_flushed()
@@ -260,6 +272,10 @@ class memtable final : public enable_lw_shared_from_this<memtable>, private loga
     mutation_source as_data_source();
 
     bool empty() const { return partitions.empty(); }
+    // Tells whether any partition of the memtable falls into the range.
+    bool has_partitions_in(const dht::partition_range& range) const {
+        return !slice(range).empty();
+    }
     void mark_flushed(mutation_source) noexcept;
     bool is_flushed() const;
     void on_detach_from_region_group() noexcept;
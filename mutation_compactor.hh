@@ -54,6 +54,17 @@ GCC6_CONCEPT(
     };
 )
 
+// Consumer of the garbage of a compaction which doesn't collect it.
+struct noop_compacted_fragments_consumer {
+    void consume_new_partition(const dht::decorated_key& dk) {}
+    void consume(tombstone t) {}
+    stop_iteration consume(static_row&& sr, tombstone, bool) { return stop_iteration::no; }
+    stop_iteration consume(clustering_row&& cr, row_tombstone, bool) { return stop_iteration::no; }
+    stop_iteration consume(range_tombstone&& rt) { return stop_iteration::no; }
+    stop_iteration consume_end_of_partition() { return stop_iteration::no; }
+    void consume_end_of_stream() {}
+};
+
 struct detached_compaction_state {
     ::partition_start partition_start;
     std::optional<::static_row> static_row;
@@ -82,11 +93,16 @@ class compact_mutation_state {
     uint32_t _rows_in_current_partition;
     uint32_t _current_partition_limit;
     bool _empty_partition{};
+    bool _empty_gc_partition{};
+    bool _partition_tombstone_collected{};
     const dht::decorated_key* _dk{};
     dht::decorated_key _last_dk;
     bool _has_ck_selector{};
 
     std::optional<static_row> _last_static_row;
+
+    // Tombstones, of any kind, dropped because they are past gc_before and can be garbage collected.
+    uint64_t _purged_tombstones = 0;
 private:
     static constexpr bool only_live() {
         return OnlyLive == emit_only_live_rows::yes;
@@ -94,6 +110,10 @@ class compact_mutation_state {
     static constexpr bool sstable_compaction() {
         return SSTableCompaction == compact_for_sstables::yes;
     }
+    template <typename GCConsumer>
+    static constexpr bool collects_garbage() {
+        return !std::is_same<GCConsumer, noop_compacted_fragments_consumer>::value;
+    }
 
     template <typename Consumer>
     void partition_is_not_empty(Consumer& consumer) {
@@ -101,12 +121,20 @@ class compact_mutation_state {
             _empty_partition = false;
             consumer.consume_new_partition(*_dk);
             auto pt = _range_tombstones.get_partition_tombstone();
-            if (pt && !can_purge_tombstone(pt)) {
+            if (pt && !can_purge_tombstone(pt) && !_partition_tombstone_collected) {
                 consumer.consume(pt);
             }
         }
     }
 
+    template <typename GCConsumer>
+    void gc_partition_is_not_empty(GCConsumer& gc_consumer) {
+        if (_empty_gc_partition) {
+            _empty_gc_partition = false;
+            gc_consumer.consume_new_partition(*_dk);
+        }
+    }
+
     bool can_purge_tombstone(const tombstone& t) {
         return t.deletion_time < _gc_before && can_gc(t);
     };
@@ -115,6 +143,12 @@ class compact_mutation_state {
         return t.max_deletion_time() < _gc_before && can_gc(t.tomb());
     };
 
+    // Tombstone past gc_before which can't be purged only because it may shadow data
+    // in sstables that aren't being compacted. The garbage consumer gets it instead.
+    bool is_garbage(tombstone t, gc_clock::time_point deletion_time) {
+        return t && deletion_time < _gc_before && !can_gc(t);
+    }
+
     bool can_gc(tombstone t) {
         if (!sstable_compaction()) {
             return true;
@@ -158,7 +192,12 @@ class compact_mutation_state {
         , _query_time(compaction_time)
         , _gc_before(saturating_subtract(_query_time, s.gc_grace_seconds()))
         , _get_max_purgeable(std::move(get_max_purgeable))
-        , _can_gc([this] (tombstone t) { return can_gc(t); })
+        , _can_gc([this] (tombstone t) {
+            // Only asked about dead cells and row markers past gc_before, which are dropped if it returns true.
+            bool purge = can_gc(t);
+            _purged_tombstones += purge;
+            return purge;
+        })
         , _slice(s.full_slice())
         , _range_tombstones(s, false)
         , _last_dk({dht::token(), partition_key::make_empty()})
@@ -172,6 +211,8 @@ class compact_mutation_state {
         _dk = &dk;
         _has_ck_selector = has_ck_selector(_slice.row_ranges(_schema, pk));
         _empty_partition = true;
+        _empty_gc_partition = true;
+        _partition_tombstone_collected = false;
         _rows_in_current_partition = 0;
         _static_row_live = false;
         _range_tombstones.clear();
@@ -185,9 +226,26 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     void consume(tombstone t, Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        consume(t, consumer, gc_consumer);
+    }
+
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    void consume(tombstone t, Consumer& consumer, GCConsumer& gc_consumer) {
         _range_tombstones.set_partition_tombstone(t);
-        if (!only_live() && !can_purge_tombstone(t)) {
-            partition_is_not_empty(consumer);
+        if (!only_live()) {
+            if (collects_garbage<GCConsumer>() && is_garbage(t, t.deletion_time)) {
+                _partition_tombstone_collected = true;
+                gc_partition_is_not_empty(gc_consumer);
+                gc_consumer.consume(t);
+            } else if (!can_purge_tombstone(t)) {
+                partition_is_not_empty(consumer);
+            } else if (t) {
+                ++_purged_tombstones;
+            }
         }
     }
 
@@ -196,6 +254,16 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     stop_iteration consume(static_row&& sr, Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        return consume(std::move(sr), consumer, gc_consumer);
+    }
+
+    // Static rows carry no tombstone of their own, so they don't produce any garbage.
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    stop_iteration consume(static_row&& sr, Consumer& consumer, GCConsumer&) {
         _last_static_row = static_row(_schema, sr);
         auto current_tombstone = _range_tombstones.get_partition_tombstone();
         bool is_live = sr.cells().compact_and_expire(_schema, column_kind::static_column,
@@ -214,9 +282,25 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     stop_iteration consume(clustering_row&& cr, Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        return consume(std::move(cr), consumer, gc_consumer);
+    }
+
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    stop_iteration consume(clustering_row&& cr, Consumer& consumer, GCConsumer& gc_consumer) {
         auto current_tombstone = _range_tombstones.tombstone_for_row(cr.key());
         auto t = cr.tomb();
-        if (t.tomb() <= current_tombstone || can_purge_tombstone(t)) {
+        if (t.tomb() <= current_tombstone) {
+            cr.remove_tombstone();
+        } else if (can_purge_tombstone(t)) {
+            cr.remove_tombstone();
+            ++_purged_tombstones;
+        } else if (collects_garbage<GCConsumer>() && is_garbage(t.tomb(), t.max_deletion_time())) {
+            gc_partition_is_not_empty(gc_consumer);
+            gc_consumer.consume(clustering_row(cr.key(), t, row_marker(), row()), t, false);
             cr.remove_tombstone();
         }
         t.apply(current_tombstone);
@@ -248,9 +332,25 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     stop_iteration consume(range_tombstone&& rt, Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        return consume(std::move(rt), consumer, gc_consumer);
+    }
+
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    stop_iteration consume(range_tombstone&& rt, Consumer& consumer, GCConsumer& gc_consumer) {
         _range_tombstones.apply(rt);
         // FIXME: drop tombstone if it is fully covered by other range tombstones
-        if (!can_purge_tombstone(rt.tomb) && rt.tomb > _range_tombstones.get_partition_tombstone()) {
+        if (can_purge_tombstone(rt.tomb)) {
+            ++_purged_tombstones;
+        } else if (rt.tomb > _range_tombstones.get_partition_tombstone()) {
+            if (collects_garbage<GCConsumer>() && is_garbage(rt.tomb, rt.tomb.deletion_time)) {
+                gc_partition_is_not_empty(gc_consumer);
+                gc_consumer.consume(std::move(rt));
+                return stop_iteration::no;
+            }
             partition_is_not_empty(consumer);
             return consumer.consume(std::move(rt));
         }
@@ -262,6 +362,20 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     stop_iteration consume_end_of_partition(Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        return consume_end_of_partition(consumer, gc_consumer);
+    }
+
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    stop_iteration consume_end_of_partition(Consumer& consumer, GCConsumer& gc_consumer) {
+        // The garbage of a partition is complete before the partition is, so it's safe
+        // for the consumer to act on both once the latter is done.
+        if (!_empty_gc_partition) {
+            gc_consumer.consume_end_of_partition();
+        }
         if (!_empty_partition) {
             // #589 - Do not add extra row for statics unless we did a CK range-less query.
             // See comment in query
@@ -285,13 +399,27 @@ class compact_mutation_state {
         requires CompactedFragmentsConsumer<Consumer>
     )
     auto consume_end_of_stream(Consumer& consumer) {
+        noop_compacted_fragments_consumer gc_consumer;
+        return consume_end_of_stream(consumer, gc_consumer);
+    }
+
+    template <typename Consumer, typename GCConsumer>
+    GCC6_CONCEPT(
+        requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
+    )
+    auto consume_end_of_stream(Consumer& consumer, GCConsumer& gc_consumer) {
         if (_dk) {
             _last_dk = *_dk;
             _dk = &_last_dk;
         }
+        gc_consumer.consume_end_of_stream();
         return consumer.consume_end_of_stream();
     }
 
+    uint64_t purged_tombstones() const {
+        return _purged_tombstones;
+    }
+
     /// The decorated key of the partition the compaction is positioned in.
     /// Can be null if the compaction wasn't started yet.
     const dht::decorated_key* current_partition() const {
@@ -343,13 +471,18 @@ class compact_mutation_state {
     }
 };
 
-template<emit_only_live_rows OnlyLive, compact_for_sstables SSTableCompaction, typename Consumer>
+// GCConsumer receives the garbage of the compaction: tombstones past gc_before which
+// can't be purged yet because they may shadow data in sstables that aren't compacted.
+// With noop_compacted_fragments_consumer, the default, those stay in the output.
+template<emit_only_live_rows OnlyLive, compact_for_sstables SSTableCompaction, typename Consumer,
+        typename GCConsumer = noop_compacted_fragments_consumer>
 GCC6_CONCEPT(
-    requires CompactedFragmentsConsumer<Consumer>
+    requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
 )
 class compact_mutation {
     lw_shared_ptr<compact_mutation_state<OnlyLive, SSTableCompaction>> _state;
     Consumer _consumer;
+    GCConsumer _gc_consumer;
 
 public:
     compact_mutation(const schema& s, gc_clock::time_point query_time, const query::partition_slice& slice, uint32_t limit,
@@ -364,9 +497,11 @@ class compact_mutation {
         , _consumer(std::move(consumer)) {
     }
 
-    compact_mutation(lw_shared_ptr<compact_mutation_state<OnlyLive, SSTableCompaction>> state, Consumer consumer)
+    compact_mutation(lw_shared_ptr<compact_mutation_state<OnlyLive, SSTableCompaction>> state, Consumer consumer,
+                     GCConsumer gc_consumer = GCConsumer())
         : _state(std::move(state))
-        , _consumer(std::move(consumer)) {
+        , _consumer(std::move(consumer))
+        , _gc_consumer(std::move(gc_consumer)) {
     }
 
     void consume_new_partition(const dht::decorated_key& dk) {
@@ -374,27 +509,27 @@ class compact_mutation {
     }
 
     void consume(tombstone t) {
-        _state->consume(std::move(t), _consumer);
+        _state->consume(std::move(t), _consumer, _gc_consumer);
     }
 
     stop_iteration consume(static_row&& sr) {
-        return _state->consume(std::move(sr), _consumer);
+        return _state->consume(std::move(sr), _consumer, _gc_consumer);
     }
 
     stop_iteration consume(clustering_row&& cr) {
-        return _state->consume(std::move(cr), _consumer);
+        return _state->consume(std::move(cr), _consumer, _gc_consumer);
     }
 
     stop_iteration consume(range_tombstone&& rt) {
-        return _state->consume(std::move(rt), _consumer);
+        return _state->consume(std::move(rt), _consumer, _gc_consumer);
     }
 
     stop_iteration consume_end_of_partition() {
-        return _state->consume_end_of_partition(_consumer);
+        return _state->consume_end_of_partition(_consumer, _gc_consumer);
     }
 
     auto consume_end_of_stream() {
-        return _state->consume_end_of_stream(_consumer);
+        return _state->consume_end_of_stream(_consumer, _gc_consumer);
     }
 };
 
@@ -411,10 +546,12 @@ using compact_for_query_state = compact_mutation_state<OnlyLive, compact_for_sst
 using compact_for_mutation_query_state = compact_for_query_state<emit_only_live_rows::no>;
 using compact_for_data_query_state = compact_for_query_state<emit_only_live_rows::yes>;
 
-template<typename Consumer>
+template<typename Consumer, typename GCConsumer = noop_compacted_fragments_consumer>
 GCC6_CONCEPT(
-    requires CompactedFragmentsConsumer<Consumer>
+    requires CompactedFragmentsConsumer<Consumer> && CompactedFragmentsConsumer<GCConsumer>
 )
-struct compact_for_compaction : compact_mutation<emit_only_live_rows::no, compact_for_sstables::yes, Consumer> {
-    using compact_mutation<emit_only_live_rows::no, compact_for_sstables::yes, Consumer>::compact_mutation;
+struct compact_for_compaction : compact_mutation<emit_only_live_rows::no, compact_for_sstables::yes, Consumer, GCConsumer> {
+    using compact_mutation<emit_only_live_rows::no, compact_for_sstables::yes, Consumer, GCConsumer>::compact_mutation;
 };
+
+using compact_for_compaction_state = compact_mutation_state<emit_only_live_rows::no, compact_for_sstables::yes>;
@@ -32,7 +32,6 @@
 #include "mutation_query.hh"
 #include "service/priority_manager.hh"
 #include "mutation_compactor.hh"
-#include "intrusive_set_external_comparator.hh"
 #include "counters.hh"
 #include "row_cache.hh"
 #include "view_info.hh"
@@ -162,7 +161,9 @@ mutation_partition::mutation_partition(const mutation_partition& x, const schema
     try {
         for(auto&& r : ck_ranges) {
             for (const rows_entry& e : x.range(schema, r)) {
-                _rows.insert(_rows.end(), *current_allocator().construct<rows_entry>(schema, e), rows_entry::compare(schema));
+                auto ce = alloc_strategy_unique_ptr<rows_entry>(current_allocator().construct<rows_entry>(schema, e));
+                _rows.insert(_rows.end(), *ce, rows_entry::compare(schema));
+                ce.release();
             }
             for (auto&& rt : x._row_tombstones.slice(schema, r)) {
                 _row_tombstones.apply(schema, rt);
@@ -222,8 +223,10 @@ mutation_partition::operator=(mutation_partition&& x) noexcept {
 
 void mutation_partition::ensure_last_dummy(const schema& s) {
     if (_rows.empty() || !_rows.rbegin()->is_last_dummy()) {
-        _rows.insert_before(_rows.end(),
-            *current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::yes));
+        auto e = alloc_strategy_unique_ptr<rows_entry>(
+            current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::yes));
+        _rows.insert_before(_rows.end(), *e);
+        e.release();
     }
 }
 
@@ -301,8 +304,10 @@ stop_iteration mutation_partition::apply_monotonically(const schema& s, mutation
             i = _rows.lower_bound(src_e, less);
         }
         if (i == _rows.end() || less(src_e, *i)) {
+            // Allocate before unlinking src_e, so that it cannot get lost.
+            auto spare = _rows.reserve_for_insert_before(i);
             p_i = p._rows.erase(p_i);
-            auto src_i = _rows.insert_before(i, src_e);
+            auto src_i = _rows.insert_before(i, src_e, spare);
             // When falling into a continuous range, preserve continuity.
             if (i != _rows.end() && i->continuous()) {
                 src_e.set_continuous(true);
@@ -478,7 +483,7 @@ void mutation_partition::apply_insert(const schema& s, clustering_key_view key,
 }
 void mutation_partition::insert_row(const schema& s, const clustering_key& key, deletable_row&& row) {
     auto e = alloc_strategy_unique_ptr<rows_entry>(
-        current_allocator().construct<rows_entry>(key, std::move(row)));
+        current_allocator().construct<rows_entry>(s, key, std::move(row)));
     _rows.insert(_rows.end(), *e, rows_entry::compare(s));
     e.release();
 }
@@ -504,7 +509,7 @@ mutation_partition::clustered_row(const schema& s, clustering_key&& key) {
     auto i = _rows.find(key, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(std::move(key)));
+            current_allocator().construct<rows_entry>(s, std::move(key)));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -516,7 +521,7 @@ mutation_partition::clustered_row(const schema& s, const clustering_key& key) {
     auto i = _rows.find(key, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(key));
+            current_allocator().construct<rows_entry>(s, key));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -528,7 +533,7 @@ mutation_partition::clustered_row(const schema& s, clustering_key_view key) {
     auto i = _rows.find(key, rows_entry::compare(s));
     if (i == _rows.end()) {
         auto e = alloc_strategy_unique_ptr<rows_entry>(
-            current_allocator().construct<rows_entry>(key));
+            current_allocator().construct<rows_entry>(s, key));
         i = _rows.insert(i, *e, rows_entry::compare(s));
         e.release();
     }
@@ -1246,6 +1251,7 @@ size_t mutation_partition::external_memory_usage(const schema& s) const {
     for (auto& clr : clustered_rows()) {
         sum += clr.memory_usage(s);
     }
+    sum += _rows.external_memory_usage();
 
     for (auto& rtb : row_tombstones()) {
         sum += rtb.memory_usage(s);
@@ -1428,6 +1434,14 @@ mutation_partition::live_row_count(const schema& s, gc_clock::time_point query_t
     return count;
 }
 
+bool rows_entry::has_key_prefix(const schema& s) {
+    if (!s.clustering_key_size()) {
+        return false;
+    }
+    auto& type = s.clustering_key_columns().begin()->type;
+    return !type->is_reversed() && type->is_byte_order_comparable();
+}
+
 rows_entry::rows_entry(rows_entry&& o) noexcept
     : _link(std::move(o._link))
     , _key(std::move(o._key))
@@ -2201,8 +2215,10 @@ mutation_partition::mutation_partition(mutation_partition::incomplete_tag, const
     , _rows()
     , _row_tombstones(s)
 {
-    _rows.insert_before(_rows.end(),
-        *current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::no));
+    auto e = alloc_strategy_unique_ptr<rows_entry>(
+        current_allocator().construct<rows_entry>(s, rows_entry::last_dummy_tag(), is_continuous::no));
+    _rows.insert_before(_rows.end(), *e);
+    e.release();
 }
 
 bool mutation_partition::is_fully_continuous() const {
@@ -2239,13 +2255,18 @@ void mutation_partition::set_continuity(const schema& s, const position_range& p
 
     auto end = _rows.lower_bound(pr.end(), less);
     if (end == _rows.end() || less(pr.end(), end->position())) {
-        end = _rows.insert_before(end, *current_allocator().construct<rows_entry>(s, pr.end(), is_dummy::yes,
+        auto e = alloc_strategy_unique_ptr<rows_entry>(current_allocator().construct<rows_entry>(s, pr.end(), is_dummy::yes,
             end == _rows.end() ? is_continuous::yes : end->continuous()));
+        end = _rows.insert_before(end, *e);
+        e.release();
     }
 
     auto i = _rows.lower_bound(pr.start(), less);
     if (less(pr.start(), i->position())) {
-        i = _rows.insert_before(i, *current_allocator().construct<rows_entry>(s, pr.start(), is_dummy::yes, i->continuous()));
+        auto e = alloc_strategy_unique_ptr<rows_entry>(
+            current_allocator().construct<rows_entry>(s, pr.start(), is_dummy::yes, i->continuous()));
+        i = _rows.insert_before(i, *e);
+        e.release();
     }
 
     assert(i != end);
@@ -44,7 +44,7 @@
 #include "hashing_partition_visitor.hh"
 #include "range_tombstone_list.hh"
 #include "clustering_key_filter.hh"
-#include "intrusive_set_external_comparator.hh"
+#include "utils/bptree.hh"
 #include "utils/with_relational_operators.hh"
 #include "utils/preempt.hh"
 
@@ -736,7 +736,7 @@ class rows_entry {
     using lru_link_type = bi::list_member_hook<bi::link_mode<bi::auto_unlink>>;
     friend class cache_tracker;
     friend class size_calculator;
-    intrusive_set_external_comparator_member_hook _link;
+    bplus::member_hook _link;
     clustering_key _key;
     deletable_row _row;
     lru_link_type _lru_link;
@@ -749,17 +749,68 @@ class rows_entry {
         // Marks a dummy entry which is after_all_clustered_rows() position.
         // Needed so that eviction, which can't use comparators, can check if it's dealing with it.
         bool _last_dummy : 1;
-        flags() : _before_ck(0), _after_ck(0), _continuous(true), _dummy(false), _last_dummy(false) { }
+        // The schema orders rows by key_prefix(), see has_key_prefix().
+        bool _prefixed : 1;
+        flags() : _before_ck(0), _after_ck(0), _continuous(true), _dummy(false), _last_dummy(false), _prefixed(false) { }
     } _flags{};
     friend class mutation_partition;
+
+    // Marks a position in the LRU of cache_tracker, see cache_tracker::for_each_recently_used_partition().
+    // It belongs to no partition.
+    struct lru_marker_tag {};
+    explicit rows_entry(lru_marker_tag)
+        : _key(clustering_key::make_empty())
+    {
+        _flags._dummy = true;
+    }
+
+    // Components of a clustering key are serialized one after another, each
+    // preceded by its 16-bit length.
+    template<typename Bytes>
+    static uint64_t first_component_prefix(const Bytes& b, bool after_all) noexcept {
+        if (b.size() < sizeof(uint16_t)) {
+            // No components, so before or after all clustered rows.
+            return after_all ? std::numeric_limits<uint64_t>::max() : 0;
+        }
+        size_t len = (size_t(uint8_t(b[0])) << 8) | uint8_t(b[1]);
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < sizeof(prefix); ++i) {
+            prefix = (prefix << 8) | (i < len ? uint8_t(b[sizeof(uint16_t) + i]) : 0);
+        }
+        return prefix;
+    }
 public:
+    // Whether rows of a table are ordered by key_prefix(), which is the case when the first
+    // clustering column compares byte-wise.
+    static bool has_key_prefix(const schema& s);
+
+    // The first 8 bytes of the first clustering key component, zero-padded. If the schema
+    // has_key_prefix(), then key_prefix(a) < key_prefix(b) implies a < b, so that comparing
+    // prefixes is enough to order most rows without looking at their keys.
+    static uint64_t key_prefix(position_in_partition_view pos) noexcept {
+        if (!pos.has_clustering_key()) {
+            return pos.is_partition_end() ? std::numeric_limits<uint64_t>::max() : 0;
+        }
+        return first_component_prefix(pos.key().representation(), pos.is_after_key());
+    }
+    static uint64_t key_prefix(const clustering_key_view& key) noexcept {
+        return first_component_prefix(key.representation(), false);
+    }
+    uint64_t key_prefix() const noexcept {
+        return _flags._prefixed ? key_prefix(position()) : 0;
+    }
+
     struct last_dummy_tag {};
-    explicit rows_entry(clustering_key&& key)
+    rows_entry(const schema& s, clustering_key&& key)
         : _key(std::move(key))
-    { }
-    explicit rows_entry(const clustering_key& key)
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
+    rows_entry(const schema& s, const clustering_key& key)
         : _key(key)
-    { }
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
     rows_entry(const schema& s, position_in_partition_view pos, is_dummy dummy, is_continuous continuous)
         : _key(pos.key())
     {
@@ -768,25 +819,34 @@ class rows_entry {
         _flags._continuous = bool(continuous);
         _flags._before_ck = pos.is_before_key();
         _flags._after_ck = pos.is_after_key();
+        _flags._prefixed = has_key_prefix(s);
     }
     rows_entry(const schema& s, last_dummy_tag, is_continuous continuous)
         : rows_entry(s, position_in_partition_view::after_all_clustered_rows(), is_dummy::yes, continuous)
     { }
-    rows_entry(const clustering_key& key, deletable_row&& row)
+    rows_entry(const schema& s, const clustering_key& key, deletable_row&& row)
         : _key(key), _row(std::move(row))
-    { }
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
     rows_entry(const schema& s, const clustering_key& key, const deletable_row& row)
         : _key(key), _row(s, row)
-    { }
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
     rows_entry(const schema& s, const clustering_key& key, row_tombstone tomb, const row_marker& marker, const row& row)
         : _key(key), _row(s, tomb, marker, row)
-    { }
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
     rows_entry(rows_entry&& o) noexcept;
     rows_entry(const schema& s, const rows_entry& e)
         : _key(e._key)
         , _row(s, e._row)
         , _flags(e._flags)
-    { }
+    {
+        _flags._prefixed = has_key_prefix(s);
+    }
     // Valid only if !dummy()
     clustering_key& key() {
         return _key;
@@ -845,7 +905,21 @@ class rows_entry {
     };
     struct compare {
         tri_compare _c;
-        explicit compare(const schema& s) : _c(s) {}
+        bool _prefixed;
+        explicit compare(const schema& s) : _c(s), _prefixed(has_key_prefix(s)) {}
+        // Prefix of a lookup key, ordered like the key_prefix() of rows of this schema.
+        uint64_t key_prefix(const rows_entry& e) const noexcept {
+            return e.key_prefix();
+        }
+        uint64_t key_prefix(const clustering_key& key) const noexcept {
+            return key_prefix(position_in_partition_view::for_key(key));
+        }
+        uint64_t key_prefix(const clustering_key_view& key) const noexcept {
+            return _prefixed ? rows_entry::key_prefix(key) : 0;
+        }
+        uint64_t key_prefix(position_in_partition_view p) const noexcept {
+            return _prefixed ? rows_entry::key_prefix(p) : 0;
+        }
         bool operator()(const rows_entry& e1, const rows_entry& e2) const {
             return _c(e1, e2) < 0;
         }
@@ -871,6 +945,17 @@ class rows_entry {
             return _c(p1, p2) < 0;
         }
     };
+    // Keeps key prefixes in the nodes of the rows container. Lookup keys are given theirs by
+    // the comparator, which knows whether the schema has_key_prefix().
+    struct key_prefix_of {
+        uint64_t operator()(const rows_entry& e) const noexcept {
+            return e.key_prefix();
+        }
+        template<typename Key>
+        uint64_t operator()(const Key& key, const compare& c) const noexcept {
+            return c.key_prefix(key);
+        }
+    };
     bool equal(const schema& s, const rows_entry& other) const;
     bool equal(const schema& s, const rows_entry& other, const schema& other_schema) const;
 
@@ -929,7 +1014,7 @@ class rows_entry {
 // in the doc in partition_version.hh.
 class mutation_partition final {
 public:
-    using rows_type = intrusive_set_external_comparator<rows_entry, &rows_entry::_link>;
+    using rows_type = bplus::tree<rows_entry, &rows_entry::_link, rows_entry::key_prefix_of>;
     friend class rows_entry;
     friend class size_calculator;
 private:
@@ -43,13 +43,14 @@ class partition_builder final : public mutation_partition_visitor {
     }
 
     virtual void accept_static_cell(column_id id, atomic_cell_view cell) override {
-        auto& cdef = _schema.static_column_at(id);
-        accept_static_cell(id, atomic_cell(*cdef.type, cell));
+        row& r = _partition.static_row();
+        r.append_cell(id, atomic_cell_or_collection(*_schema.static_column_at(id).type, cell));
     }
 
+    // Small cells are stored inline, like copies of cells are.
     void accept_static_cell(column_id id, atomic_cell&& cell) {
         row& r = _partition.static_row();
-        r.append_cell(id, atomic_cell_or_collection(std::move(cell)));
+        r.append_cell(id, atomic_cell_or_collection::from_atomic_cell(*_schema.static_column_at(id).type, std::move(cell)));
     }
 
     virtual void accept_static_cell(column_id id, collection_mutation_view collection) override {
@@ -70,13 +71,13 @@ class partition_builder final : public mutation_partition_visitor {
     }
 
     virtual void accept_row_cell(column_id id, atomic_cell_view cell) override {
-        auto& cdef = _schema.regular_column_at(id);
-        accept_row_cell(id, atomic_cell(*cdef.type, cell));
+        row& r = _current_row->cells();
+        r.append_cell(id, atomic_cell_or_collection(*_schema.regular_column_at(id).type, cell));
     }
 
     void accept_row_cell(column_id id, atomic_cell&& cell) {
         row& r = _current_row->cells();
-        r.append_cell(id, atomic_cell_or_collection(std::move(cell)));
+        r.append_cell(id, atomic_cell_or_collection::from_atomic_cell(*_schema.regular_column_at(id).type, std::move(cell)));
     }
 
     virtual void accept_row_cell(column_id id, collection_mutation_view collection) override {
@@ -106,6 +106,20 @@ class specific_ranges {
 
 constexpr auto max_rows = std::numeric_limits<uint32_t>::max();
 
+// Range of values which a regular column must fall into for a row to be
+// selected. Carried by filtering queries, whose coordinator drops rows
+// failing the restriction, so that replicas may skip data which cannot match.
+// The range never contains the empty value, so rows missing the column
+// cannot match either.
+struct column_value_range {
+    column_id column;
+    nonwrapping_range<bytes> range;
+};
+
+std::ostream& operator<<(std::ostream& out, const column_value_range& r);
+
+using column_value_ranges = std::vector<column_value_range>;
+
 // Specifies subset of rows, columns and cell attributes to be returned in a query.
 // Can be accessed across cores.
 // Schema-dependent.
@@ -134,12 +148,14 @@ class partition_slice {
     std::unique_ptr<specific_ranges> _specific_ranges;
     cql_serialization_format _cql_format;
     uint32_t _partition_row_limit;
+    column_value_ranges _value_ranges;
 public:
     partition_slice(clustering_row_ranges row_ranges, column_id_vector static_columns,
         column_id_vector regular_columns, option_set options,
         std::unique_ptr<specific_ranges> specific_ranges = nullptr,
         cql_serialization_format = cql_serialization_format::internal(),
-        uint32_t partition_row_limit = max_rows);
+        uint32_t partition_row_limit = max_rows,
+        column_value_ranges value_ranges = {});
     partition_slice(const partition_slice&);
     partition_slice(partition_slice&&);
     ~partition_slice();
@@ -170,6 +186,12 @@ class partition_slice {
     void set_partition_row_limit(uint32_t limit) {
         _partition_row_limit = limit;
     }
+    const column_value_ranges& value_ranges() const {
+        return _value_ranges;
+    }
+    void set_value_ranges(column_value_ranges ranges) {
+        _value_ranges = std::move(ranges);
+    }
 
     friend std::ostream& operator<<(std::ostream& out, const partition_slice& ps);
     friend std::ostream& operator<<(std::ostream& out, const specific_ranges& ps);
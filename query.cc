@@ -54,9 +54,16 @@ std::ostream& operator<<(std::ostream& out, const partition_slice& ps) {
     out << ", options=" << format("{:x}", ps.options.mask()); // FIXME: pretty print options
     out << ", cql_format=" << ps.cql_format();
     out << ", partition_row_limit=" << ps._partition_row_limit;
+    if (!ps._value_ranges.empty()) {
+        out << ", value_ranges=[" << join(", ", ps._value_ranges) << "]";
+    }
     return out << "}";
 }
 
+std::ostream& operator<<(std::ostream& out, const column_value_range& r) {
+    return out << "{column=" << r.column << ", range=" << r.range << "}";
+}
+
 std::ostream& operator<<(std::ostream& out, const read_command& r) {
     return out << "read_command{"
         << "cf_id=" << r.cf_id
@@ -105,7 +112,8 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     option_set options,
     std::unique_ptr<specific_ranges> specific_ranges,
     cql_serialization_format cql_format,
-    uint32_t partition_row_limit)
+    uint32_t partition_row_limit,
+    column_value_ranges value_ranges)
     : _row_ranges(std::move(row_ranges))
     , static_columns(std::move(static_columns))
     , regular_columns(std::move(regular_columns))
@@ -113,6 +121,7 @@ partition_slice::partition_slice(clustering_row_ranges row_ranges,
     , _specific_ranges(std::move(specific_ranges))
     , _cql_format(std::move(cql_format))
     , _partition_row_limit(partition_row_limit)
+    , _value_ranges(std::move(value_ranges))
 {}
 
 partition_slice::partition_slice(partition_slice&&) = default;
@@ -129,6 +138,7 @@ partition_slice::partition_slice(const partition_slice& s)
     , _specific_ranges(s._specific_ranges ? std::make_unique<specific_ranges>(*s._specific_ranges) : nullptr)
     , _cql_format(s._cql_format)
     , _partition_row_limit(s._partition_row_limit)
+    , _value_ranges(s._value_ranges)
 {}
 
 partition_slice::~partition_slice()
@@ -1396,7 +1396,7 @@ static int do_repair_start(seastar::sharded<database>& db, sstring keyspace,
         repair_results.push_back(std::move(f));
     }
 
-    when_all(repair_results.begin(), repair_results.end()).then([id, fail = std::move(fail)] (std::vector<future<>> results) mutable {
+    when_all(repair_results.begin(), repair_results.end()).then([&db, id, keyspace, cfs, fail = std::move(fail)] (std::vector<future<>> results) mutable {
         if (std::any_of(results.begin(), results.end(), [] (auto&& f) { return f.failed(); })) {
             rlogger.info("repair {} failed", id);
         } else {
@@ -1407,7 +1407,16 @@ static int do_repair_start(seastar::sharded<database>& db, sstring keyspace,
         for (auto& f : results) {
             f.ignore_ready_future();
         }
-        return make_ready_future<>();
+        // Whatever was written, even by a failed repair, is reshaped in one go per table.
+        return do_with(std::move(cfs), [&db, keyspace] (std::vector<sstring>& cfs) {
+            return parallel_for_each(cfs, [&db, keyspace] (const sstring& cf) {
+                try {
+                    return repair_trigger_offstrategy_compaction(db, db.local().find_uuid(keyspace, cf));
+                } catch (no_such_column_family&) {
+                    return make_ready_future<>();
+                }
+            });
+        });
     }).handle_exception([id] (std::exception_ptr eptr) {
          rlogger.info("repair {} failed: {}", id, eptr);
     });
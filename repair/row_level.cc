@@ -20,6 +20,7 @@
  */
 
 #include "repair/repair.hh"
+#include "repair/row_level.hh"
 #include "message/messaging_service.hh"
 #include "sstables/sstables.hh"
 #include "mutation_fragment.hh"
@@ -42,6 +43,7 @@
 #include <random>
 #include <optional>
 #include <boost/range/adaptors.hpp>
+#include <boost/algorithm/cxx11/any_of.hpp>
 #include "../db/view/view_update_generator.hh"
 
 extern logging::logger rlogger;
@@ -338,6 +340,9 @@ class repair_writer {
     schema_ptr _schema;
     uint64_t _estimated_partitions;
     size_t _nr_peer_nodes;
+    // Rows written by repair are in sync with the peers they were exchanged with, so the
+    // sstables holding them are marked as repaired as of the start of the repair.
+    uint64_t _repaired_at;
     // Needs more than one for repair master
     std::vector<std::optional<future<uint64_t>>> _writer_done;
     std::vector<std::optional<seastar::queue<mutation_fragment_opt>>> _mq;
@@ -350,7 +355,8 @@ class repair_writer {
             size_t nr_peer_nodes)
             : _schema(std::move(schema))
             , _estimated_partitions(estimated_partitions)
-            , _nr_peer_nodes(nr_peer_nodes) {
+            , _nr_peer_nodes(nr_peer_nodes)
+            , _repaired_at(std::chrono::duration_cast<std::chrono::milliseconds>(db_clock::now().time_since_epoch()).count()) {
         init_writer();
     }
 
@@ -384,10 +390,11 @@ class repair_writer {
         table& t = db.local().find_column_family(_schema->id());
         _writer_done[node_idx] = distribute_reader_and_consume_on_shards(_schema, dht::global_partitioner(),
                 make_generating_reader(_schema, std::move(get_next_mutation_fragment)),
-                [&db, estimated_partitions = this->_estimated_partitions] (flat_mutation_reader reader) {
+                [&db, estimated_partitions = this->_estimated_partitions, repaired_at = _repaired_at] (flat_mutation_reader reader) {
             auto& t = db.local().find_column_family(reader.schema());
-            return db::view::check_needs_view_update_path(_sys_dist_ks->local(), t, streaming::stream_reason::repair).then([t = t.shared_from_this(), estimated_partitions, reader = std::move(reader)] (bool use_view_update_path) mutable {
+            return db::view::check_needs_view_update_path(_sys_dist_ks->local(), t, streaming::stream_reason::repair).then([t = t.shared_from_this(), estimated_partitions, repaired_at, reader = std::move(reader)] (bool use_view_update_path) mutable {
                 sstables::shared_sstable sst = use_view_update_path ? t->make_streaming_staging_sstable() : t->make_streaming_sstable_for_write();
+                sst->get_metadata_collector().set_repaired_at(repaired_at);
                 schema_ptr s = reader.schema();
                 sstables::sstable_writer_config sst_cfg;
                 sst_cfg.large_data_handler = t->get_large_data_handler();
@@ -395,7 +402,9 @@ class repair_writer {
                 return sst->write_components(std::move(reader), std::max(1ul, estimated_partitions), s, sst_cfg, {}, pc).then([sst] {
                     return sst->open_data();
                 }).then([t, sst] {
-                    return t->add_sstable_and_update_cache(sst);
+                    // reshaped by off-strategy compaction once the repair of the table is done, see
+                    // repair_trigger_offstrategy_compaction().
+                    return t->add_maintenance_sstable_and_update_cache(sst);
                 }).then([t, s, sst, use_view_update_path]() mutable -> future<> {
                     if (!use_view_update_path) {
                         return make_ready_future<>();
@@ -1070,6 +1079,16 @@ class repair_meta {
         auto rm = get_repair_meta(from, repair_meta_id);
         return rm->wait_for_writer_done().then([rm, from, repair_meta_id, ks_name, cf_name, range] () mutable {
             remove_repair_meta(from, repair_meta_id, std::move(ks_name), std::move(cf_name), std::move(range));
+            // A follower isn't told when the repair of the table is over, so it reshapes what was
+            // written once no repair of the table is left in progress on this shard.
+            auto table_id = rm->_cf.schema()->id();
+            auto in_progress = boost::algorithm::any_of(repair_meta_map() | boost::adaptors::map_values, [&table_id] (auto& other) {
+                return other->_cf.schema()->id() == table_id;
+            });
+            if (in_progress) {
+                return make_ready_future<>();
+            }
+            return repair_trigger_offstrategy_compaction(rm->_db, table_id);
         });
     }
 
@@ -1627,3 +1646,14 @@ future<> repair_cf_range_row_level(repair_info& ri,
         return repair.run();
     });
 }
+
+future<> repair_trigger_offstrategy_compaction(seastar::sharded<database>& db, utils::UUID table_id) {
+    // Rows are written to the shards owning them, whichever shard repaired them.
+    return db.invoke_on_all([table_id] (database& localdb) {
+        try {
+            localdb.find_column_family(table_id).trigger_offstrategy_compaction();
+        } catch (no_such_column_family&) {
+            // dropped in the meantime, nothing to reshape.
+        }
+    });
+}
@@ -23,6 +23,7 @@
 
 #include <vector>
 #include "gms/inet_address.hh"
+#include "database_fwd.hh"
 #include "db/system_distributed_keyspace.hh"
 
 future<> repair_init_messaging_service_handler(distributed<db::system_distributed_keyspace>& sys_dist_ks, distributed<db::view::view_update_generator>& view_update_generator);
@@ -32,3 +33,7 @@ class repair_info;
 future<> repair_cf_range_row_level(repair_info& ri,
         sstring cf_name, dht::token_range range,
         const std::vector<gms::inet_address>& all_peer_nodes);
+
+// Submits the sstables row-level repair wrote to the table, on every shard, for off-strategy
+// compaction. Called once the repair of the table is over, rather than for every sstable.
+future<> repair_trigger_offstrategy_compaction(seastar::sharded<database>& db, utils::UUID table_id);
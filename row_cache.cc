@@ -71,6 +71,10 @@ cache_tracker::cache_tracker()
                 _memtable_cleaner.clear_some();
                 return memory::reclaiming_result::reclaimed_something;
             }
+            if (!_lru.empty() && &_lru.back() == &_lru_walk_marker) {
+                // Whatever a walk of the LRU had left was evicted.
+                _lru_walk_marker._lru_link.unlink();
+            }
             if (_lru.empty()) {
                 return memory::reclaiming_result::reclaimed_nothing;
             }
@@ -116,6 +120,9 @@ cache_tracker::setup_metrics() {
         sm::make_derive("partition_evictions", sm::description("total number of evicted partitions"), _stats.partition_evictions),
         sm::make_derive("partition_removals", sm::description("total number of invalidated partitions"), _stats.partition_removals),
         sm::make_derive("mispopulations", sm::description("number of entries not inserted by reads"), _stats.mispopulations),
+        sm::make_derive("partition_admissions", sm::description("number of missed partitions populated by reads of tables which admit frequent partitions only"), _stats.partition_admissions),
+        sm::make_derive("partition_rejections", sm::description("number of missed partitions not populated because they were not read frequently enough"), _stats.partition_rejections),
+        sm::make_gauge("admission_sketch_bytes", sm::description("memory used by the access frequency sketches of tables which admit frequent partitions only"), _stats.admission_sketch_bytes),
         sm::make_gauge("partitions", sm::description("total number of cached partitions"), _stats.partitions),
         sm::make_gauge("rows", sm::description("total number of cached rows"), _stats.rows),
         sm::make_derive("reads", sm::description("number of started reads"), _stats.reads),
@@ -139,6 +146,7 @@ void cache_tracker::clear() {
     auto rows_before = _stats.rows;
     // We need to clear garbage first because garbage versions cannot be evicted from,
     // mutation_partition::clear_gently() destroys intrusive tree invariants.
+    _lru_walk_marker._lru_link.unlink();
     with_allocator(_region.allocator(), [this] {
         _garbage.clear();
         _memtable_cleaner.clear();
@@ -368,17 +376,20 @@ class single_partition_populating_reader final : public flat_mutation_reader::im
         return _read_context->create_underlying(false, timeout).then([this, phase, timeout] {
           return _read_context->underlying().underlying()(timeout).then([this, phase] (auto&& mfopt) {
             if (!mfopt) {
-                if (phase == _cache.phase_of(_read_context->range().start()->value())) {
+                if (!_cache.admits(_read_context->range().start()->value().token())) {
+                    // Not worth populating, the partition is absent anyway.
+                } else if (phase == _cache.phase_of(_read_context->range().start()->value())) {
                     _cache._read_section(_cache._tracker.region(), [this] {
                         with_allocator(_cache._tracker.allocator(), [this] {
                             dht::decorated_key dk = _read_context->range().start()->value().as_decorated_key();
                             _cache.do_find_or_create_entry(dk, nullptr, [&] (auto i) {
                                 mutation_partition mp(_cache._schema);
-                                cache_entry* entry = current_allocator().construct<cache_entry>(
-                                    _cache._schema, std::move(dk), std::move(mp));
-                                _cache._tracker.insert(*entry);
+                                auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(
+                                    _cache._schema, std::move(dk), std::move(mp)));
                                 entry->set_continuous(i->continuous());
-                                return _cache._partitions.insert_before(i, *entry);
+                                i = _cache._partitions.insert_before(i, *entry);
+                                _cache._tracker.insert(*entry.release());
+                                return i;
                             }, [&] (auto i) {
                                 _cache._tracker.on_miss_already_populated();
                             });
@@ -388,6 +399,9 @@ class single_partition_populating_reader final : public flat_mutation_reader::im
                     _cache._tracker.on_mispopulate();
                 }
                 _end_of_stream = true;
+            } else if (!_cache.admits(mfopt->as_partition_start().key().token())) {
+                _reader = read_directly_from_underlying(*_read_context);
+                this->push_mutation_fragment(std::move(*mfopt));
             } else if (phase == _cache.phase_of(_read_context->range().start()->value())) {
                 _reader = _cache._read_section(_cache._tracker.region(), [&] {
                     cache_entry& e = _cache.find_or_create(mfopt->as_partition_start().key(), mfopt->as_partition_start().partition_tombstone(), phase);
@@ -469,6 +483,59 @@ void row_cache::on_mispopulate() {
     _tracker.on_mispopulate();
 }
 
+size_t row_cache::admission_sketch_capacity() const noexcept {
+    size_t count = 0;
+    for (auto it = _partitions.begin(); it != _partitions.end() && count < max_admission_sketch_capacity; ++it) {
+        count += !it->is_dummy_entry();
+    }
+    return std::max(count, min_admission_sketch_capacity);
+}
+
+void row_cache::reset_access_frequencies(size_t capacity) {
+    drop_access_frequencies();
+    _access_frequencies.emplace(capacity);
+    _tracker._stats.admission_sketch_bytes += _access_frequencies->memory_usage();
+}
+
+void row_cache::drop_access_frequencies() noexcept {
+    if (_access_frequencies) {
+        _tracker._stats.admission_sketch_bytes -= _access_frequencies->memory_usage();
+        _access_frequencies = {};
+    }
+}
+
+void row_cache::record_access(const dht::token& t) {
+    if (!_admit_frequent_only) {
+        return;
+    }
+    if (!_access_frequencies) {
+        reset_access_frequencies(admission_sketch_capacity());
+    }
+    // The table's partitions are only counted when the sketch ages, which is
+    // once every sample of accesses, larger than the sketch.
+    if (_access_frequencies->record(std::hash<dht::token>()(t))) {
+        auto capacity = admission_sketch_capacity();
+        if (_access_frequencies->width() < capacity) {
+            // Outgrown by the table. Estimates are only ever a sample window
+            // old, so a fresh sketch loses little.
+            reset_access_frequencies(capacity);
+        }
+    }
+}
+
+bool row_cache::admits(const dht::token& t) {
+    if (!_admit_frequent_only || !_access_frequencies) {
+        return true;
+    }
+    // Until the cache starts evicting, there is room for everything.
+    if (!_tracker.get_stats().row_evictions || _access_frequencies->estimate(std::hash<dht::token>()(t)) >= admission_frequency) {
+        ++_tracker._stats.partition_admissions;
+        return true;
+    }
+    ++_tracker._stats.partition_rejections;
+    return false;
+}
+
 void row_cache::on_row_miss() {
     _stats.misses.mark();
     _tracker.on_row_miss();
@@ -531,7 +598,13 @@ class range_populating_reader {
                 _cache.on_partition_miss();
                 const partition_start& ps = mfopt->as_partition_start();
                 const dht::decorated_key& key = ps.key();
-                if (_reader.creation_phase() == _cache.phase_of(key)) {
+                _cache.record_access(key.token());
+                if (!_cache.admits(key.token())) {
+                    // Continuity can't be set across a partition which is not cached.
+                    _last_key = {};
+                    return make_ready_future<flat_mutation_reader_opt, mutation_fragment_opt>(
+                        read_directly_from_underlying(_read_context), std::move(mfopt));
+                } else if (_reader.creation_phase() == _cache.phase_of(key)) {
                     return _cache._read_section(_cache._tracker.region(), [&] {
                         cache_entry& e = _cache.find_or_create(key,
                                                                ps.partition_tombstone(),
@@ -741,6 +814,7 @@ row_cache::make_reader(schema_ptr s,
     auto ctx = make_lw_shared<read_context>(*this, s, range, slice, pc, trace_state, fwd_mr);
 
     if (!ctx->is_range_query() && !fwd_mr) {
+        record_access(ctx->range().start()->value().token());
         auto mr = _read_section(_tracker.region(), [&] {
             return with_linearized_managed_bytes([&] {
                 cache_entry::compare cmp(_schema);
@@ -777,6 +851,7 @@ row_cache::make_reader(schema_ptr s,
 
 
 row_cache::~row_cache() {
+    drop_access_frequencies();
     with_allocator(_tracker.allocator(), [this] {
         _partitions.clear_and_dispose([this, deleter = current_deleter<cache_entry>()] (auto&& p) mutable {
             if (!p->is_dummy_entry()) {
@@ -835,9 +910,11 @@ cache_entry& row_cache::do_find_or_create_entry(const dht::decorated_key& key,
 
 cache_entry& row_cache::find_or_create(const dht::decorated_key& key, tombstone t, row_cache::phase_type phase, const previous_entry_pointer* previous) {
     return do_find_or_create_entry(key, previous, [&] (auto i) { // create
-        auto entry = current_allocator().construct<cache_entry>(cache_entry::incomplete_tag{}, _schema, key, t);
-        _tracker.insert(*entry);
-        return _partitions.insert_before(i, *entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(
+            current_allocator().construct<cache_entry>(cache_entry::incomplete_tag{}, _schema, key, t));
+        i = _partitions.insert_before(i, *entry);
+        _tracker.insert(*entry.release());
+        return i;
     }, [&] (auto i) { // visit
         _tracker.on_miss_already_populated();
         cache_entry& e = *i;
@@ -849,11 +926,11 @@ cache_entry& row_cache::find_or_create(const dht::decorated_key& key, tombstone
 void row_cache::populate(const mutation& m, const previous_entry_pointer* previous) {
   _populate_section(_tracker.region(), [&] {
     do_find_or_create_entry(m.decorated_key(), previous, [&] (auto i) {
-        cache_entry* entry = current_allocator().construct<cache_entry>(
-                m.schema(), m.decorated_key(), m.partition());
-        _tracker.insert(*entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(
+                m.schema(), m.decorated_key(), m.partition()));
         entry->set_continuous(i->continuous());
         i = _partitions.insert_before(i, *entry);
+        _tracker.insert(*entry.release());
         upgrade_entry(*i);
         return i;
     }, [&] (auto i) {
@@ -970,6 +1047,7 @@ future<> row_cache::do_update(external_updater eu, memtable& m, Updater updater)
                                 auto i = m.partitions.begin();
                                 memtable_entry& mem_e = *i;
                                 m.partitions.erase(i);
+                                --m._partition_count;
                                 mem_e.partition().evict(_tracker.memtable_cleaner());
                                 current_allocator().destroy(&mem_e);
                             });
@@ -1014,12 +1092,13 @@ future<> row_cache::update(external_updater eu, memtable& m) {
                    || with_allocator(standard_allocator(), [&] { return is_present(mem_e.key()); })
                       == partition_presence_checker_result::definitely_doesnt_exist) {
             // Partition is absent in underlying. First, insert a neutral partition entry.
-            cache_entry* entry = current_allocator().construct<cache_entry>(cache_entry::evictable_tag(),
+            auto e = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(cache_entry::evictable_tag(),
                 _schema, dht::decorated_key(mem_e.key()),
-                partition_entry::make_evictable(*_schema, mutation_partition(_schema)));
-            entry->set_continuous(cache_i->continuous());
+                partition_entry::make_evictable(*_schema, mutation_partition(_schema))));
+            e->set_continuous(cache_i->continuous());
+            _partitions.insert_before(cache_i, *e);
+            cache_entry* entry = e.release();
             _tracker.insert(*entry);
-            _partitions.insert_before(cache_i, *entry);
             return entry->partition().apply_to_incomplete(*_schema, std::move(mem_e.partition()), *mem_e.schema(), _tracker.memtable_cleaner(),
                 alloc, _tracker.region(), _tracker, _underlying_phase, acc);
         } else {
@@ -1141,14 +1220,15 @@ void row_cache::invalidate_unwrapped(const dht::partition_range& range) {
 row_cache::row_cache(schema_ptr s, snapshot_source src, cache_tracker& tracker, is_continuous cont)
     : _tracker(tracker)
     , _schema(std::move(s))
-    , _partitions(cache_entry::compare(_schema))
     , _underlying(src())
     , _snapshot_source(std::move(src))
 {
+    _admit_frequent_only = _schema->caching_options().admit_frequent_only();
     with_allocator(_tracker.allocator(), [this, cont] {
-        cache_entry* entry = current_allocator().construct<cache_entry>(cache_entry::dummy_entry_tag());
-        _partitions.insert_before(_partitions.end(), *entry);
+        auto entry = alloc_strategy_unique_ptr<cache_entry>(current_allocator().construct<cache_entry>(cache_entry::dummy_entry_tag()));
         entry->set_continuous(bool(cont));
+        _partitions.insert_before(_partitions.end(), *entry);
+        entry.release();
     });
 }
 
@@ -1157,13 +1237,8 @@ cache_entry::cache_entry(cache_entry&& o) noexcept
     , _key(std::move(o._key))
     , _pe(std::move(o._pe))
     , _flags(o._flags)
-    , _cache_link()
+    , _cache_link(std::move(o._cache_link))
 {
-    {
-        using container_type = row_cache::partitions_type;
-        container_type::node_algorithms::replace_node(o._cache_link.this_ptr(), _cache_link.this_ptr());
-        container_type::node_algorithms::init(o._cache_link.this_ptr());
-    }
 }
 
 cache_entry::~cache_entry() {
@@ -1175,10 +1250,14 @@ void cache_entry::evict(cache_tracker& tracker) noexcept {
 
 void row_cache::set_schema(schema_ptr new_schema) noexcept {
     _schema = std::move(new_schema);
+    _admit_frequent_only = _schema->caching_options().admit_frequent_only();
+    if (!_admit_frequent_only) {
+        drop_access_frequencies();
+    }
 }
 
 void cache_entry::on_evicted(cache_tracker& tracker) noexcept {
-    auto it = row_cache::partitions_type::s_iterator_to(*this);
+    auto it = row_cache::partitions_type::iterator_to(*this);
     std::next(it)->set_continuous(false);
     evict(tracker);
     current_deleter<cache_entry>()(this);
@@ -22,11 +22,12 @@
 #pragma once
 
 #include <boost/intrusive/list.hpp>
-#include <boost/intrusive/set.hpp>
 #include <boost/intrusive/parent_from_member.hpp>
+#include <unordered_set>
 
 #include <seastar/core/memory.hh>
 #include <seastar/core/thread.hh>
+#include <seastar/util/defer.hh>
 #include <seastar/util/noncopyable_function.hh>
 
 #include "mutation_reader.hh"
@@ -34,6 +35,8 @@
 #include "utils/logalloc.hh"
 #include "utils/phased_barrier.hh"
 #include "utils/histogram.hh"
+#include "utils/bptree.hh"
+#include "utils/frequency_sketch.hh"
 #include "partition_version.hh"
 #include "utils/estimated_histogram.hh"
 #include "tracing/trace_state.hh"
@@ -61,10 +64,10 @@ class lsa_manager;
 //
 // TODO: Make memtables use this format too.
 class cache_entry {
-    // We need auto_unlink<> option on the _cache_link because when entry is
-    // evicted from cache via LRU we don't have a reference to the container
-    // and don't want to store it with each entry.
-    using cache_link_type = bi::set_member_hook<bi::link_mode<bi::auto_unlink>>;
+    // The _cache_link unlinks itself when destroyed, which we need because
+    // when entry is evicted from cache via LRU we don't have a reference
+    // to the container and don't want to store it with each entry.
+    using cache_link_type = bplus::member_hook;
 
     schema_ptr _schema;
     dht::decorated_key _key;
@@ -148,6 +151,17 @@ class cache_entry {
 
     bool is_dummy_entry() const { return _flags._dummy_entry; }
 
+    // Orders entries by token only, consistently with compare.
+    // Kept inline in the partitions tree, see bplus::tree.
+    struct token_prefix {
+        uint64_t operator()(dht::ring_position_view pos) const noexcept {
+            return dht::token_prefix(pos.token());
+        }
+        uint64_t operator()(const cache_entry& e) const noexcept {
+            return (*this)(e.position());
+        }
+    };
+
     struct compare {
         dht::ring_position_less_comparator _c;
 
@@ -215,6 +229,9 @@ class cache_tracker final {
         uint64_t partitions;
         uint64_t rows;
         uint64_t mispopulations;
+        uint64_t partition_admissions;
+        uint64_t partition_rejections;
+        uint64_t admission_sketch_bytes;
         uint64_t underlying_recreations;
         uint64_t underlying_partition_skips;
         uint64_t underlying_row_skips;
@@ -232,6 +249,9 @@ class cache_tracker final {
     seastar::metrics::metric_groups _metrics;
     logalloc::region _region;
     lru_type _lru;
+    // Where for_each_recently_used_partition() resumes after yielding, linked in
+    // the LRU only while a walk is in progress.
+    rows_entry _lru_walk_marker{rows_entry::lru_marker_tag{}};
     mutation_cleaner _garbage;
     mutation_cleaner _memtable_cleaner;
 private:
@@ -270,6 +290,19 @@ class cache_tracker final {
     uint64_t partitions() const { return _stats.partitions; }
     const stats& get_stats() const { return _stats; }
     void set_compaction_scheduling_group(seastar::scheduling_group);
+
+    // Calls func(const cache_entry&) for the partitions of the most recently
+    // used rows, most recent first, until it returns stop_iteration::yes or
+    // max_rows rows were looked at. The entries are valid only during the call.
+    //
+    // Must be called in a seastar thread. The LRU is walked once, yielding when
+    // preemption is needed, with a marker linked in the LRU to keep the place of
+    // the walk. Rows used while the walk is preempted move ahead of the marker,
+    // and rows evicted meanwhile are not visited. A partition is visited once
+    // between preemption points, but may be visited again after one.
+    // Only one walk may be in progress at a time.
+    template<typename Func>
+    void for_each_recently_used_partition(size_t max_rows, Func&& func);
 };
 
 inline
@@ -299,6 +332,50 @@ void cache_tracker::insert(partition_entry& pe) noexcept {
     }
 }
 
+template<typename Func>
+inline
+void cache_tracker::for_each_recently_used_partition(size_t max_rows, Func&& func) {
+    assert(!_lru_walk_marker._lru_link.is_linked());
+    auto unlink_marker = defer([this] {
+        _lru_walk_marker._lru_link.unlink();
+    });
+    _lru.push_front(_lru_walk_marker);
+    std::unordered_set<const cache_entry*> seen;
+    // The marker is unlinked when eviction reaches it, so then nothing is left to walk.
+    while (_lru_walk_marker._lru_link.is_linked()) {
+        {
+            logalloc::reclaim_lock rl(_region);
+            auto it = std::next(_lru.iterator_to(_lru_walk_marker));
+            while (it != _lru.end()) {
+                if (!max_rows--) {
+                    return;
+                }
+                rows_entry& row = *it++;
+                partition_version& pv = partition_version::container_of(mutation_partition::container_of(
+                    mutation_partition::rows_type::container_of(row)));
+                // Rows of older versions are reachable through the latest one too.
+                if (pv.is_referenced_from_entry()) {
+                    const cache_entry& ce = cache_entry::container_of(partition_entry::container_of(pv));
+                    if (seen.insert(&ce).second && func(ce) == stop_iteration::yes) {
+                        return;
+                    }
+                }
+                if (need_preempt()) {
+                    break;
+                }
+            }
+            if (it == _lru.end()) {
+                return;
+            }
+            _lru_walk_marker._lru_link.unlink();
+            _lru.insert(it, _lru_walk_marker);
+        }
+        // Entries may be freed and their memory reused while yielding.
+        seen.clear();
+        seastar::thread::yield();
+    }
+}
+
 //
 // A data source which wraps another data source such that data obtained from the underlying data source
 // is cached in-memory in order to serve queries faster.
@@ -314,10 +391,7 @@ void cache_tracker::insert(partition_entry& pe) noexcept {
 class row_cache final {
 public:
     using phase_type = utils::phased_barrier::phase_type;
-    using partitions_type = bi::set<cache_entry,
-        bi::member_hook<cache_entry, cache_entry::cache_link_type, &cache_entry::_cache_link>,
-        bi::constant_time_size<false>, // we need this to have bi::auto_unlink on hooks
-        bi::compare<cache_entry::compare>>;
+    using partitions_type = bplus::tree<cache_entry, &cache_entry::_cache_link, cache_entry::token_prefix>;
     friend class cache::autoupdating_underlying_reader;
     friend class single_partition_populating_reader;
     friend class cache_entry;
@@ -346,6 +420,18 @@ class row_cache final {
     schema_ptr _schema;
     partitions_type _partitions; // Cached partitions are complete.
 
+    // Recent access frequencies of partitions, kept when the schema asks to
+    // populate frequently read partitions only (see caching_options::admit_frequent_only()).
+    // Missed partitions which weren't read before in the sketch's window are
+    // read from the underlying source without being populated, so that one-off
+    // reads don't evict the working set. The sketch is sized from the table's
+    // own cached partitions, and its memory is accounted in the tracker's stats.
+    static constexpr unsigned admission_frequency = 2;
+    static constexpr size_t min_admission_sketch_capacity = 1024;
+    static constexpr size_t max_admission_sketch_capacity = 1 << 18;
+    bool _admit_frequent_only = false;
+    std::optional<utils::frequency_sketch> _access_frequencies;
+
     // The snapshots used by cache are versioned. The version number of a snapshot is
     // called the "population phase", or simply "phase". Between updates, cache
     // represents the same snapshot.
@@ -395,6 +481,15 @@ class row_cache final {
     void on_row_miss();
     void on_static_row_insert();
     void on_mispopulate();
+    // Records a read of the partition with given token, if admission is enabled.
+    void record_access(const dht::token&);
+    // Returns true iff the partition with given token should be populated on a miss.
+    bool admits(const dht::token&);
+    // Number of keys the admission sketch should track: the cached partitions of this
+    // table, clamped to the sketch's bounds. Counts no further than the upper bound.
+    size_t admission_sketch_capacity() const noexcept;
+    void reset_access_frequencies(size_t capacity);
+    void drop_access_frequencies() noexcept;
     void upgrade_entry(cache_entry&);
     void invalidate_locked(const dht::decorated_key&);
     void invalidate_unwrapped(const dht::partition_range&);
@@ -557,7 +652,7 @@ class row_cache final {
     void evict(const dht::partition_range& = query::full_partition_range);
 
     size_t partitions() const {
-        return _partitions.size();
+        return _partitions.calculate_size();
     }
     const cache_tracker& get_cache_tracker() const {
         return _tracker;
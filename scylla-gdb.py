@@ -149,6 +149,24 @@ class intrusive_set_external_comparator:
             yield n
 
 
+class bplus_tree:
+    size_t = gdb.lookup_type('size_t')
+
+    def __init__(self, ref):
+        container_type = ref.type.strip_typedefs()
+        self.node_type = container_type.template_argument(0)
+        self.link_offset = container_type.template_argument(1).cast(self.size_t)
+        self.leftmost = ref['_header']['_leftmost']
+
+    def __iter__(self):
+        leaf = self.leftmost
+        while leaf:
+            for i in range(int(leaf['_count'])):
+                node_ptr = leaf['_slots'][i].cast(self.size_t) - self.link_offset
+                yield node_ptr.cast(self.node_type.pointer()).dereference()
+            leaf = leaf['_next']
+
+
 class std_array:
     def __init__(self, ref):
         self.ref = ref
@@ -293,7 +311,7 @@ class mutation_partition_printer(gdb.printing.PrettyPrinter):
         self.val = val
 
     def to_string(self):
-        rows = list(str(r) for r in intrusive_set_external_comparator(self.val['_rows']))
+        rows = list(str(r) for r in bplus_tree(self.val['_rows']))
         range_tombstones = list(str(r) for r in intrusive_set(self.val['_row_tombstones']['_tombstones']))
         return '{_tombstone=%s, _static_row=%s (cont=%s), _row_tombstones=[%s], _rows=[%s]}' % (
             self.val['_tombstone'],
@@ -1729,7 +1747,7 @@ class scylla_cache(gdb.Command):
             schema = table['_schema']['_p'].reinterpret_cast(schema_ptr_type)
             name = '%s.%s' % (schema['_raw']['_ks_name'], schema['_raw']['_cf_name'])
             gdb.write("%s:\n" % (name))
-            for e in intrusive_set(table['_cache']['_partitions']):
+            for e in bplus_tree(table['_cache']['_partitions']):
                 gdb.write('  (cache_entry*) 0x%x {_key=%s, _flags=%s, _pe=%s}\n' % (
                     int(e.address), e['_key'], e['_flags'], e['_pe']))
             gdb.write("\n")
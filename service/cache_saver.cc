@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cache_saver.hh"
+#include "database.hh"
+#include "db/config.hh"
+#include "service/priority_manager.hh"
+#include "checked-file-impl.hh"
+#include "disk-error-handler.hh"
+
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/numeric.hpp>
+#include <seastar/core/fstream.hh>
+#include <seastar/core/metrics.hh>
+#include <seastar/core/sleep.hh>
+#include <seastar/core/thread.hh>
+
+namespace service {
+
+static logging::logger cslogger("cache_saver");
+
+// Rows looked at in the LRU per saved key. Partitions with many recently
+// used rows take up several of them.
+static constexpr size_t rows_per_saved_key = 8;
+
+// A line holds a table id and a partition key, which is at most 64KiB, in hex.
+static constexpr size_t max_line_size = 2 * std::numeric_limits<uint16_t>::max() + 64;
+
+cache_saver::cache_saver(seastar::sharded<database>& db, const db::config& cfg)
+    : _db(db)
+    , _dir(cfg.saved_caches_directory())
+    , _period(cfg.row_cache_save_period())
+    , _keys_to_save(cfg.row_cache_keys_to_save())
+    , _warmup_rate(std::max(cfg.row_cache_warmup_rate(), uint32_t(1)))
+{
+    _timer.set_callback([this] {
+        (void)with_gate(_gate, [this] {
+            return save().handle_exception([] (std::exception_ptr ep) {
+                cslogger.warn("Failed to save row cache keys: {}", ep);
+            }).finally([this] {
+                if (!_as.abort_requested()) {
+                    _timer.arm(_period);
+                }
+            });
+        });
+    });
+}
+
+void cache_saver::setup_metrics() {
+    namespace sm = seastar::metrics;
+    _metrics.add_group("cache", {
+        sm::make_gauge("warmup_keys", sm::description("number of saved partitions to be read into cache after startup"), _stats.warmup_keys),
+        sm::make_derive("warmup_keys_loaded", sm::description("number of saved partitions read into cache after startup, out of warmup_keys"), _stats.warmup_keys_loaded),
+    });
+}
+
+sstring cache_saver::keys_file() const {
+    return _dir + "/row_cache_keys";
+}
+
+future<std::vector<cache_saver::saved_key>> cache_saver::recently_used_keys() {
+    if (!_keys_to_save) {
+        return make_ready_future<std::vector<saved_key>>();
+    }
+    return seastar::async([this] {
+        std::vector<saved_key> keys;
+        // The walk may visit a partition again after a preemption point.
+        std::unordered_map<utils::UUID, std::unordered_set<bytes>> seen;
+        _db.local().row_cache_tracker().for_each_recently_used_partition(_keys_to_save * rows_per_saved_key, [&] (const cache_entry& ce) {
+            auto key = ce.key().key();
+            auto repr = with_linearized_managed_bytes([&] {
+                return to_bytes(key.representation());
+            });
+            if (seen[ce.schema()->id()].insert(std::move(repr)).second) {
+                keys.push_back(saved_key{ce.schema()->id(), std::move(key)});
+            }
+            return stop_iteration(keys.size() >= _keys_to_save);
+        });
+        return keys;
+    });
+}
+
+future<> cache_saver::save() {
+    return container().map_reduce0([] (cache_saver& cs) {
+        return cs.recently_used_keys();
+    }, std::vector<saved_key>(), [] (std::vector<saved_key> a, std::vector<saved_key> b) {
+        std::move(b.begin(), b.end(), std::back_inserter(a));
+        return a;
+    }).then([this] (std::vector<saved_key> keys) {
+        return seastar::async([this, keys = std::move(keys)] {
+            // Written aside and renamed, so that a crash doesn't leave a partial file behind.
+            auto tmp = keys_file() + ".tmp";
+            auto f = open_checked_file_dma(general_disk_error_handler, tmp, open_flags::wo | open_flags::create | open_flags::truncate).get0();
+            auto out = make_file_output_stream(std::move(f));
+            for (auto& k : keys) {
+                auto line = with_linearized_managed_bytes([&] {
+                    return format("{} {}\n", k.table, to_hex(k.key.representation()));
+                });
+                out.write(line.c_str(), line.size()).get();
+            }
+            out.flush().get();
+            out.close().get();
+            io_check(rename_file, tmp, keys_file()).get();
+            io_check(sync_directory, _dir).get();
+            cslogger.debug("Saved {} row cache keys to {}", keys.size(), keys_file());
+        });
+    });
+}
+
+// Throws if the key doesn't match the partition key of the table.
+static void validate_key(const schema& s, const partition_key& key) {
+    auto columns = s.partition_key_columns();
+    auto column = columns.begin();
+    for (bytes_view component : key.components(s)) {
+        if (column == columns.end()) {
+            throw marshal_exception(format("Too many partition key components for {}.{}", s.ks_name(), s.cf_name()));
+        }
+        column++->type->validate(component);
+    }
+    if (column != columns.end()) {
+        throw marshal_exception(format("Too few partition key components for {}.{}", s.ks_name(), s.cf_name()));
+    }
+}
+
+future<std::vector<std::vector<cache_saver::saved_key>>> cache_saver::read_keys() {
+    return seastar::async([this] {
+        std::vector<std::vector<saved_key>> keys_by_shard(smp::count);
+        auto exists = io_check([this] { return file_exists(keys_file()); }).get0();
+        if (!exists) {
+            return keys_by_shard;
+        }
+        auto& tables = _db.local().get_column_families();
+        size_t bad_lines = 0;
+        auto add_key = [&] (sstring_view line) {
+            if (line.empty()) {
+                return;
+            }
+            try {
+                auto sep = line.find(' ');
+                if (sep == sstring_view::npos) {
+                    throw std::invalid_argument("no separator");
+                }
+                auto table = utils::UUID(line.substr(0, sep));
+                auto it = tables.find(table);
+                if (it == tables.end()) {
+                    // Dropped since the keys were saved
+                    return;
+                }
+                auto& s = *it->second->schema();
+                auto key = partition_key::from_bytes(from_hex(line.substr(sep + 1)));
+                validate_key(s, key);
+                auto shard = dht::shard_of(dht::global_partitioner().decorate_key(s, key).token());
+                keys_by_shard[shard].push_back(saved_key{table, std::move(key)});
+            } catch (...) {
+                cslogger.debug("Skipping bad line in {}: {}", keys_file(), std::current_exception());
+                ++bad_lines;
+            }
+        };
+
+        auto f = open_checked_file_dma(general_disk_error_handler, keys_file(), open_flags::ro).get0();
+        auto in = make_file_input_stream(std::move(f));
+        // The tail of the last buffer, whose line goes on in the next one.
+        sstring partial;
+        // Set while passing over the rest of a line which is too long to be valid.
+        bool skipping = false;
+        for (;;) {
+            auto buf = in.read().get0();
+            if (buf.empty()) {
+                break;
+            }
+            auto data = sstring_view(buf.get(), buf.size());
+            for (auto nl = data.find('\n'); nl != sstring_view::npos; nl = data.find('\n')) {
+                if (skipping) {
+                    ++bad_lines;
+                    skipping = false;
+                } else if (partial.empty()) {
+                    add_key(data.substr(0, nl));
+                } else {
+                    partial.append(data.data(), nl);
+                    add_key(partial);
+                    partial = {};
+                }
+                data.remove_prefix(nl + 1);
+            }
+            if (!skipping) {
+                if (partial.size() + data.size() > max_line_size) {
+                    partial = {};
+                    skipping = true;
+                } else {
+                    partial.append(data.data(), data.size());
+                }
+            }
+            if (need_preempt()) {
+                seastar::thread::yield();
+            }
+        }
+        in.close().get();
+        // A crash can't leave a partial file behind, but the last line may still lack its newline.
+        if (skipping) {
+            ++bad_lines;
+        } else {
+            add_key(partial);
+        }
+        if (bad_lines) {
+            cslogger.warn("Skipped {} bad lines in {}", bad_lines, keys_file());
+        }
+        return keys_by_shard;
+    });
+}
+
+future<> cache_saver::load() {
+    return read_keys().then([this] (std::vector<std::vector<saved_key>> keys_by_shard) {
+        auto count = boost::accumulate(keys_by_shard | boost::adaptors::transformed([] (const std::vector<saved_key>& keys) {
+            return keys.size();
+        }), size_t(0));
+        if (!count) {
+            return make_ready_future<>();
+        }
+        cslogger.info("Reading {} saved partitions into row cache", count);
+        return do_with(std::move(keys_by_shard), [this] (std::vector<std::vector<saved_key>>& keys_by_shard) {
+            return container().invoke_on_all([&keys_by_shard] (cache_saver& cs) {
+                return cs.warm_up(keys_by_shard[engine().cpu_id()]);
+            }).handle_exception_type([] (const seastar::gate_closed_exception&) { }).then([] {
+                cslogger.info("Done reading saved partitions into row cache");
+            });
+        });
+    });
+}
+
+future<> cache_saver::warm_up(const std::vector<saved_key>& keys) {
+    return with_gate(_gate, [this, keys] () mutable {
+        return seastar::async([this, keys = std::move(keys)] {
+            _stats.warmup_keys = keys.size();
+            auto interval = std::chrono::microseconds(1000000 / _warmup_rate);
+            for (auto& k : keys) {
+                auto& tables = _db.local().get_column_families();
+                auto it = tables.find(k.table);
+                if (it != tables.end()) {
+                    // Keeps the table alive, it could be dropped in the meantime.
+                    lw_shared_ptr<column_family> cf = it->second;
+                    auto s = cf->schema();
+                    auto pr = dht::partition_range::make_singular(dht::global_partitioner().decorate_key(*s, k.key));
+                    // Reads through the cache, which populates it.
+                    auto rd = cf->make_reader(s, pr, s->full_slice(), service::get_local_streaming_read_priority(),
+                            nullptr, streamed_mutation::forwarding::no, mutation_reader::forwarding::no);
+                    try {
+                        rd.consume_pausable([] (mutation_fragment) { return stop_iteration::no; }, db::no_timeout).get();
+                    } catch (...) {
+                        cslogger.debug("Failed to read saved partition {} of {}.{}: {}", k.key, s->ks_name(), s->cf_name(), std::current_exception());
+                    }
+                }
+                ++_stats.warmup_keys_loaded;
+                sleep_abortable(interval, _as).get();
+            }
+        }).handle_exception_type([] (const seastar::sleep_aborted& ignored) { });
+    });
+}
+
+future<> cache_saver::start() {
+    setup_metrics();
+    if (engine().cpu_id() != 0 || _period == std::chrono::seconds(0)) {
+        return make_ready_future<>();
+    }
+    // Saving waits for the warm-up, so that a restart in the middle of it
+    // doesn't lose the keys which weren't read yet.
+    (void)with_gate(_gate, [this] {
+        return load().handle_exception([] (std::exception_ptr ep) {
+            cslogger.warn("Failed to read saved row cache keys: {}", ep);
+        }).finally([this] {
+            if (!_as.abort_requested()) {
+                _timer.arm(_period);
+            }
+        });
+    });
+    return make_ready_future<>();
+}
+
+future<> cache_saver::stop() {
+    _as.request_abort();
+    _timer.cancel();
+    return _gate.close();
+}
+
+}
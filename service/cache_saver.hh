@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "database_fwd.hh"
+#include "seastarx.hh"
+#include "keys.hh"
+#include "utils/UUID.hh"
+
+#include <seastar/core/abort_source.hh>
+#include <seastar/core/gate.hh>
+#include <seastar/core/metrics_registration.hh>
+#include <seastar/core/sharded.hh>
+#include <seastar/core/timer.hh>
+
+namespace db {
+class config;
+}
+
+class cache_saver_test;
+
+namespace service {
+
+// Saves the keys of the partitions with the most recently used rows in the
+// row cache to saved_caches_directory every row_cache_save_period, and reads
+// the saved partitions back into the cache after a restart, so that the node
+// gets back to its hit rate sooner.
+//
+// Shard 0 writes the keys of all shards to a single file. When loading, each
+// key goes to the shard which owns it, so the shard count may change between
+// restarts. Each shard warms up its cache at row_cache_warmup_rate partitions
+// per second, from the most recently used, in the background.
+class cache_saver : public seastar::peering_sharded_service<cache_saver> {
+    struct saved_key {
+        utils::UUID table;
+        partition_key key;
+    };
+    struct stats {
+        uint64_t warmup_keys = 0;
+        uint64_t warmup_keys_loaded = 0;
+    };
+
+    seastar::sharded<database>& _db;
+    sstring _dir;
+    std::chrono::seconds _period;
+    size_t _keys_to_save;
+    unsigned _warmup_rate;
+    timer<lowres_clock> _timer;
+    seastar::gate _gate;
+    seastar::abort_source _as;
+    stats _stats;
+    seastar::metrics::metric_groups _metrics;
+
+    friend class ::cache_saver_test;
+private:
+    sstring keys_file() const;
+    future<std::vector<saved_key>> recently_used_keys();
+    future<> save();
+    // Returns the saved keys of the tables which still exist, by owning shard.
+    future<std::vector<std::vector<saved_key>>> read_keys();
+    future<> load();
+    future<> warm_up(const std::vector<saved_key>& keys);
+    void setup_metrics();
+public:
+    cache_saver(seastar::sharded<database>& db, const db::config& cfg);
+
+    future<> start();
+
+    future<> stop();
+};
+
+}
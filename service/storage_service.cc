@@ -107,6 +107,8 @@ static const sstring STREAM_WITH_RPC_STREAM = "STREAM_WITH_RPC_STREAM";
 static const sstring MC_SSTABLE_FEATURE = "MC_SSTABLE_FORMAT";
 static const sstring ROW_LEVEL_REPAIR = "ROW_LEVEL_REPAIR";
 static const sstring TRUNCATION_TABLE = "TRUNCATION_TABLE";
+static const sstring BLOCKED_BLOOM_FILTER_FEATURE = "BLOCKED_BLOOM_FILTER";
+static const sstring CACHE_ADMISSION_FEATURE = "CACHE_ADMISSION";
 
 distributed<storage_service> _the_storage_service;
 
@@ -153,6 +155,8 @@ storage_service::storage_service(distributed<database>& db, sharded<auth::servic
         , _mc_sstable_feature(_feature_service, MC_SSTABLE_FEATURE)
         , _row_level_repair_feature(_feature_service, ROW_LEVEL_REPAIR)
         , _truncation_table(_feature_service, TRUNCATION_TABLE)
+        , _blocked_bloom_filter_feature(_feature_service, BLOCKED_BLOOM_FILTER_FEATURE)
+        , _cache_admission_feature(_feature_service, CACHE_ADMISSION_FEATURE)
         , _replicate_action([this] { return do_replicate_to_all_cores(); })
         , _update_pending_ranges_action([this] { return do_update_pending_ranges(); })
         , _sys_dist_ks(sys_dist_ks)
@@ -185,6 +189,8 @@ void storage_service::enable_all_features() {
         std::ref(_mc_sstable_feature),
         std::ref(_row_level_repair_feature),
         std::ref(_truncation_table),
+        std::ref(_blocked_bloom_filter_feature),
+        std::ref(_cache_admission_feature),
     })
     {
         if (features.count(f.name())) {
@@ -273,6 +279,7 @@ std::set<sstring> storage_service::get_config_supported_features_set() {
         INDEXES_FEATURE,
         ROW_LEVEL_REPAIR,
         TRUNCATION_TABLE,
+        CACHE_ADMISSION_FEATURE,
     };
 
     // Do not respect config in the case database is not started
@@ -283,6 +290,9 @@ std::set<sstring> storage_service::get_config_supported_features_set() {
         if (config.enable_sstables_mc_format()) {
             features.insert(MC_SSTABLE_FEATURE);
         }
+        if (config.enable_sstables_blocked_bloom_filter()) {
+            features.insert(BLOCKED_BLOOM_FILTER_FEATURE);
+        }
         if (config.experimental()) {
             // push additional experimental features
         }
@@ -301,6 +301,8 @@ class storage_service : public service::migration_listener, public gms::i_endpoi
     gms::feature _mc_sstable_feature;
     gms::feature _row_level_repair_feature;
     gms::feature _truncation_table;
+    gms::feature _blocked_bloom_filter_feature;
+    gms::feature _cache_admission_feature;
 public:
     void enable_all_features();
 
@@ -2297,6 +2299,14 @@ class storage_service : public service::migration_listener, public gms::i_endpoi
     const gms::feature& cluster_supports_truncation_table() const {
         return _truncation_table;
     }
+
+    bool cluster_supports_blocked_bloom_filter() const {
+        return bool(_blocked_bloom_filter_feature);
+    }
+
+    bool cluster_supports_cache_admission() const {
+        return bool(_cache_admission_feature);
+    }
 private:
     future<> set_cql_ready(bool ready);
 private:
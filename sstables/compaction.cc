@@ -48,6 +48,7 @@
 #include <boost/range/adaptors.hpp>
 #include <boost/range/join.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/algorithm/cxx11/all_of.hpp>
 
 #include <seastar/core/future-util.hh>
 #include <seastar/core/pipe.hh>
@@ -149,6 +150,30 @@ class compacting_sstable_writer {
     void consume_end_of_stream();
 };
 
+// Writes tombstones which are garbage, but can't be purged yet because they may shadow data
+// in sstables that aren't being compacted, into a garbage collected sstable of their own rather
+// than into the output. See compaction_descriptor::use_garbage_collected_sstable.
+class garbage_collected_sstable_writer {
+    compaction& _c;
+    sstable_writer* _writer = nullptr;
+public:
+    explicit garbage_collected_sstable_writer(compaction& c) : _c(c) {}
+
+    void consume_new_partition(const dht::decorated_key& dk);
+
+    void consume(tombstone t) { _writer->consume(t); }
+    stop_iteration consume(static_row&& sr, tombstone, bool) { return _writer->consume(std::move(sr)); }
+    stop_iteration consume(clustering_row&& cr, row_tombstone, bool) { return _writer->consume(std::move(cr)); }
+    stop_iteration consume(range_tombstone&& rt) { return _writer->consume(std::move(rt)); }
+
+    // The garbage collected sstable has no size limit, it only ends with the compaction.
+    stop_iteration consume_end_of_partition() {
+        _writer->consume_end_of_partition();
+        return stop_iteration::no;
+    }
+    void consume_end_of_stream();
+};
+
 struct compaction_read_monitor_generator final : public read_monitor_generator {
     class compaction_read_monitor final : public  sstables::read_monitor, public backlog_read_progress_manager {
         sstables::shared_sstable _sst;
@@ -322,7 +347,12 @@ class compaction {
     uint64_t _estimated_partitions = 0;
     std::vector<unsigned long> _ancestors;
     db::replay_position _rp;
+    // Output is repaired only as of the oldest repair among input, and only if all of it is.
+    uint64_t _repaired_at = 0;
     encoding_stats_collector _stats_collector;
+    // Bytes written by this compaction the compaction manager was already charged for.
+    uint64_t _bytes_charged = 0;
+    static constexpr uint64_t charge_granularity = 1 << 20;
 protected:
     compaction(column_family& cf, std::vector<shared_sstable> sstables, uint64_t max_sstable_size, uint32_t sstable_level)
         : _cf(cf)
@@ -347,6 +377,7 @@ class compaction {
         _info->new_sstables.push_back(sst);
         sst->get_metadata_collector().set_replay_position(_rp);
         sst->get_metadata_collector().sstable_level(_sstable_level);
+        sst->get_metadata_collector().set_repaired_at(_repaired_at);
         for (auto ancestor : _ancestors) {
             sst->add_ancestor(ancestor);
         }
@@ -369,6 +400,24 @@ class compaction {
     encoding_stats get_encoding_stats() const {
         return _stats_collector.get();
     }
+
+    // Bytes written so far, used to share compaction throughput among tables.
+    // Compactions which return 0 are never held back.
+    virtual uint64_t bytes_written() const {
+        return 0;
+    }
+
+    // Charge the compaction manager for what was written since the last charge, and wait
+    // until this table is within its share of compaction throughput. Must run in a thread.
+    void maybe_charge_written_bytes() {
+        auto written = bytes_written();
+        if (written < _bytes_charged + charge_granularity) {
+            return;
+        }
+        auto bytes = written - _bytes_charged;
+        _bytes_charged = written;
+        _cf.get_compaction_manager().charge_compaction(*_info, bytes).get();
+    }
 public:
     compaction& operator=(const compaction&) = delete;
     compaction(const compaction&) = delete;
@@ -386,6 +435,11 @@ class compaction {
         auto ssts = make_lw_shared<sstables::sstable_set>(_cf.get_compaction_strategy().make_sstable_set(_schema));
         sstring formatted_msg = "[";
         auto fully_expired = get_fully_expired_sstables(_cf, _sstables, gc_clock::now() - _schema->gc_grace_seconds());
+        if (!_sstables.empty() && boost::algorithm::all_of(_sstables, [] (const shared_sstable& sst) { return sst->is_repaired(); })) {
+            _repaired_at = (*boost::min_element(_sstables, [] (const shared_sstable& a, const shared_sstable& b) {
+                return a->repaired_at() < b->repaired_at();
+            }))->repaired_at();
+        }
 
         for (auto& sst : _sstables) {
             // Compacted sstable keeps track of its ancestors.
@@ -479,10 +533,24 @@ class compaction {
     // finish all writers.
     virtual void finish_sstable_writer() = 0;
 
+    virtual bool use_garbage_collected_sstable() const {
+        return false;
+    }
+    // select the writer of the garbage collected sstable, only if use_garbage_collected_sstable().
+    virtual sstable_writer* select_gc_sstable_writer(const dht::decorated_key& dk) {
+        throw std::logic_error("compaction doesn't write a garbage collected sstable");
+    }
+    // finish the garbage collected sstable, if any. There's one per compaction, finished at its end.
+    virtual void finish_gc_sstable_writer() { }
+
     compacting_sstable_writer get_compacting_sstable_writer() {
         return compacting_sstable_writer(*this);
     }
 
+    garbage_collected_sstable_writer get_garbage_collected_sstable_writer() {
+        return garbage_collected_sstable_writer(*this);
+    }
+
     const schema_ptr& schema() const {
         return _schema;
     }
@@ -490,9 +558,11 @@ class compaction {
     static future<compaction_info> run(std::unique_ptr<compaction> c);
 
     friend class compacting_sstable_writer;
+    friend class garbage_collected_sstable_writer;
 };
 
 void compacting_sstable_writer::consume_new_partition(const dht::decorated_key& dk) {
+    _c.maybe_charge_written_bytes();
     if (_c._info->is_stop_requested()) {
         // Compaction manager will catch this exception and re-schedule the compaction.
         throw compaction_stop_exception(_c._info->ks_name, _c._info->cf_name, _c._info->stop_requested);
@@ -516,6 +586,15 @@ void compacting_sstable_writer::consume_end_of_stream() {
     _c.finish_sstable_writer();
 }
 
+void garbage_collected_sstable_writer::consume_new_partition(const dht::decorated_key& dk) {
+    _writer = _c.select_gc_sstable_writer(dk);
+    _writer->consume_new_partition(dk);
+}
+
+void garbage_collected_sstable_writer::consume_end_of_stream() {
+    _c.finish_gc_sstable_writer();
+}
+
 class regular_compaction : public compaction {
     std::function<shared_sstable()> _creator;
     replacer_fn _replacer;
@@ -528,9 +607,17 @@ class regular_compaction : public compaction {
     // sstable being currently written.
     shared_sstable _sst;
     std::optional<sstable_writer> _writer;
+    bool _use_garbage_collected_sstable;
+    // garbage collected sstable being currently written, if any.
+    shared_sstable _gc_sst;
+    std::optional<sstable_writer> _gc_writer;
+    // garbage collected sstables of a compaction are disjoint, so they make a run of their own.
+    utils::UUID _gc_run_identifier = utils::make_random_uuid();
     std::optional<compaction_weight_registration> _weight_registration;
     mutable compaction_read_monitor_generator _monitor_generator;
     std::deque<compaction_write_monitor> _active_write_monitors = {};
+    // monitor of the sstable being currently written, if any.
+    const compaction_write_monitor* _write_monitor = nullptr;
     utils::UUID _run_identifier = utils::make_random_uuid();
 public:
     regular_compaction(column_family& cf, compaction_descriptor descriptor, std::function<shared_sstable()> creator, replacer_fn replacer)
@@ -540,6 +627,7 @@ class regular_compaction : public compaction {
         , _compacting_for_max_purgeable_func(std::unordered_set<shared_sstable>(_sstables.begin(), _sstables.end()))
         , _set(cf.get_sstable_set())
         , _selector(_set.make_incremental_selector())
+        , _use_garbage_collected_sstable(descriptor.use_garbage_collected_sstable)
         , _weight_registration(std::move(descriptor.weight_registration))
         , _monitor_generator(_cf.get_compaction_manager(), _cf)
     {
@@ -547,15 +635,13 @@ class regular_compaction : public compaction {
     }
 
     flat_mutation_reader make_sstable_reader() const override {
-        return ::make_local_shard_sstable_reader(_schema,
+        return ::make_disjoint_pass_through_sstable_reader(_schema,
                 _compacting,
                 query::full_partition_range,
                 _schema->full_slice(),
                 service::get_local_compaction_priority(),
                 no_resource_tracking(),
                 nullptr,
-                ::streamed_mutation::forwarding::no,
-                ::mutation_reader::forwarding::no,
                 _monitor_generator);
     }
 
@@ -567,6 +653,10 @@ class regular_compaction : public compaction {
         clogger.info("Compacted {}", formatted_msg);
     }
 
+    uint64_t bytes_written() const override {
+        return _info->end_size + (_write_monitor ? _write_monitor->written() : 0);
+    }
+
     void backlog_tracker_adjust_charges() override {
         _monitor_generator.remove_sstables(_info->tracking);
         for (auto& wm : _active_write_monitors) {
@@ -597,7 +687,9 @@ class regular_compaction : public compaction {
             cfg.max_sstable_size = _max_sstable_size;
             cfg.monitor = &_active_write_monitors.back();
             cfg.large_data_handler = _cf.get_large_data_handler();
+            cfg.zone_maps = _cf.sstable_zone_maps_enabled();
             cfg.run_identifier = _run_identifier;
+            _write_monitor = &_active_write_monitors.back();
             _writer.emplace(_sst->get_writer(*_schema, partitions_per_sstable(), cfg, get_encoding_stats(), priority));
         }
         do_pending_replacements();
@@ -605,6 +697,7 @@ class regular_compaction : public compaction {
     }
 
     virtual void stop_sstable_writer() override {
+        _write_monitor = nullptr;
         finish_new_sstable(_writer, _sst);
         maybe_replace_exhausted_sstables();
     }
@@ -616,6 +709,36 @@ class regular_compaction : public compaction {
         }
         replace_remaining_exhausted_sstables();
     }
+
+    virtual bool use_garbage_collected_sstable() const override {
+        return _use_garbage_collected_sstable;
+    }
+
+    virtual sstable_writer* select_gc_sstable_writer(const dht::decorated_key& dk) override {
+        if (!_gc_writer) {
+            _gc_sst = _creator();
+            setup_new_sstable(_gc_sst);
+            // Garbage collected sstable overlaps with the output, so it can't be on the same level.
+            _gc_sst->get_metadata_collector().sstable_level(0);
+
+            _active_write_monitors.emplace_back(_gc_sst, _cf, maximum_timestamp(), 0);
+            auto&& priority = service::get_local_compaction_priority();
+            sstable_writer_config cfg;
+            cfg.monitor = &_active_write_monitors.back();
+            cfg.large_data_handler = _cf.get_large_data_handler();
+            cfg.zone_maps = _cf.sstable_zone_maps_enabled();
+            cfg.run_identifier = _gc_run_identifier;
+            _gc_writer.emplace(_gc_sst->get_writer(*_schema, partitions_per_sstable(), cfg, get_encoding_stats(), priority));
+        }
+        return &*_gc_writer;
+    }
+
+    virtual void finish_gc_sstable_writer() override {
+        if (_gc_writer) {
+            finish_new_sstable(_gc_writer, _gc_sst);
+            _unreplaced_new_tables.push_back(_gc_sst);
+        }
+    }
 private:
     void on_end_of_stream() {
         if (_weight_registration) {
@@ -658,7 +781,11 @@ class regular_compaction : public compaction {
             exhausted = std::partition(exhausted, _sstables.end(), overlap_with_any_non_candidate);
         } while (non_candidates_end != exhausted);
 
-        if (exhausted != _sstables.end()) {
+        // Garbage of exhausted sstables must make it into the table before they're gone from it.
+        // There is a single garbage collected sstable per compaction, sealed at the end, so once
+        // it holds anything, exhausted sstables are kept until then. That's why incremental
+        // compaction strategy, which relies on releasing them early, rejects the option.
+        if (exhausted != _sstables.end() && !_gc_writer) {
             // The goal is that exhausted sstables will be deleted as soon as possible,
             // so we need to release reference to them.
             std::for_each(exhausted, _sstables.end(), [this] (shared_sstable& sst) {
@@ -673,6 +800,7 @@ class regular_compaction : public compaction {
     }
 
     void replace_remaining_exhausted_sstables() {
+        finish_gc_sstable_writer();
         if (!_sstables.empty()) {
             std::vector<shared_sstable> sstables_compacted;
             std::move(_sstables.begin(), _sstables.end(), std::back_inserter(sstables_compacted));
@@ -832,6 +960,7 @@ class resharding_compaction final : public compaction {
             sstable_writer_config cfg;
             cfg.max_sstable_size = _max_sstable_size;
             cfg.large_data_handler = _cf.get_large_data_handler();
+            cfg.zone_maps = _cf.sstable_zone_maps_enabled();
             auto&& priority = service::get_local_compaction_priority();
             writer.emplace(sst->get_writer(*_schema, partitions_per_sstable(_shard), cfg, get_encoding_stats(), priority, _shard));
         }
@@ -859,8 +988,7 @@ future<compaction_info> compaction::run(std::unique_ptr<compaction> c) {
         auto reader = c->setup();
 
         auto cr = c->get_compacting_sstable_writer();
-        auto cfc = make_stable_flattened_mutations_consumer<compact_for_compaction<compacting_sstable_writer>>(
-            *c->schema(), gc_clock::now(), std::move(cr), c->max_purgeable_func());
+        auto compaction_state = make_lw_shared<compact_for_compaction_state>(*c->schema(), gc_clock::now(), c->max_purgeable_func());
 
         auto start_time = db_clock::now();
         try {
@@ -868,7 +996,16 @@ future<compaction_info> compaction::run(std::unique_ptr<compaction> c) {
             // leave this block either successfully or exceptionally with the reader object
             // destroyed.
             auto r = std::move(reader);
-            r.consume_in_thread(std::move(cfc), c->filter_func(), db::no_timeout);
+            if (c->use_garbage_collected_sstable()) {
+                auto cfc = make_stable_flattened_mutations_consumer<compact_for_compaction<compacting_sstable_writer, garbage_collected_sstable_writer>>(
+                    compaction_state, std::move(cr), c->get_garbage_collected_sstable_writer());
+                r.consume_in_thread(std::move(cfc), c->filter_func(), db::no_timeout);
+            } else {
+                auto cfc = make_stable_flattened_mutations_consumer<compact_for_compaction<compacting_sstable_writer>>(
+                    compaction_state, std::move(cr));
+                r.consume_in_thread(std::move(cfc), c->filter_func(), db::no_timeout);
+            }
+            c->_info->purged_tombstones = compaction_state->purged_tombstones();
         } catch (...) {
             delete_sstables_for_interrupted_compaction(c->_info->new_sstables, c->_info->ks_name, c->_info->cf_name);
             c = nullptr; // make sure writers are stopped while running in thread context
@@ -909,6 +1046,41 @@ reshard_sstables(std::vector<shared_sstable> sstables, column_family& cf, std::f
     });
 }
 
+double estimate_purgeable_tombstone_fraction(column_family& cf, const shared_sstable& sst) {
+    // Enough for a rough estimate, while keeping it cheap for sstables with many summary entries.
+    static constexpr size_t max_samples = 64;
+
+    // Strategies ask for it on every check for compaction work, for every sstable past
+    // the droppable tombstone threshold, so it's only recomputed once the set changes.
+    auto& set = cf.get_sstable_set();
+    if (auto fraction = sst->cached_purgeable_tombstone_fraction(set.version())) {
+        return *fraction;
+    }
+
+    auto& s = *cf.schema();
+    auto samples = sst->get_key_samples(s, dht::token_range::make_open_ended_both_sides());
+    if (samples.empty()) {
+        samples.push_back(sst->get_first_decorated_key());
+    }
+    auto selector = set.make_incremental_selector();
+    std::unordered_set<shared_sstable> compacting{sst};
+    auto max_timestamp = sst->get_stats_metadata().max_timestamp;
+
+    size_t step = std::max(samples.size() / max_samples, size_t(1));
+    size_t checked = 0;
+    size_t purgeable = 0;
+    for (size_t i = 0; i < samples.size(); i += step) {
+        checked++;
+        // Every tombstone of sst for this key is purgeable if older than all data it may shadow.
+        if (get_max_purgeable_timestamp(cf, selector, compacting, samples[i]) > max_timestamp) {
+            purgeable++;
+        }
+    }
+    auto fraction = double(purgeable) / checked;
+    sst->cache_purgeable_tombstone_fraction(set.version(), fraction);
+    return fraction;
+}
+
 std::unordered_set<sstables::shared_sstable>
 get_fully_expired_sstables(column_family& cf, const std::vector<sstables::shared_sstable>& compacting, gc_clock::time_point gc_before) {
     clogger.debug("Checking droppable sstables in {}.{}", cf.schema()->ks_name(), cf.schema()->cf_name());
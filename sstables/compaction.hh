@@ -43,6 +43,11 @@ namespace sstables {
         std::optional<compaction_weight_registration> weight_registration;
         // Calls compaction manager's task for this compaction to release reference to exhausted sstables.
         std::function<void(const std::vector<shared_sstable>& exhausted_sstables)> release_exhausted;
+        // Tombstones past gc_before which can't be purged because they may shadow data in sstables
+        // that aren't compacted are written to a garbage collected sstable rather than to the output.
+        // It's added to the table along with the output, and as it holds nothing but such tombstones,
+        // it goes away as soon as it's compacted with the sstables they shadow data in.
+        bool use_garbage_collected_sstable = false;
 
         compaction_descriptor() = default;
 
@@ -97,6 +102,7 @@ namespace sstables {
         uint64_t end_size = 0;
         uint64_t total_partitions = 0;
         uint64_t total_keys_written = 0;
+        uint64_t purged_tombstones = 0;
         int64_t ended_at;
         std::vector<shared_sstable> new_sstables;
         sstring stop_requested;
@@ -145,6 +151,11 @@ namespace sstables {
             column_family& cf, std::function<shared_sstable(shard_id)> creator,
         uint64_t max_sstable_size, uint32_t sstable_level);
 
+    // Estimate the fraction of the partitions of sst whose tombstones a compaction of sst alone
+    // could purge, as they can't shadow data in other sstables of cf, by checking a sample of
+    // its keys against the other sstables the way compaction does.
+    double estimate_purgeable_tombstone_fraction(column_family& cf, const shared_sstable& sst);
+
     // Return list of expired sstables for column family cf.
     // A sstable is fully expired *iff* its max_local_deletion_time precedes gc_before and its
     // max timestamp is lower than any other relevant sstable.
@@ -290,6 +290,40 @@ future<> compaction_manager::submit_major_compaction(column_family* cf) {
     return task->compaction_done.get_future().then([task] {});
 }
 
+future<> compaction_manager::perform_offstrategy_compaction(column_family* cf) {
+    if (_stopped) {
+        return make_ready_future<>();
+    }
+    auto task = make_lw_shared<compaction_manager::task>();
+    task->compacting_cf = cf;
+    _tasks.push_back(task);
+
+    task->compaction_done = with_semaphore(_offstrategy_sem, 1, [this, task, cf] {
+        // take read lock for cf, so major compaction and off-strategy compaction can't proceed in parallel.
+        return with_lock(_compaction_locks[cf].for_read(), [this, task, cf] {
+            _stats.active_tasks++;
+            if (!can_proceed(task)) {
+                return make_ready_future<>();
+            }
+            // runs under the streaming scheduling group rather than the compaction one.
+            return cf->run_offstrategy_compaction();
+        });
+    }).then_wrapped([this, task] (future<> f) {
+        _stats.active_tasks--;
+        _tasks.remove(task);
+        try {
+            f.get();
+            _stats.completed_tasks++;
+        } catch (sstables::compaction_stop_exception& e) {
+            cmlog.info("off-strategy compaction stopped, reason: {}", e.what());
+        } catch (...) {
+            cmlog.error("off-strategy compaction failed, reason: {}", std::current_exception());
+            _stats.errors++;
+        }
+    });
+    return task->compaction_done.get_future().then([task] {});
+}
+
 future<> compaction_manager::run_resharding_job(column_family* cf, std::function<future<>()> job) {
     if (_stopped) {
         return make_ready_future<>();
@@ -360,7 +394,9 @@ compaction_manager::compaction_manager(seastar::scheduling_group sg, const ::io_
     , _backlog_manager(_compaction_controller)
     , _scheduling_group(_compaction_controller.sg())
 , _available_memory(available_memory)
-{}
+{
+    _static_shares = shares;
+}
 
 compaction_manager::compaction_manager()
     : compaction_manager(seastar::default_scheduling_group(), default_priority_class(), 1)
@@ -381,6 +417,87 @@ void compaction_manager::register_metrics() {
     });
 }
 
+void compaction_manager::register_compaction(lw_shared_ptr<sstables::compaction_info> c) {
+    _compactions.push_back(c);
+    auto& e = _fair_queue[c->cf];
+    if (e.active_compactions++ == 0) {
+        // A table coming back from idleness doesn't get credit for the time it didn't compact.
+        e.virtual_time = std::max(e.virtual_time, min_active_virtual_time(c->cf).value_or(0));
+        e.last_charge = lowres_clock::now();
+    }
+}
+
+void compaction_manager::deregister_compaction(lw_shared_ptr<sstables::compaction_info> c) {
+    _compactions.remove(c);
+    auto it = _fair_queue.find(c->cf);
+    if (it != _fair_queue.end() && it->second.active_compactions) {
+        it->second.active_compactions--;
+    }
+    // Tables waiting for this one to catch up may proceed.
+    _fair_queue_cv.broadcast();
+}
+
+std::optional<double> compaction_manager::min_active_virtual_time(column_family* cf) const {
+    std::optional<double> min;
+    auto now = lowres_clock::now();
+    for (auto& [other, e] : _fair_queue) {
+        if (other == cf || !e.active_compactions || now - e.last_charge > fair_queue_idle_threshold()) {
+            continue;
+        }
+        min = std::min(min.value_or(e.virtual_time), e.virtual_time);
+    }
+    return min;
+}
+
+float compaction_manager::compaction_shares(column_family* cf) const {
+    if (_static_shares) {
+        return *_static_shares;
+    }
+    auto b = cf->get_compaction_strategy().get_backlog_tracker().backlog() / _available_memory;
+    if (compaction_controller::backlog_disabled(b)) {
+        return _compaction_controller.controller_output(compaction_controller::normalization_factor);
+    }
+    return _compaction_controller.controller_output(b);
+}
+
+uint64_t compaction_manager::compacted_bytes(column_family* cf) const {
+    auto it = _fair_queue.find(cf);
+    return it != _fair_queue.end() ? it->second.compacted_bytes : 0;
+}
+
+future<> compaction_manager::charge_compaction(const sstables::compaction_info& info, uint64_t bytes) {
+    auto* cf = info.cf;
+    auto& e = _fair_queue[cf];
+    auto now = lowres_clock::now();
+    if (now - e.last_charge > fair_queue_idle_threshold()) {
+        e.virtual_time = std::max(e.virtual_time, min_active_virtual_time(cf).value_or(0));
+    }
+    e.virtual_time += bytes / std::max(compaction_shares(cf), 1.0f);
+    e.compacted_bytes += bytes;
+    e.last_charge = now;
+    _fair_queue_cv.broadcast();
+
+    // Wait while ahead of the slowest table still compacting by more than a quantum. Tables which
+    // stop charging become idle after a while, so waiting is periodically reevaluated.
+    return repeat([this, cf, &info] {
+        if (_stopped || info.is_stop_requested()) {
+            return make_ready_future<stop_iteration>(stop_iteration::yes);
+        }
+        auto it = _fair_queue.find(cf);
+        auto min = min_active_virtual_time(cf);
+        if (it == _fair_queue.end() || !min || it->second.virtual_time - *min <= fair_queue_quantum) {
+            return make_ready_future<stop_iteration>(stop_iteration::yes);
+        }
+        return _fair_queue_cv.wait(std::chrono::milliseconds(100)).then_wrapped([] (future<> f) {
+            try {
+                f.get();
+            } catch (condition_variable_timed_out&) {
+            }
+            return stop_iteration::no;
+        });
+    });
+}
+
 void compaction_manager::start() {
     _stopped = false;
     register_metrics();
@@ -436,6 +553,7 @@ future<> compaction_manager::stop() {
     for (auto& info : _compactions) {
         info->stop("shutdown");
     }
+    _fair_queue_cv.broadcast();
     // Wait for each task handler to stop. Copy list because task remove itself
     // from the list when done.
     auto tasks = _tasks;
@@ -687,12 +805,14 @@ future<> compaction_manager::remove(column_family* cf) {
         }
     }
     _postponed.erase(boost::remove(_postponed, cf), _postponed.end());
+    _fair_queue_cv.broadcast();
 
     // Wait for the termination of an ongoing compaction on cf, if any.
     return do_for_each(*tasks_to_stop, [this, cf] (auto& task) {
         return this->task_stop(task);
     }).then([this, cf, tasks_to_stop] {
         _compaction_locks.erase(cf);
+        _fair_queue.erase(cf);
     });
 }
 
@@ -720,6 +840,7 @@ void compaction_manager::stop_compaction(sstring type) {
             info->stop("user request");
         }
     }
+    _fair_queue_cv.broadcast();
 }
 
 void compaction_manager::on_compaction_complete(compaction_weight_registration& weight_registration) {
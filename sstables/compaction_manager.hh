@@ -94,6 +94,32 @@ class compaction_manager {
 
     semaphore _resharding_sem{1};
 
+    // Serializes off-strategy compactions, they're expected to be large.
+    semaphore _offstrategy_sem{1};
+
+    // All compactions run in the same scheduling group, whose shares are set from the backlog
+    // of all tables together. Within it, the write throughput of compaction is shared among
+    // tables by weighted fair queuing, each table weighted by the shares the controller would
+    // set for its own backlog. See charge_compaction().
+    struct fair_queue_entry {
+        // Bytes written by compactions of the table, each charge divided by the table shares.
+        double virtual_time = 0;
+        unsigned active_compactions = 0;
+        uint64_t compacted_bytes = 0;
+        lowres_clock::time_point last_charge;
+    };
+    std::unordered_map<column_family*, fair_queue_entry> _fair_queue;
+    condition_variable _fair_queue_cv;
+    // Set when the controller is disabled, in which case all tables get the same shares.
+    std::optional<float> _static_shares;
+    // How far, in virtual time, a table may get ahead of the slowest table still compacting.
+    static constexpr double fair_queue_quantum = double(1 << 20) / 50;
+    // A table which didn't charge for that long is considered idle, and no one waits for it.
+    static constexpr std::chrono::seconds fair_queue_idle_threshold() { return std::chrono::seconds(1); }
+
+    // Lowest virtual time among tables which are compacting, other than cf.
+    std::optional<double> min_active_virtual_time(column_family* cf) const;
+
     std::function<void()> compaction_submission_callback();
     // all registered column families are submitted for compaction at a constant interval.
     // Submission is a NO-OP when there's nothing to do, so it's fine to call it regularly.
@@ -179,6 +205,10 @@ class compaction_manager {
     // Submit a column family for major compaction.
     future<> submit_major_compaction(column_family* cf);
 
+    // Submit a column family for off-strategy compaction of its maintenance sstables, and wait
+    // for its termination. See table::run_offstrategy_compaction().
+    future<> perform_offstrategy_compaction(column_family* cf);
+
     // Run a resharding job for a given column family.
     // it completes when future returned by job is ready or returns immediately
     // if manager was asked to stop.
@@ -201,13 +231,9 @@ class compaction_manager {
         return _stats;
     }
 
-    void register_compaction(lw_shared_ptr<sstables::compaction_info> c) {
-        _compactions.push_back(c);
-    }
+    void register_compaction(lw_shared_ptr<sstables::compaction_info> c);
 
-    void deregister_compaction(lw_shared_ptr<sstables::compaction_info> c) {
-        _compactions.remove(c);
-    }
+    void deregister_compaction(lw_shared_ptr<sstables::compaction_info> c);
 
     const std::list<lw_shared_ptr<sstables::compaction_info>>& get_compactions() const {
         return _compactions;
@@ -225,6 +251,17 @@ class compaction_manager {
         return _backlog_manager.backlog();
     }
 
+    // Charge the table of a running compaction for bytes written by it. The returned future
+    // is ready once the table is within its fair share of compaction throughput, or the
+    // compaction was asked to stop.
+    future<> charge_compaction(const sstables::compaction_info& info, uint64_t bytes);
+
+    // Shares of compaction throughput a table gets, derived from its own backlog.
+    float compaction_shares(column_family* cf) const;
+
+    // Bytes written by compactions of a table so far.
+    uint64_t compacted_bytes(column_family* cf) const;
+
     void register_backlog_tracker(compaction_backlog_tracker& backlog_tracker) {
         _backlog_manager.register_backlog_tracker(backlog_tracker);
     }
@@ -56,6 +56,7 @@
 #include "date_tiered_compaction_strategy.hh"
 #include "leveled_compaction_strategy.hh"
 #include "time_window_compaction_strategy.hh"
+#include "incremental_compaction_strategy.hh"
 #include "sstables/compaction_backlog_manager.hh"
 #include "sstables/size_tiered_backlog_tracker.hh"
 
@@ -94,17 +95,24 @@ class sstable_set_impl {
     virtual std::unique_ptr<incremental_selector_impl> make_incremental_selector() const = 0;
 };
 
+static uint64_t next_sstable_set_version() {
+    static thread_local uint64_t version = 0;
+    return ++version;
+}
+
 sstable_set::sstable_set(std::unique_ptr<sstable_set_impl> impl, schema_ptr s, lw_shared_ptr<sstable_list> all)
         : _impl(std::move(impl))
         , _schema(std::move(s))
-        , _all(std::move(all)) {
+        , _all(std::move(all))
+        , _version(next_sstable_set_version()) {
 }
 
 sstable_set::sstable_set(const sstable_set& x)
         : _impl(x._impl->clone())
         , _schema(x._schema)
         , _all(make_lw_shared(sstable_list(*x._all)))
-        , _all_runs(x._all_runs) {
+        , _all_runs(x._all_runs)
+        , _version(x._version) {
 }
 
 sstable_set::sstable_set(sstable_set&&) noexcept = default;
@@ -149,6 +157,7 @@ sstable_set::insert(shared_sstable sst) {
         _impl->erase(sst);
         throw;
     }
+    _version = next_sstable_set_version();
 }
 
 void
@@ -156,6 +165,7 @@ sstable_set::erase(shared_sstable sst) {
     _impl->erase(sst);
     _all->erase(sst);
     _all_runs[sst->run_identifier()].erase(sst);
+    _version = next_sstable_set_version();
 }
 
 sstable_set::~sstable_set() = default;
@@ -410,6 +420,26 @@ std::unique_ptr<sstable_set_impl> leveled_compaction_strategy::make_sstable_set(
     return std::make_unique<partitioned_sstable_set>(std::move(schema));
 }
 
+bool compaction_strategy_impl::worth_dropping_tombstones(const shared_sstable& sst, column_family& cf, gc_clock::time_point gc_before) {
+    if (_disable_tombstone_compaction) {
+        return false;
+    }
+    // ignore sstables that were created just recently because there's a chance
+    // that expired tombstones still cover old data and thus cannot be removed.
+    // We want to avoid a compaction loop here on the same data by considering
+    // only old enough sstables.
+    if (db_clock::now()-_tombstone_compaction_interval < sst->data_file_write_time()) {
+        return false;
+    }
+    auto ratio = sst->estimate_droppable_tombstone_ratio(gc_before);
+    if (ratio < _tombstone_threshold || _unchecked_tombstone_compaction) {
+        return ratio >= _tombstone_threshold;
+    }
+    // A tombstone which may shadow data in another sstable is kept by a compaction of its
+    // sstable alone, so count only the droppable tombstones such a compaction would purge.
+    return ratio * estimate_purgeable_tombstone_fraction(cf, sst) >= _tombstone_threshold;
+}
+
 std::vector<resharding_descriptor>
 compaction_strategy_impl::get_resharding_jobs(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
     std::vector<resharding_descriptor> jobs;
@@ -423,6 +453,17 @@ compaction_strategy_impl::get_resharding_jobs(column_family& cf, std::vector<sst
     return jobs;
 }
 
+std::vector<compaction_descriptor>
+compaction_strategy_impl::get_reshaping_jobs(column_family& cf, std::vector<sstables::shared_sstable> input) {
+    if (input.size() < 2) {
+        return {};
+    }
+    // Merging all of the input is what most strategies would eventually do with it.
+    std::vector<compaction_descriptor> jobs;
+    jobs.emplace_back(std::move(input));
+    return jobs;
+}
+
 // The backlog for TWCS is just the sum of the individual backlogs in each time window.
 // We'll keep various SizeTiered backlog tracker objects-- one per window for the static SSTables.
 // We then scan the current compacting and in-progress writes and matching them to existing time
@@ -507,6 +548,87 @@ class time_window_backlog_tracker final : public compaction_backlog_tracker::imp
     }
 };
 
+// The backlog for ICS is the size-tiered backlog, see size_tiered_backlog_tracker.hh, with
+// runs in place of SSTables: Si is the size of a whole run, and every fragment of that run
+// contributes its own bytes weighted by log4(Si). Partial writes are attributed to the run
+// they are being written into, so a compaction output grows a single run instead of adding
+// many small SSTables to the lowest tier.
+class incremental_backlog_tracker final : public compaction_backlog_tracker::impl {
+    int64_t _total_bytes = 0;
+    double _runs_backlog_contribution = 0.0f;
+    std::unordered_map<utils::UUID, int64_t> _run_bytes;
+
+    double log4(double x) const {
+        static constexpr double inv_log_4 = 1.0f / std::log(4);
+        return log(x) * inv_log_4;
+    }
+
+    double contribution(int64_t run_bytes) const {
+        return run_bytes > 0 ? run_bytes * log4(run_bytes) : 0;
+    }
+
+    int64_t run_bytes(const utils::UUID& run) const {
+        auto it = _run_bytes.find(run);
+        return it != _run_bytes.end() ? it->second : 0;
+    }
+
+    void update_run(const utils::UUID& run, int64_t delta) {
+        auto& bytes = _run_bytes[run];
+        _runs_backlog_contribution -= contribution(bytes);
+        bytes += delta;
+        _runs_backlog_contribution += contribution(bytes);
+        _total_bytes += delta;
+        if (bytes <= 0) {
+            _run_bytes.erase(run);
+        }
+    }
+public:
+    virtual double backlog(const compaction_backlog_tracker::ongoing_writes& ow, const compaction_backlog_tracker::ongoing_compactions& oc) const override {
+        std::unordered_map<utils::UUID, int64_t> written_per_run;
+        for (auto& swp : ow) {
+            auto written = swp.second->written();
+            if (written > 0) {
+                written_per_run[swp.first->run_identifier()] += written;
+            }
+        }
+
+        auto total_bytes = _total_bytes;
+        auto runs_contribution = _runs_backlog_contribution;
+        for (auto& [run, written] : written_per_run) {
+            auto bytes = run_bytes(run);
+            total_bytes += written;
+            runs_contribution += contribution(bytes + written) - contribution(bytes);
+        }
+
+        for (auto& crp : oc) {
+            auto compacted = crp.second->compacted();
+            auto bytes = run_bytes(crp.first->run_identifier());
+            if (compacted > 0 && bytes > 0) {
+                total_bytes -= compacted;
+                runs_contribution -= compacted * log4(bytes);
+            }
+        }
+
+        if (total_bytes <= 0) {
+            return 0;
+        }
+        auto b = (total_bytes * log4(total_bytes)) - runs_contribution;
+        return b > 0 ? b : 0;
+    }
+
+    virtual void add_sstable(sstables::shared_sstable sst) override {
+        if (sst->data_size() > 0) {
+            update_run(sst->run_identifier(), sst->data_size());
+        }
+    }
+
+    virtual void remove_sstable(sstables::shared_sstable sst) override {
+        if (sst->data_size() > 0) {
+            update_run(sst->run_identifier(), -int64_t(sst->data_size()));
+        }
+    }
+};
+
 class leveled_compaction_backlog_tracker final : public compaction_backlog_tracker::impl {
     // Because we can do SCTS in L0, we will account for that in the backlog.
     // Whatever backlog we accumulate here will be added to the main backlog.
@@ -620,6 +742,10 @@ class null_compaction_strategy : public compaction_strategy_impl {
         return 0;
     }
 
+    virtual std::vector<compaction_descriptor> get_reshaping_jobs(column_family& cf, std::vector<sstables::shared_sstable> input) override {
+        return {};
+    }
+
     virtual compaction_strategy_type type() const {
         return compaction_strategy_type::null;
     }
@@ -699,6 +825,25 @@ size_tiered_compaction_strategy::size_tiered_compaction_strategy(const size_tier
     , _backlog_tracker(std::make_unique<size_tiered_backlog_tracker>())
 {}
 
+incremental_compaction_strategy::incremental_compaction_strategy(const std::map<sstring, sstring>& options)
+    : compaction_strategy_impl(options)
+    , _options(options)
+    , _backlog_tracker(std::make_unique<incremental_backlog_tracker>())
+{
+    using namespace cql3::statements;
+    auto option_value = compaction_strategy_impl::get_value(options, FRAGMENT_SIZE_OPTION);
+    auto fragment_size_in_mb = property_definitions::to_int(FRAGMENT_SIZE_OPTION, option_value, DEFAULT_MAX_FRAGMENT_SIZE_IN_MB);
+    if (fragment_size_in_mb <= 0) {
+        throw exceptions::configuration_exception(format("{} must be greater than 0, but was {}", FRAGMENT_SIZE_OPTION, fragment_size_in_mb));
+    }
+    _fragment_size = uint64_t(fragment_size_in_mb) * 1024 * 1024;
+    // Exhausted fragments are kept until the garbage collected sstable is sealed at the end of
+    // compaction, which would take away the space bound of compacting runs incrementally.
+    if (_use_garbage_collected_sstable) {
+        throw exceptions::configuration_exception(format("{} is not supported by IncrementalCompactionStrategy", GARBAGE_COLLECTED_SSTABLE_OPTION));
+    }
+}
+
 compaction_strategy::compaction_strategy(::shared_ptr<compaction_strategy_impl> impl)
     : _compaction_strategy_impl(std::move(impl)) {}
 compaction_strategy::compaction_strategy() = default;
@@ -712,7 +857,23 @@ compaction_strategy_type compaction_strategy::type() const {
 }
 
 compaction_descriptor compaction_strategy::get_sstables_for_compaction(column_family& cfs, std::vector<sstables::shared_sstable> candidates) {
-    return _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(candidates));
+    // Keeping repaired data apart from unrepaired data lets repair skip the former.
+    if (!_compaction_strategy_impl->separate_repaired_data()) {
+        return _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(candidates));
+    }
+    auto repaired_begin = std::stable_partition(candidates.begin(), candidates.end(), [] (const shared_sstable& sst) {
+        return !sst->is_repaired();
+    });
+    if (repaired_begin == candidates.begin() || repaired_begin == candidates.end()) {
+        return _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(candidates));
+    }
+    std::vector<shared_sstable> repaired(std::make_move_iterator(repaired_begin), std::make_move_iterator(candidates.end()));
+    candidates.erase(repaired_begin, candidates.end());
+    auto descriptor = _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(candidates));
+    if (!descriptor.sstables.empty()) {
+        return descriptor;
+    }
+    return _compaction_strategy_impl->get_sstables_for_compaction(cfs, std::move(repaired));
 }
 
 compaction_descriptor compaction_strategy::get_major_compaction_job(column_family& cf, std::vector<sstables::shared_sstable> candidates) {
@@ -723,6 +884,24 @@ std::vector<resharding_descriptor> compaction_strategy::get_resharding_jobs(colu
     return _compaction_strategy_impl->get_resharding_jobs(cf, std::move(candidates));
 }
 
+std::vector<compaction_descriptor> compaction_strategy::get_reshaping_jobs(column_family& cf, std::vector<sstables::shared_sstable> input) {
+    if (!_compaction_strategy_impl->separate_repaired_data()) {
+        return _compaction_strategy_impl->get_reshaping_jobs(cf, std::move(input));
+    }
+    auto repaired_begin = std::stable_partition(input.begin(), input.end(), [] (const shared_sstable& sst) {
+        return !sst->is_repaired();
+    });
+    if (repaired_begin == input.begin() || repaired_begin == input.end()) {
+        return _compaction_strategy_impl->get_reshaping_jobs(cf, std::move(input));
+    }
+    std::vector<shared_sstable> repaired(std::make_move_iterator(repaired_begin), std::make_move_iterator(input.end()));
+    input.erase(repaired_begin, input.end());
+    auto jobs = _compaction_strategy_impl->get_reshaping_jobs(cf, std::move(input));
+    auto repaired_jobs = _compaction_strategy_impl->get_reshaping_jobs(cf, std::move(repaired));
+    std::move(repaired_jobs.begin(), repaired_jobs.end(), std::back_inserter(jobs));
+    return jobs;
+}
+
 void compaction_strategy::notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) {
     _compaction_strategy_impl->notify_completion(removed, added);
 }
@@ -739,6 +918,10 @@ bool compaction_strategy::use_clustering_key_filter() const {
     return _compaction_strategy_impl->use_clustering_key_filter();
 }
 
+bool compaction_strategy::use_garbage_collected_sstable() const {
+    return _compaction_strategy_impl->use_garbage_collected_sstable();
+}
+
 sstable_set
 compaction_strategy::make_sstable_set(schema_ptr schema) const {
     return sstable_set(
@@ -770,6 +953,9 @@ compaction_strategy make_compaction_strategy(compaction_strategy_type strategy,
     case compaction_strategy_type::time_window:
         impl = make_shared<time_window_compaction_strategy>(time_window_compaction_strategy(options));
         break;
+    case compaction_strategy_type::incremental:
+        impl = make_shared<incremental_compaction_strategy>(incremental_compaction_strategy(options));
+        break;
     default:
         throw std::runtime_error("strategy not supported");
     }
@@ -23,6 +23,7 @@
 
 #include "cql3/statements/property_definitions.hh"
 #include "compaction_backlog_manager.hh"
+#include <boost/algorithm/string/predicate.hpp>
 
 namespace sstables {
 
@@ -37,11 +38,17 @@ class compaction_strategy_impl {
 protected:
     const sstring TOMBSTONE_THRESHOLD_OPTION = "tombstone_threshold";
     const sstring TOMBSTONE_COMPACTION_INTERVAL_OPTION = "tombstone_compaction_interval";
+    const sstring UNCHECKED_TOMBSTONE_COMPACTION_OPTION = "unchecked_tombstone_compaction";
+    const sstring GARBAGE_COLLECTED_SSTABLE_OPTION = "garbage_collected_sstable";
 
     bool _use_clustering_key_filter = false;
     bool _disable_tombstone_compaction = false;
     float _tombstone_threshold = DEFAULT_TOMBSTONE_THRESHOLD;
     db_clock::duration _tombstone_compaction_interval = DEFAULT_TOMBSTONE_COMPACTION_INTERVAL();
+    // don't check whether tombstones of a sstable shadow data in other sstables before compacting it alone.
+    bool _unchecked_tombstone_compaction = false;
+    // write tombstones which can't be purged yet to a sstable of their own, see compaction_descriptor.
+    bool _use_garbage_collected_sstable = false;
 public:
     static std::optional<sstring> get_value(const std::map<sstring, sstring>& options, const sstring& name) {
         auto it = options.find(name);
@@ -62,6 +69,12 @@ class compaction_strategy_impl {
         auto interval = property_definitions::to_long(TOMBSTONE_COMPACTION_INTERVAL_OPTION, tmp_value, DEFAULT_TOMBSTONE_COMPACTION_INTERVAL().count());
         _tombstone_compaction_interval = db_clock::duration(std::chrono::seconds(interval));
 
+        tmp_value = get_value(options, UNCHECKED_TOMBSTONE_COMPACTION_OPTION);
+        _unchecked_tombstone_compaction = tmp_value && boost::algorithm::iequals(*tmp_value, "true");
+
+        tmp_value = get_value(options, GARBAGE_COLLECTED_SSTABLE_OPTION);
+        _use_garbage_collected_sstable = tmp_value && boost::algorithm::iequals(*tmp_value, "true");
+
         // FIXME: validate options.
     }
 public:
@@ -71,11 +84,16 @@ class compaction_strategy_impl {
         return compaction_descriptor(std::move(candidates));
     }
     virtual std::vector<resharding_descriptor> get_resharding_jobs(column_family& cf, std::vector<sstables::shared_sstable> candidates);
+    virtual std::vector<compaction_descriptor> get_reshaping_jobs(column_family& cf, std::vector<sstables::shared_sstable> input);
     virtual void notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) { }
     virtual compaction_strategy_type type() const = 0;
     virtual bool parallel_compaction() const {
         return true;
     }
+    // Whether repaired and unrepaired sstables are compacted apart, see compaction_strategy.
+    virtual bool separate_repaired_data() const {
+        return true;
+    }
     virtual int64_t estimated_pending_compactions(column_family& cf) const = 0;
     virtual std::unique_ptr<sstable_set_impl> make_sstable_set(schema_ptr schema) const;
 
@@ -83,25 +101,19 @@ class compaction_strategy_impl {
         return _use_clustering_key_filter;
     }
 
+    bool use_garbage_collected_sstable() const {
+        return _use_garbage_collected_sstable;
+    }
+
     virtual bool ignore_partial_runs() const {
         return false;
     }
 
     // Check if a given sstable is entitled for tombstone compaction based on its
-    // droppable tombstone histogram and gc_before.
-    bool worth_dropping_tombstones(const shared_sstable& sst, gc_clock::time_point gc_before) {
-        if (_disable_tombstone_compaction) {
-            return false;
-        }
-        // ignore sstables that were created just recently because there's a chance
-        // that expired tombstones still cover old data and thus cannot be removed.
-        // We want to avoid a compaction loop here on the same data by considering
-        // only old enough sstables.
-        if (db_clock::now()-_tombstone_compaction_interval < sst->data_file_write_time()) {
-            return false;
-        }
-        return sst->estimate_droppable_tombstone_ratio(gc_before) >= _tombstone_threshold;
-    }
+    // droppable tombstone histogram and gc_before, and unless unchecked, on how many
+    // of its droppable tombstones would actually be purged given the other sstables
+    // of cf they may shadow data in.
+    bool worth_dropping_tombstones(const shared_sstable& sst, column_family& cf, gc_clock::time_point gc_before);
 
     virtual compaction_backlog_tracker& get_backlog_tracker() = 0;
 };
@@ -250,6 +250,12 @@ class local_compression {
                     size_t output_len) const;
     size_t compress_max_size(size_t input_len) const;
 
+    // Size of the dictionary to train before compressing, 0 if none.
+    size_t dictionary_size() const;
+    // Trains a dictionary from the samples and switches to compressing
+    // with it. Returns the dictionary, empty if none could be trained.
+    bytes train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes);
+
     operator bool() const {
         return _compressor != nullptr;
     }
@@ -259,26 +265,36 @@ local_compression::local_compression(compressor_ptr p)
     : _compressor(std::move(p))
 {}
 
-local_compression::local_compression(const compression& c)
-    : _compressor([&c] {
-        sstring n(c.name.value.begin(), c.name.value.end());
-        return compressor::create(n, [&c, &n](const sstring& key) -> compressor::opt_string {
-            if (key == compression_parameters::CHUNK_LENGTH_KB || key == compression_parameters::CHUNK_LENGTH_KB_ERR) {
-                return to_sstring(c.chunk_len);
-            }
-            if (key == compression_parameters::SSTABLE_COMPRESSION) {
-                return n;
-            }
-            for (auto& o : c.options.elements) {
-                if (key == sstring(o.key.value.begin(), o.key.value.end())) {
-                    return sstring(o.value.value.begin(), o.value.value.end());
-                }
+static compressor_ptr make_compressor(const compression& c) {
+    sstring n(c.name.value.begin(), c.name.value.end());
+    auto p = compressor::create(n, [&c, &n](const sstring& key) -> compressor::opt_string {
+        if (key == compression_parameters::CHUNK_LENGTH_KB || key == compression_parameters::CHUNK_LENGTH_KB_ERR) {
+            return to_sstring(c.chunk_len);
+        }
+        if (key == compression_parameters::SSTABLE_COMPRESSION) {
+            return n;
+        }
+        for (auto& o : c.options.elements) {
+            if (key == sstring(o.key.value.begin(), o.key.value.end())) {
+                return sstring(o.value.value.begin(), o.value.value.end());
             }
-            return std::nullopt;
-        });
-    }())
+        }
+        return std::nullopt;
+    });
+    if (p && !c.dictionary().empty()) {
+        p = p->with_dictionary(c.dictionary());
+    }
+    return p;
+}
+
+local_compression::local_compression(const compression& c)
+    : _compressor(make_compressor(c))
 {}
 
+compressor_ptr compression::make_reader_compressor() const {
+    return make_compressor(*this);
+}
+
 size_t local_compression::uncompress(const char* input,
                 size_t input_len, char* output, size_t output_len) const {
     if (!_compressor) {
@@ -297,6 +313,18 @@ size_t local_compression::compress_max_size(size_t input_len) const {
     return _compressor ? _compressor->compress_max_size(input_len) : 0;
 }
 
+size_t local_compression::dictionary_size() const {
+    return _compressor ? _compressor->dictionary_size() : 0;
+}
+
+bytes local_compression::train_dictionary(bytes_view samples, const std::vector<size_t>& sample_sizes) {
+    auto dictionary = _compressor->train_dictionary(samples, sample_sizes);
+    if (!dictionary.empty()) {
+        _compressor = _compressor->with_dictionary(dictionary);
+    }
+    return dictionary;
+}
+
 void compression::set_compressor(compressor_ptr c) {
     if (c) {
         unqualified_name uqn(compressor::namespace_prefix, c->name());
@@ -351,11 +379,11 @@ class compressed_file_data_source_impl : public data_source_impl {
     uint64_t _beg_pos;
     uint64_t _end_pos;
 public:
-    compressed_file_data_source_impl(file f, sstables::compression* cm,
+    compressed_file_data_source_impl(file f, sstables::compression* cm, compressor_ptr compressor,
                 uint64_t pos, size_t len, file_input_stream_options options)
             : _compression_metadata(cm)
             , _offsets(_compression_metadata->offsets.get_accessor())
-            , _compression(*cm)
+            , _compression(std::move(compressor))
     {
         _beg_pos = pos;
         if (pos > _compression_metadata->uncompressed_file_length()) {
@@ -452,10 +480,10 @@ GCC6_CONCEPT(
 )
 class compressed_file_data_source : public data_source {
 public:
-    compressed_file_data_source(file f, sstables::compression* cm,
+    compressed_file_data_source(file f, sstables::compression* cm, compressor_ptr compressor,
             uint64_t offset, size_t len, file_input_stream_options options)
         : data_source(std::make_unique<compressed_file_data_source_impl<ChecksumType>>(
-                std::move(f), cm, offset, len, std::move(options)))
+                std::move(f), cm, std::move(compressor), offset, len, std::move(options)))
         {}
 };
 
@@ -464,11 +492,11 @@ GCC6_CONCEPT(
     requires ChecksumUtils<ChecksumType>
 )
 inline input_stream<char> make_compressed_file_input_stream(
-        file f, sstables::compression *cm, uint64_t offset, size_t len,
+        file f, sstables::compression *cm, compressor_ptr compressor, uint64_t offset, size_t len,
         file_input_stream_options options)
 {
     return input_stream<char>(compressed_file_data_source<ChecksumType>(
-            std::move(f), cm, offset, len, std::move(options)));
+            std::move(f), cm, std::move(compressor), offset, len, std::move(options)));
 }
 
 // For SSTables 2.x (formats 'ka' and 'la'), the full checksum is a combination of checksums of compressed chunks.
@@ -493,6 +521,20 @@ class compressed_file_data_sink_impl : public data_sink_impl {
     sstables::local_compression _compression;
     size_t _pos = 0;
     uint32_t _full_checksum;
+    // Chunks held back until there are enough of them to train the
+    // compression dictionary they will be compressed with. They are copied
+    // one after the other into a single buffer, which is what the trainer
+    // takes, and passed on to compression as shares of it.
+    temporary_buffer<char> _dictionary_samples;
+    std::vector<size_t> _dictionary_sample_sizes;
+    size_t _dictionary_samples_size = 0;
+    bool _dictionary_pending;
+
+    // zstd recommends training on about 100 times the dictionary size, but
+    // training runs on the reactor and takes time in proportion to the
+    // samples, so they are capped, and a large dictionary makes do with less.
+    static constexpr size_t dictionary_samples_ratio = 100;
+    static constexpr size_t max_dictionary_samples_size = 256 * 1024;
 public:
     compressed_file_data_sink_impl(file f, sstables::compression* cm, sstables::local_compression lc, file_output_stream_options options)
             : _out(make_file_output_stream(std::move(f), options))
@@ -500,10 +542,55 @@ class compressed_file_data_sink_impl : public data_sink_impl {
             , _offsets(_compression_metadata->offsets.get_writer())
             , _compression(lc)
             , _full_checksum(ChecksumType::init_checksum())
+            , _dictionary_pending(_compression.dictionary_size() != 0)
     {}
 
     future<> put(net::packet data) { abort(); }
     virtual future<> put(temporary_buffer<char> buf) override {
+        if (_dictionary_pending) {
+            auto samples_size = std::min(_compression.dictionary_size() * dictionary_samples_ratio, max_dictionary_samples_size);
+            if (_dictionary_samples_size + buf.size() > samples_size) {
+                return flush_dictionary_samples().then([this, buf = std::move(buf)] () mutable {
+                    return compress_and_write(std::move(buf));
+                });
+            }
+            if (!_dictionary_samples) {
+                _dictionary_samples = temporary_buffer<char>(samples_size);
+            }
+            std::copy_n(buf.get(), buf.size(), _dictionary_samples.get_write() + _dictionary_samples_size);
+            _dictionary_samples_size += buf.size();
+            _dictionary_sample_sizes.push_back(buf.size());
+            if (_dictionary_samples_size < samples_size) {
+                return make_ready_future<>();
+            }
+            return flush_dictionary_samples();
+        }
+        return compress_and_write(std::move(buf));
+    }
+    virtual future<> close() override {
+        auto f = _dictionary_pending ? flush_dictionary_samples() : make_ready_future<>();
+        return f.finally([this] {
+            return _out.close();
+        });
+    }
+private:
+    future<> flush_dictionary_samples() {
+        _dictionary_pending = false;
+        if (!_dictionary_sample_sizes.empty()) {
+            auto samples = bytes_view(reinterpret_cast<const int8_t*>(_dictionary_samples.get()), _dictionary_samples_size);
+            _compression_metadata->set_dictionary(_compression.train_dictionary(samples, _dictionary_sample_sizes));
+        }
+        return do_with(std::exchange(_dictionary_samples, {}), std::exchange(_dictionary_sample_sizes, {}), size_t(0),
+                [this] (temporary_buffer<char>& samples, std::vector<size_t>& sizes, size_t& pos) {
+            return do_for_each(sizes, [this, &samples, &pos] (size_t size) {
+                auto buf = samples.share(pos, size);
+                pos += size;
+                return compress_and_write(std::move(buf));
+            });
+        });
+    }
+
+    future<> compress_and_write(temporary_buffer<char> buf) {
         auto output_len = _compression.compress_max_size(buf.size());
 
         // account space for checksum that goes after compressed data.
@@ -543,9 +630,6 @@ class compressed_file_data_sink_impl : public data_sink_impl {
         auto f = _out.write(compressed.get(), compressed.size());
         return f.then([compressed = std::move(compressed)] {});
     }
-    virtual future<> close() override {
-        return _out.close();
-    }
 };
 
 template <typename ChecksumType, compressed_checksum_mode mode>
@@ -582,10 +666,10 @@ inline output_stream<char> make_compressed_file_output_stream(file f, file_outpu
 }
 
 input_stream<char> sstables::make_compressed_file_k_l_format_input_stream(file f,
-        sstables::compression* cm, uint64_t offset, size_t len,
+        sstables::compression* cm, compressor_ptr compressor, uint64_t offset, size_t len,
         class file_input_stream_options options)
 {
-    return make_compressed_file_input_stream<adler32_utils>(std::move(f), cm, offset, len, std::move(options));
+    return make_compressed_file_input_stream<adler32_utils>(std::move(f), cm, std::move(compressor), offset, len, std::move(options));
 }
 
 output_stream<char> sstables::make_compressed_file_k_l_format_output_stream(file f,
@@ -597,9 +681,9 @@ output_stream<char> sstables::make_compressed_file_k_l_format_output_stream(file
 }
 
 input_stream<char> sstables::make_compressed_file_m_format_input_stream(file f,
-        sstables::compression *cm, uint64_t offset, size_t len,
+        sstables::compression *cm, compressor_ptr compressor, uint64_t offset, size_t len,
         class file_input_stream_options options) {
-    return make_compressed_file_input_stream<crc32_utils>(std::move(f), cm, offset, len, std::move(options));
+    return make_compressed_file_input_stream<crc32_utils>(std::move(f), cm, std::move(compressor), offset, len, std::move(options));
 }
 
 output_stream<char> sstables::make_compressed_file_m_format_output_stream(file f,
@@ -306,6 +306,9 @@ struct compression {
     // Variables *not* found in the "Compression Info" file (added by update()):
     uint64_t _compressed_file_length = 0;
     uint32_t _full_checksum = 0;
+    // Trained compression dictionary, kept in the CompressionDictionary
+    // component. Empty if the chunks were compressed without one.
+    bytes _dictionary;
 public:
     // Set the compressor algorithm, please check the definition of enum compressor.
     void set_compressor(compressor_ptr c);
@@ -363,6 +366,18 @@ struct compression {
         _full_checksum = checksum;
     }
 
+    const bytes& dictionary() const {
+        return _dictionary;
+    }
+
+    void set_dictionary(bytes dictionary) {
+        _dictionary = std::move(dictionary);
+    }
+
+    // Creates a compressor for reading the chunks, with the dictionary
+    // prepared. Compressors aren't thread safe, so each shard needs its own.
+    compressor_ptr make_reader_compressor() const;
+
     friend class sstable;
 };
 
@@ -372,7 +387,7 @@ struct compression {
 // as long as we have *sstables* work in progress, we need to keep the whole
 // sstable alive, and the compression metadata is only a part of it.
 input_stream<char> make_compressed_file_k_l_format_input_stream(file f,
-                sstables::compression* cm, uint64_t offset, size_t len,
+                sstables::compression* cm, compressor_ptr compressor, uint64_t offset, size_t len,
                 class file_input_stream_options options);
 
 output_stream<char> make_compressed_file_k_l_format_output_stream(file f,
@@ -381,7 +396,7 @@ output_stream<char> make_compressed_file_k_l_format_output_stream(file f,
                 const compression_parameters& cp);
 
 input_stream<char> make_compressed_file_m_format_input_stream(file f,
-                sstables::compression* cm, uint64_t offset, size_t len,
+                sstables::compression* cm, compressor_ptr compressor, uint64_t offset, size_t len,
                 class file_input_stream_options options);
 
 output_stream<char> make_compressed_file_m_format_output_stream(file f,
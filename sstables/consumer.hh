@@ -477,6 +477,25 @@ class continuous_data_consumer {
         return fast_forward_to(begin, _stream_position.position + _remain);
     }
 
+    // Like fast_forward_to(), but continues reading from the given stream,
+    // which must start at begin, instead of skipping over the current one.
+    // Returns the replaced stream, which the caller is responsible for closing.
+    input_stream<char> switch_input(input_stream<char>&& input, size_t begin, size_t end) {
+        assert(begin >= _stream_position.position);
+        _stream_position.position = begin;
+
+        assert(end >= _stream_position.position);
+        _remain = end - _stream_position.position;
+
+        _prestate = prestate::NONE;
+        return std::exchange(_input, std::move(input));
+    }
+
+    // Returns the offset past the last byte which is going to be consumed.
+    uint64_t end_position() const {
+        return _stream_position.position + _remain;
+    }
+
     // Returns the offset of the first byte which has not been consumed yet.
     // When called from state_processor::process_state() invoked by this consumer,
     // returns the offset of the first byte after the buffer passed to process_state().
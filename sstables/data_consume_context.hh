@@ -69,14 +69,53 @@ GCC6_CONCEPT(
 )
 class data_consume_context {
     shared_sstable _sst;
+    const io_priority_class* _pc = nullptr;
+    reader_resource_tracker _resource_tracker;
+    lw_shared_ptr<file_input_stream_history> _history;
+    // Offset past the last byte the underlying stream may read.
+    uint64_t _stream_end = 0;
+    read_ahead_tracker _read_ahead{0, 0};
     std::unique_ptr<DataConsumeRowsContext> _ctx;
 
     template <typename Consumer>
-    data_consume_context(const schema& s, shared_sstable sst, Consumer &consumer, input_stream<char> &&input, uint64_t start, uint64_t maxlen)
+    data_consume_context(const schema& s, shared_sstable sst, Consumer &consumer, lw_shared_ptr<file_input_stream_history> history,
+            unsigned read_ahead, uint64_t start, uint64_t maxlen, uint64_t stream_end)
         : _sst(std::move(sst))
-        , _ctx(std::make_unique<DataConsumeRowsContext>(s, _sst, consumer, std::move(input), start, maxlen))
+        , _pc(&consumer.io_priority())
+        , _resource_tracker(consumer.resource_tracker())
+        , _history(std::move(history))
+        , _stream_end(stream_end)
+        , _read_ahead(_sst->sstable_buffer_size, read_ahead)
+        , _ctx(std::make_unique<DataConsumeRowsContext>(s, _sst, consumer, make_input(start), start, maxlen))
     { }
 
+    input_stream<char> make_input(uint64_t pos) {
+        return _sst->data_stream(pos, _stream_end - pos, *_pc, _resource_tracker, _history, _read_ahead.read_ahead());
+    }
+
+    void close_in_background(input_stream<char> in) {
+        auto in_ptr = std::make_unique<input_stream<char>>(std::move(in));
+        auto f = in_ptr->close();
+        f.handle_exception([in_ptr = std::move(in_ptr), sst = _sst, op = background_jobs().start()] (auto) {});
+    }
+
+    // Continues reading at begin from a fresh stream, set up with the
+    // current read-ahead depth. Only done on skips past the read-ahead
+    // window, so the old stream holds nothing which is still going to be
+    // consumed.
+    future<> switch_input(uint64_t begin, uint64_t end) {
+        sstlog.trace("data_consume_rows_context {}: switching to read-ahead {} at {}", _ctx.get(), _read_ahead.read_ahead(), begin);
+        close_in_background(_ctx->switch_input(make_input(begin), begin, end));
+        return make_ready_future<>();
+    }
+
+    future<> skip(uint64_t begin, uint64_t end) {
+        if (_read_ahead.on_skip(begin - _ctx->position())) {
+            return switch_input(begin, end);
+        }
+        return _ctx->fast_forward_to(begin, end);
+    }
+
     friend class sstable;
     friend data_consume_context<DataConsumeRowsContext>
     data_consume_rows<DataConsumeRowsContext>(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, sstable::disk_read_range, uint64_t);
@@ -95,12 +134,20 @@ class data_consume_context {
 
 public:
     future<> read() {
-        return _ctx->consume_input();
+        auto start = _ctx->position();
+        return _ctx->consume_input().then([this, start] {
+            auto end = _ctx->position();
+            if (_sst->_data_read_stats) {
+                // In on-disk bytes, like the bytes read are counted.
+                _sst->_data_read_stats->bytes_consumed += _sst->data_file_offset(end) - _sst->data_file_offset(start);
+            }
+            _read_ahead.on_read(end - start);
+        });
     }
 
     future<> fast_forward_to(uint64_t begin, uint64_t end) {
         _ctx->reset(indexable_element::partition);
-        return _ctx->fast_forward_to(begin, end);
+        return skip(begin, end);
     }
 
     bool need_skip(uint64_t pos) const {
@@ -113,7 +160,7 @@ class data_consume_context {
             return make_ready_future<>();
         }
         _ctx->reset(el);
-        return _ctx->skip_to(begin);
+        return skip(begin, _ctx->end_position());
     }
 
     const reader_position_tracker &reader_position() const {
@@ -178,21 +225,25 @@ inline data_consume_context<DataConsumeRowsContext> data_consume_rows(const sche
     // This potentially enables read-ahead beyond end, until last_end, which
     // can be beneficial if the user wants to fast_forward_to() on the
     // returned context, and may make small skips.
-    auto input = sst->data_stream(toread.start, last_end - toread.start, consumer.io_priority(), consumer.resource_tracker(), sst->_partition_range_history);
-    return {s, std::move(sst), consumer, std::move(input), toread.start, toread.end - toread.start };
+    auto history = sst->_partition_range_history;
+    return {s, std::move(sst), consumer, std::move(history), read_ahead_tracker::default_read_ahead, toread.start, toread.end - toread.start, last_end};
 }
 
 template <typename DataConsumeRowsContext>
 inline data_consume_context<DataConsumeRowsContext> data_consume_single_partition(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer, sstable::disk_read_range toread) {
-    auto input = sst->data_stream(toread.start, toread.end - toread.start, consumer.io_priority(), consumer.resource_tracker(), sst->_single_partition_history);
-    return {s, std::move(sst), consumer, std::move(input), toread.start, toread.end - toread.start };
+    // A single partition usually fits in one buffer, so start without
+    // read-ahead and let the tracker scale it up if the partition is large.
+    auto history = sst->_single_partition_history;
+    return {s, std::move(sst), consumer, std::move(history), read_ahead_tracker::single_partition_read_ahead, toread.start, toread.end - toread.start, toread.end};
 }
 
 // Like data_consume_rows() with bounds, but iterates over whole range
 template <typename DataConsumeRowsContext>
 inline data_consume_context<DataConsumeRowsContext> data_consume_rows(const schema& s, shared_sstable sst, typename DataConsumeRowsContext::consumer& consumer) {
+        // Reading the whole file, e.g. for compaction, is known to be sequential.
         auto data_size = sst->data_size();
-        return data_consume_rows<DataConsumeRowsContext>(s, std::move(sst), consumer, {0, data_size}, data_size);
+        auto history = sst->_partition_range_history;
+        return {s, std::move(sst), consumer, std::move(history), read_ahead_tracker::max_read_ahead, 0, data_size, data_size};
 }
 
 }
@@ -21,12 +21,14 @@
 
 #pragma once
 #include <variant>
+#include <map>
 #include "position_in_partition.hh"
 #include "consumer.hh"
 #include "types.hh"
 #include "column_translation.hh"
 #include "m_format_read_helpers.hh"
 #include "utils/overloaded_functor.hh"
+#include "utils/buffer_input_stream.hh"
 
 namespace sstables {
 
@@ -504,11 +506,132 @@ class promoted_index_blocks_reader : public data_consumer::continuous_data_consu
     {}
 };
 
+// Looks up blocks of an 'mc' promoted index by binary search.
+//
+// In the 'mc' format the promoted index blocks are followed by an array with
+// the offset of each block, relative to the first one. The lookup bisects
+// that array, so finding the block of a position reads and parses O(log n)
+// blocks instead of the whole promoted index, which for wide partitions
+// can be megabytes. Parsed blocks are kept, so that lookups of nearby
+// positions in the same partition don't read them again.
+class promoted_index_block_lookup {
+    const schema& _s;
+    column_values_fixed_lengths _ck_values_fixed_lengths;
+    file _index_file;
+    io_priority_class _pc;
+    // The whole promoted index, if it was read together with its index entry.
+    temporary_buffer<char> _buf;
+    uint64_t _position; // Position of the first block in the index file
+    uint32_t _size; // Size of the blocks and of the offsets array
+    uint32_t _num_blocks;
+    std::map<uint32_t, promoted_index_block> _blocks;
+
+    uint32_t offsets_start() const {
+        return _size - _num_blocks * sizeof(uint32_t);
+    }
+
+    future<temporary_buffer<char>> read(uint32_t pos, uint32_t len) {
+        if (pos + len > _size) {
+            return make_exception_future<temporary_buffer<char>>(malformed_sstable_exception(
+                    format("promoted index read [{}, {}) is out of bounds of its {} bytes", pos, pos + len, _size)));
+        }
+        if (_buf) {
+            return make_ready_future<temporary_buffer<char>>(_buf.share(pos, len));
+        }
+        return _index_file.dma_read_exactly<char>(_position + pos, len, _pc);
+    }
+
+    // Returns the [start, end) range of the block idx, relative to the first block.
+    future<std::pair<uint32_t, uint32_t>> read_block_bounds(uint32_t idx) {
+        bool last = idx + 1 == _num_blocks;
+        return read(offsets_start() + idx * sizeof(uint32_t), (last ? 1 : 2) * sizeof(uint32_t)).then(
+                [this, last] (temporary_buffer<char> buf) {
+            auto start = seastar::read_be<uint32_t>(buf.get());
+            auto end = last ? offsets_start() : seastar::read_be<uint32_t>(buf.get() + sizeof(uint32_t));
+            if (start >= end || end > offsets_start()) {
+                throw malformed_sstable_exception(format("invalid promoted index block bounds [{}, {})", start, end));
+            }
+            return std::make_pair(start, end);
+        });
+    }
+
+    future<> parse_block(uint32_t idx, temporary_buffer<char> buf) {
+        auto size = buf.size();
+        auto reader = std::make_unique<promoted_index_blocks_reader>(make_buffer_input_stream(std::move(buf)), 1,
+                _s, 0, size, column_values_fixed_lengths(_ck_values_fixed_lengths));
+        return do_with(std::move(reader), [this, idx] (std::unique_ptr<promoted_index_blocks_reader>& reader) {
+            return reader->consume_input().then([this, idx, &reader] {
+                reader->verify_end_state();
+                _blocks.emplace(idx, std::move(reader->get_pi_blocks().front()));
+            }).finally([&reader] {
+                return reader->close();
+            });
+        });
+    }
+
+public:
+    promoted_index_block_lookup(const schema& s, column_values_fixed_lengths ck_values_fixed_lengths,
+            file index_file, const io_priority_class& pc, temporary_buffer<char> buf,
+            uint64_t position, uint32_t size, uint32_t num_blocks)
+        : _s(s)
+        , _ck_values_fixed_lengths(std::move(ck_values_fixed_lengths))
+        , _index_file(std::move(index_file))
+        , _pc(pc)
+        , _buf(std::move(buf))
+        , _position(position)
+        , _size(size)
+        , _num_blocks(num_blocks)
+    {}
+
+    uint32_t num_blocks() const { return _num_blocks; }
+
+    // Returns the block idx, reading it if necessary.
+    // The block is valid as long as the lookup is valid.
+    future<const promoted_index_block*> get_block(uint32_t idx) {
+        assert(idx < _num_blocks);
+        auto i = _blocks.find(idx);
+        if (i != _blocks.end()) {
+            return make_ready_future<const promoted_index_block*>(&i->second);
+        }
+        return read_block_bounds(idx).then([this] (std::pair<uint32_t, uint32_t> bounds) {
+            return read(bounds.first, bounds.second - bounds.first);
+        }).then([this, idx] (temporary_buffer<char> buf) {
+            return parse_block(idx, std::move(buf));
+        }).then([this, idx] {
+            return make_ready_future<const promoted_index_block*>(&_blocks.at(idx));
+        });
+    }
+
+    // Returns the index of the first block in [first, num_blocks()) which starts after pos,
+    // or num_blocks() if there is no such block.
+    future<uint32_t> upper_bound(position_in_partition_view pos, uint32_t first) {
+        return do_with(first, _num_blocks, [this, pos] (uint32_t& lo, uint32_t& hi) {
+            return repeat([this, pos, &lo, &hi] {
+                if (lo >= hi) {
+                    return make_ready_future<stop_iteration>(stop_iteration::yes);
+                }
+                auto mid = lo + (hi - lo) / 2;
+                return get_block(mid).then([this, pos, mid, &lo, &hi] (const promoted_index_block* block) {
+                    if (promoted_index_block_compare(_s)(pos, block->start(_s))) {
+                        hi = mid;
+                    } else {
+                        lo = mid + 1;
+                    }
+                    return stop_iteration::no;
+                });
+            }).then([&lo] {
+                return lo;
+            });
+        });
+    }
+};
+
 class promoted_index {
     deletion_time _del_time;
     uint32_t _promoted_index_size;
     promoted_index_blocks_reader _reader;
     bool _reader_closed = false;
+    std::optional<promoted_index_block_lookup> _lookup;
 
 public:
     promoted_index(const schema& s, deletion_time del_time, input_stream<char>&& promoted_index_stream,
@@ -529,6 +652,8 @@ class promoted_index {
     [[nodiscard]] uint32_t get_promoted_index_size() const { return _promoted_index_size; }
     [[nodiscard]] promoted_index_blocks_reader& get_reader() { return _reader; };
     [[nodiscard]] const promoted_index_blocks_reader& get_reader() const { return _reader; };
+    [[nodiscard]] promoted_index_block_lookup* get_lookup() { return _lookup ? &*_lookup : nullptr; }
+    void set_lookup(promoted_index_block_lookup lookup) { _lookup.emplace(std::move(lookup)); }
     future<> close_reader() {
         if (!_reader_closed) {
             _reader_closed = true;
@@ -623,6 +748,10 @@ class index_entry {
     [[nodiscard]] promoted_index_blocks* get_pi_blocks() {
         return _index ? &_index->get_reader().get_pi_blocks() : nullptr;
     }
+    // Returns the lookup by binary search, if the promoted index supports it and is worth bisecting.
+    [[nodiscard]] promoted_index_block_lookup* get_pi_lookup() {
+        return _index ? _index->get_lookup() : nullptr;
+    }
     future<> close_pi_stream() {
         if (_index) {
             return _index->close_reader();
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "sstables/index_page_cache.hh"
+#include "sstables/sstables.hh"
+
+namespace sstables {
+
+index_page_cache::entry::entry(entry&& o) noexcept
+    : _link()
+    , _lru_link()
+    , _sst(o._sst)
+    , _summary_idx(o._summary_idx)
+    , _data(std::move(o._data))
+{
+    entries_type::node_algorithms::replace_node(o._link.this_ptr(), _link.this_ptr());
+    entries_type::node_algorithms::init(o._link.this_ptr());
+    if (o._lru_link.is_linked()) {
+        auto prev = o._lru_link.prev_;
+        o._lru_link.unlink();
+        lru_type::node_algorithms::link_after(prev, _lru_link.this_ptr());
+    }
+}
+
+index_page_cache::index_page_cache() {
+    _region.make_evictable([this] {
+        return evict_one();
+    });
+}
+
+index_page_cache::~index_page_cache() {
+    clear();
+}
+
+void index_page_cache::erase(entry& e) noexcept {
+    with_allocator(_region.allocator(), [&e] {
+        current_allocator().destroy(&e);
+    });
+    --_stats.pages;
+}
+
+memory::reclaiming_result index_page_cache::evict_one() noexcept {
+    if (_lru.empty()) {
+        return memory::reclaiming_result::reclaimed_nothing;
+    }
+    erase(_lru.back());
+    ++_stats.evictions;
+    return memory::reclaiming_result::reclaimed_something;
+}
+
+std::optional<temporary_buffer<char>> index_page_cache::get(const sstable& sst, uint64_t summary_idx) {
+    // Allocating the copy may cause the region to be compacted, which would
+    // move the entry from under our feet.
+    logalloc::reclaim_lock _(_region);
+    auto i = _entries.find(entry::key{&sst, summary_idx}, entry::compare());
+    if (i == _entries.end()) {
+        ++_stats.misses;
+        return std::nullopt;
+    }
+    ++_stats.hits;
+    _lru.erase(_lru.iterator_to(*i));
+    _lru.push_front(*i);
+    return with_linearized_managed_bytes([&] {
+        bytes_view data = i->_data;
+        return std::make_optional(temporary_buffer<char>(reinterpret_cast<const char*>(data.data()), data.size()));
+    });
+}
+
+void index_page_cache::insert(const sstable& sst, uint64_t summary_idx, const temporary_buffer<char>& page) {
+    if (page.size() > max_page_size) {
+        return;
+    }
+    _alloc_section(_region, [&] {
+        if (_entries.find(entry::key{&sst, summary_idx}, entry::compare()) != _entries.end()) {
+            return;
+        }
+        with_allocator(_region.allocator(), [&] {
+            auto e = current_allocator().construct<entry>(&sst, summary_idx, to_bytes_view(page));
+            _entries.insert(*e);
+            _lru.push_front(*e);
+        });
+        ++_stats.insertions;
+        ++_stats.pages;
+    });
+}
+
+void index_page_cache::invalidate(const sstable& sst) noexcept {
+    auto i = _entries.lower_bound(entry::key{&sst, 0}, entry::compare());
+    while (i != _entries.end() && i->_sst == &sst) {
+        auto& e = *i++;
+        erase(e);
+        ++_stats.removals;
+    }
+}
+
+void index_page_cache::clear() noexcept {
+    while (!_lru.empty()) {
+        erase(_lru.back());
+        ++_stats.removals;
+    }
+}
+
+index_page_cache& index_page_cache::shard_instance() {
+    static thread_local index_page_cache cache;
+    return cache;
+}
+
+}
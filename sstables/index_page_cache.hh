@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/intrusive/set.hpp>
+#include <boost/intrusive/list.hpp>
+#include <seastar/core/temporary_buffer.hh>
+#include "utils/logalloc.hh"
+#include "utils/managed_bytes.hh"
+
+namespace bi = boost::intrusive;
+
+namespace sstables {
+
+class sstable;
+
+// Per-shard cache of Index.db pages, keyed by (sstable, summary index).
+//
+// A page is the part of the index file between two consecutive summary
+// entries, which includes the promoted indexes of its partitions. Unlike
+// shared_index_lists, which only shares pages among the cursors of a single
+// index_reader, pages stay here after the readers which loaded them are gone,
+// so index lookups of hot partitions don't need any I/O.
+//
+// Pages are kept in their on-disk form, parsing a page is cheap compared to
+// reading it, and parsed index entries carry reader state which can't be
+// shared.
+//
+// Pages live in LSA memory of an evictable region, and are evicted in LRU
+// order when the LSA needs to reclaim memory, like row cache entries are.
+class index_page_cache {
+public:
+    struct stats {
+        uint64_t hits = 0; // Number of pages found in the cache
+        uint64_t misses = 0; // Number of pages not found in the cache
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        uint64_t removals = 0; // Number of pages dropped because their sstable went away
+        uint64_t pages = 0;
+    };
+
+    // Bigger pages are not cached, so that the promoted indexes of a few
+    // wide partitions can't push everything else out.
+    static constexpr size_t max_page_size = 128 * 1024;
+private:
+    class entry {
+        using link_type = bi::set_member_hook<bi::link_mode<bi::auto_unlink>>;
+        using lru_link_type = bi::list_member_hook<bi::link_mode<bi::auto_unlink>>;
+
+        link_type _link;
+        lru_link_type _lru_link;
+        const sstable* _sst;
+        uint64_t _summary_idx;
+        managed_bytes _data;
+
+        friend class index_page_cache;
+    public:
+        entry(const sstable* sst, uint64_t summary_idx, bytes_view data)
+            : _sst(sst)
+            , _summary_idx(summary_idx)
+            , _data(data)
+        { }
+        entry(entry&&) noexcept;
+
+        size_t memory_usage() const {
+            return sizeof(entry) + _data.external_memory_usage();
+        }
+
+        struct key {
+            const sstable* sst;
+            uint64_t summary_idx;
+        };
+
+        struct compare {
+            bool operator()(const key& a, const key& b) const {
+                return std::less<const sstable*>()(a.sst, b.sst)
+                    || (a.sst == b.sst && a.summary_idx < b.summary_idx);
+            }
+            bool operator()(const entry& a, const entry& b) const {
+                return (*this)(key{a._sst, a._summary_idx}, key{b._sst, b._summary_idx});
+            }
+            bool operator()(const entry& a, const key& b) const {
+                return (*this)(key{a._sst, a._summary_idx}, b);
+            }
+            bool operator()(const key& a, const entry& b) const {
+                return (*this)(a, key{b._sst, b._summary_idx});
+            }
+        };
+    };
+
+    using entries_type = bi::set<entry,
+        bi::member_hook<entry, entry::link_type, &entry::_link>,
+        bi::constant_time_size<false>, // we need this to have bi::auto_unlink on hooks
+        bi::compare<entry::compare>>;
+    using lru_type = bi::list<entry,
+        bi::member_hook<entry, entry::lru_link_type, &entry::_lru_link>,
+        bi::constant_time_size<false>>;
+
+    logalloc::region _region;
+    logalloc::allocating_section _alloc_section;
+    entries_type _entries;
+    lru_type _lru;
+    stats _stats;
+private:
+    void erase(entry&) noexcept;
+    memory::reclaiming_result evict_one() noexcept;
+public:
+    index_page_cache();
+    ~index_page_cache();
+    index_page_cache(const index_page_cache&) = delete;
+
+    // Returns a copy of the page, or a disengaged optional if it's not cached.
+    std::optional<temporary_buffer<char>> get(const sstable&, uint64_t summary_idx);
+
+    // Pages bigger than max_page_size are silently ignored.
+    void insert(const sstable&, uint64_t summary_idx, const temporary_buffer<char>& page);
+
+    // Drops all pages of the sstable. Must be called before it's destroyed.
+    void invalidate(const sstable&) noexcept;
+
+    void clear() noexcept;
+
+    const stats& get_stats() const { return _stats; }
+    const logalloc::region& region() const { return _region; }
+
+    static index_page_cache& shard_instance();
+};
+
+}
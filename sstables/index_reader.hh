@@ -24,6 +24,7 @@
 #include "consumer.hh"
 #include "downsampling.hh"
 #include "sstables/shared_index_lists.hh"
+#include "sstables/index_page_cache.hh"
 #include <seastar/util/bool_class.hh>
 #include "utils/buffer_input_stream.hh"
 #include "sstables/prepended_input_stream.hh"
@@ -93,6 +94,8 @@ class index_consume_entry_context : public data_consumer::continuous_data_consum
     trust_promoted_index _trust_pi;
     const schema& _s;
     std::optional<column_values_fixed_lengths> _ck_values_fixed_lengths;
+    // Promoted indexes at least this big are looked up by binary search.
+    uint32_t _pi_lookup_threshold;
 
     inline bool is_mc_format() const { return static_cast<bool>(_ck_values_fixed_lengths); }
 
@@ -191,6 +194,8 @@ class index_consume_entry_context : public data_consumer::continuous_data_consum
                 _num_pi_blocks = get_uint32();
             }
             auto data_size = data.size();
+            // Taken before data is moved into the promoted index stream, which empties it.
+            auto promoted_index_start = current_pos();
             std::optional<input_stream<char>> promoted_index_stream;
             if ((_trust_pi == trust_promoted_index::yes) && (promoted_index_size > 0)) {
                 if (promoted_index_size <= data_size) {
@@ -211,6 +216,11 @@ class index_consume_entry_context : public data_consumer::continuous_data_consum
                     index = std::make_unique<promoted_index>(_s, *_deletion_time, std::move(*promoted_index_stream),
                                   promoted_index_size,
                                   _num_pi_blocks, *_ck_values_fixed_lengths);
+                    if (promoted_index_size >= _pi_lookup_threshold && _num_pi_blocks > 1) {
+                        auto buf = promoted_index_size <= data_size ? data.share(0, promoted_index_size) : temporary_buffer<char>();
+                        index->set_lookup(promoted_index_block_lookup(_s, *_ck_values_fixed_lengths, _index_file,
+                                _options.io_priority_class, std::move(buf), promoted_index_start, promoted_index_size, _num_pi_blocks));
+                    }
                 } else {
                      index = std::make_unique<promoted_index>(_s, *_deletion_time, std::move(*promoted_index_stream),
                                    promoted_index_size, _num_pi_blocks);
@@ -234,10 +244,23 @@ class index_consume_entry_context : public data_consumer::continuous_data_consum
 
     index_consume_entry_context(IndexConsumer& consumer, trust_promoted_index trust_pi, const schema& s,
             file index_file, file_input_stream_options options, uint64_t start,
-            uint64_t maxlen, std::optional<column_values_fixed_lengths> ck_values_fixed_lengths)
+            uint64_t maxlen, std::optional<column_values_fixed_lengths> ck_values_fixed_lengths,
+            uint32_t pi_lookup_threshold = std::numeric_limits<uint32_t>::max())
         : continuous_data_consumer(make_file_input_stream(index_file, start, maxlen, options), start, maxlen)
         , _consumer(consumer), _index_file(index_file), _options(options)
         , _entry_offset(start), _trust_pi(trust_pi), _s(s), _ck_values_fixed_lengths(std::move(ck_values_fixed_lengths))
+        , _pi_lookup_threshold(pi_lookup_threshold)
+    {}
+
+    // Consumes entries from an in-memory copy of the index file range [start, start + maxlen).
+    index_consume_entry_context(IndexConsumer& consumer, trust_promoted_index trust_pi, const schema& s,
+            file index_file, file_input_stream_options options, temporary_buffer<char> page, uint64_t start,
+            std::optional<column_values_fixed_lengths> ck_values_fixed_lengths,
+            uint32_t pi_lookup_threshold = std::numeric_limits<uint32_t>::max())
+        : continuous_data_consumer(make_buffer_input_stream(page.share()), start, page.size())
+        , _consumer(consumer), _index_file(index_file), _options(options)
+        , _entry_offset(start), _trust_pi(trust_pi), _s(s), _ck_values_fixed_lengths(std::move(ck_values_fixed_lengths))
+        , _pi_lookup_threshold(pi_lookup_threshold)
     {}
 
     void reset(uint64_t offset) {
@@ -308,17 +331,41 @@ class index_reader {
             return options;
         }
 
+        static std::optional<column_values_fixed_lengths> get_ck_values_fixed_lengths(const shared_sstable& sst) {
+            return sst->get_version() == sstable_version_types::mc
+                ? std::make_optional(get_clustering_values_fixed_lengths(sst->get_serialization_header()))
+                : std::optional<column_values_fixed_lengths>{};
+        }
+
         reader(shared_sstable sst, const io_priority_class& pc, uint64_t begin, uint64_t end, uint64_t quantity)
             : _consumer(quantity)
             , _context(_consumer,
                        trust_promoted_index(sst->has_correct_promoted_index_entries()), *sst->_schema, sst->_index_file,
                        get_file_input_stream_options(sst, pc), begin, end - begin,
-                       (sst->get_version() == sstable_version_types::mc
-                           ? std::make_optional(get_clustering_values_fixed_lengths(sst->get_serialization_header()))
-                           : std::optional<column_values_fixed_lengths>{}))
+                       get_ck_values_fixed_lengths(sst), promoted_index_lookup_threshold())
+        { }
+
+        // Parses a page which is already in memory.
+        reader(shared_sstable sst, const io_priority_class& pc, uint64_t begin, temporary_buffer<char> page, uint64_t quantity)
+            : _consumer(quantity)
+            , _context(_consumer,
+                       trust_promoted_index(sst->has_correct_promoted_index_entries()), *sst->_schema, sst->_index_file,
+                       get_file_input_stream_options(sst, pc), std::move(page), begin,
+                       get_ck_values_fixed_lengths(sst), promoted_index_lookup_threshold())
         { }
     };
 
+    static future<index_list> consume_page(std::unique_ptr<reader> entries_reader) {
+        return do_with(std::move(entries_reader), [] (auto& entries_reader) {
+            return entries_reader->_context.consume_input().then([&entries_reader] {
+                auto indexes = std::move(entries_reader->_consumer.indexes);
+                return entries_reader->_context.close().then([indexes = std::move(indexes)] () mutable {
+                    return std::move(indexes);
+                });
+            });
+        });
+    }
+
     // Stores information about open end RT marker
     // of the lower index bound
     struct open_rt_marker {
@@ -379,14 +426,20 @@ class index_reader {
                 end = summary.entries[summary_idx + 1].position;
             }
 
-            return do_with(std::make_unique<reader>(_sstable, _pc, position, end, quantity), [this, summary_idx] (auto& entries_reader) {
-                return entries_reader->_context.consume_input().then([this, summary_idx, &entries_reader] {
-                    auto indexes = std::move(entries_reader->_consumer.indexes);
-                    return entries_reader->_context.close().then([indexes = std::move(indexes)] () mutable {
-                        return std::move(indexes);
-                    });
-
-                });
+            auto& page_cache = index_page_cache::shard_instance();
+            auto page = page_cache.get(*_sstable, summary_idx);
+            if (page) {
+                return consume_page(std::make_unique<reader>(_sstable, _pc, position, std::move(*page), quantity));
+            }
+            if (end - position > index_page_cache::max_page_size) {
+                return consume_page(std::make_unique<reader>(_sstable, _pc, position, end, quantity));
+            }
+            // Read the whole page at once, so that it can be cached.
+            return _sstable->_index_file.dma_read_exactly<char>(position, end - position, _pc).then(
+                    [this, summary_idx, position, quantity] (temporary_buffer<char> page) {
+                index_page_cache::shard_instance().insert(*_sstable, summary_idx, page);
+                _sstable->_index_pages_cached = true;
+                return consume_page(std::make_unique<reader>(_sstable, _pc, position, std::move(page), quantity));
             });
         };
 
@@ -570,6 +623,10 @@ class index_reader {
             return advance_to_next_partition(*_upper_bound);
         }
 
+        if (promoted_index_block_lookup* lookup = e.get_pi_lookup()) {
+            return advance_upper_past(e, *lookup, pos);
+        }
+
         if (e.get_read_pi_blocks_count() == 0) {
             return e.get_next_pi_blocks().then([this, pos] {
                 return advance_upper_past(pos);
@@ -596,6 +653,41 @@ class index_reader {
         return make_ready_future<>();
     }
 
+    future<> advance_upper_past(index_entry& e, promoted_index_block_lookup& lookup, position_in_partition_view pos) {
+        return lookup.upper_bound(pos, _upper_bound->current_pi_idx).then([this, &e, &lookup] (uint32_t idx) {
+            _upper_bound->current_pi_idx = idx;
+            if (idx == lookup.num_blocks()) {
+                return advance_to_next_partition(*_upper_bound);
+            }
+            return lookup.get_block(idx).then([this, &e] (const promoted_index_block* block) {
+                _upper_bound->data_file_position = e.position() + block->offset();
+                _upper_bound->element = indexable_element::cell;
+                sstlog.trace("index {} upper bound: bisected to cell, _current_pi_idx={}, _data_file_position={}",
+                         this, _upper_bound->current_pi_idx, _upper_bound->data_file_position);
+            });
+        });
+    }
+
+    // Advances the lower bound within the current partition, whose promoted index is looked up by binary search.
+    // current_pi_idx of the bound is the absolute index of the first block which starts after it.
+    future<> advance_lower_to(promoted_index_block_lookup& lookup, position_in_partition_view pos) {
+        return lookup.upper_bound(pos, _lower_bound.current_pi_idx).then([this, &lookup] (uint32_t idx) {
+            if (idx == _lower_bound.current_pi_idx) {
+                sstlog.trace("index {}: position in current block (bisected)", this);
+                return make_ready_future<>();
+            }
+            _lower_bound.current_pi_idx = idx;
+            auto prev = idx > 1 ? lookup.get_block(idx - 2) : make_ready_future<const promoted_index_block*>(nullptr);
+            return prev.then([this, &lookup, idx] (const promoted_index_block* prev) {
+                return lookup.get_block(idx - 1).then([this, prev] (const promoted_index_block* block) {
+                    get_info_from_promoted_block(*block, prev);
+                    sstlog.trace("index {}: lower bound bisected to cell, _current_pi_idx={}, _data_file_position={}",
+                            this, _lower_bound.current_pi_idx, _lower_bound.data_file_position);
+                });
+            });
+        });
+    }
+
     // Returns position right after all partitions in the sstable
     uint64_t data_file_end() const {
         return _sstable->data_size();
@@ -603,13 +695,17 @@ class index_reader {
 
     void get_info_from_promoted_block(const promoted_index_blocks::const_iterator iter,
             const promoted_index_blocks& pi_blocks) {
+        get_info_from_promoted_block(*iter, iter == pi_blocks.cbegin() ? nullptr : &*std::prev(iter));
+    }
+
+    // prev is the block preceding block, if there is one.
+    void get_info_from_promoted_block(const promoted_index_block& block, const promoted_index_block* prev) {
         const index_entry& e = current_partition_entry();
-        _lower_bound.data_file_position = e.position() + iter->offset();
+        _lower_bound.data_file_position = e.position() + block.offset();
         _lower_bound.element = indexable_element::cell;
-        if (iter == pi_blocks.cbegin() || !std::prev(iter)->end_open_marker()) {
+        if (!prev || !prev->end_open_marker()) {
             _lower_bound.end_open_marker.reset();
         } else {
-            auto prev = std::prev(iter);
             // End open marker can be only engaged in SSTables 3.x ('mc' format) and never in ka/la
             auto end_pos = prev->end(*_sstable->get_schema());
             position_in_partition_view* open_rt_pos = std::get_if<position_in_partition_view>(&end_pos);
@@ -702,6 +798,10 @@ class index_reader {
             return make_ready_future<>();
         }
 
+        if (promoted_index_block_lookup* lookup = e.get_pi_lookup()) {
+            return advance_lower_to(*lookup, pos);
+        }
+
         const promoted_index_blocks* pi_blocks = e.get_pi_blocks();
         assert(pi_blocks);
 
@@ -22,6 +22,8 @@
 #pragma once
 
 #include "leveled_manifest.hh"
+#include <boost/range/adaptor/transformed.hpp>
+#include <boost/range/numeric.hpp>
 
 namespace sstables {
 
@@ -43,6 +45,8 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
 
     virtual std::vector<resharding_descriptor> get_resharding_jobs(column_family& cf, std::vector<shared_sstable> candidates) override;
 
+    virtual std::vector<compaction_descriptor> get_reshaping_jobs(column_family& cf, std::vector<shared_sstable> input) override;
+
     virtual void notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) override;
 
     // for each level > 0, get newest sstable and use its last key as last
@@ -55,6 +59,12 @@ class leveled_compaction_strategy : public compaction_strategy_impl {
         return false;
     }
 
+    // Each level must stay a single run of disjoint sstables. Compacting repaired and unrepaired
+    // sstables apart would put overlapping output in the same level.
+    virtual bool separate_repaired_data() const override {
+        return false;
+    }
+
     virtual compaction_strategy_type type() const {
         return compaction_strategy_type::leveled;
     }
@@ -90,8 +100,8 @@ compaction_descriptor leveled_compaction_strategy::get_sstables_for_compaction(c
     for (auto level = int(manifest.get_level_count()); level >= 0; level--) {
         auto& sstables = manifest.get_level(level);
         // filter out sstables which droppable tombstone ratio isn't greater than the defined threshold.
-        auto e = boost::range::remove_if(sstables, [this, &gc_before] (const sstables::shared_sstable& sst) -> bool {
-            return !worth_dropping_tombstones(sst, gc_before);
+        auto e = boost::range::remove_if(sstables, [this, &cfs, &gc_before] (const sstables::shared_sstable& sst) -> bool {
+            return !worth_dropping_tombstones(sst, cfs, gc_before);
         });
         sstables.erase(e, sstables.end());
         if (sstables.empty()) {
@@ -149,6 +159,33 @@ std::vector<resharding_descriptor> leveled_compaction_strategy::get_resharding_j
     return descriptors;
 }
 
+std::vector<compaction_descriptor> leveled_compaction_strategy::get_reshaping_jobs(column_family& cf, std::vector<shared_sstable> input) {
+    if (input.empty()) {
+        return {};
+    }
+    auto candidates = cf.candidates_for_compaction();
+    leveled_manifest manifest = leveled_manifest::create(cf, candidates, _max_sstable_size_in_mb, _stcs_options);
+    uint64_t max_sstable_size = _max_sstable_size_in_mb*1024*1024;
+    uint64_t input_size = boost::accumulate(input | boost::adaptors::transformed(std::mem_fn(&sstable::data_size)), uint64_t(0));
+
+    // The level whose size is closest to that of the input, so that a small batch isn't given a
+    // level of its own, leaving the levels below it almost empty.
+    uint64_t sstables_worth = std::max((input_size + max_sstable_size - 1) / max_sstable_size, uint64_t(1));
+    auto level = int(std::ceil(std::log(double(sstables_worth)) / std::log(double(leveled_manifest::leveled_fan_out))));
+
+    // Compaction output is a run of disjoint sstables, so rather than piling the input up
+    // in L0, it can go straight to its level if that's empty.
+    std::vector<compaction_descriptor> jobs;
+    if (level > 0 && level < leveled_manifest::MAX_LEVELS && manifest.get_level(level).empty()) {
+        jobs.emplace_back(std::move(input), level, max_sstable_size);
+    } else if (input.size() > 1) {
+        // Otherwise it's merged into a single run in L0, rather than left overlapping there.
+        jobs.emplace_back(std::move(input), 0, max_sstable_size);
+    }
+    // A single sstable which can only go to L0 is left as it is.
+    return jobs;
+}
+
 void leveled_compaction_strategy::notify_completion(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) {
     if (removed.empty() || added.empty()) {
         return;
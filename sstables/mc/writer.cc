@@ -551,6 +551,14 @@ class writer : public sstable_writer::writer_impl {
     // Used to defer writing collections until all atomic cells are written
     std::vector<cdef_and_collection> _collections;
 
+    // Smallest and largest live value of each regular column, indexed by column id.
+    // Empty unless sstable_writer_config::zone_maps is set.
+    struct zone_map_bounds {
+        std::optional<bytes> min;
+        bytes max;
+    };
+    std::vector<zone_map_bounds> _zone_maps;
+
     std::optional<rt_marker> _end_open_marker;
 
     struct clustering_info {
@@ -679,6 +687,8 @@ class writer : public sstable_writer::writer_impl {
         const row_time_properties& properties, bool has_complex_deletion);
 
     void write_cells(bytes_ostream& writer, column_kind kind, const row& row_body, const row_time_properties& properties, bool has_complex_deletion);
+    void update_zone_map(const column_definition& cdef, atomic_cell_view cell);
+    disk_array<uint32_t, column_zone_map> make_zone_maps() const;
     void write_row_body(bytes_ostream& writer, const clustering_row& row, bool has_complex_deletion);
     void write_static_row(const row& static_row);
     void collect_row_stats(uint64_t row_size, const clustering_key_prefix* clustering_key) {
@@ -738,12 +748,18 @@ class writer : public sstable_writer::writer_impl {
         _compression_enabled = !_sst.has_component(component_type::CRC);
         init_file_writers();
         _sst._shards = { shard };
+        // Let the backlog tracker attribute the partial write to its run.
+        _sst._run_identifier = _run_identifier;
 
         _cfg.monitor->on_write_started(_data_writer->offset_tracker());
-        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(), utils::filter_format::m_format);
+        _sst._components->filter = utils::i_filter::get_filter(estimated_partitions, _schema.bloom_filter_fp_chance(),
+                _cfg.blocked_bloom_filter ? utils::filter_format::blocked_format : utils::filter_format::m_format);
         _pi_write_m.desired_block_size = cfg.promoted_index_block_size.value_or(get_config().column_index_size_in_kb() * 1024);
         _sst._correctly_serialize_non_compound_range_tombstones = _cfg.correctly_serialize_non_compound_range_tombstones;
         _index_sampling_state.summary_byte_cost = summary_byte_cost();
+        if (_cfg.zone_maps) {
+            _zone_maps.resize(_schema.regular_columns_count());
+        }
         prepare_summary(_sst._components->summary, estimated_partitions, _schema.min_index_interval());
     }
 
@@ -1029,6 +1045,10 @@ void writer::write_cell(bytes_ostream& writer, atomic_cell_view cell, const colu
         return;
     }
 
+    if (!_zone_maps.empty() && column_zone_map_is_tracked(cdef)) {
+        update_zone_map(cdef, cell);
+    }
+
     if (is_cell_expiring) {
         _c_stats.update_ttl(cell.ttl());
         // tombstone histogram is updated with expiration time because if ttl is longer
@@ -1041,6 +1061,33 @@ void writer::write_cell(bytes_ostream& writer, atomic_cell_view cell, const colu
     _sst.get_stats().on_cell_write();
 }
 
+void writer::update_zone_map(const column_definition& cdef, atomic_cell_view cell) {
+    auto& zm = _zone_maps[cdef.id];
+    cell.value().with_linearized([&] (bytes_view value) {
+        if (!zm.min) {
+            zm.min = bytes(value);
+            zm.max = bytes(value);
+        } else if (cdef.type->compare(value, *zm.min) < 0) {
+            zm.min = bytes(value);
+        } else if (cdef.type->compare(value, zm.max) > 0) {
+            zm.max = bytes(value);
+        }
+    });
+}
+
+disk_array<uint32_t, column_zone_map> writer::make_zone_maps() const {
+    disk_array<uint32_t, column_zone_map> zone_maps;
+    for (auto& cdef : _schema.regular_columns()) {
+        auto& zm = _zone_maps[cdef.id];
+        // Columns without any live value get no entry, which readers take
+        // to mean that no row in the sstable has a value for them.
+        if (zm.min) {
+            zone_maps.elements.push_back(column_zone_map{{cdef.name()}, {*zm.min}, {zm.max}});
+        }
+    }
+    return zone_maps;
+}
+
 void writer::write_liveness_info(bytes_ostream& writer, const row_marker& marker) {
     if (marker.is_missing()) {
         return;
@@ -1375,8 +1422,15 @@ void writer::consume_end_of_stream() {
     if (!_cfg.correctly_serialize_non_compound_range_tombstones) {
         features.disable(sstable_feature::NonCompoundRangeTombstones);
     }
+    if (!_cfg.blocked_bloom_filter) {
+        features.disable(sstable_feature::BlockedBloomFilter);
+    }
     run_identifier identifier{_run_identifier};
-    _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier));
+    std::optional<disk_array<uint32_t, column_zone_map>> zone_maps;
+    if (!_zone_maps.empty()) {
+        zone_maps = make_zone_maps();
+    }
+    _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier), std::move(zone_maps));
     _cfg.monitor->on_write_completed();
     if (!_cfg.leave_unsealed) {
         _sst.seal_sstable(_cfg.backup).get();
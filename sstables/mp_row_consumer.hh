@@ -928,6 +928,40 @@ class mp_row_consumer_m : public consumer_m {
         }
     }
 
+    void do_consume_column(const column_translation::column_info& column_info,
+                           bytes_view cell_path,
+                           bytes_view value,
+                           api::timestamp_type timestamp,
+                           gc_clock::duration ttl,
+                           gc_clock::time_point local_deletion_time,
+                           bool is_deleted) {
+        const std::optional<column_id>& column_id = column_info.id;
+        check_column_missing_in_current_schema(column_info, timestamp);
+        if (!column_id) {
+            return;
+        }
+        const column_definition& column_def = get_column_definition(column_id);
+        if (timestamp <= column_def.dropped_at()) {
+            return;
+        }
+        check_schema_mismatch(column_info, column_def);
+        if (column_def.is_multi_cell()) {
+            auto ctype = static_pointer_cast<const collection_type_impl>(column_def.type);
+            auto ac = is_deleted ? atomic_cell::make_dead(timestamp, local_deletion_time)
+                                 : make_atomic_cell(*ctype->value_comparator(),
+                                                    timestamp,
+                                                    value,
+                                                    ttl,
+                                                    local_deletion_time,
+                                                    atomic_cell::collection_member::yes);
+            _cm.cells.emplace_back(to_bytes(cell_path), std::move(ac));
+        } else {
+            auto ac = is_deleted ? atomic_cell::make_dead(timestamp, local_deletion_time)
+                                 : make_atomic_cell(*column_def.type, timestamp, value, ttl, local_deletion_time,
+                                       atomic_cell::collection_member::no);
+            _cells.push_back({*column_id, atomic_cell_or_collection(std::move(ac))});
+        }
+    }
 public:
 
     /*
@@ -1138,33 +1172,17 @@ class mp_row_consumer_m : public consumer_m {
                                    gc_clock::duration ttl,
                                    gc_clock::time_point local_deletion_time,
                                    bool is_deleted) override {
-        const std::optional<column_id>& column_id = column_info.id;
         sstlog.trace("mp_row_consumer_m {}: consume_column(id={}, path={}, value={}, ts={}, ttl={}, del_time={}, deleted={})", this,
-            column_id, cell_path, value, timestamp, ttl.count(), local_deletion_time.time_since_epoch().count(), is_deleted);
-        check_column_missing_in_current_schema(column_info, timestamp);
-        if (!column_id) {
-            return proceed::yes;
-        }
-        const column_definition& column_def = get_column_definition(column_id);
-        if (timestamp <= column_def.dropped_at()) {
-            return proceed::yes;
-        }
-        check_schema_mismatch(column_info, column_def);
-        if (column_def.is_multi_cell()) {
-            auto ctype = static_pointer_cast<const collection_type_impl>(column_def.type);
-            auto ac = is_deleted ? atomic_cell::make_dead(timestamp, local_deletion_time)
-                                 : make_atomic_cell(*ctype->value_comparator(),
-                                                    timestamp,
-                                                    value,
-                                                    ttl,
-                                                    local_deletion_time,
-                                                    atomic_cell::collection_member::yes);
-            _cm.cells.emplace_back(to_bytes(cell_path), std::move(ac));
-        } else {
-            auto ac = is_deleted ? atomic_cell::make_dead(timestamp, local_deletion_time)
-                                 : make_atomic_cell(*column_def.type, timestamp, value, ttl, local_deletion_time,
-                                       atomic_cell::collection_member::no);
-            _cells.push_back({*column_id, atomic_cell_or_collection(std::move(ac))});
+            column_info.id, cell_path, value, timestamp, ttl.count(), local_deletion_time.time_since_epoch().count(), is_deleted);
+        do_consume_column(column_info, cell_path, value, timestamp, ttl, local_deletion_time, is_deleted);
+        return proceed::yes;
+    }
+
+    virtual proceed consume_fixed_size_columns(const fixed_size_cells& cells) override {
+        sstlog.trace("mp_row_consumer_m {}: consume_fixed_size_columns({} cells)", this, cells.size());
+        _cells.reserve(_cells.size() + cells.size());
+        for (auto&& c : cells) {
+            do_consume_column(*c.column, bytes_view(), c.value, c.timestamp, c.ttl, c.local_deletion_time, c.is_deleted);
         }
         return proceed::yes;
     }
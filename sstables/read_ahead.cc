@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include <seastar/core/reactor.hh>
+#include <seastar/core/sharded.hh>
+
+#include "sstables/read_ahead.hh"
+
+namespace sstables {
+
+// Handles may be turned into files on other shards, where the stats of
+// this shard can't be touched, so only files made on the shard of the
+// stats count reads.
+class read_counting_file_handle_impl : public file_handle_impl {
+    std::unique_ptr<file_handle_impl> _handle;
+    std::shared_ptr<foreign_ptr<lw_shared_ptr<data_read_stats>>> _stats;
+public:
+    read_counting_file_handle_impl(std::unique_ptr<file_handle_impl> handle, std::shared_ptr<foreign_ptr<lw_shared_ptr<data_read_stats>>> stats)
+        : _handle(std::move(handle))
+        , _stats(std::move(stats))
+    { }
+
+    virtual std::unique_ptr<file_handle_impl> clone() const override {
+        return std::make_unique<read_counting_file_handle_impl>(_handle->clone(), _stats);
+    }
+
+    virtual shared_ptr<file_impl> to_file() && override {
+        auto f = file(std::move(*_handle).to_file());
+        if (_stats->get_owner_shard() != engine().cpu_id()) {
+            return get_file_impl(f);
+        }
+        return get_file_impl(make_read_counting_file(std::move(f), (*_stats)->shared_from_this()));
+    }
+};
+
+class read_counting_file_impl : public file_impl {
+    file _file;
+    lw_shared_ptr<data_read_stats> _stats;
+private:
+    template <typename T>
+    T count(T n) {
+        _stats->bytes_read += n;
+        return n;
+    }
+public:
+    read_counting_file_impl(file f, lw_shared_ptr<data_read_stats> stats)
+        : _file(std::move(f))
+        , _stats(std::move(stats))
+    { }
+
+    virtual future<size_t> write_dma(uint64_t pos, const void* buffer, size_t len, const io_priority_class& pc) override {
+        return get_file_impl(_file)->write_dma(pos, buffer, len, pc);
+    }
+
+    virtual future<size_t> write_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override {
+        return get_file_impl(_file)->write_dma(pos, std::move(iov), pc);
+    }
+
+    virtual future<size_t> read_dma(uint64_t pos, void* buffer, size_t len, const io_priority_class& pc) override {
+        return get_file_impl(_file)->read_dma(pos, buffer, len, pc).then([this] (size_t n) {
+            return count(n);
+        });
+    }
+
+    virtual future<size_t> read_dma(uint64_t pos, std::vector<iovec> iov, const io_priority_class& pc) override {
+        return get_file_impl(_file)->read_dma(pos, std::move(iov), pc).then([this] (size_t n) {
+            return count(n);
+        });
+    }
+
+    virtual future<> flush(void) override {
+        return get_file_impl(_file)->flush();
+    }
+
+    virtual future<struct stat> stat(void) override {
+        return get_file_impl(_file)->stat();
+    }
+
+    virtual future<> truncate(uint64_t length) override {
+        return get_file_impl(_file)->truncate(length);
+    }
+
+    virtual future<> discard(uint64_t offset, uint64_t length) override {
+        return get_file_impl(_file)->discard(offset, length);
+    }
+
+    virtual future<> allocate(uint64_t position, uint64_t length) override {
+        return get_file_impl(_file)->allocate(position, length);
+    }
+
+    virtual future<uint64_t> size(void) override {
+        return get_file_impl(_file)->size();
+    }
+
+    virtual future<> close() override {
+        return get_file_impl(_file)->close();
+    }
+
+    virtual std::unique_ptr<file_handle_impl> dup() override {
+        return std::make_unique<read_counting_file_handle_impl>(get_file_impl(_file)->dup(),
+                std::make_shared<foreign_ptr<lw_shared_ptr<data_read_stats>>>(make_foreign(_stats)));
+    }
+
+    virtual subscription<directory_entry> list_directory(std::function<future<> (directory_entry de)> next) override {
+        return get_file_impl(_file)->list_directory(std::move(next));
+    }
+
+    virtual future<temporary_buffer<uint8_t>> dma_read_bulk(uint64_t offset, size_t range_size, const io_priority_class& pc) override {
+        return get_file_impl(_file)->dma_read_bulk(offset, range_size, pc).then([this] (temporary_buffer<uint8_t> buf) {
+            count(buf.size());
+            return buf;
+        });
+    }
+};
+
+file make_read_counting_file(file f, lw_shared_ptr<data_read_stats> stats) {
+    return file(make_shared<read_counting_file_impl>(std::move(f), std::move(stats)));
+}
+
+bool read_ahead_tracker::on_skip(uint64_t n) {
+    if (n < window()) {
+        // Part of the data read ahead is still going to be used.
+        return false;
+    }
+    auto old_read_ahead = _read_ahead;
+    if (_sequential_bytes >= 2 * window()) {
+        _read_ahead = std::min(std::max(_read_ahead * 2, 1u), max_read_ahead);
+    } else {
+        _read_ahead /= 2;
+    }
+    _sequential_bytes = 0;
+    return _read_ahead != old_read_ahead;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <seastar/core/file.hh>
+#include <seastar/core/shared_ptr.hh>
+
+namespace sstables {
+
+// Counts the data file bytes a table's sstable readers fetched from disk
+// and the data file bytes holding what they handed to their consumers.
+// Both are in on-disk bytes, so for compressed sstables the consumed bytes
+// are the compressed bytes of the consumed data. The ratio of the two is
+// the read amplification of the table's data reads.
+struct data_read_stats : public enable_lw_shared_from_this<data_read_stats> {
+    uint64_t bytes_read = 0;
+    uint64_t bytes_consumed = 0;
+
+    double read_amplification() const {
+        return bytes_consumed ? double(bytes_read) / bytes_consumed : 0;
+    }
+};
+
+// Returns a file which accounts every read served by f in stats.
+file make_read_counting_file(file f, lw_shared_ptr<data_read_stats> stats);
+
+// Tracks the access pattern of a single sstable data reader and picks the
+// read-ahead depth (in buffers) of its input stream.
+//
+// The initial depth reflects what the reader is known to be doing: a
+// single partition read usually needs no more than one buffer, while
+// scans start deeper. The depth only changes when the reader skips past
+// the read-ahead window, where nothing the stream buffered is of use and
+// it can be replaced without wasting reads. If the reader consumed at
+// least two windows since the last such skip, read-ahead paid off and the
+// depth doubles, up to max_read_ahead. Otherwise the data read ahead was
+// wasted and the depth is halved.
+class read_ahead_tracker {
+public:
+    static constexpr unsigned single_partition_read_ahead = 0;
+    static constexpr unsigned default_read_ahead = 4;
+    static constexpr unsigned max_read_ahead = 8;
+private:
+    size_t _buffer_size;
+    unsigned _read_ahead;
+    // Bytes consumed since the reader last skipped past the read-ahead window.
+    uint64_t _sequential_bytes = 0;
+private:
+    uint64_t window() const {
+        return uint64_t(_read_ahead + 1) * _buffer_size;
+    }
+public:
+    read_ahead_tracker(size_t buffer_size, unsigned read_ahead)
+        : _buffer_size(buffer_size)
+        , _read_ahead(read_ahead)
+    { }
+
+    unsigned read_ahead() const {
+        return _read_ahead;
+    }
+
+    // Records that the reader consumed n bytes sequentially.
+    void on_read(uint64_t n) {
+        _sequential_bytes += n;
+    }
+
+    // Records that the reader skipped n bytes forward.
+    // Returns true if the read-ahead depth changed.
+    bool on_skip(uint64_t n);
+};
+
+}
@@ -44,6 +44,7 @@
 #include "tombstone.hh"
 #include "m_format_read_helpers.hh"
 
+#include <algorithm>
 #include <variant>
 
 // sstables::data_consume_row feeds the contents of a single row into a
@@ -136,6 +137,22 @@ class row_consumer {
     }
 };
 
+// A cell decoded by the parser's fast path for rows whose columns are all
+// simple and fixed-size. The value points into the parser's buffer and is
+// only valid during consume_fixed_size_columns().
+struct fixed_size_cell {
+    const sstables::column_translation::column_info* column;
+    bytes_view value;
+    api::timestamp_type timestamp;
+    gc_clock::duration ttl;
+    gc_clock::time_point local_deletion_time;
+    bool is_deleted;
+};
+
+// The cells of one row, decoded in a single loop instead of going through
+// the per-cell parser states, and handed to the consumer in one call.
+using fixed_size_cells = std::vector<fixed_size_cell>;
+
 class consumer_m {
     reader_resource_tracker _resource_tracker;
     const io_priority_class& _pc;
@@ -189,6 +206,18 @@ class consumer_m {
                                    gc_clock::time_point local_deletion_time,
                                    bool is_deleted) = 0;
 
+    // Consumes all cells of a row at once, as if consume_column() was called
+    // for each of them. All cells are consumed even if proceed::no is returned.
+    virtual proceed consume_fixed_size_columns(const fixed_size_cells& cells) {
+        auto ret = proceed::yes;
+        for (auto&& c : cells) {
+            if (consume_column(*c.column, bytes_view(), c.value, c.timestamp, c.ttl, c.local_deletion_time, c.is_deleted) == proceed::no) {
+                ret = proceed::no;
+            }
+        }
+        return ret;
+    }
+
     virtual proceed consume_complex_column_start(const sstables::column_translation::column_info& column_info,
                                                  tombstone tomb) = 0;
 
@@ -634,6 +663,10 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
 
         // Represents the subset of _all_columns present in current row
         boost::dynamic_bitset<uint64_t> _columns_selector; // size() == _columns.size()
+
+        // Whether all columns are simple, non-counter and of fixed size,
+        // which allows decoding rows with consume_fixed_size_columns().
+        bool _fixed_size_columns;
     };
 
     row_schema _regular_row;
@@ -672,6 +705,7 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
      */
     tombstone _left_range_tombstone;
     tombstone _right_range_tombstone;
+    fixed_size_cells _fixed_size_cells;
     void start_row(row_schema& rs) {
         _row = &rs;
         _row->_columns = _row->_all_columns;
@@ -679,6 +713,9 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
     void setup_columns(row_schema& rs, const std::vector<column_translation::column_info>& columns) {
         rs._all_columns = boost::make_iterator_range(columns);
         rs._columns_selector = boost::dynamic_bitset<uint64_t>(columns.size());
+        rs._fixed_size_columns = !columns.empty() && std::all_of(columns.begin(), columns.end(), [] (const column_translation::column_info& c) {
+            return c.value_length && !c.is_collection && !c.is_counter;
+        });
     }
     void skip_absent_columns() {
         size_t pos = _row->_columns_selector.find_first();
@@ -734,6 +771,57 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
     bool should_read_block_header() {
         return _ck_blocks_header_offset == 0u;
     }
+    // Fast path for rows whose columns are all simple and fixed-size, taken
+    // when the rest of the row is already in data. Decodes the remaining
+    // cells in one pass, bypassing the per-cell states, and hands them to
+    // the consumer at once.
+    consumer_m::proceed consume_fixed_size_columns(temporary_buffer<char>& data) {
+        const char* p = data.get();
+        const char* const end = p + (_next_row_offset - (position() - data.size()));
+        auto check_available = [&] (size_t n) {
+            if (size_t(end - p) < n) {
+                throw malformed_sstable_exception("cell exceeds the row body size");
+            }
+        };
+        auto read_vint = [&] {
+            check_available(1);
+            auto len = unsigned_vint::serialized_size_from_first_byte(*p);
+            check_available(len);
+            auto value = unsigned_vint::deserialize(bytes_view(reinterpret_cast<const bytes::value_type*>(p), len)).value;
+            p += len;
+            return value;
+        };
+        _fixed_size_cells.clear();
+        while (!no_more_columns()) {
+            check_available(1);
+            column_flags_m flags(uint8_t(*p++));
+            auto timestamp = flags.use_row_timestamp() ? _liveness.timestamp() : parse_timestamp(_header, read_vint());
+            gc_clock::time_point local_deletion_time = gc_clock::time_point::max();
+            if (flags.use_row_ttl()) {
+                local_deletion_time = _liveness.local_deletion_time();
+            } else if (flags.is_deleted() || flags.is_expiring()) {
+                local_deletion_time = parse_expiry(_header, read_vint());
+            }
+            gc_clock::duration ttl = gc_clock::duration::zero();
+            if (flags.use_row_ttl()) {
+                ttl = _liveness.ttl();
+            } else if (flags.is_expiring()) {
+                ttl = parse_ttl(_header, read_vint());
+            }
+            bytes_view value;
+            if (flags.has_value()) {
+                auto len = *get_column_value_length();
+                check_available(len);
+                value = bytes_view(reinterpret_cast<const bytes::value_type*>(p), len);
+                p += len;
+            }
+            _fixed_size_cells.push_back(fixed_size_cell{&get_column_info(), value, timestamp, ttl, local_deletion_time, flags.is_deleted()});
+            move_to_next_column();
+        }
+        auto ret = _consumer.consume_fixed_size_columns(_fixed_size_cells);
+        data.trim_front(p - data.get());
+        return ret;
+    }
 public:
     using consumer = consumer_m;
     bool non_consuming() const {
@@ -1031,6 +1119,13 @@ class data_consume_rows_context_m : public data_consumer::continuous_data_consum
                     _state = state::COMPLEX_COLUMN;
                     goto complex_column_label;
                 }
+                if (_row->_fixed_size_columns && _next_row_offset <= position()) {
+                    _state = state::COLUMN;
+                    if (consume_fixed_size_columns(data) == consumer_m::proceed::no) {
+                        return consumer_m::proceed::no;
+                    }
+                    goto column_label;
+                }
                 _subcolumns_to_read = 0;
             }
         case state::SIMPLE_COLUMN:
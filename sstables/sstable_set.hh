@@ -50,6 +50,7 @@ class sstable_set {
     // that has a reference somewhere
     lw_shared_ptr<sstable_list> _all;
     std::unordered_map<utils::UUID, sstable_run> _all_runs;
+    uint64_t _version;
 public:
     ~sstable_set();
     sstable_set(std::unique_ptr<sstable_set_impl> impl, schema_ptr s, lw_shared_ptr<sstable_list> all);
@@ -61,6 +62,9 @@ class sstable_set {
     // Select all runs which contain any of the input sstables.
     std::vector<sstable_run> select(const std::vector<shared_sstable>& sstables) const;
     lw_shared_ptr<sstable_list> all() const { return _all; }
+    // Changes whenever sstables are inserted or erased, and is unique to this shard,
+    // so sets with the same version hold the same sstables.
+    uint64_t version() const { return _version; }
     void insert(shared_sstable sst);
     void erase(shared_sstable sst);
 
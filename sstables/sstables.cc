@@ -920,6 +920,9 @@ void sstable::generate_toc(compressor_ptr c, double filter_fp_chance) {
         _recognized_components.insert(component_type::CRC);
     } else {
         _recognized_components.insert(component_type::CompressionInfo);
+        if (c->dictionary_size()) {
+            _recognized_components.insert(component_type::CompressionDictionary);
+        }
     }
     _recognized_components.insert(component_type::Scylla);
 }
@@ -1080,7 +1083,16 @@ future<> sstable::read_compression(const io_priority_class& pc) {
         return make_ready_future<>();
     }
 
-    return read_simple<component_type::CompressionInfo>(_components->compression, pc);
+    return read_simple<component_type::CompressionInfo>(_components->compression, pc).then([this, &pc] {
+        if (!has_component(component_type::CompressionDictionary)) {
+            return make_ready_future<>();
+        }
+        return do_with(compression_dictionary(), [this, &pc] (compression_dictionary& dict) {
+            return read_simple<component_type::CompressionDictionary>(dict, pc).then([this, &dict] {
+                _components->compression.set_dictionary(std::move(dict.data.value));
+            });
+        });
+    });
 }
 
 void sstable::write_compression(const io_priority_class& pc) {
@@ -1089,6 +1101,11 @@ void sstable::write_compression(const io_priority_class& pc) {
     }
 
     write_simple<component_type::CompressionInfo>(_components->compression, pc);
+    if (has_component(component_type::CompressionDictionary)) {
+        // Written even if no dictionary could be trained, since the TOC is
+        // generated before the data, and thus before training.
+        write_simple<component_type::CompressionDictionary>(compression_dictionary{{_components->compression.dictionary()}}, pc);
+    }
 }
 
 void sstable::validate_min_max_metadata() {
@@ -1340,7 +1357,7 @@ future<> sstable::read_filter(const io_priority_class& pc) {
         auto nr_bits = filter.buckets.elements.size() * std::numeric_limits<typename decltype(filter.buckets.elements)::value_type>::digits;
         large_bitset bs(nr_bits, std::move(filter.buckets.elements));
         utils::filter_format format = (_version == sstable_version_types::mc)
-                                      ? utils::filter_format::m_format
+                                      ? (has_blocked_bloom_filter() ? utils::filter_format::blocked_format : utils::filter_format::m_format)
                                       : utils::filter_format::k_l_format;
         _components->filter = utils::filter::create_filter(filter.hashes, std::move(bs), format);
     });
@@ -1351,7 +1368,7 @@ void sstable::write_filter(const io_priority_class& pc) {
         return;
     }
 
-    auto f = static_cast<utils::filter::murmur3_bloom_filter *>(_components->filter.get());
+    auto f = static_cast<utils::filter::bloom_filter *>(_components->filter.get());
 
     auto&& bs = f->bits();
     auto filter_ref = sstables::filter_ref(f->num_hashes(), bs.get_storage());
@@ -1365,10 +1382,12 @@ future<> sstable::load(const io_priority_class& pc) {
         // Read statistics ahead of others - if summary is missing
         // we'll attempt to re-generate it and we need statistics for that
         return read_statistics(pc).then([this, &pc] {
+            // The filter format is recorded in the scylla component.
             return seastar::when_all_succeed(
                     read_compression(pc),
-                    read_scylla_metadata(pc),
-                    read_filter(pc),
+                    read_scylla_metadata(pc).then([this, &pc] {
+                        return read_filter(pc);
+                    }),
                     read_summary(pc)).then([this] {
                 validate_min_max_metadata();
                 validate_max_local_deletion_time();
@@ -2173,7 +2192,8 @@ sstable::read_scylla_metadata(const io_priority_class& pc) {
 }
 
 void
-sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, struct run_identifier identifier) {
+sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, struct run_identifier identifier,
+        std::optional<disk_array<uint32_t, column_zone_map>> zone_maps) {
     auto&& first_key = get_first_decorated_key();
     auto&& last_key = get_last_decorated_key();
     auto sm = create_sharding_metadata(_schema, first_key, last_key, shard);
@@ -2191,10 +2211,31 @@ sstable::write_scylla_metadata(const io_priority_class& pc, shard_id shard, ssta
     _components->scylla_metadata->data.set<scylla_metadata_type::Sharding>(std::move(sm));
     _components->scylla_metadata->data.set<scylla_metadata_type::Features>(std::move(features));
     _components->scylla_metadata->data.set<scylla_metadata_type::RunIdentifier>(std::move(identifier));
+    if (zone_maps) {
+        _components->scylla_metadata->data.set<scylla_metadata_type::ZoneMaps>(std::move(*zone_maps));
+    }
 
     write_simple<component_type::Scylla>(*_components->scylla_metadata, pc);
 }
 
+bool sstable::may_contain_values(const column_definition& cdef, const nonwrapping_range<bytes>& range) const {
+    if (!column_zone_map_is_tracked(cdef) || !has_scylla_component()) {
+        return true;
+    }
+    auto* zone_maps = _components->scylla_metadata->get_zone_maps();
+    if (!zone_maps) {
+        return true;
+    }
+    auto cmp = [&cdef] (const bytes& a, const bytes& b) { return cdef.type->compare(a, b); };
+    for (auto& zm : zone_maps->elements) {
+        if (zm.name.value == cdef.name()) {
+            return range.overlaps(nonwrapping_range<bytes>({zm.min.value}, {zm.max.value}), cmp);
+        }
+    }
+    // No live value of the column was written to this sstable.
+    return false;
+}
+
 void sstable::update_stats_on_end_of_stream()
 {
     if (_c_stats.capped_local_deletion_time) {
@@ -2287,6 +2328,8 @@ sstable_writer_k_l::sstable_writer_k_l(sstable& sst, const schema& s, uint64_t e
     _sst.create_data().get();
     _compression_enabled = !_sst.has_component(component_type::CRC);
     prepare_file_writer();
+    // Let the backlog tracker attribute the partial write to its run.
+    _sst._run_identifier = _run_identifier;
 
     _monitor->on_write_started(_writer->offset_tracker());
     _components_writer.emplace(_sst, _schema, *_writer, estimated_partitions, _cfg, _pc);
@@ -2312,6 +2355,7 @@ void sstable_writer_k_l::consume_end_of_stream()
     if (!_correctly_serialize_non_compound_range_tombstones) {
         features.disable(sstable_feature::NonCompoundRangeTombstones);
     }
+    features.disable(sstable_feature::BlockedBloomFilter);
     run_identifier identifier{_run_identifier};
     _sst.write_scylla_metadata(_pc, _shard, std::move(features), std::move(identifier));
 
@@ -2724,22 +2768,33 @@ component_type sstable::component_from_sstring(version_types v, sstring &s) {
     }
 }
 
-input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_priority_class& pc, reader_resource_tracker resource_tracker, lw_shared_ptr<file_input_stream_history> history) {
+const compressor_ptr& sstable::reader_compressor() {
+    if (!_reader_compressor) {
+        _reader_compressor = _components->compression.make_reader_compressor();
+    }
+    return _reader_compressor;
+}
+
+input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_priority_class& pc, reader_resource_tracker resource_tracker,
+        lw_shared_ptr<file_input_stream_history> history, unsigned read_ahead) {
     file_input_stream_options options;
     options.buffer_size = sstable_buffer_size;
     options.io_priority_class = pc;
-    options.read_ahead = 4;
+    options.read_ahead = read_ahead;
     options.dynamic_adjustments = std::move(history);
 
     auto f = resource_tracker.track(_data_file);
+    if (_data_read_stats) {
+        f = make_read_counting_file(std::move(f), _data_read_stats);
+    }
 
     input_stream<char> stream;
     if (_components->compression) {
         if (_version == sstable_version_types::mc) {
-             return make_compressed_file_m_format_input_stream(f, &_components->compression,
+             return make_compressed_file_m_format_input_stream(f, &_components->compression, reader_compressor(),
                 pos, len, std::move(options));
         } else {
-            return make_compressed_file_k_l_format_input_stream(f, &_components->compression,
+            return make_compressed_file_k_l_format_input_stream(f, &_components->compression, reader_compressor(),
                 pos, len, std::move(options));
         }
     }
@@ -2747,6 +2802,18 @@ input_stream<char> sstable::data_stream(uint64_t pos, size_t len, const io_prior
     return make_file_input_stream(f, pos, len, std::move(options));
 }
 
+uint64_t sstable::data_file_offset(uint64_t pos) {
+    if (!_components->compression) {
+        return pos;
+    }
+    auto& c = _components->compression;
+    if (pos >= c.uncompressed_file_length()) {
+        return c.compressed_file_length();
+    }
+    auto addr = c.locate(pos, c.offsets.get_accessor());
+    return addr.chunk_start + uint64_t(addr.offset) * addr.chunk_len / c.uncompressed_chunk_length();
+}
+
 future<temporary_buffer<char>> sstable::data_read(uint64_t pos, size_t len, const io_priority_class& pc) {
     return do_with(data_stream(pos, len, pc, no_resource_tracking(), {}), [len] (auto& stream) {
         return stream.read_exactly(len).finally([&stream] {
@@ -2858,6 +2925,9 @@ int sstable::compare_by_max_timestamp(const sstable& other) const {
 }
 
 sstable::~sstable() {
+    if (_index_pages_cached) {
+        index_page_cache::shard_instance().invalidate(*this);
+    }
     if (_index_file) {
         _index_file.close().handle_exception([save = _index_file, op = background_jobs().start()] (auto ep) {
             sstlog.warn("sstable close index_file failed: {}", ep);
@@ -3277,6 +3347,18 @@ future<> init_metrics() {
             sm::description("Index page requests which initiated a read from disk")),
         sm::make_derive("index_page_blocks", [] { return shared_index_lists::shard_stats().blocks; },
             sm::description("Index page requests which needed to wait due to page not being loaded yet")),
+        sm::make_derive("index_page_cache_hits", [] { return index_page_cache::shard_instance().get_stats().hits; },
+            sm::description("Index page loads which were served from the index page cache")),
+        sm::make_derive("index_page_cache_misses", [] { return index_page_cache::shard_instance().get_stats().misses; },
+            sm::description("Index page loads which had to read the page from disk")),
+        sm::make_derive("index_page_cache_evictions", [] { return index_page_cache::shard_instance().get_stats().evictions; },
+            sm::description("Index pages evicted from the index page cache to reclaim memory")),
+        sm::make_derive("index_page_cache_populations", [] { return index_page_cache::shard_instance().get_stats().insertions; },
+            sm::description("Index pages inserted into the index page cache")),
+        sm::make_gauge("index_page_cache_pages", [] { return index_page_cache::shard_instance().get_stats().pages; },
+            sm::description("Number of pages in the index page cache")),
+        sm::make_gauge("index_page_cache_bytes", [] { return index_page_cache::shard_instance().region().occupancy().used_space(); },
+            sm::description("Memory used by the index page cache")),
 
         sm::make_derive("partition_writes", [] { return sstables_stats::get_shard_stats().partition_writes; },
             sm::description("Number of partitions written")),
@@ -3337,6 +3419,14 @@ bool supports_correct_non_compound_range_tombstones() {
     return service::get_local_storage_service().cluster_supports_reading_correctly_serialized_range_tombstones();
 }
 
+bool supports_blocked_bloom_filter() {
+    return service::get_local_storage_service().cluster_supports_blocked_bloom_filter();
+}
+
+uint32_t promoted_index_lookup_threshold() {
+    return std::min<uint64_t>(uint64_t(get_config().promoted_index_bsearch_threshold_in_kb()) * 1024, std::numeric_limits<uint32_t>::max());
+}
+
 }
 
 std::ostream& operator<<(std::ostream& out, const sstables::component_type& comp_type) {
@@ -3354,6 +3444,7 @@ std::ostream& operator<<(std::ostream& out, const sstables::component_type& comp
     case ct::TemporaryTOC: out << "TemporaryTOC"; break;
     case ct::TemporaryStatistics: out << "TemporaryStatistics"; break;
     case ct::Scylla: out << "Scylla"; break;
+    case ct::CompressionDictionary: out << "CompressionDictionary"; break;
     case ct::Unknown: out << "Unknown"; break;
     }
     return out;
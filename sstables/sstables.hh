@@ -60,6 +60,7 @@
 #include "db/large_data_handler.hh"
 #include "column_translation.hh"
 #include "stats.hh"
+#include "read_ahead.hh"
 #include "utils/observable.hh"
 
 #include <seastar/util/optimized_optional.hh>
@@ -86,10 +87,12 @@ struct sstable_open_info;
 GCC6_CONCEPT(
 template<typename T>
 concept bool ConsumeRowsContext() {
-    return requires(T c, indexable_element el, size_t s) {
+    return requires(T c, indexable_element el, size_t s, input_stream<char>&& in) {
         { c.consume_input() } -> future<>;
         { c.reset(el) } -> void;
         { c.fast_forward_to(s, s) } -> future<>;
+        { c.switch_input(std::move(in), s, s) } -> input_stream<char>;
+        { c.end_position() } -> uint64_t;
         { c.position() } -> uint64_t;
         { c.skip_to(s) } -> future<>;
         { c.reader_position() } -> const sstables::reader_position_tracker&;
@@ -108,6 +111,9 @@ class data_consume_context;
 class index_reader;
 
 bool supports_correct_non_compound_range_tombstones();
+bool supports_blocked_bloom_filter();
+// Size from which promoted indexes are looked up by binary search rather than parsed sequentially.
+uint32_t promoted_index_lookup_threshold();
 
 struct sstable_writer_config {
     std::optional<size_t> promoted_index_block_size;
@@ -117,10 +123,19 @@ struct sstable_writer_config {
     std::optional<db::replay_position> replay_position;
     write_monitor* monitor = &default_write_monitor();
     bool correctly_serialize_non_compound_range_tombstones = supports_correct_non_compound_range_tombstones();
+    bool blocked_bloom_filter = supports_blocked_bloom_filter();
     db::large_data_handler* large_data_handler;
     utils::UUID run_identifier = utils::make_random_uuid();
+    // Record per-column min/max zone maps in the Scylla component (mc only).
+    bool zone_maps = false;
 };
 
+// Whether sstables written with sstable_writer_config::zone_maps record a
+// column_zone_map for the column.
+inline bool column_zone_map_is_tracked(const column_definition& cdef) {
+    return cdef.is_regular() && cdef.is_atomic() && !cdef.is_counter();
+}
+
 static constexpr inline size_t default_sstable_buffer_size() {
     return 128 * 1024;
 }
@@ -414,6 +429,12 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     bool requires_view_building() const;
 
+    // Makes readers of the data file account the bytes they read and
+    // consume in stats.
+    void set_data_read_stats(lw_shared_ptr<data_read_stats> stats) {
+        _data_read_stats = std::move(stats);
+    }
+
     metadata_collector& get_metadata_collector() {
         return _collector;
     }
@@ -488,6 +509,13 @@ class sstable : public enable_lw_shared_from_this<sstable> {
 
     lw_shared_ptr<file_input_stream_history> _single_partition_history = make_lw_shared<file_input_stream_history>();
     lw_shared_ptr<file_input_stream_history> _partition_range_history = make_lw_shared<file_input_stream_history>();
+    // Set by the owning table, accounts the reads of the data file.
+    lw_shared_ptr<data_read_stats> _data_read_stats;
+    // Compressor for reading the data file, shared by the readers on this
+    // shard so that the dictionary is prepared once rather than per read.
+    // The components are shared with other shards, so it can't live there.
+    compressor_ptr _reader_compressor;
+    const compressor_ptr& reader_compressor();
 
     //FIXME: Set by sstable_writer to influence sstable writing behavior.
     //       Remove when doing #3012
@@ -529,6 +557,10 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     filter_tracker _filter_tracker;
 
     bool _marked_for_deletion = false;
+    // Set once any of our index pages was put in the index_page_cache.
+    bool _index_pages_cached = false;
+    // Last estimate_purgeable_tombstone_fraction(), with the version of the sstable set it was computed against.
+    std::optional<std::pair<uint64_t, double>> _purgeable_tombstone_fraction;
 
     gc_clock::time_point _now;
 
@@ -565,7 +597,8 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     void write_compression(const io_priority_class& pc);
 
     future<> read_scylla_metadata(const io_priority_class& pc);
-    void write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, run_identifier identifier);
+    void write_scylla_metadata(const io_priority_class& pc, shard_id shard, sstable_enabled_features features, run_identifier identifier,
+            std::optional<disk_array<uint32_t, column_zone_map>> zone_maps = {});
 
     future<> read_filter(const io_priority_class& pc);
 
@@ -614,8 +647,18 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // of bytes to be read using this stream, we can make better choices
     // about the buffer size to read, and where exactly to stop reading
     // (even when a large buffer size is used).
+    //
+    // read_ahead is the number of buffers read ahead of the consumer, see
+    // read_ahead_tracker.
     input_stream<char> data_stream(uint64_t pos, size_t len, const io_priority_class& pc,
-                                   reader_resource_tracker resource_tracker, lw_shared_ptr<file_input_stream_history> history);
+                                   reader_resource_tracker resource_tracker, lw_shared_ptr<file_input_stream_history> history,
+                                   unsigned read_ahead = read_ahead_tracker::default_read_ahead);
+
+    // Maps pos, an offset in the uncompressed data, to an offset in the data
+    // file on disk. Within a compressed chunk, the offset is interpolated
+    // linearly, so that differences of offsets estimate how many compressed
+    // bytes hold a range of the data.
+    uint64_t data_file_offset(uint64_t pos);
 
     // Read exactly the specific byte range from the data file (after
     // uncompression, if the file is compressed). This can be used to read
@@ -687,10 +730,19 @@ class sstable : public enable_lw_shared_from_this<sstable> {
         return has_scylla_component() && _components->scylla_metadata->has_feature(sstable_feature::ShadowableTombstones);
     }
 
+    bool has_blocked_bloom_filter() const {
+        return has_scylla_component() && _components->scylla_metadata->has_feature(sstable_feature::BlockedBloomFilter);
+    }
+
     utils::UUID run_identifier() const {
         return _run_identifier;
     }
 
+    // Returns false when the zone map of cdef proves that no row in this
+    // sstable has a value of cdef within range. Rows with no value for the
+    // column are not accounted for, so range must not contain the empty value.
+    bool may_contain_values(const column_definition& cdef, const nonwrapping_range<bytes>& range) const;
+
     bool has_correct_max_deletion_time() const {
         return (_version == sstable_version_types::mc) || has_scylla_component();
     }
@@ -781,6 +833,16 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // This will change sstable level only in memory.
     void set_sstable_level(uint32_t);
 
+    // Time, in milliseconds since the epoch, as of which the content of this sstable was
+    // repaired, or 0 if it wasn't.
+    uint64_t repaired_at() const {
+        return get_stats_metadata().repaired_at;
+    }
+
+    bool is_repaired() const {
+        return repaired_at() != 0;
+    }
+
     double get_compression_ratio() const;
 
     future<> mutate_sstable_level(uint32_t);
@@ -795,6 +857,18 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     // for cells expired before gc_before and regular tombstones older than gc_before.
     double estimate_droppable_tombstone_ratio(gc_clock::time_point gc_before) const;
 
+    // Cache of estimate_purgeable_tombstone_fraction(), which doesn't change as long as
+    // the sstable set of the table doesn't.
+    std::optional<double> cached_purgeable_tombstone_fraction(uint64_t set_version) const {
+        if (_purgeable_tombstone_fraction && _purgeable_tombstone_fraction->first == set_version) {
+            return _purgeable_tombstone_fraction->second;
+        }
+        return std::nullopt;
+    }
+    void cache_purgeable_tombstone_fraction(uint64_t set_version, double fraction) {
+        _purgeable_tombstone_fraction.emplace(set_version, fraction);
+    }
+
     // get sstable open info from a loaded sstable, which can be used to quickly open a sstable
     // at another shard.
     future<foreign_sstable_open_info> get_open_info() &;
@@ -819,6 +893,9 @@ class sstable : public enable_lw_shared_from_this<sstable> {
     friend class mc::writer;
     friend class index_reader;
     template <typename DataConsumeRowsContext>
+    GCC6_CONCEPT(requires ConsumeRowsContext<DataConsumeRowsContext>())
+    friend class data_consume_context;
+    template <typename DataConsumeRowsContext>
     friend data_consume_context<DataConsumeRowsContext>
     data_consume_rows(const schema&, shared_sstable, typename DataConsumeRowsContext::consumer&, disk_read_range, uint64_t);
     template <typename DataConsumeRowsContext>
@@ -169,6 +169,17 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
         }
         return compaction_descriptor(std::move(compaction_candidates));
     }
+
+    // Merge the input into a sstable per time window, as would compaction of each window.
+    virtual std::vector<compaction_descriptor> get_reshaping_jobs(column_family& cf, std::vector<shared_sstable> input) override {
+        std::vector<compaction_descriptor> jobs;
+        for (auto& [window, sstables] : get_buckets(std::move(input), _options).first) {
+            if (sstables.size() > 1) {
+                jobs.emplace_back(std::move(sstables));
+            }
+        }
+        return jobs;
+    }
 private:
     static timestamp_type
     to_timestamp_type(time_window_compaction_strategy_options::timestamp_resolutions resolution, int64_t timestamp_from_sstable) {
@@ -192,8 +203,8 @@ class time_window_compaction_strategy : public compaction_strategy_impl {
 
         // if there is no sstable to compact in standard way, try compacting single sstable whose droppable tombstone
         // ratio is greater than threshold.
-        auto e = boost::range::remove_if(non_expiring_sstables, [this, &gc_before] (const shared_sstable& sst) -> bool {
-            return !worth_dropping_tombstones(sst, gc_before);
+        auto e = boost::range::remove_if(non_expiring_sstables, [this, &cf, &gc_before] (const shared_sstable& sst) -> bool {
+            return !worth_dropping_tombstones(sst, cf, gc_before);
         });
         non_expiring_sstables.erase(e, non_expiring_sstables.end());
         if (non_expiring_sstables.empty()) {
@@ -457,7 +457,8 @@ enum sstable_feature : uint8_t {
     NonCompoundPIEntries = 0,       // See #2993
     NonCompoundRangeTombstones = 1, // See #2986
     ShadowableTombstones = 2, // See #3885
-    End = 4,
+    BlockedBloomFilter = 4, // Filter.db holds a utils::filter::blocked_bloom_filter
+    End = 5,
 };
 
 // Scylla-specific features enabled for a particular sstable.
@@ -496,6 +497,7 @@ enum class scylla_metadata_type : uint32_t {
     Features = 2,
     ExtensionAttributes = 3,
     RunIdentifier = 4,
+    ZoneMaps = 5,
 };
 
 struct run_identifier {
@@ -507,6 +509,20 @@ struct run_identifier {
     auto describe_type(sstable_version_types v, Describer f) { return f(id); }
 };
 
+// Smallest and largest live value written for a regular column, compared
+// with the column's type. Used to skip whole sstables on filtered reads
+// whose restriction on the column cannot be satisfied by any value in
+// [min, max]. The column is identified by name, so that the zone map
+// survives schema changes which reassign column ids.
+struct column_zone_map {
+    disk_string<uint32_t> name;
+    disk_string<uint32_t> min;
+    disk_string<uint32_t> max;
+
+    template <typename Describer>
+    auto describe_type(sstable_version_types v, Describer f) { return f(name, min, max); }
+};
+
 struct scylla_metadata {
     using extension_attributes = disk_hash<uint32_t, disk_string<uint32_t>, disk_string<uint32_t>>;
 
@@ -514,7 +530,8 @@ struct scylla_metadata {
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::Sharding, sharding_metadata>,
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::Features, sstable_enabled_features>,
             disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ExtensionAttributes, extension_attributes>,
-            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::RunIdentifier, run_identifier>
+            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::RunIdentifier, run_identifier>,
+            disk_tagged_union_member<scylla_metadata_type, scylla_metadata_type::ZoneMaps, disk_array<uint32_t, column_zone_map>>
             > data;
 
     bool has_feature(sstable_feature f) const {
@@ -536,6 +553,18 @@ struct scylla_metadata {
         auto* m = data.get<scylla_metadata_type::RunIdentifier, run_identifier>();
         return m ? std::make_optional(m->id) : std::nullopt;
     }
+    const disk_array<uint32_t, column_zone_map>* get_zone_maps() const {
+        return data.get<scylla_metadata_type::ZoneMaps, disk_array<uint32_t, column_zone_map>>();
+    }
+
+    template <typename Describer>
+    auto describe_type(sstable_version_types v, Describer f) { return f(data); }
+};
+
+// Dictionary shared by all compressed chunks of the Data component, for
+// compressors which support one (see compressor::dictionary_size()).
+struct compression_dictionary {
+    disk_string<uint32_t> data;
 
     template <typename Describer>
     auto describe_type(sstable_version_types v, Describer f) { return f(data); }
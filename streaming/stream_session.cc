@@ -190,11 +190,13 @@ void stream_session::init_messaging_service_handler() {
                                 schema_ptr s = reader.schema();
                                 sstables::sstable_writer_config sst_cfg;
                                 sst_cfg.large_data_handler = cf->get_large_data_handler();
+                                sst_cfg.zone_maps = cf->sstable_zone_maps_enabled();
                                 auto& pc = service::get_local_streaming_write_priority();
                                 return sst->write_components(std::move(reader), std::max(1ul, estimated_partitions), s, sst_cfg, {}, pc).then([sst] {
                                     return sst->open_data();
                                 }).then([cf, sst] {
-                                    return cf->add_sstable_and_update_cache(sst);
+                                    // reshaped by off-strategy compaction once the stream is done, see flush_streaming_mutations().
+                                    return cf->add_maintenance_sstable_and_update_cache(sst);
                                 }).then([cf, s, sst, use_view_update_path]() mutable -> future<> {
                                     if (!use_view_update_path) {
                                         return make_ready_future<>();
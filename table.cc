@@ -468,7 +468,10 @@ table::make_reader(schema_ptr s,
     if (_config.enable_cache && !slice.options.contains(query::partition_slice::option::bypass_cache)) {
         readers.emplace_back(_cache.make_reader(s, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
     } else {
-        readers.emplace_back(make_sstable_reader(s, _sstables, range, slice, pc, std::move(trace_state), fwd, fwd_mr));
+        // Zone maps are only applied when bypassing the cache, which would
+        // otherwise be populated with partitions lacking the skipped data.
+        auto sstables = slice.value_ranges().empty() ? _sstables : exclude_sstables_by_value_ranges(*s, range, slice.value_ranges(), trace_state);
+        readers.emplace_back(make_sstable_reader(s, std::move(sstables), range, slice, pc, std::move(trace_state), fwd, fwd_mr));
     }
 
     auto comb_reader = make_combined_reader(s, std::move(readers), fwd, fwd_mr);
@@ -492,6 +495,47 @@ sstables::shared_sstable table::make_streaming_sstable_for_write(std::optional<s
     return newtab;
 }
 
+lw_shared_ptr<sstables::sstable_set>
+table::exclude_sstables_by_value_ranges(const schema& s, const dht::partition_range& range,
+                                        const query::column_value_ranges& value_ranges,
+                                        const tracing::trace_state_ptr& trace_state) const {
+    // The zone maps of an sstable only describe the rows as they are in that
+    // sstable. A row with parts in several sstables or memtables may match
+    // when merged even though none of its parts does, e.g. when each part
+    // holds the matching value of a different column, or when an sstable
+    // lacks the restricted column, whose value comes from another one. So an
+    // sstable is only skipped for a partition which no other source holds.
+    // That can only be told cheaply for a single partition, through the
+    // filters of the other sstables, and is common for partitions written
+    // once, e.g. time series bucketed by time window.
+    if (!range.is_singular() || !range.start()->value().has_key()) {
+        return _sstables;
+    }
+    auto& key = *range.start()->value().key();
+    sstables::shared_sstable holder;
+    for (auto&& sst : _sstables->select(range)) {
+        if (!sst->filter_has_key(s, key)) {
+            continue;
+        }
+        if (holder) {
+            return _sstables;
+        }
+        holder = sst;
+    }
+    if (!holder) {
+        return _sstables;
+    }
+    auto may_match = boost::algorithm::all_of(value_ranges, [&] (const query::column_value_range& vr) {
+        return holder->may_contain_values(s.regular_column_at(vr.column), vr.range);
+    });
+    if (may_match || boost::algorithm::any_of(*_memtables, [&] (const lw_shared_ptr<memtable>& mt) { return mt->has_partitions_in(range); })) {
+        return _sstables;
+    }
+    tracing::trace(trace_state, "Skipping sstable {} by zone maps", holder->get_filename());
+    // No other sstable holds the partition, so there is nothing left to read.
+    return make_lw_shared(_compaction_strategy.make_sstable_set(_schema));
+}
+
 flat_mutation_reader
 table::make_streaming_reader(schema_ptr s,
                            const dht::partition_range_vector& ranges) const {
@@ -599,6 +643,147 @@ flat_mutation_reader make_local_shard_sstable_reader(schema_ptr s,
             fwd_mr);
 }
 
+// Reads the sstables one region of the key space after the other, where a region is covered by a
+// group of sstables overlapping with no sstable out of it. A region of a single sstable is read
+// directly from its reader, only those of several sstables go through the combined reader.
+class disjoint_pass_through_sstable_reader final : public flat_mutation_reader::impl {
+    struct region {
+        dht::partition_range range;
+        // Set iff the region is covered by a single sstable.
+        sstables::shared_sstable sst;
+    };
+    lw_shared_ptr<sstables::sstable_set> _sstables;
+    // Never resized once built, as region readers refer to their range.
+    std::vector<region> _regions;
+    std::vector<region>::iterator _next_region;
+    tracing::trace_state_ptr _trace_state;
+    sstable_reader_factory_type _fn;
+    std::optional<flat_mutation_reader> _reader;
+private:
+    static std::vector<region> get_regions(const schema& s, const sstables::sstable_set& sstables, const dht::partition_range& pr) {
+        auto ssts = boost::copy_range<std::vector<sstables::shared_sstable>>(*sstables.all());
+        std::sort(ssts.begin(), ssts.end(), [&s] (const sstables::shared_sstable& a, const sstables::shared_sstable& b) {
+            return a->get_first_decorated_key().tri_compare(s, b->get_first_decorated_key()) < 0;
+        });
+
+        std::vector<region> regions;
+        auto add_region = [&] (auto first, auto last) {
+            const dht::decorated_key* last_key = &(*first)->get_last_decorated_key();
+            for (auto it = first; it != last; ++it) {
+                if ((*it)->get_last_decorated_key().tri_compare(s, *last_key) > 0) {
+                    last_key = &(*it)->get_last_decorated_key();
+                }
+            }
+            auto range = dht::partition_range::make(dht::ring_position((*first)->get_first_decorated_key()), dht::ring_position(*last_key));
+            if (auto r = pr.intersection(range, dht::ring_position_comparator(s))) {
+                regions.push_back(region{std::move(*r), std::next(first) == last ? *first : nullptr});
+            }
+        };
+
+        auto region_begin = ssts.begin();
+        const dht::decorated_key* region_last = nullptr;
+        for (auto it = ssts.begin(); it != ssts.end(); ++it) {
+            if (region_last && (*it)->get_first_decorated_key().tri_compare(s, *region_last) > 0) {
+                add_region(region_begin, it);
+                region_begin = it;
+                region_last = nullptr;
+            }
+            if (!region_last || (*it)->get_last_decorated_key().tri_compare(s, *region_last) > 0) {
+                region_last = &(*it)->get_last_decorated_key();
+            }
+        }
+        if (region_begin != ssts.end()) {
+            add_region(region_begin, ssts.end());
+        }
+        return regions;
+    }
+
+    flat_mutation_reader make_region_reader(region& r) {
+        if (r.sst) {
+            // The reader keeps the sstable alive for as long as it needs it.
+            auto sst = std::exchange(r.sst, nullptr);
+            return _fn(sst, r.range);
+        }
+        // Selecting from all of the sstables only yields those of the region, as no other overlaps it.
+        return make_combined_reader(_schema, std::make_unique<incremental_reader_selector>(_schema,
+                        _sstables,
+                        r.range,
+                        _trace_state,
+                        _fn),
+                streamed_mutation::forwarding::no,
+                mutation_reader::forwarding::no);
+    }
+public:
+    disjoint_pass_through_sstable_reader(schema_ptr s, lw_shared_ptr<sstables::sstable_set> sstables, const dht::partition_range& pr,
+            tracing::trace_state_ptr trace_state, sstable_reader_factory_type fn)
+        : impl(s)
+        , _sstables(std::move(sstables))
+        , _regions(get_regions(*s, *_sstables, pr))
+        , _next_region(_regions.begin())
+        , _trace_state(std::move(trace_state))
+        , _fn(std::move(fn)) {
+    }
+
+    virtual future<> fill_buffer(db::timeout_clock::time_point timeout) override {
+        return do_until([this] { return is_end_of_stream() || is_buffer_full(); }, [this, timeout] {
+            if (!_reader) {
+                if (_next_region == _regions.end()) {
+                    _end_of_stream = true;
+                    return make_ready_future<>();
+                }
+                _reader = make_region_reader(*_next_region++);
+            }
+            return _reader->fill_buffer(timeout).then([this] {
+                _reader->move_buffer_content_to(*this);
+                if (_reader->is_end_of_stream()) {
+                    _reader = std::nullopt;
+                }
+            });
+        });
+    }
+
+    virtual void next_partition() override {
+        clear_buffer_to_next_partition();
+        if (is_buffer_empty() && _reader) {
+            _reader->next_partition();
+        }
+    }
+
+    virtual future<> fast_forward_to(const dht::partition_range&, db::timeout_clock::time_point) override {
+        throw std::bad_function_call();
+    }
+
+    virtual future<> fast_forward_to(position_range, db::timeout_clock::time_point) override {
+        throw std::bad_function_call();
+    }
+
+    virtual size_t buffer_size() const override {
+        return flat_mutation_reader::impl::buffer_size() + (_reader ? _reader->buffer_size() : 0);
+    }
+};
+
+flat_mutation_reader make_disjoint_pass_through_sstable_reader(schema_ptr s,
+        lw_shared_ptr<sstables::sstable_set> sstables,
+        const dht::partition_range& pr,
+        const query::partition_slice& slice,
+        const io_priority_class& pc,
+        reader_resource_tracker resource_tracker,
+        tracing::trace_state_ptr trace_state,
+        sstables::read_monitor_generator& monitor_generator)
+{
+    auto reader_factory_fn = [s, &slice, &pc, resource_tracker, &monitor_generator] (sstables::shared_sstable& sst, const dht::partition_range& pr) {
+        flat_mutation_reader reader = sst->read_range_rows_flat(s, pr, slice, pc, resource_tracker,
+                streamed_mutation::forwarding::no, mutation_reader::forwarding::no, monitor_generator(sst));
+        if (sst->is_shared()) {
+            using sig = bool (&)(const dht::decorated_key&);
+            reader = make_filtering_reader(std::move(reader), sig(belongs_to_current_shard));
+        }
+        return reader;
+    };
+    return make_flat_mutation_reader<disjoint_pass_through_sstable_reader>(s, std::move(sstables), pr, std::move(trace_state),
+            std::move(reader_factory_fn));
+}
+
 future<sstables::shared_sstable>
 table::open_sstable(sstables::foreign_sstable_open_info info, sstring dir, int64_t generation,
         sstables::sstable::version_types v, sstables::sstable::format_types f) {
@@ -658,13 +843,14 @@ void table::update_stats_for_new_sstable(uint64_t disk_space_used_by_sstable, co
 
 void table::add_sstable(sstables::shared_sstable sstable, const std::vector<unsigned>& shards_for_the_sstable) {
     // allow in-progress reads to continue using old list
+    sstable->set_data_read_stats(_data_read_stats);
     auto new_sstables = make_lw_shared(*_sstables);
     new_sstables->insert(sstable);
     _sstables = std::move(new_sstables);
     update_stats_for_new_sstable(sstable->bytes_on_disk(), shards_for_the_sstable);
     if (sstable->requires_view_building()) {
         _sstables_staging.emplace(sstable->generation(), sstable);
-    } else {
+    } else if (!_sstables_maintenance.count(sstable->generation())) {
         _compaction_strategy.get_backlog_tracker().add_sstable(sstable);
     }
 }
@@ -679,6 +865,19 @@ table::add_sstable_and_update_cache(sstables::shared_sstable sst) {
     }, dht::partition_range::make({sst->get_first_decorated_key(), true}, {sst->get_last_decorated_key(), true}));
 }
 
+future<>
+table::add_maintenance_sstable_and_update_cache(sstables::shared_sstable sst) {
+    if (sst->requires_view_building()) {
+        // staging sstables are kept away from compaction until views are built anyway.
+        return add_sstable_and_update_cache(std::move(sst));
+    }
+    return get_row_cache().invalidate([this, sst] () noexcept {
+        // FIXME: this is not really noexcept, but we need to provide strong exception guarantees.
+        _sstables_maintenance.emplace(sst->generation(), sst);
+        add_sstable(sst, {engine().cpu_id()});
+    }, dht::partition_range::make({sst->get_first_decorated_key(), true}, {sst->get_last_decorated_key(), true}));
+}
+
 future<>
 table::update_cache(lw_shared_ptr<memtable> m, sstables::shared_sstable sst) {
     auto adder = [this, m, sst] {
@@ -801,7 +1000,7 @@ table::seal_active_streaming_memtable_immediate(flush_permit&& permit) {
             database_sstable_write_monitor monitor(std::move(fp), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
             return do_with(std::move(monitor), [this, newtab, old, permit = std::move(permit)] (auto& monitor) mutable {
                 auto&& priority = service::get_local_streaming_write_priority();
-                return write_memtable_to_sstable(*old, newtab, monitor, get_large_data_handler(), incremental_backups_enabled(), priority, false).then([this, newtab, old] {
+                return write_memtable_to_sstable(*old, newtab, monitor, get_large_data_handler(), incremental_backups_enabled(), priority, false, sstable_zone_maps_enabled()).then([this, newtab, old] {
                     return newtab->open_data();
                 }).then([this, old, newtab] () {
                     return with_scheduling_group(_config.memtable_to_cache_scheduling_group, [this, newtab, old] {
@@ -852,7 +1051,7 @@ future<> table::seal_active_streaming_memtable_big(streaming_memtable_big& smb,
                 auto fp = permit.release_sstable_write_permit();
                 auto monitor = std::make_unique<database_sstable_write_monitor>(std::move(fp), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
                 auto&& priority = service::get_local_streaming_write_priority();
-                auto fut = write_memtable_to_sstable(*old, newtab, *monitor, get_large_data_handler(), incremental_backups_enabled(), priority, true);
+                auto fut = write_memtable_to_sstable(*old, newtab, *monitor, get_large_data_handler(), incremental_backups_enabled(), priority, true, sstable_zone_maps_enabled());
                 return fut.then_wrapped([this, newtab, old, &smb, permit = std::move(permit), monitor = std::move(monitor)] (future<> f) mutable {
                     if (!f.failed()) {
                         smb.sstables.push_back(monitored_sstable{std::move(monitor), newtab});
@@ -953,7 +1152,7 @@ table::try_flush_memtable_to_sstable(lw_shared_ptr<memtable> old, sstable_write_
     database_sstable_write_monitor monitor(std::move(permit), newtab, _compaction_manager, _compaction_strategy, old->get_max_timestamp());
     return do_with(std::move(monitor), [this, old, newtab] (auto& monitor) {
         auto&& priority = service::get_local_memtable_flush_priority();
-        auto f = write_memtable_to_sstable(*old, newtab, monitor, get_large_data_handler(), incremental_backups_enabled(), priority, false);
+        auto f = write_memtable_to_sstable(*old, newtab, monitor, get_large_data_handler(), incremental_backups_enabled(), priority, false, sstable_zone_maps_enabled());
         // Switch back to default scheduling group for post-flush actions, to avoid them being staved by the memtable flush
         // controller. Cache update does not affect the input of the memtable cpu controller, so it can be subject to
         // priority inversion.
@@ -1076,7 +1275,17 @@ void table::set_metrics() {
                 ms::make_gauge("live_disk_space", ms::description("Live disk space used"), _stats.live_disk_space_used)(cf)(ks),
                 ms::make_gauge("total_disk_space", ms::description("Total disk space used"), _stats.total_disk_space_used)(cf)(ks),
                 ms::make_gauge("live_sstable", ms::description("Live sstable count"), _stats.live_sstable_count)(cf)(ks),
-                ms::make_gauge("pending_compaction", ms::description("Estimated number of compactions pending for this column family"), _stats.pending_compactions)(cf)(ks)
+                ms::make_gauge("pending_compaction", ms::description("Estimated number of compactions pending for this column family"), _stats.pending_compactions)(cf)(ks),
+                ms::make_derive("purged_tombstones", ms::description("Number of tombstones garbage collected by compaction"), _stats.purged_tombstones)(cf)(ks),
+                ms::make_derive("cleanup_bytes_saved", ms::description("Bytes of sstables which cleanup skipped or deleted rather than rewrote"), _stats.cleanup_bytes_saved)(cf)(ks),
+                ms::make_gauge("compaction_shares", ms::description("Shares of compaction throughput allocated to this column family from its backlog"),
+                        [this] { return _compaction_manager.compaction_shares(this); })(cf)(ks),
+                ms::make_derive("compaction_bytes_written", ms::description("Bytes written by compactions of this column family"),
+                        [this] { return _compaction_manager.compacted_bytes(this); })(cf)(ks),
+                ms::make_derive("sstable_data_read_bytes", ms::description("Bytes read from disk by sstable data readers"), _data_read_stats->bytes_read)(cf)(ks),
+                ms::make_derive("sstable_data_consumed_bytes", ms::description("On-disk bytes of the sstable data consumed by sstable data readers, i.e. compressed bytes for compressed sstables"), _data_read_stats->bytes_consumed)(cf)(ks),
+                ms::make_gauge("sstable_read_amplification", ms::description("Ratio of bytes read from disk to on-disk bytes of the data consumed by sstable data readers"),
+                        [this] { return _data_read_stats->read_amplification(); })(cf)(ks)
         });
 
         // Metrics related to row locking
@@ -1137,6 +1346,10 @@ table::rebuild_sstable_list(const std::vector<sstables::shared_sstable>& new_sst
 
     std::unordered_set<sstables::shared_sstable> s(old_sstables.begin(), old_sstables.end());
 
+    for (auto& sst : new_sstables) {
+        sst->set_data_read_stats(_data_read_stats);
+    }
+
     // this might seem dangerous, but "move" here just avoids constness,
     // making the two ranges compatible when compiling with boost 1.55.
     // Noone is actually moving anything...
@@ -1182,6 +1395,9 @@ table::on_compaction_completion(const std::vector<sstables::shared_sstable>& new
     rebuild_sstable_list(new_sstables, sstables_to_remove);
 
     _sstables_compacted_but_not_deleted = std::move(new_compacted_but_not_deleted);
+    for (auto& sst : sstables_to_remove) {
+        _sstables_maintenance.erase(sst->generation());
+    }
 
     rebuild_statistics();
 
@@ -1262,6 +1478,7 @@ table::compact_sstables(sstables::compaction_descriptor descriptor, bool cleanup
         // if there is nothing to compact, just return.
         return make_ready_future<>();
     }
+    descriptor.use_garbage_collected_sstable = !cleanup && _compaction_strategy.use_garbage_collected_sstable();
 
     return with_lock(_sstables_lock.for_read(), [this, descriptor = std::move(descriptor), cleanup] () mutable {
         auto create_sstable = [this] {
@@ -1284,6 +1501,7 @@ table::compact_sstables(sstables::compaction_descriptor descriptor, bool cleanup
 
         return sstables::compact_sstables(std::move(descriptor), *this, create_sstable, replace_sstables, cleanup);
     }).then([this] (auto info) {
+        _stats.purged_tombstones += info.purged_tombstones;
         if (info.type != sstables::compaction_type::Compaction) {
             return make_ready_future<>();
         }
@@ -1300,7 +1518,36 @@ table::compact_sstables(sstables::compaction_descriptor descriptor, bool cleanup
     });
 }
 
-static bool needs_cleanup(const sstables::shared_sstable& sst,
+enum class cleanup_action {
+    // all of the sstable is owned by this node.
+    skip,
+    // none of the sstable is owned by this node.
+    remove,
+    // the sstable is partly owned by this node.
+    rewrite,
+};
+
+// Merges owned ranges into sorted, non-overlapping and non-adjacent ranges, so that an sstable
+// spanning adjacent owned ranges is found to be fully owned.
+static dht::token_range_vector merge_owned_ranges(dht::token_range_vector ranges) {
+    dht::token_comparator cmp;
+    ranges = dht::token_range::deoverlap(std::move(ranges), cmp);
+    dht::token_range_vector merged;
+    merged.reserve(ranges.size());
+    for (auto& r : ranges) {
+        if (!merged.empty() && merged.back().end() && r.start()
+                && cmp(merged.back().end()->value(), r.start()->value()) == 0
+                && (merged.back().end()->is_inclusive() || r.start()->is_inclusive())) {
+            merged.back() = dht::token_range(merged.back().start(), r.end());
+        } else {
+            merged.push_back(std::move(r));
+        }
+    }
+    return merged;
+}
+
+// owned_ranges are expected to be merged by merge_owned_ranges().
+static cleanup_action get_cleanup_action(const sstables::shared_sstable& sst,
                    const dht::token_range_vector& owned_ranges,
                    schema_ptr s) {
     auto first = sst->get_first_partition_key();
@@ -1309,27 +1556,57 @@ static bool needs_cleanup(const sstables::shared_sstable& sst,
     auto last_token = dht::global_partitioner().get_token(*s, last);
     dht::token_range sst_token_range = dht::token_range::make(first_token, last_token);
 
-    // return true iff sst partition range isn't fully contained in any of the owned ranges.
+    auto action = cleanup_action::remove;
     for (auto& r : owned_ranges) {
         if (r.contains(sst_token_range, dht::token_comparator())) {
-            return false;
+            return cleanup_action::skip;
+        }
+        if (r.overlaps(sst_token_range, dht::token_comparator())) {
+            action = cleanup_action::rewrite;
         }
     }
-    return true;
+    return action;
 }
 
 future<> table::cleanup_sstables(sstables::compaction_descriptor descriptor, bool is_actual_cleanup) {
     dht::token_range_vector r;
 
     if (is_actual_cleanup) {
-        r = service::get_local_storage_service().get_local_ranges(_schema->ks_name());
+        r = merge_owned_ranges(service::get_local_storage_service().get_local_ranges(_schema->ks_name()));
     }
 
-    return do_with(std::move(descriptor.sstables), std::move(r), std::move(descriptor.release_exhausted), [this, is_actual_cleanup] (auto& sstables, auto& owned_ranges, auto& release_fn) {
-        return do_for_each(sstables, [this, &owned_ranges, &release_fn, is_actual_cleanup] (auto& sst) {
-            if (!owned_ranges.empty() && !needs_cleanup(sst, owned_ranges, _schema)) {
+    struct cleanup_stats {
+        size_t skipped = 0;
+        size_t removed = 0;
+        size_t rewritten = 0;
+        uint64_t bytes_saved = 0;
+    };
+
+    return do_with(std::move(descriptor.sstables), std::move(r), std::move(descriptor.release_exhausted), cleanup_stats(),
+            [this, is_actual_cleanup] (auto& sstables, auto& owned_ranges, auto& release_fn, cleanup_stats& stats) {
+        return do_for_each(sstables, [this, &owned_ranges, &release_fn, &stats, is_actual_cleanup] (auto& sst) {
+            auto action = is_actual_cleanup ? get_cleanup_action(sst, owned_ranges, _schema) : cleanup_action::rewrite;
+            if (action == cleanup_action::skip) {
+                stats.skipped++;
+                stats.bytes_saved += sst->bytes_on_disk();
                 return make_ready_future<>();
             }
+            if (action == cleanup_action::remove) {
+                stats.removed++;
+                stats.bytes_saved += sst->bytes_on_disk();
+                // Nothing in it would survive cleanup, so it's removed as if compacted into nothing, without being read.
+                return with_lock(_sstables_lock.for_read(), [this, &sst, &release_fn] {
+                    std::vector<sstables::shared_sstable> removed{std::move(sst)};
+                    _compaction_strategy.get_backlog_tracker().remove_sstable(removed.front());
+                    _compaction_strategy.notify_completion(removed, {});
+                    _compaction_manager.propagate_replacement(this, removed, {});
+                    on_compaction_completion({}, removed);
+                    if (release_fn) {
+                        release_fn(removed);
+                    }
+                });
+            }
+            stats.rewritten++;
 
             // this semaphore ensures that only one cleanup will run per shard.
             // That's to prevent node from running out of space when almost all sstables
@@ -1344,6 +1621,13 @@ future<> table::cleanup_sstables(sstables::compaction_descriptor descriptor, boo
                 descriptor.release_exhausted = release_fn;
                 return this->compact_sstables(std::move(descriptor), is_actual_cleanup);
             });
+        }).then([this, &stats, is_actual_cleanup] {
+            if (!is_actual_cleanup) {
+                return;
+            }
+            _stats.cleanup_bytes_saved += stats.bytes_saved;
+            tlogger.info("Cleanup of {}.{}: skipped {} fully owned sstables, deleted {} unowned sstables and rewrote {}, saving {} bytes of rewrite",
+                    _schema->ks_name(), _schema->cf_name(), stats.skipped, stats.removed, stats.rewritten, stats.bytes_saved);
         });
     });
 }
@@ -1382,6 +1666,66 @@ future<> table::run_compaction(sstables::compaction_descriptor descriptor) {
     return compact_sstables(std::move(descriptor));
 }
 
+void table::trigger_offstrategy_compaction() {
+    if (_offstrategy_compaction_pending) {
+        return;
+    }
+    _offstrategy_compaction_pending = true;
+    // Wait for the streams in progress first, so that what they write is reshaped in a single pass.
+    (void)run_async([this] {
+        return await_pending_streams().then([this] {
+            _offstrategy_compaction_pending = false;
+            // Stopped and waited for by the compaction manager on removal of the table.
+            (void)_compaction_manager.perform_offstrategy_compaction(this);
+        });
+    }).handle_exception([this] (std::exception_ptr ep) {
+        _offstrategy_compaction_pending = false;
+        tlogger.warn("Failed to trigger off-strategy compaction of {}.{}: {}", _schema->ks_name(), _schema->cf_name(), ep);
+    });
+}
+
+future<> table::run_offstrategy_compaction() {
+    auto sstables = maintenance_sstables();
+    if (sstables.empty()) {
+        return make_ready_future<>();
+    }
+    auto jobs = _compaction_strategy.get_reshaping_jobs(*this, sstables);
+    tlogger.info("Off-strategy compaction of {} sstables of {}.{}, in {} jobs", sstables.size(), _schema->ks_name(), _schema->cf_name(), jobs.size());
+
+    return with_scheduling_group(_config.streaming_scheduling_group, [this, jobs = std::move(jobs)] () mutable {
+        return do_with(std::move(jobs), [this] (std::vector<sstables::compaction_descriptor>& jobs) {
+            return do_for_each(jobs, [this] (sstables::compaction_descriptor& descriptor) {
+                // The input is charged to the strategy's backlog only while it's being compacted,
+                // compaction removes it as usual.
+                auto& tracker = _compaction_strategy.get_backlog_tracker();
+                for (auto& sst : descriptor.sstables) {
+                    tracker.add_sstable(sst);
+                }
+                auto input = descriptor.sstables;
+                return compact_sstables(std::move(descriptor)).handle_exception([this, input = std::move(input)] (std::exception_ptr ep) {
+                    auto& tracker = _compaction_strategy.get_backlog_tracker();
+                    for (auto& sst : input) {
+                        if (_sstables_maintenance.count(sst->generation())) {
+                            tracker.remove_sstable(sst);
+                        }
+                    }
+                    return make_exception_future<>(std::move(ep));
+                });
+            });
+        });
+    }).finally([this, sstables = std::move(sstables)] {
+        // Maintenance sstables not compacted by any job are in the strategy's layout already.
+        // Those left behind by a failed or stopped job are handed back too, as nothing would
+        // retry them until the next stream ends.
+        for (auto& sst : sstables) {
+            if (_sstables_maintenance.erase(sst->generation())) {
+                _compaction_strategy.get_backlog_tracker().add_sstable(sst);
+            }
+        }
+        trigger_compaction();
+    });
+}
+
 void table::set_compaction_strategy(sstables::compaction_strategy_type strategy) {
     tlogger.debug("Setting compaction strategy of {}.{} to {}", _schema->ks_name(), _schema->cf_name(), sstables::compaction_strategy::name(strategy));
     auto new_cs = make_compaction_strategy(strategy, _schema->compaction_strategy_options());
@@ -1392,7 +1736,9 @@ void table::set_compaction_strategy(sstables::compaction_strategy_type strategy)
 
     auto new_sstables = new_cs.make_sstable_set(_schema);
     for (auto&& s : *_sstables->all()) {
-        new_cs.get_backlog_tracker().add_sstable(s);
+        if (!_sstables_maintenance.count(s->generation())) {
+            new_cs.get_backlog_tracker().add_sstable(s);
+        }
         new_sstables.insert(s);
     }
 
@@ -1467,10 +1813,15 @@ std::vector<sstables::shared_sstable> table::select_sstables(const dht::partitio
 std::vector<sstables::shared_sstable> table::candidates_for_compaction() const {
     return boost::copy_range<std::vector<sstables::shared_sstable>>(*get_sstables()
             | boost::adaptors::filtered([this] (auto& sst) {
-        return !_sstables_need_rewrite.count(sst->generation()) && !_sstables_staging.count(sst->generation());
+        return !_sstables_need_rewrite.count(sst->generation()) && !_sstables_staging.count(sst->generation())
+                && !_sstables_maintenance.count(sst->generation());
     }));
 }
 
+std::vector<sstables::shared_sstable> table::maintenance_sstables() const {
+    return boost::copy_range<std::vector<sstables::shared_sstable>>(_sstables_maintenance | boost::adaptors::map_values);
+}
+
 std::vector<sstables::shared_sstable> table::sstables_need_rewrite() const {
     return boost::copy_range<std::vector<sstables::shared_sstable>>(_sstables_need_rewrite | boost::adaptors::map_values);
 }
@@ -1839,10 +2190,13 @@ future<> table::flush_streaming_mutations(utils::UUID plan_id, dht::partition_ra
                     // FIXME: this is not really noexcept, but we need to provide strong exception guarantees.
                     for (auto&& sst : sstables) {
                         // seal_active_streaming_memtable_big() ensures sst is unshared.
+                        _sstables_maintenance.emplace(sst.sstable->generation(), sst.sstable);
                         this->add_sstable(sst.sstable, {engine().cpu_id()});
                     }
                     this->try_trigger_compaction();
-                }, std::move(ranges));
+                }, std::move(ranges)).then([this] {
+                    trigger_offstrategy_compaction();
+                });
             });
         });
     });
@@ -2280,11 +2634,12 @@ table::apply(const frozen_mutation& m, const schema_ptr& m_schema, db::rp_handle
 future<>
 write_memtable_to_sstable(memtable& mt, sstables::shared_sstable sst,
                           sstables::write_monitor& monitor, db::large_data_handler* lp_handler,
-                          bool backup, const io_priority_class& pc, bool leave_unsealed) {
+                          bool backup, const io_priority_class& pc, bool leave_unsealed, bool zone_maps) {
     sstables::sstable_writer_config cfg;
     cfg.replay_position = mt.replay_position();
     cfg.backup = backup;
     cfg.leave_unsealed = leave_unsealed;
+    cfg.zone_maps = zone_maps;
     cfg.monitor = &monitor;
     cfg.large_data_handler = lp_handler;
     return sst->write_components(mt.make_flush_reader(mt.schema(), pc), mt.partition_count(),
@@ -125,6 +125,8 @@ boost_tests = [
     'top_k_test',
     'utf8_test',
     'small_vector_test',
+    'bptree_test',
+    'frequency_sketch_test',
     'data_listeners_test',
     'truncation_migration_test',
 ]
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE bptree
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <set>
+#include <boost/range/adaptor/reversed.hpp>
+
+#include "utils/bptree.hh"
+#include "utils/logalloc.hh"
+#include "failure_injecting_allocation_strategy.hh"
+
+struct entry {
+    bplus::member_hook _link;
+    int _key;
+
+    explicit entry(int key) : _key(key) { }
+    entry(entry&& o) noexcept : _link(std::move(o._link)), _key(o._key) { }
+
+    struct compare {
+        static int key_of(int key) { return key; }
+        static int key_of(const entry& e) { return e._key; }
+        template<typename A, typename B>
+        bool operator()(const A& a, const B& b) const { return key_of(a) < key_of(b); }
+    };
+};
+
+using tree_type = bplus::tree<entry, &entry::_link>;
+
+// Coarse, so that lookups often have to compare elements too.
+struct entry_prefix {
+    uint64_t operator()(int key) const { return (key + 8) / 8; }
+    uint64_t operator()(const entry& e) const { return (*this)(e._key); }
+};
+
+using keyed_tree_type = bplus::tree<entry, &entry::_link, entry_prefix>;
+
+static entry* make_entry(int key) {
+    return current_allocator().construct<entry>(key);
+}
+
+static void dispose(entry* e) {
+    current_allocator().destroy(e);
+}
+
+template<typename Tree>
+static void check_contents(const Tree& t, const std::set<int>& expected) {
+    BOOST_REQUIRE_EQUAL(t.empty(), expected.empty());
+    BOOST_REQUIRE_EQUAL(t.calculate_size(), expected.size());
+    auto i = t.begin();
+    for (auto key : expected) {
+        BOOST_REQUIRE(i != t.end());
+        BOOST_REQUIRE_EQUAL(i->_key, key);
+        ++i;
+    }
+    BOOST_REQUIRE(i == t.end());
+    auto ri = t.rbegin();
+    for (auto key : boost::adaptors::reverse(expected)) {
+        BOOST_REQUIRE(ri != t.rend());
+        BOOST_REQUIRE_EQUAL(ri->_key, key);
+        ++ri;
+    }
+    BOOST_REQUIRE(ri == t.rend());
+}
+
+template<typename Tree>
+static void check_lookups(const Tree& t, const std::set<int>& expected, int max_key) {
+    entry::compare less;
+    for (int key = -1; key <= max_key + 1; ++key) {
+        auto lb = t.lower_bound(key, less);
+        auto expected_lb = expected.lower_bound(key);
+        BOOST_REQUIRE_EQUAL(lb == t.end(), expected_lb == expected.end());
+        if (expected_lb != expected.end()) {
+            BOOST_REQUIRE_EQUAL(lb->_key, *expected_lb);
+        }
+        auto ub = t.upper_bound(key, less);
+        auto expected_ub = expected.upper_bound(key);
+        BOOST_REQUIRE_EQUAL(ub == t.end(), expected_ub == expected.end());
+        if (expected_ub != expected.end()) {
+            BOOST_REQUIRE_EQUAL(ub->_key, *expected_ub);
+        }
+        BOOST_REQUIRE_EQUAL(t.find(key, less) != t.end(), expected.count(key) == 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_insertion_and_lookups) {
+    std::default_random_engine rnd(42);
+    std::uniform_int_distribution<int> dist(0, 10000);
+    entry::compare less;
+    tree_type t;
+    std::set<int> expected;
+
+    check_contents(t, expected);
+    check_lookups(t, expected, 10);
+
+    for (int i = 0; i < 5000; ++i) {
+        auto key = dist(rnd);
+        auto e = make_entry(key);
+        auto hint = t.lower_bound(key + (i % 3) - 1, less);
+        auto [it, inserted] = t.insert_check(hint, *e, less);
+        BOOST_REQUIRE_EQUAL(inserted, expected.insert(key).second);
+        BOOST_REQUIRE_EQUAL(it->_key, key);
+        if (!inserted) {
+            dispose(e);
+        }
+    }
+    check_contents(t, expected);
+    check_lookups(t, expected, 10000);
+
+    t.clear_and_dispose(dispose);
+    check_contents(t, std::set<int>());
+}
+
+BOOST_AUTO_TEST_CASE(test_appending_fills_nodes) {
+    tree_type t;
+    std::set<int> expected;
+    const int count = 10000;
+    for (int key = 0; key < count; ++key) {
+        t.insert_before(t.end(), *make_entry(key));
+        expected.insert(key);
+    }
+    check_contents(t, expected);
+    check_lookups(t, expected, count);
+
+    // Appended rows pack leaves, only the last one of each level is partially filled.
+    auto leaves = (count + bplus::internal::node_capacity - 1) / bplus::internal::node_capacity;
+    BOOST_REQUIRE_LE(t.external_memory_usage(), leaves * (sizeof(bplus::internal::leaf) + sizeof(bplus::internal::inner)));
+    for (auto& e : t) {
+        BOOST_REQUIRE_EQUAL(&tree_type::container_of(e), &t);
+    }
+
+    t.clear_and_dispose(dispose);
+}
+
+BOOST_AUTO_TEST_CASE(test_erasure) {
+    std::default_random_engine rnd(7);
+    entry::compare less;
+    tree_type t;
+    std::set<int> expected;
+    const int count = 5000;
+    for (int key = 0; key < count; ++key) {
+        t.insert_before(t.end(), *make_entry(key));
+        expected.insert(key);
+    }
+
+    // Erase whole ranges, which empties nodes.
+    auto i = t.erase_and_dispose(t.lower_bound(1000, less), t.lower_bound(2000, less), dispose);
+    BOOST_REQUIRE_EQUAL(i->_key, 2000);
+    expected.erase(expected.lower_bound(1000), expected.lower_bound(2000));
+    check_contents(t, expected);
+
+    // Erase randomly, which merges nodes, and through the element destructor.
+    std::uniform_int_distribution<int> dist(0, count);
+    for (int n = 0; n < 2000; ++n) {
+        auto key = dist(rnd);
+        auto i = t.find(key, less);
+        if (i == t.end()) {
+            continue;
+        }
+        if (n % 2) {
+            auto next = t.erase_and_dispose(i, dispose);
+            auto expected_next = expected.upper_bound(key);
+            BOOST_REQUIRE_EQUAL(next == t.end(), expected_next == expected.end());
+        } else {
+            dispose(&*i);
+        }
+        expected.erase(key);
+    }
+    check_contents(t, expected);
+    check_lookups(t, expected, count);
+
+    while (auto e = t.unlink_leftmost_without_rebalance()) {
+        BOOST_REQUIRE_EQUAL(e->_key, *expected.begin());
+        expected.erase(expected.begin());
+        dispose(e);
+    }
+    check_contents(t, expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_only_member_and_move) {
+    tree_type t;
+    auto e1 = std::make_unique<entry>(1);
+    t.insert_before(t.end(), *e1);
+    BOOST_REQUIRE(tree_type::is_only_member(*e1));
+    BOOST_REQUIRE_EQUAL(&tree_type::container_of_only_member(*e1), &t);
+
+    auto e2 = std::make_unique<entry>(2);
+    t.insert_before(t.end(), *e2);
+    BOOST_REQUIRE(!tree_type::is_only_member(*e1));
+
+    tree_type t2(std::move(t));
+    check_contents(t, std::set<int>());
+    check_contents(t2, std::set<int>({1, 2}));
+    e2.reset();
+    BOOST_REQUIRE_EQUAL(&tree_type::container_of_only_member(*e1), &t2);
+    BOOST_REQUIRE_EQUAL(&tree_type::container_of(*e1), &t2);
+    BOOST_REQUIRE(tree_type::iterator_to(*e1) == t2.begin());
+}
+
+BOOST_AUTO_TEST_CASE(test_lsa_migration) {
+    std::default_random_engine rnd(13);
+    std::uniform_int_distribution<int> dist(0, 20000);
+    entry::compare less;
+    logalloc::region reg;
+    tree_type t;
+    std::set<int> expected;
+
+    with_allocator(reg.allocator(), [&] {
+        for (int round = 0; round < 20; ++round) {
+            for (int n = 0; n < 1000; ++n) {
+                auto key = dist(rnd);
+                if (expected.count(key)) {
+                    t.erase_and_dispose(t.find(key, less), dispose);
+                    expected.erase(key);
+                    continue;
+                }
+                auto pos = t.lower_bound(key, less);
+                // Nodes reserved for an insertion can be moved before they are used.
+                auto spare = t.reserve_for_insert_before(pos);
+                if (n % 100 == 0) {
+                    reg.full_compaction();
+                    pos = t.lower_bound(key, less);
+                }
+                t.insert_before(pos, *make_entry(key), spare);
+                expected.insert(key);
+            }
+            reg.full_compaction();
+            check_contents(t, expected);
+        }
+        check_lookups(t, expected, 20000);
+        t.clear_and_dispose(dispose);
+    });
+    BOOST_REQUIRE_EQUAL(reg.occupancy().used_space(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_insertion_is_exception_safe) {
+    logalloc::region reg;
+    auto allocator = failure_injecting_allocation_strategy(reg.allocator());
+    tree_type t;
+    std::set<int> expected;
+
+    with_allocator(allocator, [&] {
+        // Fill up the tree so that insertions in the middle split nodes at every level.
+        for (int key = 0; key < 20000; key += 2) {
+            t.insert_before(t.end(), *make_entry(key));
+            expected.insert(key);
+        }
+        entry::compare less;
+        size_t failures = 0;
+        for (int key = 1; key < 20000; key += 200) {
+            auto e = make_entry(key);
+            for (uint64_t fail_offset = 0; ; ++fail_offset) {
+                allocator.fail_after(fail_offset);
+                try {
+                    t.insert(t.end(), *e, less);
+                } catch (const std::bad_alloc&) {
+                    ++failures;
+                    BOOST_REQUIRE(!e->_link.is_linked());
+                    continue;
+                }
+                allocator.stop_failing();
+                break;
+            }
+            expected.insert(key);
+        }
+        BOOST_REQUIRE_GT(failures, 0);
+        check_contents(t, expected);
+        t.clear_and_dispose(dispose);
+    });
+    BOOST_REQUIRE_EQUAL(reg.occupancy().used_space(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_key_prefixes) {
+    std::default_random_engine rnd(17);
+    std::uniform_int_distribution<int> dist(0, 20000);
+    entry::compare less;
+    logalloc::region reg;
+    keyed_tree_type t;
+    std::set<int> expected;
+
+    with_allocator(reg.allocator(), [&] {
+        for (int round = 0; round < 10; ++round) {
+            for (int n = 0; n < 2000; ++n) {
+                auto key = dist(rnd);
+                if (expected.count(key)) {
+                    if (n % 2) {
+                        t.erase_and_dispose(t.find(key, less), dispose);
+                    } else {
+                        dispose(&*t.find(key, less));
+                    }
+                    expected.erase(key);
+                    continue;
+                }
+                t.insert(t.lower_bound(key, less), *make_entry(key), less);
+                expected.insert(key);
+            }
+            // Moves nodes, along with their prefixes.
+            reg.full_compaction();
+            check_contents(t, expected);
+            check_lookups(t, expected, 20000);
+        }
+        t.clear_and_dispose(dispose);
+    });
+    BOOST_REQUIRE_EQUAL(reg.occupancy().used_space(), 0);
+}
@@ -47,4 +47,22 @@ BOOST_AUTO_TEST_CASE(test_caching_options) {
         sstring in_str = "{\"keys\": \"NONE, }";
         BOOST_REQUIRE_THROW(caching_options::from_sstring(in_str), std::exception);
     }
+    {
+        string_map in_map = { {"keys", "ALL"}, {"rows_per_partition", "ALL"}, {"admission", "FREQUENT"}};
+        caching_options co = caching_options::from_map(in_map);
+        BOOST_REQUIRE(co.admit_frequent_only());
+        BOOST_REQUIRE(in_map == co.to_map());
+        BOOST_REQUIRE(co != caching_options::from_map(string_map{}));
+    }
+    {
+        // The default admission policy is left out, for compatibility.
+        string_map in_map = { {"keys", "ALL"}, {"rows_per_partition", "ALL"}, {"admission", "ALL"}};
+        caching_options co = caching_options::from_map(in_map);
+        BOOST_REQUIRE(!co.admit_frequent_only());
+        BOOST_REQUIRE(co.to_map().count("admission") == 0);
+    }
+    {
+        sstring in_str = "{\"keys\": \"ALL\", \"admission\": \"SOME\"}";
+        BOOST_REQUIRE_THROW(caching_options::from_sstring(in_str), std::exception);
+    }
 }
@@ -23,6 +23,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <random>
+
 #include "sstables/compress.hh"
 
 BOOST_AUTO_TEST_CASE(segmented_offsets_basic_functionality) {
@@ -156,3 +158,91 @@ BOOST_AUTO_TEST_CASE(segmented_offsets_corner_cases) {
     BOOST_REQUIRE(accessor.at(4079) == 4079);
     BOOST_REQUIRE(accessor.at(4080) == 4080);
 }
+
+static temporary_buffer<char> make_compressible_chunk(std::default_random_engine& rng, size_t size) {
+    std::uniform_int_distribution<int> dist(0, 99);
+    temporary_buffer<char> buf(size);
+    size_t pos = 0;
+    while (pos < size) {
+        auto word = format("key{:02d}=value{:02d};", dist(rng), dist(rng));
+        auto n = std::min(word.size(), size - pos);
+        std::copy_n(word.begin(), n, buf.get_write() + pos);
+        pos += n;
+    }
+    return buf;
+}
+
+static void check_roundtrip(const compressor& c, const temporary_buffer<char>& chunk) {
+    temporary_buffer<char> compressed(c.compress_max_size(chunk.size()));
+    auto len = c.compress(chunk.get(), chunk.size(), compressed.get_write(), compressed.size());
+    BOOST_REQUIRE_LT(len, chunk.size());
+
+    temporary_buffer<char> uncompressed(chunk.size());
+    BOOST_REQUIRE_EQUAL(c.uncompress(compressed.get(), len, uncompressed.get_write(), uncompressed.size()), chunk.size());
+    BOOST_REQUIRE(std::equal(chunk.begin(), chunk.end(), uncompressed.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(zstd_compressor_options) {
+    auto c = compressor::create({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "compression_level", "7" },
+    });
+    BOOST_REQUIRE_EQUAL(c->name(), compressor::namespace_prefix + "ZstdCompressor");
+    BOOST_REQUIRE_EQUAL(c->options().at("compression_level"), "7");
+    BOOST_REQUIRE_EQUAL(c->dictionary_size(), 0);
+
+    compression_parameters cp1({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "compression_level", "7" },
+    });
+    compression_parameters cp2({
+        { compression_parameters::SSTABLE_COMPRESSION, "org.apache.cassandra.io.compress.ZstdCompressor" },
+        { "compression_level", "7" },
+    });
+    BOOST_REQUIRE(cp1 == cp2);
+
+    BOOST_REQUIRE_THROW(compressor::create({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "compression_level", "100" },
+    }), exceptions::configuration_exception);
+    BOOST_REQUIRE_THROW(compression_parameters({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "no_such_option", "1" },
+    }), exceptions::configuration_exception);
+}
+
+BOOST_AUTO_TEST_CASE(zstd_compressor_dictionary) {
+    std::default_random_engine rng;
+    auto c = compressor::create({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "dictionary_size_in_kb", "4" },
+    });
+    BOOST_REQUIRE_EQUAL(c->dictionary_size(), 4096);
+
+    bytes samples;
+    std::vector<size_t> sample_sizes;
+    for (int i = 0; i < 200; ++i) {
+        auto chunk = make_compressible_chunk(rng, 4096);
+        samples.append(reinterpret_cast<const int8_t*>(chunk.get()), chunk.size());
+        sample_sizes.push_back(chunk.size());
+    }
+    auto dictionary = c->train_dictionary(samples, sample_sizes);
+    BOOST_REQUIRE(!dictionary.empty());
+    BOOST_REQUIRE_LE(dictionary.size(), 4096);
+
+    // Too few samples for a dictionary of that size
+    BOOST_REQUIRE(c->train_dictionary(bytes_view(samples).substr(0, 4096 * 5), {4096, 4096, 4096, 4096, 4096}).size() <= 4096 / 2);
+
+    auto chunk = make_compressible_chunk(rng, 4096);
+    check_roundtrip(*c, chunk);
+    auto with_dictionary = c->with_dictionary(dictionary);
+    check_roundtrip(*with_dictionary, chunk);
+
+    // Data compressed with a dictionary can't be read back without it.
+    temporary_buffer<char> compressed(with_dictionary->compress_max_size(chunk.size()));
+    auto len = with_dictionary->compress(chunk.get(), chunk.size(), compressed.get_write(), compressed.size());
+    temporary_buffer<char> uncompressed(chunk.size());
+    BOOST_REQUIRE_THROW(c->uncompress(compressed.get(), len, uncompressed.get_write(), uncompressed.size()), std::runtime_error);
+
+    BOOST_REQUIRE_THROW(compressor::lz4->with_dictionary(dictionary), std::runtime_error);
+}
@@ -3340,3 +3340,21 @@ SEASTAR_TEST_CASE(test_cache_bypass) {
     });
 }
 
+
+SEASTAR_TEST_CASE(test_caching_admission_requires_cluster_feature) {
+    return do_with_cql_env_thread([] (cql_test_env& e) {
+        e.execute_cql("CREATE TABLE t (k int PRIMARY KEY) WITH caching = {'keys': 'ALL', 'rows_per_partition': 'ALL', 'admission': 'FREQUENT'}").get();
+        BOOST_REQUIRE(e.local_db().find_schema("ks", "t")->caching_options().admit_frequent_only());
+    }).then([] {
+        cql_test_config cfg;
+        cfg.disabled_features = { "CACHE_ADMISSION" };
+        return do_with_cql_env_thread([] (cql_test_env& e) {
+            BOOST_REQUIRE_THROW(e.execute_cql("CREATE TABLE t (k int PRIMARY KEY) WITH caching = {'admission': 'FREQUENT'}").get(),
+                    exceptions::configuration_exception);
+            e.execute_cql("CREATE TABLE t (k int PRIMARY KEY) WITH caching = {'keys': 'NONE', 'rows_per_partition': 'ALL'}").get();
+            auto& co = e.local_db().find_schema("ks", "t")->caching_options();
+            BOOST_REQUIRE(!co.admit_frequent_only());
+            BOOST_REQUIRE(co == caching_options::from_map(std::map<sstring, sstring>{{"keys", "NONE"}}));
+        }, std::move(cfg));
+    });
+}
@@ -36,8 +36,11 @@
 #include "service/migration_manager.hh"
 #include "sstables/sstables.hh"
 #include "db/config.hh"
+#include "service/cache_saver.hh"
 #include "tmpdir.hh"
 
+#include <seastar/util/defer.hh>
+
 SEASTAR_TEST_CASE(test_querying_with_limits) {
     return do_with_cql_env([](cql_test_env& e) {
         return seastar::async([&] {
@@ -286,3 +289,120 @@ SEASTAR_THREAD_TEST_CASE(test_distributed_loader_with_pending_delete) {
         return make_ready_future<>();
     }, db_cfg).get();
 }
+
+class cache_saver_test {
+public:
+    static future<> save(service::cache_saver& cs) {
+        return cs.save();
+    }
+    static auto read_keys(service::cache_saver& cs) {
+        return cs.read_keys();
+    }
+    static future<> load(service::cache_saver& cs) {
+        return cs.load();
+    }
+    static sstring keys_file(const service::cache_saver& cs) {
+        return cs.keys_file();
+    }
+    static uint64_t warmup_keys(const service::cache_saver& cs) {
+        return cs._stats.warmup_keys;
+    }
+};
+
+SEASTAR_THREAD_TEST_CASE(test_cache_saver_round_trip) {
+    tmpdir saved_caches_dir;
+    db::config saver_cfg;
+    saver_cfg.saved_caches_directory(saved_caches_dir.path().string(), db::config::config_source::CommandLine);
+    saver_cfg.row_cache_warmup_rate(1000000, db::config::config_source::CommandLine);
+
+    do_with_cql_env_thread([&saver_cfg] (cql_test_env& e) {
+        const int nr_keys = 32;
+        e.execute_cql("CREATE TABLE t1 (pk int PRIMARY KEY, v int)").get();
+        e.execute_cql("CREATE TABLE t2 (pk int PRIMARY KEY, v int)").get();
+        for (int i = 0; i < nr_keys; ++i) {
+            e.execute_cql(format("INSERT INTO t1 (pk, v) VALUES ({}, 0)", i)).get();
+            e.execute_cql(format("INSERT INTO t2 (pk, v) VALUES ({}, 0)", i)).get();
+        }
+        e.db().invoke_on_all([] (database& db) {
+            return db.flush_all_memtables();
+        }).get();
+        for (int i = 0; i < nr_keys; ++i) {
+            e.execute_cql(format("SELECT * FROM t1 WHERE pk = {}", i)).get();
+            e.execute_cql(format("SELECT * FROM t2 WHERE pk = {}", i)).get();
+        }
+        auto s1 = e.local_db().find_schema("ks", "t1");
+
+        sharded<service::cache_saver> cs;
+        cs.start(std::ref(e.db()), std::cref(saver_cfg)).get();
+        auto stop_cs = defer([&cs] { cs.stop().get(); });
+
+        cache_saver_test::save(cs.local()).get();
+        e.execute_cql("DROP TABLE t2").get();
+
+        // The keys of the dropped table are skipped, the others go to the shards which own them.
+        auto keys_by_shard = cache_saver_test::read_keys(cs.local()).get0();
+        BOOST_REQUIRE_EQUAL(keys_by_shard.size(), smp::count);
+        std::set<int> found;
+        for (unsigned shard = 0; shard < smp::count; ++shard) {
+            for (auto& k : keys_by_shard[shard]) {
+                BOOST_REQUIRE_EQUAL(k.table, s1->id());
+                BOOST_REQUIRE_EQUAL(dht::shard_of(dht::global_partitioner().decorate_key(*s1, k.key).token()), shard);
+                for (int i = 0; i < nr_keys; ++i) {
+                    if (k.key.equal(*s1, partition_key::from_singular(*s1, i))) {
+                        BOOST_REQUIRE(found.insert(i).second);
+                    }
+                }
+            }
+        }
+        BOOST_REQUIRE_EQUAL(found.size(), size_t(nr_keys));
+
+        cache_saver_test::load(cs.local()).get();
+        for (unsigned shard = 0; shard < smp::count; ++shard) {
+            auto warmup_keys = cs.invoke_on(shard, [] (service::cache_saver& saver) {
+                return cache_saver_test::warmup_keys(saver);
+            }).get0();
+            BOOST_REQUIRE_EQUAL(warmup_keys, keys_by_shard[shard].size());
+        }
+
+        // Bad lines are skipped, and the last line may lack its newline.
+        auto key_of = [&s1] (int i) {
+            auto pk = partition_key::from_singular(*s1, i);
+            return with_linearized_managed_bytes([&] {
+                return to_hex(pk.representation());
+            });
+        };
+        auto line_of = [&s1] (const sstring& hex) {
+            return format("{} {}", s1->id(), hex);
+        };
+        auto text = sstring("garbage\n")
+                + line_of("0") + "\n"
+                + line_of("zz") + "\n"
+                + line_of("0004") + "\n"
+                + line_of("00020001") + "\n"
+                + line_of(key_of(1) + key_of(2)) + "\n"
+                + line_of(sstring(1 << 18, 'a')) + "\n"
+                + line_of(key_of(7)) + "\n"
+                + line_of(key_of(8));
+        auto f = open_file_dma(cache_saver_test::keys_file(cs.local()), open_flags::wo | open_flags::create | open_flags::truncate).get0();
+        auto os = make_file_output_stream(std::move(f));
+        os.write(text).get();
+        os.flush().get();
+        os.close().get();
+
+        keys_by_shard = cache_saver_test::read_keys(cs.local()).get0();
+        found.clear();
+        size_t count = 0;
+        for (auto& keys : keys_by_shard) {
+            for (auto& k : keys) {
+                ++count;
+                for (int i : {7, 8}) {
+                    if (k.key.equal(*s1, partition_key::from_singular(*s1, i))) {
+                        BOOST_REQUIRE(found.insert(i).second);
+                    }
+                }
+            }
+        }
+        BOOST_REQUIRE_EQUAL(count, size_t(2));
+        BOOST_REQUIRE_EQUAL(found.size(), size_t(2));
+    }).get();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define BOOST_TEST_MODULE frequency_sketch
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <random>
+
+#include "utils/frequency_sketch.hh"
+
+BOOST_AUTO_TEST_CASE(test_frequent_keys_are_told_apart) {
+    std::default_random_engine rnd(3);
+    utils::frequency_sketch sketch(1000);
+    std::uniform_int_distribution<uint64_t> dist;
+
+    // Keys 0..9 are hot, the rest are read once each.
+    for (int i = 0; i < 500; ++i) {
+        sketch.record(i % 10);
+        sketch.record(dist(rnd) | (uint64_t(1) << 63));
+    }
+    for (uint64_t key = 0; key < 10; ++key) {
+        BOOST_REQUIRE_GE(sketch.estimate(key), 2u);
+    }
+    size_t frequent = 0;
+    for (int i = 0; i < 1000; ++i) {
+        frequent += sketch.estimate(dist(rnd) | (uint64_t(1) << 63)) >= 2;
+    }
+    BOOST_REQUIRE_LE(frequent, 10u);
+}
+
+BOOST_AUTO_TEST_CASE(test_estimates_saturate_and_age) {
+    utils::frequency_sketch sketch(64);
+    for (int i = 0; i < 100; ++i) {
+        sketch.record(7);
+    }
+    BOOST_REQUIRE_EQUAL(sketch.estimate(7), utils::frequency_sketch::max_frequency);
+
+    // Other keys push the sketch through a few agings.
+    size_t agings = 0;
+    for (uint64_t key = 1000; agings < 5; ++key) {
+        agings += sketch.record(key);
+    }
+    BOOST_REQUIRE_LE(sketch.estimate(7), 1u);
+}
@@ -36,6 +36,7 @@
 #include "sstable_utils.hh"
 #include "test_services.hh"
 #include "sstable_test_env.hh"
+#include "intrusive_set_external_comparator.hh"
 
 class size_calculator {
     class nest {
@@ -60,16 +61,33 @@ class size_calculator {
             nest n;
             std::cout << prefix() << "sizeof(decorated_key) = " << sizeof(dht::decorated_key) << "\n";
             std::cout << prefix() << "sizeof(cache_link_type) = " << sizeof(cache_entry::cache_link_type) << "\n";
+            std::cout << prefix() << "sizeof(bplus::keyed_leaf) = " << sizeof(bplus::internal::keyed_leaf) << "\n";
+            std::cout << prefix() << "sizeof(bplus::keyed_inner) = " << sizeof(bplus::internal::keyed_inner) << "\n";
             print_mutation_partition_size();
         }
 
         std::cout << "\n";
 
         std::cout << prefix() << "sizeof(rows_entry) = " << sizeof(rows_entry) << "\n";
+        std::cout << prefix() << "sizeof(link_type) = " << sizeof(rows_entry::_link) << "\n";
         std::cout << prefix() << "sizeof(lru_link_type) = " << sizeof(rows_entry::lru_link_type) << "\n";
         std::cout << prefix() << "sizeof(deletable_row) = " << sizeof(deletable_row) << "\n";
         std::cout << prefix() << "sizeof(row) = " << sizeof(row) << "\n";
         std::cout << prefix() << "sizeof(atomic_cell_or_collection) = " << sizeof(atomic_cell_or_collection) << "\n";
+        std::cout << prefix() << "max inline cell size = " << atomic_cell_or_collection::max_inline_size << "\n";
+    }
+
+    // Memory taken by the clustering rows container, per row. The red-black tree
+    // it replaced took only the hook embedded in each row.
+    static void print_rows_container_size(const mutation_partition& mp) {
+        auto rows = mp.clustered_rows().calculate_size();
+        std::cout << prefix() << "sizeof(bplus::keyed_leaf) = " << sizeof(bplus::internal::keyed_leaf) << "\n";
+        std::cout << prefix() << "sizeof(bplus::keyed_inner) = " << sizeof(bplus::internal::keyed_inner) << "\n";
+        if (rows) {
+            auto per_row = sizeof(rows_entry::_link) + double(mp.clustered_rows().external_memory_usage()) / rows;
+            std::cout << prefix() << "rows container per row = " << per_row
+                << " (red-black tree: " << sizeof(intrusive_set_external_comparator_member_hook) << ")\n";
+        }
     }
 
     static void print_mutation_partition_size() {
@@ -237,6 +255,9 @@ int main(int argc, char** argv) {
 
             std::cout << "\n";
             size_calculator::print_cache_entry_size();
+
+            std::cout << "\n";
+            size_calculator::print_rows_container_size(m.partition());
         });
     });
 }
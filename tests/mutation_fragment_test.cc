@@ -161,8 +161,8 @@ SEASTAR_TEST_CASE(test_range_tombstones_stream) {
         mutation_fragment cr1 = clustering_row(create_ck({ 0, 0 }));
         mutation_fragment cr2 = clustering_row(create_ck({ 1, 0 }));
         mutation_fragment cr3 = clustering_row(create_ck({ 1, 1 }));
-        auto cr4 = rows_entry(create_ck({ 1, 2 }));
-        auto cr5 = rows_entry(create_ck({ 1, 3 }));
+        auto cr4 = rows_entry(*s, create_ck({ 1, 2 }));
+        auto cr5 = rows_entry(*s, create_ck({ 1, 3 }));
 
         range_tombstone_stream rts(*s);
         rts.apply(range_tombstone(rt1));
@@ -510,6 +510,90 @@ SEASTAR_THREAD_TEST_CASE(combined_mutation_reader_test) {
         .produces(expexted_mutation_4)
         .produces(expexted_mutation_5)
         .produces_end_of_stream();
+
+}
+
+SEASTAR_THREAD_TEST_CASE(disjoint_pass_through_sstable_reader_test) {
+    storage_service_for_tests ssft;
+
+    simple_schema s;
+
+    auto pkeys = s.make_pkeys(7);
+    const auto ckeys = s.make_ckeys(2);
+
+    boost::sort(pkeys, [&s] (const dht::decorated_key& a, const dht::decorated_key& b) {
+        return a.less_compare(*s.schema(), b);
+    });
+
+    auto make_sstable_mutations = [&] (sstring value_prefix, unsigned ckey_index, std::vector<unsigned> pkey_indexes) {
+        std::vector<mutation> muts;
+        for (auto pkey_index : pkey_indexes) {
+            muts.emplace_back(s.schema(), pkeys[pkey_index]);
+            s.add_row(muts.back(), ckeys[ckey_index], format("{}_{:d}_val", value_prefix, ckey_index));
+        }
+        return muts;
+    };
+
+    // a and b overlap, so their region is merged. c and d each make a region of their own.
+    std::vector<mutation> a_mutations = make_sstable_mutations("a", 0, {0, 1, 2            });
+    std::vector<mutation> b_mutations = make_sstable_mutations("b", 1, {   1,    3         });
+    std::vector<mutation> c_mutations = make_sstable_mutations("c", 0, {            4      });
+    std::vector<mutation> d_mutations = make_sstable_mutations("d", 0, {               5, 6});
+
+    std::vector<mutation> expected = {
+        a_mutations[0],
+        a_mutations[1] + b_mutations[0],
+        a_mutations[2],
+        b_mutations[1],
+        c_mutations[0],
+        d_mutations[0],
+        d_mutations[1],
+    };
+
+    auto tmp = tmpdir();
+
+    unsigned gen{0};
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, {});
+    auto sstable_set = make_lw_shared<sstables::sstable_set>(cs.make_sstable_set(s.schema()));
+    for (auto* muts : {&a_mutations, &b_mutations, &c_mutations, &d_mutations}) {
+        sstable_set->insert(make_sstable_containing(sst_factory(s.schema(), tmp.path().string(), ++gen, 0), *muts));
+    }
+
+    auto make_reader = [&] (const dht::partition_range& pr) {
+        return make_disjoint_pass_through_sstable_reader(
+                s.schema(),
+                sstable_set,
+                pr,
+                s.schema()->full_slice(),
+                seastar::default_priority_class(),
+                no_resource_tracking(),
+                nullptr);
+    };
+
+    {
+        auto rd = assert_that(make_reader(query::full_partition_range));
+        for (auto& m : expected) {
+            rd.produces(m);
+        }
+        rd.produces_end_of_stream();
+    }
+
+    // A range starting in the middle of the merged region and ending in the middle of the last one.
+    {
+        auto pr = dht::partition_range::make(dht::ring_position(pkeys[2]), dht::ring_position(pkeys[5]));
+        assert_that(make_reader(pr))
+            .produces(expected[2])
+            .produces(expected[3])
+            .produces(expected[4])
+            .produces(expected[5])
+            .produces_end_of_stream();
+    }
+
+    // A key none of the sstables holds.
+    {
+        auto pr = dht::partition_range::make_singular(s.make_pkey());
+        assert_that(make_reader(pr)).produces_end_of_stream();
+    }
 }
 
 static mutation make_mutation_with_key(simple_schema& s, dht::decorated_key dk) {
@@ -56,6 +56,7 @@
 #include "service/storage_proxy.hh"
 #include "random-utils.hh"
 #include "simple_schema.hh"
+#include "partition_builder.hh"
 #include "types/map.hh"
 #include "types/list.hh"
 #include "types/set.hh"
@@ -1755,6 +1756,74 @@ SEASTAR_THREAD_TEST_CASE(test_cell_external_memory_usage) {
     test_collection(bytes(1024 * 1024, 'a'));
 }
 
+SEASTAR_THREAD_TEST_CASE(test_small_cells_are_copied_inline) {
+    measuring_allocator alloc;
+
+    auto test_cell = [&] (data_type dt, atomic_cell ac, bool expect_inline) {
+        auto cell = atomic_cell_or_collection(std::move(ac));
+        auto other = atomic_cell_or_collection(atomic_cell::make_live(*bytes_type, 2, bytes(1024, 'b')));
+        with_allocator(alloc, [&] {
+            auto before = alloc.allocated_bytes();
+            auto copy = cell.copy(*dt);
+            auto after = alloc.allocated_bytes();
+            BOOST_REQUIRE_EQUAL(after == before, expect_inline);
+            BOOST_REQUIRE_EQUAL(copy.external_memory_usage(*dt), after - before);
+            BOOST_REQUIRE(copy.equals(*dt, cell));
+
+            auto moved = std::move(copy);
+            BOOST_REQUIRE(!copy);
+            BOOST_REQUIRE(moved.equals(*dt, cell));
+
+            auto other_copy = other.copy(*bytes_type);
+            moved.swap(other_copy);
+            BOOST_REQUIRE(moved.equals(*bytes_type, other));
+            BOOST_REQUIRE(other_copy.equals(*dt, cell));
+        });
+    };
+
+    test_cell(int32_type, atomic_cell::make_live(*int32_type, 1, int32_type->decompose(int32_t(1))), true);
+    test_cell(long_type, atomic_cell::make_live(*long_type, 1, long_type->decompose(int64_t(1))), true);
+    test_cell(long_type, atomic_cell::make_dead(1, gc_clock::now()), true);
+    test_cell(bytes_type, atomic_cell::make_live(*bytes_type, 1, bytes(10, 'a')), true);
+    test_cell(bytes_type, atomic_cell::make_live(*bytes_type, 1, bytes(11, 'a')), false);
+    test_cell(bytes_type, atomic_cell::make_live(*bytes_type, 1, bytes(1024, 'a')), false);
+    test_cell(bytes_type, atomic_cell::make_live(*bytes_type, 1, bytes(1, 'a'), gc_clock::now() + 1h, 1h), false);
+}
+
+// memtable::apply() builds cells from frozen mutations, small ones must end up inline too.
+SEASTAR_THREAD_TEST_CASE(test_small_cells_from_frozen_mutations_are_inline) {
+    auto s = schema_builder("ks", "cf")
+            .with_column("pk", utf8_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("s1", int32_type, column_kind::static_column)
+            .with_column("v1", int32_type)
+            .with_column("v2", bytes_type)
+            .build();
+    auto& s1 = *s->get_column_definition("s1");
+    auto& v1 = *s->get_column_definition("v1");
+    auto& v2 = *s->get_column_definition("v2");
+    auto ck = clustering_key::from_single_value(*s, int32_type->decompose(int32_t(0)));
+
+    mutation m(s, partition_key::from_single_value(*s, to_bytes("key")));
+    m.set_static_cell(s1, atomic_cell::make_live(*s1.type, 1, s1.type->decompose(int32_t(1))));
+    m.set_clustered_cell(ck, v1, atomic_cell::make_live(*v1.type, 1, v1.type->decompose(int32_t(2))));
+    m.set_clustered_cell(ck, v2, atomic_cell::make_live(*v2.type, 1, bytes(1024, 'a')));
+    auto fm = freeze(m);
+
+    mutation_partition mp(s);
+    partition_builder pb(*s, mp);
+    fm.partition().accept(*s, pb);
+    auto& row = mp.clustered_row(*s, ck).cells();
+    BOOST_REQUIRE_EQUAL(mp.static_row().cell_at(s1.id).external_memory_usage(*s1.type), 0);
+    BOOST_REQUIRE_EQUAL(row.cell_at(v1.id).external_memory_usage(*v1.type), 0);
+    BOOST_REQUIRE_GT(row.cell_at(v2.id).external_memory_usage(*v2.type), 0);
+    BOOST_REQUIRE(mp.equal(*s, m.partition()));
+
+    auto mt = make_lw_shared<memtable>(s);
+    mt->apply(fm, s);
+    BOOST_REQUIRE(get_partition(*mt, m.key()).equal(*s, m.partition()));
+}
+
 // external_memory_usage() must be invariant to the merging order,
 // so that accounting of a clustering_row produced by partition_snapshot_flat_reader
 // doesn't give a greater result than what is used by the memtable region, possibly
@@ -1846,3 +1915,68 @@ SEASTAR_THREAD_TEST_CASE(test_collection_compaction) {
     BOOST_CHECK(!cmut.tomb);
     BOOST_CHECK(cmut.cells.empty());
 }
+
+SEASTAR_THREAD_TEST_CASE(test_rows_are_ordered_with_key_prefixes) {
+    auto make_schema = [] (data_type ck_type) {
+        return schema_builder("ks", "cf")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("ck1", ck_type, column_kind::clustering_key)
+                .with_column("ck2", int32_type, column_kind::clustering_key)
+                .with_column("v", int32_type)
+                .build();
+    };
+    auto blob_schema = make_schema(bytes_type);
+    auto reversed_schema = make_schema(reversed_type_impl::get_instance(bytes_type));
+    auto int_schema = make_schema(int32_type);
+    BOOST_REQUIRE(rows_entry::has_key_prefix(*blob_schema));
+    BOOST_REQUIRE(!rows_entry::has_key_prefix(*reversed_schema));
+    BOOST_REQUIRE(!rows_entry::has_key_prefix(*int_schema));
+
+    // Keys which share their first 8 bytes have equal prefixes, so that ordering them takes their keys.
+    std::vector<bytes> values = { bytes(), to_bytes("a"), to_bytes("aaaaaaaa"), to_bytes(sstring("aaaaaaaa\0", 9)),
+            to_bytes("aaaaaaaab"), to_bytes("aaaaaaab"), to_bytes("b"), bytes(8, int8_t(0xff)), bytes(9, int8_t(0xff)) };
+    for (auto s : {blob_schema, reversed_schema}) {
+        auto ck = [&] (const bytes& v, int32_t i) {
+            return clustering_key::from_exploded(*s, {v, int32_type->decompose(i)});
+        };
+        std::vector<clustering_key> keys;
+        for (auto& v : values) {
+            keys.push_back(ck(v, 1));
+            keys.push_back(ck(v, 0));
+        }
+        auto shuffled = keys;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::default_random_engine(keys.size()));
+
+        mutation m(s, partition_key::from_single_value(*s, to_bytes("key")));
+        for (auto& k : shuffled) {
+            m.set_clustered_cell(k, "v", data_value(int32_t(1)), 1);
+        }
+        // Dummies before and after each key interleave with the rows.
+        for (auto& v : values) {
+            auto prefix = clustering_key_prefix::from_exploded(*s, {v});
+            m.partition().set_continuity(*s, position_range(query::clustering_range::make_singular(prefix)), is_continuous::yes);
+        }
+
+        std::sort(keys.begin(), keys.end(), clustering_key::less_compare(*s));
+        std::vector<clustering_key> rows;
+        rows_entry::compare less(*s);
+        const rows_entry* prev = nullptr;
+        for (auto& e : m.partition().clustered_rows()) {
+            if (prev) {
+                BOOST_REQUIRE(less(*prev, e));
+                BOOST_REQUIRE_LE(prev->key_prefix(), e.key_prefix());
+            }
+            prev = &e;
+            if (!e.dummy()) {
+                rows.push_back(e.key());
+            }
+        }
+        BOOST_REQUIRE_EQUAL(rows.size(), keys.size());
+        for (auto i = 0u; i < keys.size(); ++i) {
+            BOOST_REQUIRE(rows[i].equal(*s, keys[i]));
+            BOOST_REQUIRE(m.partition().find_row(*s, keys[i]));
+        }
+        BOOST_REQUIRE(!m.partition().find_row(*s, ck(to_bytes("aaaaaaaaa"), 0)));
+        BOOST_REQUIRE(!m.partition().find_row(*s, ck(to_bytes("aaaaaaaa"), 2)));
+    }
+}
@@ -1037,3 +1037,25 @@ do_test_selective_token_range_sharder(const dht::i_partitioner& part, const sche
 SEASTAR_THREAD_TEST_CASE(test_selective_token_range_sharder) {
     return test_something_with_some_interesting_ranges_and_partitioners_with_token_range(do_test_selective_token_range_sharder);
 }
+
+static void test_token_prefix_order(dht::i_partitioner&& part) {
+    std::vector<dht::token> tokens;
+    for (int i = 0; i < 1000; ++i) {
+        tokens.push_back(part.get_random_token());
+    }
+    std::sort(tokens.begin(), tokens.end(), [&] (const dht::token& a, const dht::token& b) {
+        return part.tri_compare(a, b) < 0;
+    });
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        BOOST_REQUIRE_LE(part.token_prefix(tokens[i - 1]), part.token_prefix(tokens[i]));
+    }
+}
+
+SEASTAR_THREAD_TEST_CASE(test_token_prefix_is_ordered_like_tokens) {
+    test_token_prefix_order(dht::murmur3_partitioner());
+    test_token_prefix_order(dht::random_partitioner());
+    test_token_prefix_order(dht::byte_ordered_partitioner());
+
+    BOOST_REQUIRE_EQUAL(dht::token_prefix(dht::minimum_token()), 0);
+    BOOST_REQUIRE_EQUAL(dht::token_prefix(dht::maximum_token()), std::numeric_limits<uint64_t>::max());
+}
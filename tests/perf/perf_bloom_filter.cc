@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+
+#include "utils/bloom_filter.hh"
+#include "tests/make_random_string.hh"
+
+#include <seastar/tests/perf/perf_tests.hh>
+
+// Compares the classic bloom filter, which touches one cache line per hash
+// function, with the cache-line blocked one. Filters are sized so that they
+// do not fit in the CPU caches, like the filters of many sstables don't.
+
+static constexpr int64_t nr_keys = 4 * 1000 * 1000;
+static constexpr double fp_chance = 0.01;
+
+static bytes_view to_bytes_view(const sstring& s) {
+    return bytes_view(reinterpret_cast<const int8_t*>(s.data()), s.size());
+}
+
+struct bloom_filter_test {
+    std::vector<utils::hashed_key> present;
+    std::vector<utils::hashed_key> absent;
+    utils::filter_ptr classic = utils::i_filter::get_filter(nr_keys, fp_chance, utils::filter_format::m_format);
+    utils::filter_ptr blocked = utils::i_filter::get_filter(nr_keys, fp_chance, utils::filter_format::blocked_format);
+    size_t next = 0;
+
+    bloom_filter_test() {
+        for (int64_t i = 0; i < nr_keys; i++) {
+            auto key = make_random_string(16);
+            classic->add(to_bytes_view(key));
+            blocked->add(to_bytes_view(key));
+            present.push_back(utils::make_hashed_key(to_bytes_view(key)));
+            // Absent keys are longer, so they cannot collide with present ones.
+            absent.push_back(utils::make_hashed_key(to_bytes_view(make_random_string(17))));
+        }
+        std::shuffle(present.begin(), present.end(), std::default_random_engine());
+        report("classic", *classic);
+        report("blocked", *blocked);
+    }
+
+    void report(const char* name, utils::i_filter& f) {
+        auto fp = std::count_if(absent.begin(), absent.end(), [&] (auto& k) { return f.is_present(k); });
+        std::cout << format("{}: {} bytes, false positive rate {:.4f}\n", name, f.memory_size(), double(fp) / absent.size());
+    }
+
+    const utils::hashed_key& next_key(const std::vector<utils::hashed_key>& keys) {
+        next = (next + 1) % keys.size();
+        return keys[next];
+    }
+};
+
+PERF_TEST_F(bloom_filter_test, classic_present) {
+    perf_tests::do_not_optimize(classic->is_present(next_key(present)));
+}
+
+PERF_TEST_F(bloom_filter_test, blocked_present) {
+    perf_tests::do_not_optimize(blocked->is_present(next_key(present)));
+}
+
+PERF_TEST_F(bloom_filter_test, classic_absent) {
+    perf_tests::do_not_optimize(classic->is_present(next_key(absent)));
+}
+
+PERF_TEST_F(bloom_filter_test, blocked_absent) {
+    perf_tests::do_not_optimize(blocked->is_present(next_key(absent)));
+}
@@ -27,6 +27,7 @@
 #include "database.hh"
 #include "db/config.hh"
 #include "partition_slice_builder.hh"
+#include "schema_builder.hh"
 #include "utils/int_range.hh"
 #include "utils/div_ceil.hh"
 #include <seastar/core/reactor.hh>
@@ -59,6 +60,8 @@ int main(int argc, char** argv) {
     app.add_options()
         ("trace", "Enables trace-level logging for the test actions")
         ("no-reads", "Disable reads during the test")
+        ("cold-reads", "Also read distinct partitions, each one once, during the test")
+        ("admission", "Populate cache only with partitions which are read frequently")
         ("seconds", bpo::value<unsigned>()->default_value(60), "Duration [s] after which the test terminates with a success")
         ;
 
@@ -73,6 +76,7 @@ int main(int argc, char** argv) {
 
         return do_with_cql_env_thread([&app] (cql_test_env& env) {
             auto reads_enabled = !app.configuration().count("no-reads");
+            auto cold_reads_enabled = app.configuration().count("cold-reads");
             auto seconds = app.configuration()["seconds"].as<unsigned>();
 
             engine().at_exit([] {
@@ -92,9 +96,16 @@ int main(int argc, char** argv) {
             auto s = db.find_schema("ks", "cf");
             column_family& cf = db.find_column_family(s->id());
             cf.set_compaction_strategy(sstables::compaction_strategy_type::null);
+            if (app.configuration().count("admission")) {
+                cf.set_schema(schema_builder(s)
+                    .set_caching_options(caching_options::from_map(std::map<sstring, sstring>{{"admission", "FREQUENT"}}))
+                    .build());
+                s = cf.schema();
+            }
 
             uint64_t mutations = 0;
             uint64_t reads = 0;
+            uint64_t cold_reads = 0;
             utils::estimated_histogram reads_hist;
             utils::estimated_histogram writes_hist;
 
@@ -106,14 +117,25 @@ int main(int argc, char** argv) {
             monotonic_counter<uint64_t> pmerges_ctr([&] { return tracker.get_stats().partition_merges; });
             monotonic_counter<uint64_t> eviction_ctr([&] { return tracker.get_stats().row_evictions; });
             monotonic_counter<uint64_t> miss_ctr([&] { return tracker.get_stats().reads_with_misses; });
+            monotonic_counter<uint64_t> cold_reads_ctr([&] { return cold_reads; });
+            monotonic_counter<uint64_t> admission_ctr([&] { return tracker.get_stats().partition_admissions; });
+            monotonic_counter<uint64_t> rejection_ctr([&] { return tracker.get_stats().partition_rejections; });
+            monotonic_counter<uint64_t> phit_ctr([&] { return tracker.get_stats().partition_hits; });
+            monotonic_counter<uint64_t> pmiss_ctr([&] { return tracker.get_stats().partition_misses; });
             stats_printer.set_callback([&] {
                 auto MB = 1024 * 1024;
-                std::cout << format("rd/s: {:d}, wr/s: {:d}, ev/s: {:d}, pmerge/s: {:d}, miss/s: {:d}, cache: {:d}/{:d} [MB], LSA: {:d}/{:d} [MB], std free: {:d} [MB]",
+                auto phits = phit_ctr.change();
+                auto pmisses = pmiss_ctr.change();
+                std::cout << format("rd/s: {:d}, cold rd/s: {:d}, wr/s: {:d}, ev/s: {:d}, pmerge/s: {:d}, miss/s: {:d}, adm/s: {:d}, rej/s: {:d}, phit: {:.2f}%, cache: {:d}/{:d} [MB], LSA: {:d}/{:d} [MB], std free: {:d} [MB]",
                     reads_ctr.change(),
+                    cold_reads_ctr.change(),
                     mutations_ctr.change(),
                     eviction_ctr.change(),
                     pmerges_ctr.change(),
                     miss_ctr.change(),
+                    admission_ctr.change(),
+                    rejection_ctr.change(),
+                    phits + pmisses ? 100.0 * phits / (phits + pmisses) : 0.0,
                     tracker.region().occupancy().used_space() / MB,
                     tracker.region().occupancy().total_space() / MB,
                     logalloc::shard_tracker().region_occupancy().used_space() / MB,
@@ -163,6 +185,21 @@ int main(int argc, char** argv) {
                 }
             });
 
+            // Reads each partition once, which shouldn't push the hot one out of cache.
+            auto cold_reader = seastar::async([&] {
+                if (!cold_reads_enabled) {
+                    return;
+                }
+                auto id = env.prepare("select * from ks.cf where pk = ? limit 10;").get0();
+                uint64_t key_seq = 0;
+                while (!cancelled) {
+                    auto key = cql3::raw_value::make_value(utf8_type->decompose(format("cold{:d}", key_seq++)));
+                    env.execute_prepared(id, {key}).get();
+                    ++cold_reads;
+                    sleep(1ms).get();
+                }
+            });
+
             auto mutator = seastar::async([&] {
                 int32_t ckey_seq = 0;
                 while (!cancelled) {
@@ -179,6 +216,7 @@ int main(int argc, char** argv) {
 
             mutator.get();
             reader.get();
+            cold_reader.get();
             stats_printer.cancel();
             completion_timer.cancel();
         }, cfg);
@@ -0,0 +1,379 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays a write workload against a compaction strategy, offline. Sstables exist only as
+// metadata (key range, size, timestamps and level), and compaction is simulated on it, so
+// thousands of flushes take seconds. Reports write, space and read amplification, and what
+// the backlog tracker of the strategy feeds the compaction controller with, over time.
+//
+// The data model: the key space is made of slots, each holding the same share of a data set
+// of fixed size. A sstable covers a contiguous range of slots, and holds a uniformly random
+// sample of the keys of every slot it covers, whose density is the same in all of them.
+// Merging sstables merges their samples, so in a slot, compaction output has a density of
+// 1 - (1 - d1) * (1 - d2) * ..., for all the input densities d1, d2... in that slot.
+//
+// Compaction is instantaneous, but its bandwidth may be limited to a multiple of the flush
+// bandwidth, in which case compactions wait for the next flush once it's used up.
+
+#include <seastar/core/app-template.hh>
+#include <seastar/core/thread.hh>
+#include <boost/range/adaptor/map.hpp>
+#include <boost/range/numeric.hpp>
+#include <fstream>
+
+// hack: sstable_test.hh falsely depends on Boost.Test, but we can't include it
+// with statically linked boost
+#define BOOST_REQUIRE(x) (void)(x)
+#define BOOST_CHECK_NO_THROW(x) (void)(x)
+
+#include "tests/sstable_test.hh"
+#include "tests/test_services.hh"
+#include "backlog_controller.hh"
+
+using namespace sstables;
+
+struct simulation_config {
+    compaction_strategy_type strategy;
+    std::map<sstring, sstring> options;
+    unsigned slots;
+    uint64_t data_set_size;
+    double compaction_bandwidth_ratio;
+    uint64_t available_memory;
+    unsigned report_interval;
+};
+
+struct flush {
+    uint64_t size;
+    api::timestamp_type timestamp;
+};
+
+class compaction_simulator {
+    struct simulated_sstable {
+        unsigned first_slot;
+        unsigned last_slot;
+        double density;
+    };
+
+    simulation_config _cfg;
+    test_env _env;
+    schema_ptr _schema;
+    column_family_for_tests _cf;
+    // keys of the slots, in token order.
+    std::vector<sstring> _keys;
+    std::unordered_map<shared_sstable, simulated_sstable> _sstables;
+    compaction_controller _controller;
+    unsigned long _generation = 0;
+
+    unsigned _flushes = 0;
+    uint64_t _bytes_flushed = 0;
+    uint64_t _bytes_compacted = 0;
+    unsigned _compactions = 0;
+    double _compaction_budget = 0;
+private:
+    static constexpr unsigned max_compactions_per_flush = 1000;
+
+    static schema_ptr make_schema(const simulation_config& cfg) {
+        return schema_builder("ks", "cf")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("v", utf8_type)
+                .set_compaction_strategy(cfg.strategy)
+                .set_compaction_strategy_options(cfg.options)
+                .build();
+    }
+
+    std::vector<sstring> make_keys() const {
+        std::vector<std::pair<sstring, dht::token>> keys;
+        for (unsigned i = 0; i < _cfg.slots; i++) {
+            auto key = format("key{:d}", i);
+            auto dk = dht::global_partitioner().decorate_key(*_schema, partition_key::from_exploded(*_schema, {to_bytes(key)}));
+            keys.emplace_back(std::move(key), dk.token());
+        }
+        std::sort(keys.begin(), keys.end(), [] (auto& a, auto& b) {
+            return a.second < b.second;
+        });
+        return boost::copy_range<std::vector<sstring>>(keys | boost::adaptors::map_keys);
+    }
+
+    double slot_size() const {
+        return double(_cfg.data_set_size) / _cfg.slots;
+    }
+
+    compaction_strategy& strategy() {
+        return _cf->get_compaction_strategy();
+    }
+
+    shared_sstable make_sstable(simulated_sstable s, uint64_t size, api::timestamp_type min_timestamp, api::timestamp_type max_timestamp,
+            uint32_t level, utils::UUID run_identifier) {
+        auto sst = _env.make_sstable(_schema, "", ++_generation, sstable::version_types::la, sstable::format_types::big);
+        stats_metadata stats = {};
+        stats.min_timestamp = min_timestamp;
+        stats.max_timestamp = max_timestamp;
+        // holds no expiring data, so it's never fully expired.
+        stats.max_local_deletion_time = std::numeric_limits<int32_t>::max();
+        stats.sstable_level = level;
+        sstables::test(sst).set_values(_keys[s.first_slot], _keys[s.last_slot], std::move(stats));
+        sstables::test(sst).set_data_file_size(size);
+        sstables::test(sst).set_run_identifier(run_identifier);
+        _sstables.emplace(sst, s);
+        return sst;
+    }
+
+    void replace(const std::vector<shared_sstable>& removed, const std::vector<shared_sstable>& added) {
+        auto& tracker = strategy().get_backlog_tracker();
+        for (auto& sst : removed) {
+            tracker.remove_sstable(sst);
+            _sstables.erase(sst);
+        }
+        for (auto& sst : added) {
+            tracker.add_sstable(sst);
+        }
+        column_family_test(_cf).rebuild_sstable_list(added, removed);
+        strategy().notify_completion(removed, added);
+    }
+
+    // Merges the samples of the input in every slot, and splits the result into sstables
+    // of at most max_sstable_bytes each.
+    std::vector<shared_sstable> compact(const compaction_descriptor& descriptor) {
+        unsigned first = _cfg.slots;
+        unsigned last = 0;
+        api::timestamp_type min_timestamp = api::max_timestamp;
+        api::timestamp_type max_timestamp = api::min_timestamp;
+        for (auto& sst : descriptor.sstables) {
+            auto& s = _sstables.at(sst);
+            first = std::min(first, s.first_slot);
+            last = std::max(last, s.last_slot);
+            min_timestamp = std::min(min_timestamp, sst->get_stats_metadata().min_timestamp);
+            max_timestamp = std::max(max_timestamp, sst->get_stats_metadata().max_timestamp);
+        }
+
+        std::vector<double> absent(last - first + 1, 1.0);
+        for (auto& sst : descriptor.sstables) {
+            auto& s = _sstables.at(sst);
+            for (auto slot = s.first_slot; slot <= s.last_slot; slot++) {
+                absent[slot - first] *= 1 - s.density;
+            }
+        }
+
+        std::vector<shared_sstable> output;
+        auto run_identifier = utils::make_random_uuid();
+        auto fragment_first = first;
+        double fragment_size = 0;
+        auto seal = [&] (unsigned fragment_last) {
+            auto density = fragment_size / (slot_size() * (fragment_last - fragment_first + 1));
+            output.push_back(make_sstable({fragment_first, fragment_last, density}, uint64_t(fragment_size),
+                    min_timestamp, max_timestamp, descriptor.level, run_identifier));
+            _bytes_compacted += uint64_t(fragment_size);
+        };
+        for (auto slot = first; slot <= last; slot++) {
+            auto size = slot_size() * (1 - absent[slot - first]);
+            if (fragment_size > 0 && fragment_size + size > descriptor.max_sstable_bytes) {
+                seal(slot - 1);
+                fragment_first = slot;
+                fragment_size = 0;
+            }
+            fragment_size += size;
+        }
+        if (fragment_size > 0) {
+            seal(last);
+        }
+        return output;
+    }
+
+    void run_compactions() {
+        auto unlimited = _cfg.compaction_bandwidth_ratio == 0;
+        for (unsigned i = 0; i < max_compactions_per_flush; i++) {
+            if (!unlimited && _compaction_budget <= 0) {
+                return;
+            }
+            auto candidates = boost::copy_range<std::vector<shared_sstable>>(*_cf->get_sstables());
+            auto descriptor = strategy().get_sstables_for_compaction(*_cf, std::move(candidates));
+            if (descriptor.sstables.empty()) {
+                return;
+            }
+            for (auto& sst : descriptor.sstables) {
+                _compaction_budget -= sst->data_size();
+            }
+            auto output = compact(descriptor);
+            replace(descriptor.sstables, output);
+            _compactions++;
+        }
+        std::cerr << format("Stopped after {:d} compactions following flush {:d}, strategy may be looping\n", max_compactions_per_flush, _flushes);
+    }
+
+    uint64_t on_disk() const {
+        uint64_t size = 0;
+        for (auto& s : _sstables) {
+            size += s.first->data_size();
+        }
+        return size;
+    }
+
+    // Size of the distinct data in all of the sstables.
+    double live_data() const {
+        std::vector<double> absent(_cfg.slots, 1.0);
+        for (auto& [sst, s] : _sstables) {
+            for (auto slot = s.first_slot; slot <= s.last_slot; slot++) {
+                absent[slot] *= 1 - s.density;
+            }
+        }
+        return boost::accumulate(absent, 0.0, [this] (double acc, double a) {
+            return acc + slot_size() * (1 - a);
+        });
+    }
+
+    // Average number of sstables a read of a key has to look at, bloom filters aside.
+    double sstables_per_read() const {
+        uint64_t covering = 0;
+        for (auto& [sst, s] : _sstables) {
+            covering += s.last_slot - s.first_slot + 1;
+        }
+        return double(covering) / _cfg.slots;
+    }
+public:
+    explicit compaction_simulator(simulation_config cfg)
+        : _cfg(std::move(cfg))
+        , _schema(make_schema(_cfg))
+        , _cf(_schema)
+        , _keys(make_keys())
+        // The interval is long enough for it to never adjust shares while simulating.
+        , _controller(default_scheduling_group(), default_priority_class(), std::chrono::hours(24), [] { return 0.0f; })
+    {
+    }
+
+    future<> stop() {
+        return _controller.shutdown();
+    }
+
+    void on_flush(const flush& f) {
+        auto density = std::min(1.0, double(f.size) / _cfg.data_set_size);
+        auto size = uint64_t(density * _cfg.data_set_size);
+        auto sst = make_sstable({0, _cfg.slots - 1, density}, size, f.timestamp, f.timestamp, 0, utils::make_random_uuid());
+        replace({}, {sst});
+        _flushes++;
+        _bytes_flushed += size;
+        _compaction_budget += _cfg.compaction_bandwidth_ratio * size;
+
+        if (_flushes % _cfg.report_interval == 0) {
+            report();
+        }
+        run_compactions();
+    }
+
+    // Reported before the compactions triggered by the last flush, so the backlog is what
+    // the controller would see when they start.
+    void report() {
+        auto backlog = strategy().get_backlog_tracker().backlog();
+        auto normalized = backlog / _cfg.available_memory;
+        if (compaction_controller::backlog_disabled(normalized)) {
+            normalized = compaction_controller::normalization_factor;
+        }
+        auto live = live_data();
+        std::cout << format("flush {:d}: sstables: {:d}, compactions: {:d}, write amplification: {:.2f}, space amplification: {:.2f}, "
+                "sstables per read: {:.2f}, backlog: {:.0f}, normalized backlog: {:.3f}, controller shares: {:.0f}\n",
+                _flushes, _sstables.size(), _compactions,
+                double(_bytes_flushed + _bytes_compacted) / _bytes_flushed,
+                live > 0 ? on_disk() / live : 0.0,
+                sstables_per_read(),
+                backlog, normalized, _controller.controller_output(normalized));
+    }
+};
+
+// Each line of a recorded workload is the size of a flushed sstable in bytes, and the
+// timestamp of its data in microseconds.
+static std::vector<flush> load_workload(const sstring& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(format("Could not open workload {}", path));
+    }
+    std::vector<flush> flushes;
+    uint64_t size;
+    api::timestamp_type timestamp;
+    while (in >> size >> timestamp) {
+        flushes.push_back({size, timestamp});
+    }
+    return flushes;
+}
+
+static std::vector<flush> make_workload(unsigned count, uint64_t size, std::chrono::seconds interval) {
+    auto start = api::new_timestamp();
+    auto step = std::chrono::duration_cast<std::chrono::microseconds>(interval).count();
+    std::vector<flush> flushes;
+    for (unsigned i = 0; i < count; i++) {
+        flushes.push_back({size, start + i * step});
+    }
+    return flushes;
+}
+
+int main(int argc, char** argv) {
+    namespace bpo = boost::program_options;
+    app_template app;
+    app.add_options()
+        ("strategy", bpo::value<sstring>()->default_value("SizeTieredCompactionStrategy"), "Compaction strategy")
+        ("option", bpo::value<std::vector<sstring>>()->default_value({}, ""), "Compaction strategy option, as name=value, may be repeated")
+        ("workload", bpo::value<sstring>(), "Recorded workload to replay, one flush per line: size in bytes and timestamp in microseconds. "
+                "When not given, a synthetic one is generated")
+        ("flushes", bpo::value<unsigned>()->default_value(1000), "Flushes of the synthetic workload")
+        ("flush-size-mb", bpo::value<uint64_t>()->default_value(64), "Size of the sstables flushed by the synthetic workload")
+        ("flush-interval", bpo::value<unsigned>()->default_value(60), "Seconds between flushes of the synthetic workload")
+        ("data-set-size-mb", bpo::value<uint64_t>()->default_value(64 * 1024), "Size of the distinct data written to, which bounds the live data")
+        ("slots", bpo::value<unsigned>()->default_value(256), "Number of slots the key space is divided into")
+        ("compaction-bandwidth-ratio", bpo::value<double>()->default_value(0), "Bytes compacted per byte flushed, 0 for unlimited")
+        ("available-memory-mb", bpo::value<uint64_t>(), "Memory the backlog is normalized by, defaults to the memory of the shard")
+        ("report-interval", bpo::value<unsigned>()->default_value(10), "Flushes between reports")
+        ;
+
+    return app.run(argc, argv, [&app] {
+        return seastar::async([&app] {
+            storage_service_for_tests ssft;
+            auto& config = app.configuration();
+            constexpr uint64_t MB = 1024 * 1024;
+
+            simulation_config cfg;
+            cfg.strategy = compaction_strategy::type(config["strategy"].as<sstring>());
+            for (auto& option : config["option"].as<std::vector<sstring>>()) {
+                auto pos = option.find('=');
+                if (pos == sstring::npos) {
+                    throw std::invalid_argument(format("Invalid option {}, expected name=value", option));
+                }
+                cfg.options.emplace(option.substr(0, pos), option.substr(pos + 1));
+            }
+            cfg.slots = config["slots"].as<unsigned>();
+            cfg.data_set_size = config["data-set-size-mb"].as<uint64_t>() * MB;
+            cfg.compaction_bandwidth_ratio = config["compaction-bandwidth-ratio"].as<double>();
+            cfg.available_memory = config.count("available-memory-mb")
+                    ? config["available-memory-mb"].as<uint64_t>() * MB : memory::stats().total_memory();
+            cfg.report_interval = std::max(config["report-interval"].as<unsigned>(), 1U);
+
+            auto workload = config.count("workload")
+                    ? load_workload(config["workload"].as<sstring>())
+                    : make_workload(config["flushes"].as<unsigned>(), config["flush-size-mb"].as<uint64_t>() * MB,
+                            std::chrono::seconds(config["flush-interval"].as<unsigned>()));
+
+            std::cout << format("Replaying {:d} flushes against {}\n", workload.size(), compaction_strategy::name(cfg.strategy));
+            compaction_simulator simulator(std::move(cfg));
+            for (auto& f : workload) {
+                simulator.on_flush(f);
+            }
+            simulator.report();
+            simulator.stop().get();
+        });
+    });
+}
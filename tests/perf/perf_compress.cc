@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+
+#include "compress.hh"
+#include "tests/perf/perf.hh"
+
+// Measures compression ratio and (un)compression throughput of the sstable
+// compressors, on chunks of time-series like data.
+
+static constexpr size_t chunk_size = 16 * 1024;
+static constexpr size_t nr_chunks = 1024;
+
+// Rows of a sensor table: mostly repeating identifiers, slowly changing
+// timestamps and noisy readings, like what cold time-series tables hold.
+static std::vector<temporary_buffer<char>> make_chunks() {
+    std::default_random_engine rng;
+    std::uniform_int_distribution<int> sensor(0, 200);
+    std::normal_distribution<double> reading(20, 3);
+    std::vector<temporary_buffer<char>> chunks;
+    int64_t ts = 1546300800000;
+    for (size_t i = 0; i < nr_chunks; ++i) {
+        temporary_buffer<char> buf(chunk_size);
+        size_t pos = 0;
+        while (pos < chunk_size) {
+            auto row = format("sensor-{:04d}|{}|temperature|{:.3f}|OK\n", sensor(rng), ts, reading(rng));
+            ts += 1000;
+            auto n = std::min(row.size(), chunk_size - pos);
+            std::copy_n(row.begin(), n, buf.get_write() + pos);
+            pos += n;
+        }
+        chunks.push_back(std::move(buf));
+    }
+    return chunks;
+}
+
+static void measure(const sstring& label, compressor_ptr c, const std::vector<temporary_buffer<char>>& chunks) {
+    using clk = std::chrono::steady_clock;
+
+    std::vector<temporary_buffer<char>> compressed;
+    size_t compressed_size = 0;
+    auto start = clk::now();
+    for (auto& chunk : chunks) {
+        temporary_buffer<char> out(c->compress_max_size(chunk.size()));
+        auto len = c->compress(chunk.get(), chunk.size(), out.get_write(), out.size());
+        out.trim(len);
+        compressed_size += len;
+        compressed.push_back(std::move(out));
+    }
+    auto compress_duration = std::chrono::duration<double>(clk::now() - start).count();
+
+    temporary_buffer<char> out(chunk_size);
+    start = clk::now();
+    for (auto& chunk : compressed) {
+        c->uncompress(chunk.get(), chunk.size(), out.get_write(), out.size());
+    }
+    auto uncompress_duration = std::chrono::duration<double>(clk::now() - start).count();
+
+    auto mb = double(chunk_size * chunks.size()) / (1024 * 1024);
+    std::cout << format("{:<24} ratio: {:.3f}  compress: {:>8.2f} MB/s  uncompress: {:>8.2f} MB/s\n",
+            label, double(compressed_size) / (chunk_size * chunks.size()),
+            mb / compress_duration, mb / uncompress_duration);
+}
+
+static compressor_ptr make_zstd(int level, int dictionary_size_kb = 0) {
+    return compressor::create({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "compression_level", std::to_string(level) },
+        { "dictionary_size_in_kb", std::to_string(dictionary_size_kb) },
+    });
+}
+
+int main(int argc, char* argv[]) {
+    auto chunks = make_chunks();
+
+    for (int i = 0; i < 3; ++i) {
+        measure("LZ4Compressor", compressor::lz4, chunks);
+        measure("SnappyCompressor", compressor::snappy, chunks);
+        measure("DeflateCompressor", compressor::deflate, chunks);
+        for (auto level : { 1, 3, 9 }) {
+            measure(format("ZstdCompressor({})", level), make_zstd(level), chunks);
+        }
+        // Train on the first chunks, like the sstable writer does.
+        auto zstd = make_zstd(3, 16);
+        bytes samples;
+        std::vector<size_t> sample_sizes;
+        for (size_t i = 0; i < nr_chunks / 10; ++i) {
+            samples.append(reinterpret_cast<const int8_t*>(chunks[i].get()), chunks[i].size());
+            sample_sizes.push_back(chunks[i].size());
+        }
+        auto dictionary = zstd->train_dictionary(samples, sample_sizes);
+        std::cout << format("trained a {} byte dictionary\n", dictionary.size());
+        measure("ZstdCompressor(3, dict)", dictionary.empty() ? zstd : zstd->with_dictionary(dictionary), chunks);
+    }
+}
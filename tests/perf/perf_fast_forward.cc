@@ -1754,6 +1754,7 @@ int main(int argc, char** argv) {
         ("data-directory", bpo::value<sstring>()->default_value("./perf_large_partition_data"), "Data directory")
         ("output-directory", bpo::value<sstring>()->default_value("./perf_fast_forward_output"), "Results output directory (for 'json')")
         ("sstable-format", bpo::value<std::string>()->default_value("mc"), "Sstable format version to use during population")
+        ("promoted-index-bsearch-threshold", bpo::value<uint32_t>(), "Size in KiB from which promoted indexes are bisected rather than parsed sequentially")
         ("dump-all-results", "Write results of all iterations of all tests to text files in the output directory")
         ;
 
@@ -1800,6 +1801,10 @@ int main(int argc, char** argv) {
             throw std::runtime_error(format("Unsupported sstable format: {}", sstable_format_name));
         }
 
+        if (app.configuration().count("promoted-index-bsearch-threshold")) {
+            db_cfg.promoted_index_bsearch_threshold_in_kb(app.configuration()["promoted-index-bsearch-threshold"].as<uint32_t>());
+        }
+
         test_case_duration = app.configuration()["test-case-duration"].as<double>();
 
         if (!app.configuration().count("verbose")) {
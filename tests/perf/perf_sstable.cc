@@ -95,6 +95,9 @@ int main(int argc, char** argv) {
         ("column_size", bpo::value<unsigned>()->default_value(64), "size in bytes for each column")
         ("sstables", bpo::value<unsigned>()->default_value(1), "number of sstables (valid only for compaction mode)")
         ("mode", bpo::value<sstring>()->default_value("index_write"), "one of: sequential_read, index_read, write, compaction, index_write (default)")
+        ("sstable_format", bpo::value<sstring>()->default_value("ka"), "sstable format version to write and read, e.g. ka or mc")
+        ("fixed_size_columns", "use bigint columns instead of text columns of column_size bytes")
+        ("disjoint_sstables", "write sstables holding partitions of their own, rather than the same ones (valid only for compaction mode)")
         ("testdir", bpo::value<sstring>()->default_value("/var/lib/scylla/perf-tests"), "directory in which to store the sstables");
 
     return app.run_deprecated(argc, argv, [&app] {
@@ -107,6 +110,10 @@ int main(int argc, char** argv) {
         cfg.key_size = app.configuration()["key_size"].as<unsigned>();
         cfg.buffer_size = app.configuration()["buffer_size"].as<unsigned>() << 10;
         cfg.sstables = app.configuration()["sstables"].as<unsigned>();
+        auto format = app.configuration()["sstable_format"].as<sstring>();
+        cfg.version = sstable::version_from_sstring(format);
+        cfg.fixed_size_columns = app.configuration().count("fixed_size_columns");
+        cfg.disjoint_sstables = app.configuration().count("disjoint_sstables");
         sstring dir = app.configuration()["testdir"].as<sstring>();
         cfg.dir = dir;
         auto mode = test_mode[app.configuration()["mode"].as<sstring>()];
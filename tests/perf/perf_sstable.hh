@@ -46,6 +46,12 @@ class perf_sstable_test_env {
         unsigned sstables;
         size_t buffer_size;
         sstring dir;
+        sstable::version_types version;
+        // When set, columns are bigints instead of text of column_size bytes.
+        bool fixed_size_columns;
+        // When set, compaction mode writes each sstable with partitions of its own, rather than
+        // all of them with the same partitions.
+        bool disjoint_sstables;
     };
 
 private:
@@ -76,11 +82,22 @@ class perf_sstable_test_env {
     lw_shared_ptr<memtable> _mt;
     std::vector<shared_sstable> _sst;
 
+    data_type column_type() const {
+        return _cfg.fixed_size_columns ? long_type : utf8_type;
+    }
+
+    bytes random_value() {
+        if (_cfg.fixed_size_columns) {
+            return long_type->decompose(int64_t(_generator()));
+        }
+        return utf8_type->decompose(random_column());
+    }
+
     schema_ptr create_schema() {
         std::vector<schema::column> columns;
 
         for (unsigned i = 0; i < _cfg.num_columns; ++i) {
-            columns.push_back(schema::column{ to_bytes(format("column{:04d}", i)), utf8_type });
+            columns.push_back(schema::column{ to_bytes(format("column{:04d}", i)), column_type() });
         }
 
         schema_builder builder(make_lw_shared(schema(generate_legacy_id("ks", "perf-test"), "ks", "perf-test",
@@ -109,14 +126,32 @@ class perf_sstable_test_env {
 
     future<> stop() { return make_ready_future<>(); }
 
+    unsigned partitions_per_memtable() const {
+        return _cfg.disjoint_sstables ? _cfg.partitions : _cfg.partitions / _cfg.sstables;
+    }
+
+    // Consecutive slices of the memtable, one per sstable, so that the sstables written from them don't overlap.
+    std::vector<lw_shared_ptr<memtable>> disjoint_memtables() {
+        std::vector<lw_shared_ptr<memtable>> mts;
+        auto partitions_per_sstable = _mt->partition_count() / _cfg.sstables;
+        auto rd = _mt->make_flat_reader(s);
+        while (auto mo = read_mutation_from_flat_mutation_reader(rd, db::no_timeout).get0()) {
+            if (mts.empty() || (mts.back()->partition_count() >= partitions_per_sstable && mts.size() < _cfg.sstables)) {
+                mts.push_back(make_lw_shared<memtable>(s));
+            }
+            mts.back()->apply(std::move(*mo));
+        }
+        return mts;
+    }
+
     future<> fill_memtable() {
-        auto idx = boost::irange(0, int(_cfg.partitions / _cfg.sstables));
-        auto local_keys = make_local_keys(int(_cfg.partitions / _cfg.sstables), s, _cfg.key_size);
+        auto idx = boost::irange(0, int(partitions_per_memtable()));
+        auto local_keys = make_local_keys(int(partitions_per_memtable()), s, _cfg.key_size);
         return do_for_each(idx.begin(), idx.end(), [this, local_keys = std::move(local_keys)] (auto iteration) {
             auto key = partition_key::from_deeply_exploded(*s, { local_keys.at(iteration) });
             auto mut = mutation(this->s, key);
             for (auto& cdef: this->s->regular_columns()) {
-                mut.set_clustered_cell(clustering_key::make_empty(), cdef, atomic_cell::make_live(*utf8_type, 0, utf8_type->decompose(this->random_column())));
+                mut.set_clustered_cell(clustering_key::make_empty(), cdef, atomic_cell::make_live(*cdef.type, 0, this->random_value()));
             }
             this->_mt->apply(std::move(mut));
             return make_ready_future<>();
@@ -124,7 +159,7 @@ class perf_sstable_test_env {
     }
 
     future<> load_sstables(unsigned iterations) {
-        _sst.push_back(_env.make_sstable(s, this->dir(), 0, sstable::version_types::ka, sstable::format_types::big));
+        _sst.push_back(_env.make_sstable(s, this->dir(), 0, _cfg.version, sstable::format_types::big));
         return _sst.back()->load();
     }
 
@@ -140,7 +175,7 @@ class perf_sstable_test_env {
             size_t partitions = _mt->partition_count();
 
             test_setup::create_empty_test_dir(dir()).get();
-            auto sst = _env.make_sstable(s, dir(), idx, sstable::version_types::ka, sstable::format_types::big, _cfg.buffer_size);
+            auto sst = _env.make_sstable(s, dir(), idx, _cfg.version, sstable::format_types::big, _cfg.buffer_size);
 
             auto start = perf_sstable_test_env::now();
             write_memtable_to_sstable_for_test(*_mt, sst).get();
@@ -157,15 +192,20 @@ class perf_sstable_test_env {
         return test_setup::create_empty_test_dir(dir()).then([this, idx] {
             return seastar::async([this, idx] {
                 auto sst_gen = [this, gen = make_lw_shared<unsigned>(idx)] () mutable {
-                    return _env.make_sstable(s, dir(), (*gen)++, sstable::version_types::ka, sstable::format_types::big, _cfg.buffer_size);
+                    return _env.make_sstable(s, dir(), (*gen)++, _cfg.version, sstable::format_types::big, _cfg.buffer_size);
                 };
 
+                std::vector<lw_shared_ptr<memtable>> mts;
+                if (_cfg.disjoint_sstables) {
+                    mts = disjoint_memtables();
+                }
                 std::vector<shared_sstable> ssts;
                 for (auto i = 0u; i < _cfg.sstables; i++) {
+                    auto& mt = _cfg.disjoint_sstables ? *mts[i] : *_mt;
                     auto sst = sst_gen();
-                    write_memtable_to_sstable_for_test(*_mt, sst).get();
+                    write_memtable_to_sstable_for_test(mt, sst).get();
                     sst->open_data().get();
-                    _mt->revert_flushed_memory();
+                    mt.revert_flushed_memory();
                     ssts.push_back(std::move(sst));
                 }
 
@@ -180,8 +220,7 @@ class perf_sstable_test_env {
                 auto ret = sstables::compact_sstables(sstables::compaction_descriptor(std::move(ssts)), *cf, sst_gen, sstables::replacer_fn_no_op()).get0();
                 auto end = perf_sstable_test_env::now();
 
-                auto partitions_per_sstable = _cfg.partitions / _cfg.sstables;
-                assert(ret.total_keys_written == partitions_per_sstable);
+                assert(ret.total_keys_written == partitions_per_memtable());
 
                 auto duration = std::chrono::duration<double>(end - start).count();
                 return ret.total_keys_written / duration;
@@ -20,6 +20,8 @@
  */
 
 #include <chrono>
+#include <numeric>
+#include <random>
 #include <seastar/core/distributed.hh>
 #include <seastar/core/app-template.hh>
 #include <seastar/core/sstring.hh>
@@ -34,6 +36,8 @@
 #include "schema_builder.hh"
 #include "memtable.hh"
 #include "tests/perf/perf.hh"
+#include "intrusive_set_external_comparator.hh"
+#include "utils/bptree.hh"
 
 static const int update_iterations = 16;
 static const int cell_size = 128;
@@ -192,6 +196,112 @@ void run_test(const sstring& name, schema_ptr s, MutationGenerator&& gen) {
     std::cout << format("invalidation: {:.6f} [ms]", d.count() * 1000) << "\n";
 }
 
+struct rbtree_rows_entry {
+    intrusive_set_external_comparator_member_hook _link;
+    int64_t _key;
+    explicit rbtree_rows_entry(int64_t key) : _key(key) { }
+};
+
+struct bptree_rows_entry {
+    bplus::member_hook _link;
+    int64_t _key;
+    explicit bptree_rows_entry(int64_t key) : _key(key) { }
+};
+
+struct rows_entry_less {
+    static int64_t key_of(int64_t key) { return key; }
+    template<typename Entry>
+    static int64_t key_of(const Entry& e) { return e._key; }
+    template<typename A, typename B>
+    bool operator()(const A& a, const B& b) const { return key_of(a) < key_of(b); }
+};
+
+// Orders like rows_entry_less, the way tokens are kept in the partitions containers.
+struct rows_entry_prefix {
+    uint64_t operator()(int64_t key) const { return uint64_t(key) + uint64_t(std::numeric_limits<int64_t>::min()); }
+    uint64_t operator()(const bptree_rows_entry& e) const { return (*this)(e._key); }
+};
+
+// Measures the clustering rows container alone, on a partition with lots of rows.
+// Rows are allocated in the order in which they are inserted, first in key order,
+// then in random order.
+template<typename Tree, typename Entry, typename IndexSize>
+void test_rows_container(const sstring& name, size_t row_count, IndexSize index_size) {
+    std::vector<int64_t> keys(row_count);
+    std::iota(keys.begin(), keys.end(), 0);
+    auto make_entries = [&] {
+        std::vector<std::unique_ptr<Entry>> entries;
+        entries.reserve(row_count);
+        for (auto key : keys) {
+            entries.emplace_back(std::make_unique<Entry>(key));
+        }
+        return entries;
+    };
+    auto entries = make_entries();
+    std::shuffle(keys.begin(), keys.end(), std::default_random_engine(row_count));
+    auto shuffled = make_entries();
+    auto per_row = [row_count] (std::chrono::duration<float> d) {
+        return d.count() * 1e9 / row_count;
+    };
+    rows_entry_less less;
+
+    std::cout << name << ":\n";
+    {
+        Tree rows;
+        auto d = duration_in_seconds([&] {
+            for (auto& e : entries) {
+                rows.insert_before(rows.end(), *e);
+            }
+        });
+        std::cout << format("append: {:.1f} [ns/row], memory: {:.1f} [B/row]\n", per_row(d), double(index_size(rows)) / row_count);
+        rows.clear_and_dispose([] (Entry*) { });
+    }
+
+    Tree rows;
+    auto d = duration_in_seconds([&] {
+        for (auto& e : shuffled) {
+            rows.insert(rows.end(), *e, less);
+        }
+    });
+    std::cout << format("insert: {:.1f} [ns/row], memory: {:.1f} [B/row]\n", per_row(d), double(index_size(rows)) / row_count);
+
+    size_t found = 0;
+    d = duration_in_seconds([&] {
+        for (auto key : keys) {
+            found += rows.find(key, less) != rows.end();
+        }
+    });
+    assert(found == row_count);
+    std::cout << format("lookup: {:.1f} [ns/row]\n", per_row(d));
+
+    int64_t sum = 0;
+    d = duration_in_seconds([&] {
+        for (auto& e : rows) {
+            sum += e._key;
+        }
+    });
+    assert(sum == int64_t(row_count * (row_count - 1) / 2));
+    std::cout << format("scan: {:.1f} [ns/row]\n", per_row(d));
+
+    rows.clear_and_dispose([] (Entry*) { });
+}
+
+void test_rows_containers() {
+    const size_t row_count = 1000000;
+    test_rows_container<intrusive_set_external_comparator<rbtree_rows_entry, &rbtree_rows_entry::_link>, rbtree_rows_entry>(
+        "Rows container, red-black tree", row_count, [] (auto&) {
+            return sizeof(rbtree_rows_entry::_link) * row_count;
+        });
+    test_rows_container<bplus::tree<bptree_rows_entry, &bptree_rows_entry::_link>, bptree_rows_entry>(
+        "Rows container, B+tree", row_count, [] (auto& rows) {
+            return sizeof(bptree_rows_entry::_link) * row_count + rows.external_memory_usage();
+        });
+    test_rows_container<bplus::tree<bptree_rows_entry, &bptree_rows_entry::_link, rows_entry_prefix>, bptree_rows_entry>(
+        "Rows container, B+tree with key prefixes", row_count, [] (auto& rows) {
+            return sizeof(bptree_rows_entry::_link) * row_count + rows.external_memory_usage();
+        });
+}
+
 void test_small_partitions() {
     auto s = schema_builder("ks", "cf")
         .with_column("pk", uuid_type, column_kind::partition_key)
@@ -295,6 +405,7 @@ int main(int argc, char** argv) {
                 return make_ready_future();
             });
             logalloc::prime_segment_pool(memory::stats().total_memory(), memory::min_free_memory()).get();
+            test_rows_containers();
             test_small_partitions();
             test_partition_with_few_small_rows();
             test_partition_with_lots_of_small_rows();
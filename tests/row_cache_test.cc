@@ -3478,3 +3478,104 @@ SEASTAR_TEST_CASE(test_reading_progress_with_small_buffer_and_invalidation) {
         assert_that(result).is_equal_to(m1);
     });
 }
+
+SEASTAR_TEST_CASE(test_recently_used_partitions_are_visited_first) {
+    return seastar::async([] {
+        simple_schema s;
+        cache_tracker tracker;
+        memtable_snapshot_source underlying(s.schema());
+        row_cache cache(s.schema(), snapshot_source([&] { return underlying(); }), tracker);
+
+        auto pkeys = s.make_pkeys(4);
+        for (auto&& pk : pkeys) {
+            mutation m(s.schema(), pk);
+            s.add_row(m, s.make_ckey(1), "v");
+            s.add_row(m, s.make_ckey(2), "v");
+            apply(cache, underlying, m);
+        }
+        cache.evict();
+
+        for (auto&& pk : pkeys) {
+            populate_range(cache, dht::partition_range::make_singular(pk));
+        }
+        populate_range(cache, dht::partition_range::make_singular(pkeys[1]));
+
+        std::vector<dht::decorated_key> visited;
+        tracker.for_each_recently_used_partition(100, [&] (const cache_entry& ce) {
+            visited.push_back(ce.key());
+            return stop_iteration::no;
+        });
+        BOOST_REQUIRE_EQUAL(visited.size(), pkeys.size());
+        BOOST_REQUIRE(visited[0].equal(*s.schema(), pkeys[1]));
+        BOOST_REQUIRE(visited[1].equal(*s.schema(), pkeys[3]));
+
+        visited.clear();
+        tracker.for_each_recently_used_partition(100, [&] (const cache_entry& ce) {
+            visited.push_back(ce.key());
+            return stop_iteration(visited.size() == 2);
+        });
+        BOOST_REQUIRE_EQUAL(visited.size(), 2);
+
+        visited.clear();
+        tracker.for_each_recently_used_partition(1, [&] (const cache_entry& ce) {
+            visited.push_back(ce.key());
+            return stop_iteration::no;
+        });
+        BOOST_REQUIRE_EQUAL(visited.size(), 1);
+
+        // A walk leaves nothing behind in the LRU: walking again visits the same
+        // partitions, in the same order, and the whole cache can still be evicted.
+        std::vector<dht::decorated_key> all;
+        tracker.for_each_recently_used_partition(100, [&] (const cache_entry& ce) {
+            all.push_back(ce.key());
+            return stop_iteration::no;
+        });
+        visited.clear();
+        tracker.for_each_recently_used_partition(100, [&] (const cache_entry& ce) {
+            visited.push_back(ce.key());
+            return stop_iteration::no;
+        });
+        BOOST_REQUIRE_EQUAL(visited.size(), all.size());
+        for (size_t i = 0; i < all.size(); ++i) {
+            BOOST_REQUIRE(visited[i].equal(*s.schema(), all[i]));
+        }
+
+        cache.evict();
+        visited.clear();
+        tracker.for_each_recently_used_partition(100, [&] (const cache_entry& ce) {
+            visited.push_back(ce.key());
+            return stop_iteration::no;
+        });
+        BOOST_REQUIRE(visited.empty());
+    });
+}
+
+SEASTAR_TEST_CASE(test_admission_sketch_is_sized_per_table) {
+    return seastar::async([] {
+        auto s = make_schema();
+        auto admitting_s = schema_builder(s)
+                .set_caching_options(caching_options::from_map(std::map<sstring, sstring>{{"admission", "FREQUENT"}}))
+                .build();
+        cache_tracker tracker;
+
+        // Another table on the shard caches many partitions.
+        row_cache cache(s, snapshot_source_from_snapshot(make_empty_mutation_source()), tracker);
+        for (int i = 0; i < 4096; ++i) {
+            cache.populate(make_new_mutation(s, i));
+        }
+
+        auto m = make_new_mutation(admitting_s, 1);
+        {
+            row_cache admitting_cache(admitting_s, snapshot_source_from_snapshot(make_source_with(m)), tracker);
+            assert_that(admitting_cache.make_reader(admitting_s, dht::partition_range::make_singular(m.decorated_key())))
+                .produces(m)
+                .produces_end_of_stream();
+
+            // The sketch follows the partitions of its own table, not those of the whole cache.
+            auto bytes = tracker.get_stats().admission_sketch_bytes;
+            BOOST_REQUIRE_GT(bytes, 0u);
+            BOOST_REQUIRE_LT(bytes, utils::frequency_sketch(4096).memory_usage());
+        }
+        BOOST_REQUIRE_EQUAL(tracker.get_stats().admission_sketch_bytes, 0u);
+    });
+}
@@ -36,6 +36,7 @@
 #include <seastar/core/seastar.hh>
 #include <seastar/core/do_with.hh>
 #include "sstables/compaction_manager.hh"
+#include "sstables/index_page_cache.hh"
 #include "tmpdir.hh"
 #include "dht/i_partitioner.hh"
 #include "dht/murmur3_partitioner.hh"
@@ -44,6 +45,7 @@
 #include "sstables/compaction_strategy_impl.hh"
 #include "sstables/date_tiered_compaction_strategy.hh"
 #include "sstables/time_window_compaction_strategy.hh"
+#include "sstables/incremental_compaction_strategy.hh"
 #include "mutation_assertions.hh"
 #include "counters.hh"
 #include "cell_locking.hh"
@@ -59,6 +61,7 @@
 #include <ftw.h>
 #include <unistd.h>
 #include <boost/range/algorithm/find_if.hpp>
+#include <boost/range/algorithm/count_if.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/algorithm/cxx11/is_sorted.hpp>
 #include "test_services.hh"
@@ -952,6 +955,66 @@ SEASTAR_TEST_CASE(datafile_generation_15) {
     return sstable_compression_test(compressor::deflate, 15);
 }
 
+SEASTAR_TEST_CASE(datafile_generation_zstd) {
+    auto zstd = compressor::create({
+        { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+        { "compression_level", "5" },
+        { "dictionary_size_in_kb", "1" },
+    });
+    return sstable_compression_test(zstd, 15);
+}
+
+SEASTAR_TEST_CASE(test_zstd_dictionary_is_trained_and_read_through) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto zstd = compressor::create({
+            { compression_parameters::SSTABLE_COMPRESSION, "ZstdCompressor" },
+            { "dictionary_size_in_kb", "1" },
+        });
+        auto builder = schema_builder("tests", "zstd_dictionary")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("ck", int32_type, column_kind::clustering_key)
+                .with_column("v", utf8_type);
+        builder.set_compressor_params(zstd);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp] () {
+            return env.make_sstable(s, tmp.path().string(), 1, la, big);
+        };
+
+        // Enough data for the samples to fill up before the end.
+        std::vector<mutation> muts;
+        for (int i = 0; i < 1000; ++i) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(format("key{:04d}", i))}));
+            for (int j = 0; j < 10; ++j) {
+                m.set_clustered_cell(clustering_key::from_exploded(*s, {int32_type->decompose(j)}),
+                    "v", data_value(format("value{:02d}-{:04d}", j, i % 10)), 1);
+            }
+            muts.push_back(std::move(m));
+        }
+        std::sort(muts.begin(), muts.end(), mutation_decorated_key_less_comparator());
+        make_sstable_containing(sst_gen, muts);
+
+        auto sst = env.reusable_sst(s, tmp.path().string(), 1).get0();
+        auto& c = sstables::test(sst).get_compression();
+        BOOST_REQUIRE(!c.dictionary().empty());
+
+        for (int round = 0; round < 2; ++round) {
+            auto rd = assert_that(sst->as_mutation_source().make_reader(s));
+            for (auto& m : muts) {
+                rd.produces(m);
+            }
+            rd.produces_end_of_stream();
+        }
+        // The dictionary is prepared once, for all readers on the shard.
+        auto prepared = sstables::test(sst).reader_compressor().get();
+        BOOST_REQUIRE(prepared);
+        assert_that(sst->as_mutation_source().make_reader(s)).produces(muts[0]);
+        BOOST_REQUIRE_EQUAL(sstables::test(sst).reader_compressor().get(), prepared);
+    });
+}
+
 SEASTAR_TEST_CASE(datafile_generation_16) {
     return test_setup::do_with_tmp_directory([] (test_env& env, sstring tmpdir_path) {
         auto s = uncompressed_schema();
@@ -2435,6 +2498,383 @@ SEASTAR_TEST_CASE(tombstone_purge_test) {
     });
 }
 
+SEASTAR_TEST_CASE(garbage_collected_sstable_test) {
+    BOOST_REQUIRE(smp::count == 1);
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+
+        auto builder = schema_builder("tests", "garbage_collected_sstable")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        builder.set_gc_grace_seconds(0);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        auto compact = [&, s] (std::vector<shared_sstable> all, std::vector<shared_sstable> to_compact) {
+            column_family_for_tests cf(s);
+            for (auto&& sst : all) {
+                column_family_test(cf).add_sstable(sst);
+            }
+            auto descriptor = sstables::compaction_descriptor(std::move(to_compact));
+            descriptor.use_garbage_collected_sstable = true;
+            return sstables::compact_sstables(std::move(descriptor), *cf, sst_gen, replacer_fn_no_op()).get0();
+        };
+
+        auto alpha = partition_key::from_exploded(*s, {to_bytes("alpha")});
+        auto beta = partition_key::from_exploded(*s, {to_bytes("beta")});
+
+        mutation insert_alpha(s, alpha);
+        insert_alpha.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), 1);
+        mutation delete_alpha(s, alpha);
+        delete_alpha.partition().apply(tombstone(2, gc_clock::now()));
+        mutation insert_beta(s, beta);
+        insert_beta.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), 3);
+
+        auto sst1 = make_sstable_containing(sst_gen, {insert_alpha});
+        auto sst2 = make_sstable_containing(sst_gen, {delete_alpha, insert_beta});
+
+        forward_jump_clocks(std::chrono::seconds(1));
+
+        // The tombstone can't be purged as it shadows data in sst1, so it's written to the
+        // garbage collected sstable rather than to the output.
+        auto info = compact({sst1, sst2}, {sst2});
+        BOOST_REQUIRE_EQUAL(2, info.new_sstables.size());
+        auto is_output = [&] (const shared_sstable& sst) {
+            return sst->run_identifier() == info.run_identifier;
+        };
+        auto output = *boost::find_if(info.new_sstables, is_output);
+        auto gc_sst = *boost::find_if(info.new_sstables, std::not_fn(is_output));
+        BOOST_REQUIRE(gc_sst->get_sstable_level() == 0);
+        assert_that(sstable_reader(output, s))
+                .produces(insert_beta)
+                .produces_end_of_stream();
+        assert_that(sstable_reader(gc_sst, s))
+                .produces(delete_alpha)
+                .produces_end_of_stream();
+
+        // Compacted along with the data it shadows, the tombstone is purged and nothing is left of the
+        // garbage collected sstable.
+        info = compact({sst1, output, gc_sst}, {sst1, output, gc_sst});
+        BOOST_REQUIRE_EQUAL(1, info.new_sstables.size());
+        assert_that(sstable_reader(info.new_sstables[0], s))
+                .produces(insert_beta)
+                .produces_end_of_stream();
+    });
+}
+
+// A compaction writes all of its garbage to a single sstable, however many outputs it has, and
+// keeps exhausted input sstables until that sstable is sealed along with the last output.
+SEASTAR_TEST_CASE(garbage_collected_sstable_per_compaction_test) {
+    BOOST_REQUIRE(smp::count == 1);
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+
+        auto builder = schema_builder("tests", "garbage_collected_sstable_per_compaction")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type);
+        builder.set_gc_grace_seconds(0);
+        auto s = builder.build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        // Every input deletes a partition of the older sstable and inserts one of its own.
+        static constexpr unsigned inputs = 4;
+        auto tokens = token_generation_for_current_shard(2 * inputs);
+        std::vector<mutation> old_inserts;
+        std::vector<mutation> deletes;
+        std::vector<mutation> inserts;
+        std::vector<shared_sstable> input;
+        for (auto i = 0U; i < inputs; i++) {
+            auto deleted_key = partition_key::from_exploded(*s, {to_bytes(tokens[2 * i].first)});
+            auto inserted_key = partition_key::from_exploded(*s, {to_bytes(tokens[2 * i + 1].first)});
+            mutation old_insert(s, deleted_key);
+            old_insert.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), 1);
+            old_inserts.push_back(std::move(old_insert));
+            mutation del(s, deleted_key);
+            del.partition().apply(tombstone(2, gc_clock::now()));
+            deletes.push_back(del);
+            mutation insert(s, inserted_key);
+            insert.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), 3);
+            inserts.push_back(insert);
+            input.push_back(make_sstable_containing(sst_gen, {std::move(del), std::move(insert)}));
+        }
+        auto older = make_sstable_containing(sst_gen, std::move(old_inserts));
+
+        forward_jump_clocks(std::chrono::seconds(1));
+
+        column_family_for_tests cf(s);
+        column_family_test(cf).add_sstable(older);
+        for (auto&& sst : input) {
+            column_family_test(cf).add_sstable(sst);
+        }
+        std::vector<std::vector<shared_sstable>> replaced;
+        std::vector<shared_sstable> added;
+        auto replacer = [&] (std::vector<shared_sstable> old_sstables, std::vector<shared_sstable> new_sstables) {
+            replaced.push_back(std::move(old_sstables));
+            boost::copy(new_sstables, std::back_inserter(added));
+        };
+        // One output per partition.
+        auto descriptor = sstables::compaction_descriptor(input, 0, 1);
+        descriptor.use_garbage_collected_sstable = true;
+        auto info = sstables::compact_sstables(std::move(descriptor), *cf, sst_gen, replacer).get0();
+
+        auto is_output = [&] (const shared_sstable& sst) {
+            return sst->run_identifier() == info.run_identifier;
+        };
+        BOOST_REQUIRE_EQUAL(info.new_sstables.size(), inputs + 1);
+        BOOST_REQUIRE_EQUAL(size_t(boost::count_if(info.new_sstables, is_output)), inputs);
+        BOOST_REQUIRE_EQUAL(added.size(), info.new_sstables.size());
+        // Garbage was found in the first partition, so no input was released before the end.
+        BOOST_REQUIRE_EQUAL(replaced.size(), 1u);
+        BOOST_REQUIRE_EQUAL(replaced.front().size(), inputs);
+
+        auto gc_sst = *boost::find_if(info.new_sstables, std::not_fn(is_output));
+        auto rd = assert_that(sstable_reader(gc_sst, s));
+        for (auto& m : deletes) {
+            rd.produces(m);
+        }
+        rd.produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(offstrategy_reshaping_jobs_test) {
+    test_env env;
+    column_family_for_tests cf;
+    constexpr uint64_t MB = 1024*1024;
+
+    auto make_input = [&] (int64_t gen, uint64_t data_size, int64_t max_timestamp) {
+        auto sst = env.make_sstable(cf.schema(), "", gen, la, big);
+        sstables::test(sst).set_values_for_leveled_strategy(data_size, /*level*/0, max_timestamp, "a", "z");
+        return sst;
+    };
+
+    // 15 sstables worth of input goes straight to L2, whose size is the closest to it.
+    add_sstable_for_leveled_test(env, cf, /*gen*/1, /*data_size*/MB, /*level*/1, "a", "a");
+    auto lcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::leveled, {{"sstable_size_in_mb", "1"}});
+    auto jobs = lcs.get_reshaping_jobs(*cf, {make_input(2, 5*MB, 0), make_input(3, 5*MB, 0), make_input(4, 5*MB, 0)});
+    BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+    BOOST_REQUIRE_EQUAL(jobs[0].sstables.size(), 3);
+    BOOST_REQUIRE_EQUAL(jobs[0].level, 2);
+    BOOST_REQUIRE_EQUAL(jobs[0].max_sstable_bytes, MB);
+
+    // Input belonging in L1 can't go there, as L1 is taken, so it's merged into a run in L0.
+    jobs = lcs.get_reshaping_jobs(*cf, {make_input(8, 3*MB, 0), make_input(9, 3*MB, 0)});
+    BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+    BOOST_REQUIRE_EQUAL(jobs[0].sstables.size(), 2);
+    BOOST_REQUIRE_EQUAL(jobs[0].level, 0);
+
+    // A small batch doesn't take a level of its own, and a single small sstable isn't rewritten.
+    jobs = lcs.get_reshaping_jobs(*cf, {make_input(10, MB / 4, 0), make_input(11, MB / 4, 0)});
+    BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+    BOOST_REQUIRE_EQUAL(jobs[0].level, 0);
+    BOOST_REQUIRE(lcs.get_reshaping_jobs(*cf, {make_input(12, MB / 2, 0)}).empty());
+
+    // Input is merged per time window, and a window with a single sstable is left alone.
+    using namespace std::chrono;
+    auto hour = duration_cast<microseconds>(hours(1)).count();
+    auto twcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::time_window,
+            {{"compaction_window_unit", "HOURS"}, {"compaction_window_size", "1"}});
+    jobs = twcs.get_reshaping_jobs(*cf, {make_input(5, MB, 0), make_input(6, MB, hour / 2), make_input(7, MB, 2 * hour)});
+    BOOST_REQUIRE_EQUAL(jobs.size(), 1);
+    BOOST_REQUIRE_EQUAL(jobs[0].sstables.size(), 2);
+    for (auto& sst : jobs[0].sstables) {
+        BOOST_REQUIRE(sst->generation() != 7);
+    }
+
+    return make_ready_future<>();
+}
+
+// Sstables added to the maintenance set are readable right away, but are left out of
+// regular compaction until off-strategy compaction reshapes them into the main set.
+SEASTAR_TEST_CASE(offstrategy_maintenance_set_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        BOOST_REQUIRE(smp::count == 1);
+        auto s = schema_builder("tests", "offstrategy_maintenance_set_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type).build();
+
+        auto cm = make_lw_shared<compaction_manager>();
+        cm->start();
+
+        auto tmp = tmpdir();
+        column_family::config cfg;
+        cfg.datadir = tmp.path().string();
+        cfg.enable_commitlog = false;
+        cfg.enable_incremental_backups = false;
+        cfg.large_data_handler = &nop_lp_handler;
+        cell_locker_stats cl_stats;
+        cache_tracker tracker;
+        auto cf = make_lw_shared<column_family>(s, cfg, column_family::no_commitlog(), *cm, cl_stats, tracker);
+        cf->start();
+        cf->mark_ready_for_writes();
+
+        auto sst_gen = [&env, s, &tmp, cf] () mutable {
+            auto sst = env.make_sstable(s, tmp.path().string(), column_family_test::calculate_generation_for_new_table(*cf), la, big);
+            sst->set_unshared();
+            return sst;
+        };
+        auto make_insert = [&] (const std::pair<sstring, dht::token>& p, int32_t value) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(p.first)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(value), 1 /* ts */);
+            return m;
+        };
+
+        // Two overlapping sstables, as a repair or a stream would write them.
+        auto tokens = token_generation_for_current_shard(2);
+        std::vector<mutation> muts = { make_insert(tokens[0], 1), make_insert(tokens[1], 2) };
+        std::vector<shared_sstable> input;
+        for (auto i = 0; i < 2; i++) {
+            input.push_back(make_sstable_containing(sst_gen, muts));
+            cf->add_maintenance_sstable_and_update_cache(input.back()).get();
+        }
+
+        auto assert_data_readable = [&] {
+            assert_that(cf->make_reader(s, query::full_partition_range))
+                .produces(muts[0])
+                .produces(muts[1])
+                .produces_end_of_stream();
+        };
+
+        BOOST_REQUIRE_EQUAL(cf->maintenance_sstables().size(), 2u);
+        BOOST_REQUIRE(cf->candidates_for_compaction().empty());
+        assert_data_readable();
+
+        cm->perform_offstrategy_compaction(&*cf).get();
+
+        BOOST_REQUIRE(cf->maintenance_sstables().empty());
+        auto candidates = cf->candidates_for_compaction();
+        BOOST_REQUIRE_EQUAL(candidates.size(), 1u);
+        BOOST_REQUIRE(boost::find(input, candidates.front()) == input.end());
+        assert_data_readable();
+
+        // The input of a failed job is handed back to the strategy as well.
+        input.clear();
+        for (auto i = 0; i < 2; i++) {
+            input.push_back(make_sstable_containing(sst_gen, muts));
+            cf->add_maintenance_sstable_and_update_cache(input.back()).get();
+        }
+        // The job's output takes the next generation, whose temporary TOC is made to exist already.
+        auto output_generation = column_family_test::calculate_generation_for_new_table(*cf) + 1;
+        for (auto v : {sstable_version_types::la, sstable_version_types::mc}) {
+            auto name = sstable::filename(tmp.path().string(), s->ks_name(), s->cf_name(), v, output_generation, big, component_type::TemporaryTOC);
+            open_file_dma(name, open_flags::wo | open_flags::create).get0().close().get();
+        }
+        cm->perform_offstrategy_compaction(&*cf).get();
+
+        BOOST_REQUIRE(cf->maintenance_sstables().empty());
+        candidates = cf->candidates_for_compaction();
+        BOOST_REQUIRE_EQUAL(candidates.size(), 3u);
+        for (auto& sst : input) {
+            BOOST_REQUIRE(boost::find(candidates, sst) != candidates.end());
+        }
+        assert_data_readable();
+
+        cf->stop().get();
+        cm->stop().get();
+    });
+}
+
+SEASTAR_TEST_CASE(compaction_fair_sharing_among_tables_test) {
+    return seastar::async([] {
+        column_family_for_tests cf1;
+        column_family_for_tests cf2;
+        constexpr uint64_t MB = 1024*1024;
+
+        compaction_manager cm;
+        cm.start();
+        auto make_info = [&] (column_family_for_tests& cf) {
+            auto info = make_lw_shared<sstables::compaction_info>();
+            info->cf = &*cf;
+            cm.register_compaction(info);
+            return info;
+        };
+        auto info1 = make_info(cf1);
+        auto info2 = make_info(cf2);
+
+        // Tables get the same shares, so the one ahead waits for the other one to catch up.
+        auto f = cm.charge_compaction(*info1, 4*MB);
+        BOOST_REQUIRE(!f.available());
+        cm.charge_compaction(*info2, 2*MB).get();
+        BOOST_REQUIRE(!f.available());
+        cm.charge_compaction(*info2, 2*MB).get();
+        f.get();
+        BOOST_REQUIRE_EQUAL(cm.compacted_bytes(&*cf1), 4*MB);
+        BOOST_REQUIRE_EQUAL(cm.compacted_bytes(&*cf2), 4*MB);
+
+        // No one waits for a table which is done compacting.
+        cm.deregister_compaction(info2);
+        cm.charge_compaction(*info1, 16*MB).get();
+
+        cm.deregister_compaction(info1);
+        cm.stop().get();
+    });
+}
+
+SEASTAR_TEST_CASE(compaction_keeps_repaired_data_apart_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("tests", "repaired_data_apart")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type).build();
+        auto tmp = tmpdir();
+        auto gen = make_lw_shared<unsigned>(1);
+        auto sst_gen = [&env, s, &tmp, gen] (uint64_t repaired_at) {
+            return [&env, s, &tmp, gen, repaired_at] {
+                auto sst = env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+                sst->get_metadata_collector().set_repaired_at(repaired_at);
+                return sst;
+            };
+        };
+        auto make_sstable = [&] (uint64_t repaired_at) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes("key")}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), api::new_timestamp());
+            return make_sstable_containing(sst_gen(repaired_at), {std::move(m)});
+        };
+        column_family_for_tests cf(s);
+
+        std::vector<shared_sstable> unrepaired, repaired;
+        for (auto i = 0; i < 4; i++) {
+            unrepaired.push_back(make_sstable(0));
+            repaired.push_back(make_sstable(1000 + i));
+        }
+        BOOST_REQUIRE(!unrepaired[0]->is_repaired());
+        BOOST_REQUIRE_EQUAL(repaired[1]->repaired_at(), 1001);
+
+        // Unrepaired sstables are compacted first, and never along with repaired ones.
+        auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, s->compaction_strategy_options());
+        auto candidates = repaired;
+        candidates.insert(candidates.end(), unrepaired.begin(), unrepaired.end());
+        auto descriptor = cs.get_sstables_for_compaction(*cf, candidates);
+        BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), 4);
+        BOOST_REQUIRE(boost::algorithm::all_of(descriptor.sstables, [] (auto& sst) { return !sst->is_repaired(); }));
+        descriptor = cs.get_sstables_for_compaction(*cf, repaired);
+        BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), 4);
+
+        // LCS keeps a single set of levels, so it compacts repaired and unrepaired L0 sstables together.
+        auto lcs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::leveled, s->compaction_strategy_options());
+        descriptor = lcs.get_sstables_for_compaction(*cf, candidates);
+        BOOST_REQUIRE_EQUAL(descriptor.sstables.size(), candidates.size());
+        BOOST_REQUIRE_EQUAL(descriptor.level, 0);
+
+        // Output is repaired as of the oldest repair of its input, if all of it was repaired.
+        auto compact = [&] (std::vector<shared_sstable> input) {
+            auto new_sstables = sstables::compact_sstables(sstables::compaction_descriptor(std::move(input)), *cf, sst_gen(0), replacer_fn_no_op()).get0().new_sstables;
+            BOOST_REQUIRE_EQUAL(new_sstables.size(), 1);
+            return new_sstables[0];
+        };
+        BOOST_REQUIRE_EQUAL(compact({repaired[2], repaired[1]})->repaired_at(), 1001);
+        BOOST_REQUIRE(!compact({repaired[3], unrepaired[3]})->is_repaired());
+    });
+}
+
 SEASTAR_TEST_CASE(check_multi_schema) {
     // Schema used to write sstable:
     // CREATE TABLE multi_schema_test (
@@ -4093,6 +4533,7 @@ SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
         BOOST_REQUIRE(info.new_sstables.size() == 1);
         BOOST_REQUIRE(info.new_sstables.front()->estimate_droppable_tombstone_ratio(gc_before) == 0.0f);
         BOOST_REQUIRE_CLOSE(info.new_sstables.front()->data_size(), uncompacted_size*(1-expired), 5);
+        BOOST_REQUIRE_GE(info.purged_tombstones, uint64_t(expired_keys));
 
         std::map<sstring, sstring> options;
         options.emplace("tombstone_threshold", "0.3f");
@@ -4138,6 +4579,46 @@ SEASTAR_TEST_CASE(sstable_expired_data_ratio) {
             auto descriptor = cs.get_sstables_for_compaction(*cf, { sst });
             BOOST_REQUIRE(descriptor.sstables.size() == 0);
         }
+        // sstable whose tombstones may shadow data in another sstable won't be included, unless unchecked
+        {
+            auto older_mt = make_lw_shared<memtable>(s);
+            auto insert_older_key = [&] (bytes k) {
+                mutation m(s, partition_key::from_exploded(*s, {k}));
+                auto c_key = clustering_key::from_exploded(*s, {to_bytes("c1")});
+                m.set_clustered_cell(c_key, *s->get_column_definition("r1"), make_atomic_cell(utf8_type, bytes("b")));
+                older_mt->apply(std::move(m));
+            };
+            for (auto i = 0; i < expired_keys; i++) {
+                insert_older_key(to_bytes("expired_key" + to_sstring(i)));
+            }
+            for (auto i = 0; i < remaining; i++) {
+                insert_older_key(to_bytes("key" + to_sstring(i)));
+            }
+            auto older = env.make_sstable(s, tmp.path().string(), 3, la, big);
+            write_memtable_to_sstable_for_test(*older_mt, older).get();
+            older = env.reusable_sst(s, tmp.path().string(), 3).get0();
+            column_family_test(cf).add_sstable(older);
+
+            sstables::test(sst).set_data_file_write_time(db_clock::time_point::min());
+            auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, options);
+            auto descriptor = cs.get_sstables_for_compaction(*cf, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 0);
+
+            options.emplace("unchecked_tombstone_compaction", "true");
+            cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::size_tiered, options);
+            descriptor = cs.get_sstables_for_compaction(*cf, { sst });
+            BOOST_REQUIRE(descriptor.sstables.size() == 1);
+            BOOST_REQUIRE(descriptor.sstables.front() == sst);
+
+            // The estimate is cached until the sstable set changes.
+            auto fraction = sstables::estimate_purgeable_tombstone_fraction(*cf, sst);
+            BOOST_REQUIRE_LT(fraction, 1.0);
+            BOOST_REQUIRE(sst->cached_purgeable_tombstone_fraction(cf->get_sstable_set().version()));
+            BOOST_REQUIRE_EQUAL(sstables::estimate_purgeable_tombstone_fraction(*cf, sst), fraction);
+            column_family_test(cf).rebuild_sstable_list({}, { older });
+            BOOST_REQUIRE(!sst->cached_purgeable_tombstone_fraction(cf->get_sstable_set().version()));
+            BOOST_REQUIRE_EQUAL(sstables::estimate_purgeable_tombstone_fraction(*cf, sst), 1.0);
+        }
     });
 }
 
@@ -4601,9 +5082,16 @@ SEASTAR_TEST_CASE(sstable_cleanup_correctness_test) {
             cf->start();
 
             auto cleanup_compaction = true;
-            auto ret = sstables::compact_sstables(sstables::compaction_descriptor({std::move(sst)}), *cf, sst_gen, sstables::replacer_fn_no_op(), cleanup_compaction).get0();
+            auto ret = sstables::compact_sstables(sstables::compaction_descriptor({sst}), *cf, sst_gen, sstables::replacer_fn_no_op(), cleanup_compaction).get0();
 
             BOOST_REQUIRE(ret.total_keys_written == total_partitions);
+
+            // The sstable spans many of the ranges of the node, but all of its keys are owned,
+            // so cleanup leaves it alone.
+            column_family_test(cf).add_sstable(sst);
+            cf->cleanup_sstables(sstables::compaction_descriptor({sst}), true).get();
+            BOOST_REQUIRE(cf->get_sstables()->count(sst));
+            BOOST_REQUIRE_EQUAL(cf->get_stats().cleanup_bytes_saved, int64_t(sst->bytes_on_disk()));
         });
     });
 }
@@ -4879,3 +5367,655 @@ SEASTAR_TEST_CASE(compaction_strategy_aware_major_compaction_test) {
         }
     });
 }
+
+SEASTAR_TEST_CASE(test_index_page_cache) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+        };
+
+        auto keys = ss.make_pkeys(4);
+        std::vector<mutation> muts;
+        for (auto& key : keys) {
+            mutation m(s, key);
+            ss.add_row(m, ss.make_ckey("ck"), "v");
+            muts.push_back(std::move(m));
+        }
+        auto sst = make_sstable_containing(sst_gen, muts);
+
+        auto& cache = index_page_cache::shard_instance();
+        auto read = [&] {
+            auto pr = dht::partition_range::make_singular(keys[2]);
+            assert_that(sstable_reader(sst, s, pr))
+                .produces(muts[2])
+                .produces_end_of_stream();
+        };
+
+        // The first read may already hit if validation in make_sstable_containing() populated the page.
+        read();
+        auto stats_before = cache.get_stats();
+        read();
+        BOOST_REQUIRE_GT(cache.get_stats().hits, stats_before.hits);
+        BOOST_REQUIRE_EQUAL(cache.get_stats().misses, stats_before.misses);
+        BOOST_REQUIRE_EQUAL(cache.get_stats().insertions, stats_before.insertions);
+
+        auto pages = cache.get_stats().pages;
+        BOOST_REQUIRE_GT(pages, 0);
+        sst = {};
+        BOOST_REQUIRE_LT(cache.get_stats().pages, pages);
+    });
+}
+
+SEASTAR_TEST_CASE(test_blocked_bloom_filter) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+
+        auto keys = ss.make_pkeys(100);
+        std::vector<mutation> muts;
+        for (auto& key : keys) {
+            mutation m(s, key);
+            ss.add_row(m, ss.make_ckey("ck"), "v");
+            muts.push_back(std::move(m));
+        }
+        sstable_writer_config cfg;
+        cfg.large_data_handler = &nop_lp_handler;
+        cfg.blocked_bloom_filter = true;
+        auto sst = env.make_sstable(s, tmp.path().string(), 1, sstable_version_types::mc, big);
+        sst->write_components(flat_mutation_reader_from_mutations(muts), keys.size(), s, cfg, encoding_stats{}).get();
+        sst = env.reusable_sst(s, tmp.path().string(), 1, sstable_version_types::mc).get0();
+        BOOST_REQUIRE(sst->has_blocked_bloom_filter());
+
+        for (auto& key : keys) {
+            BOOST_REQUIRE(sst->filter_has_key(*s, key.key()));
+        }
+
+        auto false_positives = 0;
+        for (auto i = 0; i < 1000; i++) {
+            false_positives += sst->filter_has_key(*s, ss.make_pkey(format("absent{}", i)).key());
+        }
+        BOOST_REQUIRE_LT(false_positives, 100);
+
+        auto pr = dht::partition_range::make_singular(keys[7]);
+        assert_that(sstable_reader(sst, s, pr))
+            .produces(muts[7])
+            .produces_end_of_stream();
+    });
+}
+
+static void test_promoted_index_lookup_with_rows(test_env& env, uint32_t n_rows, uint64_t min_promoted_index_size = 0) {
+    storage_service_for_tests ssft;
+    simple_schema table;
+    auto s = table.schema();
+    auto key = table.make_pkey(0);
+    mutation m(s, key);
+    for (uint32_t i = 0; i < n_rows; ++i) {
+        table.add_row(m, table.make_ckey(i), "v");
+    }
+
+    tmpdir dir;
+    sstable_writer_config cfg;
+    cfg.promoted_index_block_size = 1; // So that every row starts a block
+    cfg.large_data_handler = &nop_lp_handler;
+    auto sst = make_sstable_easy(env, dir.path(), flat_mutation_reader_from_mutations({m}), cfg, sstable_version_types::mc);
+
+    {
+        auto ir = get_index_reader(sst);
+        ir->read_partition_data().get();
+        auto& e = ir->current_partition_entry();
+        BOOST_REQUIRE_GE(e.get_promoted_index_size(), std::max<uint64_t>(min_promoted_index_size, sstables::promoted_index_lookup_threshold()));
+        BOOST_REQUIRE(e.get_pi_lookup());
+        BOOST_REQUIRE_EQUAL(e.get_pi_lookup()->num_blocks(), e.get_total_pi_blocks_count());
+        ir->close().get();
+    }
+
+    auto ms = as_mutation_source(sst);
+    for (auto i : {0u, 1u, n_rows / 2 - 1, n_rows / 2, n_rows - 1}) {
+        auto slice = partition_slice_builder(*s)
+            .with_range(query::clustering_range::make_singular(table.make_ckey(i)))
+            .build();
+        assert_that(ms.make_reader(s, query::full_partition_range, slice))
+            .produces_partition_start(key)
+            .produces_row_with_key(table.make_ckey(i))
+            .produces_partition_end()
+            .produces_end_of_stream();
+    }
+
+    // Each skip bisects only the blocks after the current one.
+    auto rd = ms.make_reader(s, query::full_partition_range, s->full_slice(), default_priority_class(),
+            nullptr, streamed_mutation::forwarding::yes);
+    auto assertions = assert_that(std::move(rd));
+    assertions.produces_partition_start(key);
+    for (uint32_t i = 10; i + 2 < n_rows; i += 97) {
+        assertions.fast_forward_to(position_range(
+                position_in_partition::for_key(table.make_ckey(i)),
+                position_in_partition::for_key(table.make_ckey(i + 2))))
+            .produces_row_with_key(table.make_ckey(i))
+            .produces_row_with_key(table.make_ckey(i + 1))
+            .produces_end_of_stream();
+    }
+}
+
+SEASTAR_TEST_CASE(test_promoted_index_lookup) {
+    return test_env::do_with_async([] (test_env& env) {
+        test_promoted_index_lookup_with_rows(env, 1000);
+    });
+}
+
+// The promoted index is bigger than both a cached index page and the index
+// read buffer, so it is read partly through a separate stream.
+SEASTAR_TEST_CASE(test_promoted_index_lookup_of_large_index) {
+    return test_env::do_with_async([] (test_env& env) {
+        test_promoted_index_lookup_with_rows(env, 20000, std::max(size_t(index_page_cache::max_page_size), size_t(sstable::default_buffer_size)) + 1);
+    });
+}
+
+SEASTAR_TEST_CASE(test_read_ahead_tracker) {
+    sstables::read_ahead_tracker t(4096, read_ahead_tracker::single_partition_read_ahead);
+    // Skips within the read-ahead window don't waste it.
+    BOOST_REQUIRE(!t.on_skip(4095));
+    // Without read-ahead, there is nothing to shrink.
+    BOOST_REQUIRE(!t.on_skip(4096));
+
+    // Long sequential runs between skips deepen read-ahead.
+    t.on_read(2 * 4096);
+    BOOST_REQUIRE(t.on_skip(4096));
+    BOOST_REQUIRE_EQUAL(t.read_ahead(), 1u);
+    for (unsigned ra = 2; ra <= read_ahead_tracker::max_read_ahead; ra *= 2) {
+        t.on_read(2 * (ra / 2 + 1) * 4096);
+        BOOST_REQUIRE(t.on_skip(1024 * 1024));
+        BOOST_REQUIRE_EQUAL(t.read_ahead(), ra);
+    }
+    t.on_read(1024 * 1024);
+    BOOST_REQUIRE(!t.on_skip(1024 * 1024));
+
+    // Short ones make it shallower.
+    BOOST_REQUIRE(t.on_skip(1024 * 1024));
+    BOOST_REQUIRE_EQUAL(t.read_ahead(), read_ahead_tracker::max_read_ahead / 2);
+    return make_ready_future<>();
+}
+
+SEASTAR_TEST_CASE(test_adaptive_read_ahead) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        // Small buffers, so that the data spans many of them.
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstable_version_types::mc, big, 4096);
+        };
+
+        auto keys = ss.make_pkeys(200);
+        std::vector<mutation> muts;
+        for (auto& key : keys) {
+            mutation m(s, key);
+            for (auto i : boost::irange(0, 8)) {
+                ss.add_row(m, ss.make_ckey(i), sstring(128, 'v'));
+            }
+            muts.push_back(std::move(m));
+        }
+        auto sst = make_sstable_containing(sst_gen, muts);
+        auto stats = make_lw_shared<sstables::data_read_stats>();
+        sst->set_data_read_stats(stats);
+
+        auto full_scan = assert_that(sstable_reader(sst, s));
+        for (auto& m : muts) {
+            full_scan.produces(m);
+        }
+        full_scan.produces_end_of_stream();
+        // Consumed bytes are counted on disk, like the bytes read.
+        BOOST_REQUIRE_EQUAL(stats->bytes_consumed, sst->ondisk_data_size());
+        BOOST_REQUIRE_GE(stats->bytes_read, stats->bytes_consumed);
+
+        auto single_partition_stats = make_lw_shared<sstables::data_read_stats>();
+        sst->set_data_read_stats(single_partition_stats);
+        auto& m = muts[muts.size() / 2];
+        assert_that(sstable_reader(sst, s, dht::partition_range::make_singular(m.decorated_key())))
+            .produces(m)
+            .produces_end_of_stream();
+        BOOST_REQUIRE_GT(single_partition_stats->bytes_consumed, 0);
+        BOOST_REQUIRE_LT(single_partition_stats->bytes_read, sst->ondisk_data_size() / 4);
+    });
+}
+
+SEASTAR_TEST_CASE(test_read_counting_file_dup) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        simple_schema ss;
+        auto s = ss.schema();
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstable_version_types::mc, big);
+        };
+        mutation m(s, ss.make_pkey(0));
+        ss.add_row(m, ss.make_ckey(0), sstring(4096, 'v'));
+        auto sst = make_sstable_containing(sst_gen, {m});
+
+        auto stats = make_lw_shared<sstables::data_read_stats>();
+        auto f = sstables::make_read_counting_file(open_file_dma(sst->filename(component_type::Data), open_flags::ro).get0(), stats);
+        auto duped = f.dup().to_file();
+        auto buf = duped.dma_read<char>(0, 4096).get0();
+        BOOST_REQUIRE_GE(stats->bytes_read, buf.size());
+        duped.close().get();
+        f.close().get();
+    });
+}
+
+SEASTAR_TEST_CASE(test_fixed_size_columns_fast_path) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("s1", long_type, column_kind::static_column)
+            .with_column("r1", int32_type)
+            .with_column("r2", long_type)
+            .with_column("r3", double_type)
+            .build();
+        auto tmp = tmpdir();
+        // Small buffers, so that some rows straddle buffer boundaries and
+        // are decoded cell by cell.
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            return env.make_sstable(s, tmp.path().string(), (*gen)++, sstable_version_types::mc, big, 4096);
+        };
+
+        auto now = gc_clock::now();
+        auto& r1 = *s->get_column_definition("r1");
+        auto& r2 = *s->get_column_definition("r2");
+        auto& r3 = *s->get_column_definition("r3");
+        std::vector<mutation> muts;
+        for (int32_t pk : boost::irange(0, 20)) {
+            mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(pk)));
+            m.set_static_cell("s1", data_value(int64_t(pk)), api::timestamp_type(1));
+            for (int32_t ck : boost::irange(0, 100)) {
+                auto key = clustering_key::from_single_value(*s, int32_type->decompose(ck));
+                api::timestamp_type ts = 1 + ck % 3;
+                m.set_clustered_cell(key, r1, atomic_cell::make_live(*r1.type, ts, int32_type->decompose(ck)));
+                if (ck % 5 == 0) {
+                    m.set_clustered_cell(key, r2, atomic_cell::make_dead(ts, now));
+                } else if (ck % 7 != 0) {
+                    m.set_clustered_cell(key, r2, atomic_cell::make_live(*r2.type, ts, long_type->decompose(int64_t(ck) * pk)));
+                }
+                if (ck % 2 == 0) {
+                    m.set_clustered_cell(key, r3, atomic_cell::make_live(*r3.type, ts + 1, double_type->decompose(ck / 2.0),
+                            now + gc_clock::duration(3600), gc_clock::duration(3600)));
+                }
+            }
+            muts.push_back(std::move(m));
+        }
+        std::sort(muts.begin(), muts.end(), mutation_decorated_key_less_comparator());
+        auto sst = make_sstable_containing(sst_gen, muts);
+
+        auto rd = assert_that(sstable_reader(sst, s));
+        for (auto& m : muts) {
+            rd.produces(m);
+        }
+        rd.produces_end_of_stream();
+    });
+}
+
+SEASTAR_TEST_CASE(test_compressed_writer_many_chunks) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        for (auto compressor : {"LZ4Compressor", "ZstdCompressor"}) {
+            std::map<sstring, sstring> options = {
+                { compression_parameters::SSTABLE_COMPRESSION, compressor },
+                { compression_parameters::CHUNK_LENGTH_KB, "4" },
+            };
+            if (sstring(compressor) == "ZstdCompressor") {
+                options.emplace("dictionary_size_in_kb", "1");
+            }
+            auto s = schema_builder("ks", "cf")
+                .with_column("pk", utf8_type, column_kind::partition_key)
+                .with_column("ck", int32_type, column_kind::clustering_key)
+                .with_column("v", utf8_type)
+                .set_compressor_params(compression_parameters(options))
+                .build();
+            auto tmp = tmpdir();
+            auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+                return env.make_sstable(s, tmp.path().string(), (*gen)++, sstable_version_types::mc, big);
+            };
+
+            // Many chunks, more than zstd holds back to train its dictionary on.
+            std::vector<mutation> muts;
+            for (auto i : boost::irange(0, 64)) {
+                mutation m(s, partition_key::from_single_value(*s, utf8_type->decompose(format("key{:04d}", i))));
+                for (int32_t ck : boost::irange(0, 32)) {
+                    auto key = clustering_key::from_single_value(*s, int32_type->decompose(ck));
+                    m.set_clustered_cell(key, "v", data_value(format("{:0256d}", i * ck)), api::timestamp_type(1));
+                }
+                muts.push_back(std::move(m));
+            }
+            std::sort(muts.begin(), muts.end(), mutation_decorated_key_less_comparator());
+            auto sst = make_sstable_containing(sst_gen, muts);
+            BOOST_REQUIRE_GT(sst->data_size(), 64 * 4096);
+
+            auto rd = assert_that(sstable_reader(sst, s));
+            for (auto& m : muts) {
+                rd.produces(m);
+            }
+            rd.produces_end_of_stream();
+        }
+    });
+}
+
+SEASTAR_TEST_CASE(test_sstable_zone_maps) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("s1", int32_type, column_kind::static_column)
+            .with_column("v", int32_type)
+            .with_column("t", utf8_type)
+            .with_column("unset", int32_type)
+            .with_column("l", list_type_impl::get_instance(int32_type, true))
+            .build();
+        auto& v = *s->get_column_definition("v");
+        auto& t = *s->get_column_definition("t");
+        auto& unset = *s->get_column_definition("unset");
+        auto& l = *s->get_column_definition("l");
+        auto& s1 = *s->get_column_definition("s1");
+
+        std::vector<mutation> muts;
+        for (int32_t pk : boost::irange(0, 10)) {
+            mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(pk)));
+            m.set_static_cell("s1", data_value(pk * 1000), api::timestamp_type(1));
+            for (int32_t ck : boost::irange(0, 10)) {
+                auto key = clustering_key::from_single_value(*s, int32_type->decompose(ck));
+                m.set_clustered_cell(key, v, atomic_cell::make_live(*v.type, 1, int32_type->decompose(100 + pk * 10 + ck)));
+                m.set_clustered_cell(key, t, atomic_cell::make_live(*t.type, 1, utf8_type->decompose(format("t{}", ck))));
+            }
+            // Deleted values do not widen the zone map.
+            auto key = clustering_key::from_single_value(*s, int32_type->decompose(10));
+            m.set_clustered_cell(key, v, atomic_cell::make_dead(1, gc_clock::now()));
+            m.set_clustered_cell(key, unset, atomic_cell::make_dead(1, gc_clock::now()));
+            muts.push_back(std::move(m));
+        }
+        std::sort(muts.begin(), muts.end(), mutation_decorated_key_less_comparator());
+
+        auto tmp = tmpdir();
+        sstable_writer_config cfg;
+        cfg.large_data_handler = &nop_lp_handler;
+        cfg.zone_maps = true;
+        auto sst = make_sstable_easy(env, tmp.path(), flat_mutation_reader_from_mutations(muts), cfg, sstable_version_types::mc);
+
+        auto value_range = [] (std::optional<int32_t> start, std::optional<int32_t> end) {
+            auto bound = [] (std::optional<int32_t> x) -> std::optional<nonwrapping_range<bytes>::bound> {
+                return x ? std::make_optional(nonwrapping_range<bytes>::bound(int32_type->decompose(*x))) : std::nullopt;
+            };
+            return nonwrapping_range<bytes>(bound(start), bound(end));
+        };
+        // v spans [100, 199].
+        BOOST_REQUIRE(sst->may_contain_values(v, value_range(150, 150)));
+        BOOST_REQUIRE(sst->may_contain_values(v, value_range(199, {})));
+        BOOST_REQUIRE(sst->may_contain_values(v, value_range({}, 100)));
+        BOOST_REQUIRE(!sst->may_contain_values(v, value_range(200, {})));
+        BOOST_REQUIRE(!sst->may_contain_values(v, value_range({}, 99)));
+        BOOST_REQUIRE(!sst->may_contain_values(v, nonwrapping_range<bytes>(
+                nonwrapping_range<bytes>::bound(int32_type->decompose(199), false), std::nullopt)));
+        // t is compared as text, not as bytes of a fixed size.
+        BOOST_REQUIRE(sst->may_contain_values(t, nonwrapping_range<bytes>::make_singular(utf8_type->decompose(sstring("t5")))));
+        BOOST_REQUIRE(!sst->may_contain_values(t, nonwrapping_range<bytes>::make_singular(utf8_type->decompose(sstring("t50")))));
+        // No live value at all.
+        BOOST_REQUIRE(!sst->may_contain_values(unset, value_range(0, {})));
+        // Columns without zone maps can never be excluded.
+        BOOST_REQUIRE(sst->may_contain_values(s1, value_range(-10, -1)));
+        BOOST_REQUIRE(sst->may_contain_values(l, nonwrapping_range<bytes>::make_singular(bytes())));
+
+        auto rd = assert_that(sstable_reader(sst, s));
+        for (auto& m : muts) {
+            rd.produces(m);
+        }
+        rd.produces_end_of_stream();
+
+        // Sstables written without zone maps may contain anything.
+        auto tmp2 = tmpdir();
+        cfg.zone_maps = false;
+        auto plain = make_sstable_easy(env, tmp2.path(), flat_mutation_reader_from_mutations(muts), cfg, sstable_version_types::mc);
+        BOOST_REQUIRE(plain->may_contain_values(v, value_range(200, {})));
+        BOOST_REQUIRE(plain->may_contain_values(unset, value_range(0, {})));
+    });
+}
+
+SEASTAR_TEST_CASE(test_zone_maps_table_reads) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        auto s = schema_builder("ks", "cf")
+            .with_column("pk", int32_type, column_kind::partition_key)
+            .with_column("ck", int32_type, column_kind::clustering_key)
+            .with_column("a", int32_type)
+            .with_column("b", int32_type)
+            .build();
+        auto& a = *s->get_column_definition("a");
+        auto& b = *s->get_column_definition("b");
+        auto make_mutation = [&] (int32_t pk, const column_definition& col, int32_t value, api::timestamp_type ts) {
+            mutation m(s, partition_key::from_single_value(*s, int32_type->decompose(pk)));
+            auto key = clustering_key::from_single_value(*s, int32_type->decompose(0));
+            m.set_clustered_cell(key, col, atomic_cell::make_live(*col.type, ts, int32_type->decompose(value)));
+            return m;
+        };
+
+        sstable_writer_config cfg;
+        cfg.large_data_handler = &nop_lp_handler;
+        cfg.zone_maps = true;
+        std::vector<tmpdir> dirs;
+        auto make_sst = [&] (mutation m) {
+            dirs.emplace_back();
+            return make_sstable_easy(env, dirs.back().path(), flat_mutation_reader_from_mutations({std::move(m)}), cfg, sstable_version_types::mc);
+        };
+
+        // The row of pk 0 has a = 1 in an older sstable and b = 2 in a newer one.
+        auto old_a = make_mutation(0, a, 1, 1);
+        auto new_b = make_mutation(0, b, 2, 2);
+        // pk 1 is alone in its sstable, and never matches.
+        auto other = make_mutation(1, a, 9, 1);
+        auto merged = old_a + new_b;
+
+        auto cm = make_lw_shared<compaction_manager>();
+        auto tracker = make_lw_shared<cache_tracker>();
+        cell_locker_stats cl_stats;
+        auto cf_cfg = column_family_test_config();
+        cf_cfg.enable_cache = false;
+        auto cf = make_lw_shared<column_family>(s, cf_cfg, column_family::no_commitlog(), *cm, cl_stats, *tracker);
+        cf->mark_ready_for_writes();
+        for (auto&& sst : {make_sst(old_a), make_sst(new_b), make_sst(other)}) {
+            column_family_test(cf).add_sstable(sst);
+        }
+
+        auto eq = [] (const column_definition& col, int32_t value) {
+            return query::column_value_range{col.id, nonwrapping_range<bytes>::make_singular(int32_type->decompose(value))};
+        };
+        auto read = [&] (const dht::partition_range& pr, query::column_value_ranges ranges, size_t expected_sstables) {
+            auto slice = s->full_slice();
+            slice.set_value_ranges(ranges);
+            auto sstables = column_family_test::exclude_sstables_by_value_ranges(*cf, pr, ranges);
+            BOOST_REQUIRE_EQUAL(sstables->all()->size(), expected_sstables);
+            return assert_that(cf->make_reader(s, pr, slice));
+        };
+        auto pk0 = dht::partition_range::make_singular(merged.decorated_key());
+        auto pk1 = dht::partition_range::make_singular(other.decorated_key());
+
+        // The sstable lacking b must not be skipped on a restriction of b,
+        // as it holds the a of the row whose b matches.
+        read(pk0, {eq(b, 2)}, 3).produces(merged).produces_end_of_stream();
+
+        // Neither sstable matches both restrictions, but the merged row does.
+        read(pk0, {eq(a, 1), eq(b, 2)}, 3).produces(merged).produces_end_of_stream();
+
+        // A partition held by a single sstable is skipped when its zone maps
+        // rule the restriction out, and read otherwise.
+        read(pk1, {eq(a, 1)}, 0).produces_end_of_stream();
+        read(pk1, {eq(a, 9)}, 3).produces(other).produces_end_of_stream();
+
+        // Scans never skip sstables.
+        read(query::full_partition_range, {eq(a, 1)}, 3);
+    });
+}
+
+SEASTAR_TEST_CASE(incremental_compaction_strategy_test) {
+    test_env env;
+    column_family_for_tests cf;
+    static constexpr uint64_t fragment_size = 1024 * 1024;
+    auto cs = sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, {{"sstable_size_in_mb", "1"}});
+    BOOST_REQUIRE(cs.type() == sstables::compaction_strategy_type::incremental);
+
+    unsigned gen = 0;
+    auto make_run = [&] (unsigned fragments, uint64_t size) {
+        auto run_id = utils::make_random_uuid();
+        std::vector<sstables::shared_sstable> run;
+        for (unsigned i = 0; i < fragments; i++) {
+            auto sst = env.make_sstable(cf.schema(), "", gen++, la, big);
+            sstables::test(sst).set_data_file_size(size);
+            sstables::test(sst).set_run_identifier(run_id);
+            run.push_back(std::move(sst));
+        }
+        return run;
+    };
+
+    // min_threshold runs of similar size, made of 2 fragments each, plus a run in a tier of its own.
+    std::vector<sstables::shared_sstable> candidates;
+    auto min_threshold = cf->schema()->min_compaction_threshold();
+    for (auto i = 0; i < min_threshold; i++) {
+        boost::copy(make_run(2, fragment_size), std::back_inserter(candidates));
+    }
+    auto large_run = make_run(1, 1000 * fragment_size);
+    boost::copy(large_run, std::back_inserter(candidates));
+
+    // Whole runs are compacted together, into fragments of the configured size.
+    auto desc = cs.get_sstables_for_compaction(*cf, candidates);
+    BOOST_REQUIRE_EQUAL(desc.sstables.size(), size_t(2 * min_threshold));
+    BOOST_REQUIRE(boost::find(desc.sstables, large_run.front()) == desc.sstables.end());
+    BOOST_REQUIRE_EQUAL(desc.max_sstable_bytes, fragment_size);
+
+    auto major = cs.get_major_compaction_job(*cf, candidates);
+    BOOST_REQUIRE_EQUAL(major.sstables.size(), candidates.size());
+    BOOST_REQUIRE_EQUAL(major.max_sstable_bytes, fragment_size);
+
+    // A single run, however many fragments it has, has nothing left to compact
+    // (up to rounding, as the tracker updates its sums incrementally).
+    auto& tracker = cs.get_backlog_tracker();
+    for (auto& sst : make_run(4, fragment_size)) {
+        tracker.add_sstable(sst);
+    }
+    BOOST_REQUIRE_SMALL(tracker.backlog(), 1.0);
+    auto other_run = make_run(1, fragment_size);
+    tracker.add_sstable(other_run.front());
+    BOOST_REQUIRE_GT(tracker.backlog(), 0);
+    tracker.remove_sstable(other_run.front());
+    BOOST_REQUIRE_SMALL(tracker.backlog(), 1.0);
+
+    // Keeping exhausted fragments until the garbage collected sstable is sealed would defeat the strategy.
+    BOOST_REQUIRE_THROW(sstables::make_compaction_strategy(sstables::compaction_strategy_type::incremental, {{"garbage_collected_sstable", "true"}}),
+            exceptions::configuration_exception);
+
+    return make_ready_future<>();
+}
+
+// Compacting runs of fragments must release each input fragment as soon as the
+// output has gone past its last key, which is what bounds the temporary space
+// incremental compaction needs to about a fragment per run instead of a copy
+// of all its input.
+SEASTAR_TEST_CASE(incremental_compaction_releases_exhausted_fragments_test) {
+    return test_env::do_with_async([] (test_env& env) {
+        storage_service_for_tests ssft;
+        cell_locker_stats cl_stats;
+
+        auto s = schema_builder("tests", "incremental_compaction_releases_exhausted_fragments_test")
+                .with_column("id", utf8_type, column_kind::partition_key)
+                .with_column("value", int32_type).build();
+
+        auto tmp = tmpdir();
+        auto sst_gen = [&env, s, &tmp, gen = make_lw_shared<unsigned>(1)] () mutable {
+            auto sst = env.make_sstable(s, tmp.path().string(), (*gen)++, la, big);
+            sst->set_unshared();
+            return sst;
+        };
+
+        auto cm = make_lw_shared<compaction_manager>();
+        auto tracker = make_lw_shared<cache_tracker>();
+        auto cf = make_lw_shared<column_family>(s, column_family_test_config(), column_family::no_commitlog(), *cm, cl_stats, *tracker);
+        cf->mark_ready_for_writes();
+        cf->start();
+        cf->set_compaction_strategy(sstables::compaction_strategy_type::incremental);
+
+        auto make_insert = [&] (const std::pair<sstring, dht::token>& p) {
+            mutation m(s, partition_key::from_exploded(*s, {to_bytes(p.first)}));
+            m.set_clustered_cell(clustering_key::make_empty(), bytes("value"), data_value(int32_t(1)), 1 /* ts */);
+            return m;
+        };
+
+        // Two runs of single partition fragments, interleaved in token order.
+        static constexpr unsigned runs = 2;
+        static constexpr unsigned fragments_per_run = 8;
+        auto tokens = token_generation_for_current_shard(runs * fragments_per_run);
+        std::vector<utils::UUID> run_ids(runs);
+        for (auto& id : run_ids) {
+            id = utils::make_random_uuid();
+        }
+        std::vector<mutation> muts;
+        std::unordered_set<shared_sstable> live_inputs;
+        std::vector<shared_sstable> input;
+        uint64_t input_bytes = 0;
+        for (auto i = 0U; i < tokens.size(); i++) {
+            muts.push_back(make_insert(tokens[i]));
+            auto sst = make_sstable_containing(sst_gen, { muts.back() });
+            sstables::test(sst).set_run_identifier(run_ids[i % runs]);
+            column_family_test(cf).add_sstable(sst);
+            input_bytes += sst->data_size();
+            live_inputs.insert(sst);
+            input.push_back(std::move(sst));
+        }
+
+        // Tiny outputs, so that each one seals after a single partition and
+        // releases the fragments it went past.
+        uint64_t output_bytes = 0;
+        uint64_t peak_bytes = 0;
+        unsigned replacements_before_end = 0;
+        auto replacer = [&] (std::vector<shared_sstable> old_sstables, std::vector<shared_sstable> new_sstables) {
+            for (auto& sst : old_sstables) {
+                BOOST_REQUIRE(live_inputs.count(sst));
+            }
+            uint64_t live_input_bytes = 0;
+            for (auto& sst : live_inputs) {
+                live_input_bytes += sst->data_size();
+            }
+            for (auto& sst : new_sstables) {
+                output_bytes += sst->data_size();
+            }
+            // Both the fragments about to be released and the outputs replacing them exist on disk at this point.
+            peak_bytes = std::max(peak_bytes, live_input_bytes + output_bytes);
+            for (auto& sst : old_sstables) {
+                live_inputs.erase(sst);
+            }
+            if (!live_inputs.empty()) {
+                replacements_before_end++;
+            }
+            column_family_test(cf).rebuild_sstable_list(new_sstables, old_sstables);
+            cf->get_compaction_manager().propagate_replacement(&*cf, old_sstables, new_sstables);
+        };
+
+        auto result = sstables::compact_sstables(sstables::compaction_descriptor(std::move(input), 0, 1), *cf, sst_gen, replacer).get0();
+        BOOST_REQUIRE(live_inputs.empty());
+        BOOST_REQUIRE_EQUAL(result.new_sstables.size(), tokens.size());
+
+        // Fragments were released one output at a time, not all at the end.
+        BOOST_REQUIRE_GE(replacements_before_end, tokens.size() - 2);
+        // Compacting everything at once needs room for all of the input and all
+        // of the output. Releasing as it goes, only about a fragment is on disk twice.
+        BOOST_REQUIRE_LT(peak_bytes, input_bytes + input_bytes / 4);
+
+        for (auto i = 0U; i < tokens.size(); i++) {
+            assert_that(sstable_reader(result.new_sstables[i], s))
+                .produces(muts[i])
+                .produces_end_of_stream();
+        }
+    });
+}
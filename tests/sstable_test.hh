@@ -64,6 +64,11 @@ class column_family_test {
     static int64_t calculate_shard_from_sstable_generation(int64_t generation) {
         return column_family::calculate_shard_from_sstable_generation(generation);
     }
+
+    static lw_shared_ptr<sstables::sstable_set> exclude_sstables_by_value_ranges(column_family& cf, const dht::partition_range& range,
+            const query::column_value_ranges& value_ranges) {
+        return cf.exclude_sstables_by_value_ranges(*cf.schema(), range, value_ranges, nullptr);
+    }
 };
 
 namespace sstables {
@@ -126,6 +131,14 @@ class test {
         return _sst->_components->summary;
     }
 
+    sstables::compression& get_compression() {
+        return _sst->_components->compression;
+    }
+
+    const compressor_ptr& reader_compressor() {
+        return _sst->_reader_compressor;
+    }
+
     summary move_summary() {
         return std::move(_sst->_components->summary);
     }
@@ -155,6 +168,10 @@ class test {
         _sst->_data_file_size = size;
     }
 
+    void set_run_identifier(utils::UUID identifier) {
+        _sst->_run_identifier = identifier;
+    }
+
     void set_data_file_write_time(db_clock::time_point wtime) {
         _sst->_data_file_write_time = wtime;
     }
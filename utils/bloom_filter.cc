@@ -44,11 +44,16 @@
 #include "bytes.hh"
 #include "utils/murmur_hash.hh"
 #include <seastar/core/shared_ptr.hh>
+#include <seastar/core/print.hh>
 #include "utils/large_bitset.hh"
 #include <array>
 #include <cstdlib>
 #include "bloom_filter.hh"
 
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
 namespace utils {
 namespace filter {
 
@@ -88,15 +93,93 @@ bool bloom_filter::is_present(const bytes_view& key) {
     return is_present(make_hashed_key(key));
 }
 
+blocked_bloom_filter::blocked_bloom_filter(int hashes, bitmap&& bs)
+    : bloom_filter(hashes, std::move(bs), filter_format::blocked_format)
+    , _nr_blocks(_bitset.get_storage().size() / words_per_block)
+{
+    if (!_nr_blocks) {
+        throw std::invalid_argument(format("Blocked bloom filter of {} bits is smaller than a block", _bitset.size()));
+    }
+}
+
+uint64_t* blocked_bloom_filter::block_for(hashed_key key) {
+    // Multiply-shift maps the hash onto [0, _nr_blocks) without a division.
+    auto idx = size_t((static_cast<unsigned __int128>(key.hash()[0]) * _nr_blocks) >> 64);
+    return _bitset.words(idx * words_per_block);
+}
+
+blocked_bloom_filter::block_mask blocked_bloom_filter::mask_for(hashed_key key) const {
+    auto h = key.hash()[1];
+    auto bit = static_cast<uint32_t>(h);
+    // Odd, so that up to bits_per_block probes hit distinct bits.
+    auto inc = static_cast<uint32_t>(h >> 32) | 1;
+    block_mask mask = {};
+    for (int i = 0; i < _hash_count; i++) {
+        auto b = bit % bits_per_block;
+        mask[b / 64] |= uint64_t(1) << (b % 64);
+        bit += inc;
+    }
+    return mask;
+}
+
+static bool block_contains(const uint64_t* block, const std::array<uint64_t, blocked_bloom_filter::words_per_block>& mask) {
+#if defined(__AVX2__)
+    auto b = reinterpret_cast<const __m256i*>(block);
+    auto m = reinterpret_cast<const __m256i*>(mask.data());
+    return _mm256_testc_si256(_mm256_loadu_si256(b), _mm256_loadu_si256(m))
+        & _mm256_testc_si256(_mm256_loadu_si256(b + 1), _mm256_loadu_si256(m + 1));
+#elif defined(__SSE4_1__)
+    auto b = reinterpret_cast<const __m128i*>(block);
+    auto m = reinterpret_cast<const __m128i*>(mask.data());
+    return _mm_testc_si128(_mm_loadu_si128(b), _mm_loadu_si128(m))
+        & _mm_testc_si128(_mm_loadu_si128(b + 1), _mm_loadu_si128(m + 1))
+        & _mm_testc_si128(_mm_loadu_si128(b + 2), _mm_loadu_si128(m + 2))
+        & _mm_testc_si128(_mm_loadu_si128(b + 3), _mm_loadu_si128(m + 3));
+#else
+    uint64_t missing = 0;
+    for (size_t i = 0; i < mask.size(); i++) {
+        missing |= mask[i] & ~block[i];
+    }
+    return !missing;
+#endif
+}
+
+void blocked_bloom_filter::add(const bytes_view& key) {
+    auto hk = make_hashed_key(key);
+    auto block = block_for(hk);
+    auto mask = mask_for(hk);
+    for (size_t i = 0; i < words_per_block; i++) {
+        block[i] |= mask[i];
+    }
+}
+
+bool blocked_bloom_filter::is_present(const bytes_view& key) {
+    return is_present(make_hashed_key(key));
+}
+
+bool blocked_bloom_filter::is_present(hashed_key key) {
+    return block_contains(block_for(key), mask_for(key));
+}
+
 filter_ptr create_filter(int hash, large_bitset&& bitset, filter_format format) {
+    if (format == filter_format::blocked_format) {
+        return std::make_unique<blocked_bloom_filter>(hash, std::move(bitset));
+    }
     return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
 }
 
 filter_ptr create_filter(int hash, int64_t num_elements, int buckets_per, filter_format format) {
+    int64_t alignment = 64;
+    if (format == filter_format::blocked_format) {
+        // Keys are not spread evenly across blocks, so the fuller blocks
+        // raise the false positive rate. Around 10% more bits make up for it.
+        buckets_per += (buckets_per + 9) / 10;
+        alignment = blocked_bloom_filter::bits_per_block;
+    }
     int64_t num_bits = (num_elements * buckets_per) + bloom_calculations::EXCESS;
-    num_bits = align_up<int64_t>(num_bits, 64);  // Seems to be implied in origin
+    num_bits = align_up<int64_t>(num_bits, alignment);  // Seems to be implied in origin
     large_bitset bitset(num_bits);
-    return std::make_unique<murmur3_bloom_filter>(hash, std::move(bitset), format);
+    return create_filter(hash, std::move(bitset), format);
 }
 }
 }
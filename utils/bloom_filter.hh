@@ -46,6 +46,7 @@
 #include "utils/murmur_hash.hh"
 #include "utils/large_bitset.hh"
 
+#include <array>
 #include <vector>
 
 namespace utils {
@@ -55,7 +56,7 @@ class bloom_filter: public i_filter {
 public:
     using bitmap = large_bitset;
 
-private:
+protected:
     bitmap _bitset;
     int _hash_count;
     filter_format _format;
@@ -93,6 +94,33 @@ struct murmur3_bloom_filter: public bloom_filter {
     {}
 };
 
+// A bloom filter whose probes for a given key all land on one 512-bit block,
+// so that a lookup touches a single cache line instead of one per hash
+// function. The first half of the key's hash selects the block, the second
+// one the bits within it, and the whole block is tested at once with word
+// (SIMD, when available) masks. It has a somewhat higher false positive rate
+// than bloom_filter for the same size, which create_filter() compensates for.
+class blocked_bloom_filter: public bloom_filter {
+public:
+    static constexpr size_t words_per_block = 8;
+    static constexpr size_t bits_per_block = words_per_block * 64;
+private:
+    using block_mask = std::array<uint64_t, words_per_block>;
+
+    size_t _nr_blocks;
+
+    uint64_t* block_for(hashed_key key);
+    block_mask mask_for(hashed_key key) const;
+public:
+    blocked_bloom_filter(int hashes, bitmap&& bs);
+
+    virtual void add(const bytes_view& key) override;
+
+    virtual bool is_present(const bytes_view& key) override;
+
+    virtual bool is_present(hashed_key key) override;
+};
+
 struct always_present_filter: public i_filter {
 
     virtual bool is_present(const bytes_view& key) override {
@@ -0,0 +1,1209 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <boost/intrusive/parent_from_member.hpp>
+#include "utils/allocation_strategy.hh"
+
+//
+// An intrusive, ordered B+tree with an external comparator.
+//
+// It is a replacement for intrusive_set_external_comparator, with the same
+// interface, for large sets which are looked up and iterated over often.
+// Elements are kept in leaves of up to node_capacity pointers, chained into
+// a list, so lookups touch O(log(n) / log(node_capacity)) nodes and iteration
+// mostly walks a contiguous array instead of chasing a pointer per element.
+// Inner nodes keep, next to each child, a pointer to the first element of
+// its subtree, which is the separator used to route lookups.
+//
+// Nodes are allocated with current_allocator() and are movable, so they can
+// live in LSA regions. Elements refer to their leaf through member_hook, and
+// both nodes and hooks fix up the pointers to themselves when moved.
+//
+// Like with the red-black tree, iterators are pointers to elements, so they
+// stay valid until the element they point to is erased. The end() iterator
+// stays valid until the tree is moved.
+//
+// Unlike with the red-black tree, insertion allocates and may throw. Erasure
+// never allocates and is noexcept. To make an insertion which cannot fail,
+// reserve the nodes it needs with reserve_for_insert_before() first.
+//
+// Optionally, nodes also keep a 64-bit key prefix for each element, computed
+// by the KeyPrefix function object, next to the pointer to it. Prefixes must
+// be ordered like the elements, that is if a < b then prefix(a) <= prefix(b).
+// Lookups compare prefixes first, and compare elements only when prefixes are
+// equal, so when prefixes are mostly distinct they don't touch the elements
+// on the way down. KeyPrefix must accept the keys passed to lookups as well,
+// either alone or along with the comparator of the lookup, for prefixes which
+// depend on what only the comparator knows, like the schema. It must not throw.
+//
+
+namespace bplus {
+
+class member_hook;
+
+namespace internal {
+
+static constexpr unsigned node_capacity = 16;
+// A node which has at most that many entries left is merged with
+// a sibling if the result fits in a single node.
+static constexpr unsigned merge_threshold = node_capacity / 4;
+static constexpr unsigned max_spare_nodes = 32;
+
+enum class node_kind : uint8_t {
+    header,
+    leaf,
+    inner,
+    spare,
+};
+
+struct node_base {
+    node_base* _parent = nullptr;
+    uint16_t _count = 0;
+    node_kind _kind;
+    // The node is a keyed_leaf or a keyed_inner.
+    bool _keyed;
+
+    explicit node_base(node_kind kind, bool keyed = false) noexcept : _kind(kind), _keyed(keyed) { }
+    node_base(const node_base&) = delete;
+};
+
+struct leaf;
+
+// Embedded in the tree. The root's parent.
+struct header : node_base {
+    node_base* _root = nullptr;
+    leaf* _leftmost = nullptr;
+    leaf* _rightmost = nullptr;
+
+    header() noexcept : node_base(node_kind::header) { }
+    header(header&& o) noexcept;
+};
+
+struct leaf : node_base {
+    leaf* _prev = nullptr;
+    leaf* _next = nullptr;
+    member_hook* _slots[node_capacity];
+
+    explicit leaf(bool keyed = false) noexcept : node_base(node_kind::leaf, keyed) { }
+    leaf(leaf&& o) noexcept;
+};
+
+struct keyed_leaf : leaf {
+    // _keys[i] is the prefix of _slots[i].
+    uint64_t _keys[node_capacity];
+
+    keyed_leaf() noexcept : leaf(true) { }
+    keyed_leaf(keyed_leaf&& o) noexcept;
+};
+
+struct inner : node_base {
+    node_base* _children[node_capacity];
+    // _firsts[i] is the first element of the subtree of _children[i].
+    member_hook* _firsts[node_capacity];
+
+    explicit inner(bool keyed = false) noexcept : node_base(node_kind::inner, keyed) { }
+    inner(inner&& o) noexcept;
+};
+
+struct keyed_inner : inner {
+    // _keys[i] is the prefix of _firsts[i].
+    uint64_t _keys[node_capacity];
+
+    keyed_inner() noexcept : inner(true) { }
+    keyed_inner(keyed_inner&& o) noexcept;
+};
+
+// Nodes allocated up front for an insertion, so that it cannot fail.
+// They point back at it, so that it can follow them when LSA moves them.
+class spare_nodes : public node_base {
+    node_base* _nodes[max_spare_nodes];
+    unsigned _leaves = 0;
+    unsigned _inners = 0;
+private:
+    void release() noexcept;
+public:
+    spare_nodes(unsigned leaves, unsigned inners, bool keyed);
+    spare_nodes(spare_nodes&&) = delete;
+    ~spare_nodes() { release(); }
+    bool empty() const noexcept { return !_leaves && !_inners; }
+    leaf* take_leaf() noexcept;
+    inner* take_inner() noexcept;
+    void replace(node_base* old, node_base* n) noexcept;
+};
+
+inline void merge_leaves(leaf* dst, leaf* src) noexcept;
+inline void insert_into_leaf(leaf* l, unsigned i, member_hook* h, uint64_t key) noexcept;
+inline void spill(leaf*& l, unsigned& i) noexcept;
+
+}
+
+// Links an element into a bplus::tree.
+// Unlinks the element from the tree when destroyed.
+class member_hook {
+    template<typename Elem, member_hook Elem::*, typename> friend class tree;
+    friend struct internal::leaf;
+    friend void internal::merge_leaves(internal::leaf*, internal::leaf*) noexcept;
+    friend void internal::insert_into_leaf(internal::leaf*, unsigned, member_hook*, uint64_t) noexcept;
+    friend void internal::spill(internal::leaf*&, unsigned&) noexcept;
+    internal::leaf* _leaf = nullptr;
+public:
+    member_hook() noexcept = default;
+    member_hook(const member_hook&) = delete;
+    member_hook(member_hook&& o) noexcept;
+    ~member_hook();
+    bool is_linked() const noexcept { return _leaf; }
+};
+
+namespace internal {
+
+inline header* header_of(node_base* n) noexcept {
+    while (n->_kind != node_kind::header) {
+        n = n->_parent;
+    }
+    return static_cast<header*>(n);
+}
+
+inline uint64_t* keys_of(leaf* l) noexcept {
+    return l->_keyed ? static_cast<keyed_leaf*>(l)->_keys : nullptr;
+}
+
+inline const uint64_t* keys_of(const leaf* l) noexcept {
+    return l->_keyed ? static_cast<const keyed_leaf*>(l)->_keys : nullptr;
+}
+
+inline uint64_t* keys_of(inner* n) noexcept {
+    return n->_keyed ? static_cast<keyed_inner*>(n)->_keys : nullptr;
+}
+
+inline const uint64_t* keys_of(const inner* n) noexcept {
+    return n->_keyed ? static_cast<const keyed_inner*>(n)->_keys : nullptr;
+}
+
+// Calls f with each of the arrays of l, which are indexed alike.
+template<typename Func>
+inline void for_each_array(leaf* l, Func&& f) noexcept {
+    f(l->_slots);
+    if (l->_keyed) {
+        f(keys_of(l));
+    }
+}
+
+// Calls f with each pair of corresponding arrays of a and b.
+template<typename Func>
+inline void for_each_array(leaf* a, leaf* b, Func&& f) noexcept {
+    f(a->_slots, b->_slots);
+    if (a->_keyed) {
+        f(keys_of(a), keys_of(b));
+    }
+}
+
+template<typename Func>
+inline void for_each_array(inner* n, Func&& f) noexcept {
+    f(n->_children);
+    f(n->_firsts);
+    if (n->_keyed) {
+        f(keys_of(n));
+    }
+}
+
+template<typename Func>
+inline void for_each_array(inner* a, inner* b, Func&& f) noexcept {
+    f(a->_children, b->_children);
+    f(a->_firsts, b->_firsts);
+    if (a->_keyed) {
+        f(keys_of(a), keys_of(b));
+    }
+}
+
+inline unsigned index_in_leaf(const leaf* l, const member_hook* h) noexcept {
+    unsigned i = 0;
+    while (l->_slots[i] != h) {
+        ++i;
+    }
+    return i;
+}
+
+// Like index_in_leaf(), but tries hint first.
+inline unsigned index_in_leaf(const leaf* l, const member_hook* h, uintptr_t hint) noexcept {
+    return hint < l->_count && l->_slots[hint] == h ? hint : index_in_leaf(l, h);
+}
+
+inline unsigned index_in_parent(const node_base* n) noexcept {
+    auto p = static_cast<const inner*>(n->_parent);
+    unsigned i = 0;
+    while (p->_children[i] != n) {
+        ++i;
+    }
+    return i;
+}
+
+inline member_hook* first_of(node_base* n) noexcept {
+    if (n->_kind == node_kind::leaf) {
+        return static_cast<leaf*>(n)->_slots[0];
+    }
+    return static_cast<inner*>(n)->_firsts[0];
+}
+
+inline uint64_t first_key_of(node_base* n) noexcept {
+    if (!n->_keyed) {
+        return 0;
+    }
+    if (n->_kind == node_kind::leaf) {
+        return static_cast<keyed_leaf*>(n)->_keys[0];
+    }
+    return static_cast<keyed_inner*>(n)->_keys[0];
+}
+
+// Sets the first element of the subtree rooted at n, and its prefix,
+// in the ancestors of n.
+inline void update_first(node_base* n) noexcept {
+    auto first = first_of(n);
+    auto key = first_key_of(n);
+    while (n->_parent->_kind == node_kind::inner) {
+        auto p = static_cast<inner*>(n->_parent);
+        auto i = index_in_parent(n);
+        p->_firsts[i] = first;
+        if (auto keys = keys_of(p)) {
+            keys[i] = key;
+        }
+        if (i) {
+            break;
+        }
+        n = p;
+    }
+}
+
+// Makes whatever pointed at old, which was just moved to n, point at n.
+inline void replace_child(node_base* old, node_base* n) noexcept {
+    auto p = n->_parent;
+    if (!p) {
+        return;
+    }
+    switch (p->_kind) {
+    case node_kind::header:
+        static_cast<header*>(p)->_root = n;
+        break;
+    case node_kind::inner: {
+        auto in = static_cast<inner*>(p);
+        unsigned i = 0;
+        while (in->_children[i] != old) {
+            ++i;
+        }
+        in->_children[i] = n;
+        break;
+    }
+    case node_kind::spare:
+        static_cast<spare_nodes*>(p)->replace(old, n);
+        break;
+    case node_kind::leaf:
+        assert(false);
+    }
+}
+
+inline header::header(header&& o) noexcept
+    : node_base(node_kind::header)
+    , _root(std::exchange(o._root, nullptr))
+    , _leftmost(std::exchange(o._leftmost, nullptr))
+    , _rightmost(std::exchange(o._rightmost, nullptr))
+{
+    if (_root) {
+        _root->_parent = this;
+    }
+}
+
+inline leaf::leaf(leaf&& o) noexcept
+    : node_base(node_kind::leaf, o._keyed)
+    , _prev(o._prev)
+    , _next(o._next)
+{
+    _parent = o._parent;
+    _count = o._count;
+    std::copy_n(o._slots, _count, _slots);
+    for (unsigned i = 0; i < _count; ++i) {
+        _slots[i]->_leaf = this;
+    }
+    replace_child(&o, this);
+    if (_parent && _parent->_kind != node_kind::spare) {
+        if (_prev) {
+            _prev->_next = this;
+        } else {
+            header_of(this)->_leftmost = this;
+        }
+        if (_next) {
+            _next->_prev = this;
+        } else {
+            header_of(this)->_rightmost = this;
+        }
+    }
+    o._count = 0;
+}
+
+inline keyed_leaf::keyed_leaf(keyed_leaf&& o) noexcept
+    : leaf(std::move(o))
+{
+    std::copy_n(o._keys, _count, _keys);
+}
+
+inline inner::inner(inner&& o) noexcept
+    : node_base(node_kind::inner, o._keyed)
+{
+    _parent = o._parent;
+    _count = o._count;
+    std::copy_n(o._children, _count, _children);
+    std::copy_n(o._firsts, _count, _firsts);
+    for (unsigned i = 0; i < _count; ++i) {
+        _children[i]->_parent = this;
+    }
+    replace_child(&o, this);
+    o._count = 0;
+}
+
+inline keyed_inner::keyed_inner(keyed_inner&& o) noexcept
+    : inner(std::move(o))
+{
+    std::copy_n(o._keys, _count, _keys);
+}
+
+inline void destroy_node(node_base* n) noexcept {
+    if (n->_kind == node_kind::leaf) {
+        if (n->_keyed) {
+            current_allocator().destroy(static_cast<keyed_leaf*>(n));
+        } else {
+            current_allocator().destroy(static_cast<leaf*>(n));
+        }
+    } else {
+        if (n->_keyed) {
+            current_allocator().destroy(static_cast<keyed_inner*>(n));
+        } else {
+            current_allocator().destroy(static_cast<inner*>(n));
+        }
+    }
+}
+
+inline spare_nodes::spare_nodes(unsigned leaves, unsigned inners, bool keyed)
+    : node_base(node_kind::spare)
+{
+    assert(leaves + inners <= max_spare_nodes);
+    try {
+        while (_leaves < leaves) {
+            leaf* n;
+            if (keyed) {
+                n = current_allocator().construct<keyed_leaf>();
+            } else {
+                n = current_allocator().construct<leaf>();
+            }
+            n->_parent = this;
+            _nodes[_leaves++] = n;
+        }
+        while (_inners < inners) {
+            inner* n;
+            if (keyed) {
+                n = current_allocator().construct<keyed_inner>();
+            } else {
+                n = current_allocator().construct<inner>();
+            }
+            n->_parent = this;
+            _nodes[_leaves + _inners++] = n;
+        }
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+inline void spare_nodes::release() noexcept {
+    for (unsigned i = 0; i < _leaves + _inners; ++i) {
+        destroy_node(_nodes[i]);
+    }
+    _leaves = _inners = 0;
+}
+
+// Leaves come first in _nodes.
+inline leaf* spare_nodes::take_leaf() noexcept {
+    assert(_leaves);
+    auto n = static_cast<leaf*>(_nodes[0]);
+    std::copy(_nodes + 1, _nodes + _leaves + _inners, _nodes);
+    --_leaves;
+    n->_parent = nullptr;
+    return n;
+}
+
+inline inner* spare_nodes::take_inner() noexcept {
+    assert(_inners);
+    auto n = static_cast<inner*>(_nodes[_leaves + --_inners]);
+    n->_parent = nullptr;
+    return n;
+}
+
+inline void spare_nodes::replace(node_base* old, node_base* n) noexcept {
+    *std::find(_nodes, _nodes + _leaves + _inners, old) = n;
+}
+
+// Detaches n from its parent and destroys it.
+inline void remove_child(node_base* n) noexcept;
+
+inline void unlink_leaf(leaf* l) noexcept {
+    if (l->_prev) {
+        l->_prev->_next = l->_next;
+    } else {
+        header_of(l)->_leftmost = l->_next;
+    }
+    if (l->_next) {
+        l->_next->_prev = l->_prev;
+    } else {
+        header_of(l)->_rightmost = l->_prev;
+    }
+}
+
+// Moves the entries of src to the end of dst, and removes src.
+inline void merge_leaves(leaf* dst, leaf* src) noexcept {
+    for (unsigned i = 0; i < src->_count; ++i) {
+        src->_slots[i]->_leaf = dst;
+    }
+    for_each_array(dst, src, [&] (auto d, auto s) {
+        std::copy_n(s, src->_count, d + dst->_count);
+    });
+    dst->_count += src->_count;
+    src->_count = 0;
+    unlink_leaf(src);
+    remove_child(src);
+}
+
+inline void merge_inners(inner* dst, inner* src) noexcept {
+    for (unsigned i = 0; i < src->_count; ++i) {
+        src->_children[i]->_parent = dst;
+    }
+    for_each_array(dst, src, [&] (auto d, auto s) {
+        std::copy_n(s, src->_count, d + dst->_count);
+    });
+    dst->_count += src->_count;
+    src->_count = 0;
+    remove_child(src);
+}
+
+// Merges n with a sibling, if they fit in a single node.
+template<typename Node, typename Merge>
+inline void maybe_merge(Node* n, Merge merge) noexcept {
+    if (n->_parent->_kind != node_kind::inner) {
+        return;
+    }
+    auto p = static_cast<inner*>(n->_parent);
+    auto i = index_in_parent(n);
+    if (i + 1 < p->_count) {
+        auto next = static_cast<Node*>(p->_children[i + 1]);
+        if (n->_count + next->_count <= node_capacity) {
+            merge(n, next);
+            return;
+        }
+    }
+    if (i > 0) {
+        auto prev = static_cast<Node*>(p->_children[i - 1]);
+        if (prev->_count + n->_count <= node_capacity) {
+            merge(prev, n);
+        }
+    }
+}
+
+inline void remove_child(node_base* n) noexcept {
+    auto p0 = n->_parent;
+    if (p0->_kind == node_kind::header) {
+        static_cast<header*>(p0)->_root = nullptr;
+        destroy_node(n);
+        return;
+    }
+    auto p = static_cast<inner*>(p0);
+    auto i = index_in_parent(n);
+    destroy_node(n);
+    for_each_array(p, [&] (auto a) {
+        std::copy(a + i + 1, a + p->_count, a + i);
+    });
+    if (!--p->_count) {
+        remove_child(p);
+        return;
+    }
+    if (i == 0) {
+        update_first(p);
+    }
+    if (p->_parent->_kind == node_kind::header) {
+        if (p->_count == 1) {
+            auto hdr = static_cast<header*>(p->_parent);
+            hdr->_root = p->_children[0];
+            hdr->_root->_parent = hdr;
+            p->_count = 0;
+            destroy_node(p);
+        }
+    } else if (p->_count <= merge_threshold) {
+        maybe_merge(p, merge_inners);
+    }
+}
+
+inline void erase(member_hook* h, leaf* l) noexcept {
+    auto i = index_in_leaf(l, h);
+    for_each_array(l, [&] (auto a) {
+        std::copy(a + i + 1, a + l->_count, a + i);
+    });
+    if (!--l->_count) {
+        unlink_leaf(l);
+        remove_child(l);
+        return;
+    }
+    if (i == 0) {
+        update_first(l);
+    }
+    if (l->_count <= merge_threshold) {
+        maybe_merge(l, merge_leaves);
+    }
+}
+
+inline void insert_into_leaf(leaf* l, unsigned i, member_hook* h, uint64_t key) noexcept {
+    for_each_array(l, [&] (auto a) {
+        std::copy_backward(a + i, a + l->_count, a + l->_count + 1);
+    });
+    l->_slots[i] = h;
+    if (auto keys = keys_of(l)) {
+        keys[i] = key;
+    }
+    ++l->_count;
+    h->_leaf = l;
+}
+
+inline void insert_into_inner(inner* p, unsigned i, node_base* n) noexcept {
+    for_each_array(p, [&] (auto a) {
+        std::copy_backward(a + i, a + p->_count, a + p->_count + 1);
+    });
+    p->_children[i] = n;
+    p->_firsts[i] = first_of(n);
+    if (auto keys = keys_of(p)) {
+        keys[i] = first_key_of(n);
+    }
+    ++p->_count;
+    n->_parent = p;
+}
+
+// Returns true if a sibling of the full leaf l can take one of its elements,
+// so that an insertion at index i doesn't have to split l.
+inline bool can_spill(const leaf* l, unsigned i) noexcept {
+    return (l->_next && l->_next->_count < node_capacity)
+        || (i > 0 && l->_prev && l->_prev->_count < node_capacity);
+}
+
+// Makes room in the full leaf l for an insertion at index i, see can_spill().
+// Updates l and i to the position to insert at.
+inline void spill(leaf*& l, unsigned& i) noexcept {
+    auto next = l->_next;
+    if (next && next->_count < node_capacity) {
+        if (i == node_capacity) {
+            l = next;
+            i = 0;
+            return;
+        }
+        // Move the last element of l to the front of next.
+        for_each_array(next, [&] (auto a) {
+            std::copy_backward(a, a + next->_count, a + next->_count + 1);
+        });
+        for_each_array(next, l, [&] (auto d, auto s) {
+            d[0] = s[node_capacity - 1];
+        });
+        ++next->_count;
+        --l->_count;
+        next->_slots[0]->_leaf = next;
+        update_first(next);
+        return;
+    }
+    // Move the first element of l to the back of the previous leaf.
+    auto prev = l->_prev;
+    for_each_array(prev, l, [&] (auto d, auto s) {
+        d[prev->_count] = s[0];
+    });
+    for_each_array(l, [&] (auto a) {
+        std::copy(a + 1, a + node_capacity, a);
+    });
+    ++prev->_count;
+    --l->_count;
+    prev->_slots[prev->_count - 1]->_leaf = prev;
+    update_first(l);
+    --i;
+}
+
+// Links n as the next sibling of left.
+inline void insert_child(node_base* left, node_base* n, spare_nodes& spare) noexcept {
+    if (left->_parent->_kind == node_kind::header) {
+        auto hdr = static_cast<header*>(left->_parent);
+        auto root = spare.take_inner();
+        insert_into_inner(root, 0, left);
+        insert_into_inner(root, 1, n);
+        root->_parent = hdr;
+        hdr->_root = root;
+        return;
+    }
+    auto p = static_cast<inner*>(left->_parent);
+    auto i = index_in_parent(left) + 1;
+    if (p->_count < node_capacity) {
+        insert_into_inner(p, i, n);
+        return;
+    }
+    auto np = spare.take_inner();
+    if (i == node_capacity) {
+        // Appending, keep p full.
+        insert_into_inner(np, 0, n);
+    } else {
+        constexpr unsigned mid = node_capacity / 2;
+        for (unsigned j = mid; j < node_capacity; ++j) {
+            p->_children[j]->_parent = np;
+        }
+        for_each_array(np, p, [&] (auto d, auto s) {
+            std::copy(s + mid, s + node_capacity, d);
+        });
+        np->_count = node_capacity - mid;
+        p->_count = mid;
+        if (i <= mid) {
+            insert_into_inner(p, i, n);
+        } else {
+            insert_into_inner(np, i - mid, n);
+        }
+    }
+    insert_child(p, np, spare);
+}
+
+}
+
+inline member_hook::member_hook(member_hook&& o) noexcept
+    : _leaf(std::exchange(o._leaf, nullptr))
+{
+    if (_leaf) {
+        auto i = internal::index_in_leaf(_leaf, &o);
+        _leaf->_slots[i] = this;
+        if (i == 0) {
+            internal::update_first(_leaf);
+        }
+    }
+}
+
+inline member_hook::~member_hook() {
+    if (_leaf) {
+        internal::erase(this, std::exchange(_leaf, nullptr));
+    }
+}
+
+// When KeyPrefix is void, nodes don't keep key prefixes.
+template<typename Elem, member_hook Elem::* Hook, typename KeyPrefix = void>
+class tree final {
+    using node_base = internal::node_base;
+    using leaf = internal::leaf;
+    using inner = internal::inner;
+    using header = internal::header;
+    static constexpr unsigned node_capacity = internal::node_capacity;
+    static constexpr bool keyed = !std::is_void<KeyPrefix>::value;
+    using leaf_type = std::conditional_t<keyed, internal::keyed_leaf, leaf>;
+    using inner_type = std::conditional_t<keyed, internal::keyed_inner, inner>;
+
+    header _header;
+
+    template<typename Key>
+    static uint64_t prefix_of(const Key& key) {
+        if constexpr (keyed) {
+            return KeyPrefix()(key);
+        } else {
+            return 0;
+        }
+    }
+
+    template<typename Key, typename Less>
+    static uint64_t prefix_of(const Key& key, const Less& less) {
+        if constexpr (keyed && std::is_invocable_r<uint64_t, KeyPrefix, const Key&, const Less&>::value) {
+            return KeyPrefix()(key, less);
+        } else {
+            return prefix_of(key);
+        }
+    }
+
+    static Elem* to_value(member_hook* h) noexcept {
+        return boost::intrusive::get_parent_from_member<Elem, member_hook>(h, Hook);
+    }
+    static const Elem* to_value(const member_hook* h) noexcept {
+        return boost::intrusive::get_parent_from_member<Elem, member_hook>(h, Hook);
+    }
+public:
+    typedef Elem value_type;
+
+    template<bool Const>
+    class iterator_base {
+        friend class tree;
+        friend class iterator_base<!Const>;
+        member_hook* _hook = nullptr;
+        // For end(), the header. Otherwise, the index of _hook in its leaf
+        // as of when the iterator was positioned, which saves a search in
+        // the leaf when it is still valid.
+        uintptr_t _aux = 0;
+        iterator_base(member_hook* h, uintptr_t aux) noexcept : _hook(h), _aux(aux) { }
+        iterator_base(member_hook* h, const header* hdr) noexcept
+            : _hook(h), _aux(h ? 0 : reinterpret_cast<uintptr_t>(hdr)) { }
+        const header* hdr() const noexcept { return reinterpret_cast<const header*>(_aux); }
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = Elem;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const Elem*, Elem*>;
+        using reference = std::conditional_t<Const, const Elem&, Elem&>;
+
+        iterator_base() noexcept = default;
+        template<bool C = Const, typename = std::enable_if_t<C>>
+        iterator_base(const iterator_base<false>& o) noexcept : _hook(o._hook), _aux(o._aux) { }
+
+        reference operator*() const noexcept { return *to_value(_hook); }
+        pointer operator->() const noexcept { return to_value(_hook); }
+
+        iterator_base& operator++() noexcept {
+            auto l = _hook->_leaf;
+            auto i = internal::index_in_leaf(l, _hook, _aux) + 1;
+            if (i < l->_count) {
+                _hook = l->_slots[i];
+                _aux = i;
+            } else if (l->_next) {
+                _hook = l->_next->_slots[0];
+                _aux = 0;
+            } else {
+                _hook = nullptr;
+                _aux = reinterpret_cast<uintptr_t>(internal::header_of(l));
+            }
+            return *this;
+        }
+        iterator_base operator++(int) noexcept {
+            auto it = *this;
+            ++*this;
+            return it;
+        }
+        iterator_base& operator--() noexcept {
+            if (!_hook) {
+                auto l = hdr()->_rightmost;
+                _aux = l->_count - 1;
+                _hook = l->_slots[_aux];
+                return *this;
+            }
+            auto l = _hook->_leaf;
+            auto i = internal::index_in_leaf(l, _hook, _aux);
+            if (!i) {
+                l = l->_prev;
+                i = l->_count;
+            }
+            _aux = i - 1;
+            _hook = l->_slots[_aux];
+            return *this;
+        }
+        iterator_base operator--(int) noexcept {
+            auto it = *this;
+            --*this;
+            return it;
+        }
+        iterator_base<false> unconst() const noexcept {
+            return iterator_base<false>(_hook, _aux);
+        }
+    };
+
+    using iterator = iterator_base<false>;
+    using const_iterator = iterator_base<true>;
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept {
+        return equal(a, b);
+    }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept {
+        return !(a == b);
+    }
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    // Nodes needed by insert_before() for a given position.
+    // Valid until the tree is modified.
+    using reservation = internal::spare_nodes;
+private:
+    static bool equal(const const_iterator& a, const const_iterator& b) noexcept {
+        return a._hook == b._hook && (a._hook || a._aux == b._aux);
+    }
+
+    std::pair<leaf*, unsigned> locate(const_iterator pos) const noexcept {
+        if (!pos._hook) {
+            auto l = _header._rightmost;
+            return {l, l->_count};
+        }
+        auto l = pos._hook->_leaf;
+        auto i = internal::index_in_leaf(l, pos._hook, pos._aux);
+        if (i == 0 && l->_prev && l->_prev->_count < node_capacity) {
+            // Rather than shifting l, append to the previous leaf.
+            return {l->_prev, l->_prev->_count};
+        }
+        return {l, i};
+    }
+
+    // Returns the number of leaves and inner nodes an insertion needs.
+    std::pair<unsigned, unsigned> nodes_needed(const_iterator pos) const noexcept {
+        if (!_header._root) {
+            return {1, 0};
+        }
+        auto [l, i] = locate(pos);
+        if (l->_count < node_capacity || internal::can_spill(l, i)) {
+            return {0, 0};
+        }
+        unsigned inners = 0;
+        const node_base* n = l;
+        while (n->_parent->_kind == internal::node_kind::inner) {
+            n = n->_parent;
+            if (n->_count < node_capacity) {
+                return {1, inners};
+            }
+            ++inners;
+        }
+        return {1, inners + 1};
+    }
+
+    // Returns the first element for which before(h, prefix) is false,
+    // assuming it is true for all elements before it and false for all after.
+    template<typename Before>
+    member_hook* partition_point_hook(Before before) const {
+        auto n = _header._root;
+        if (!n) {
+            return nullptr;
+        }
+        auto find = [&] (member_hook* const* hooks, const uint64_t* keys, unsigned b, unsigned e) {
+            while (b < e) {
+                auto m = b + (e - b) / 2;
+                if (before(hooks[m], keyed ? keys[m] : 0)) {
+                    b = m + 1;
+                } else {
+                    e = m;
+                }
+            }
+            return b;
+        };
+        while (n->_kind == internal::node_kind::inner) {
+            auto in = static_cast<const inner*>(n);
+            n = in->_children[find(in->_firsts, internal::keys_of(in), 1, in->_count) - 1];
+        }
+        auto l = static_cast<const leaf*>(n);
+        auto i = find(l->_slots, internal::keys_of(l), 0, l->_count);
+        if (i < l->_count) {
+            return l->_slots[i];
+        }
+        return l->_next ? l->_next->_slots[0] : nullptr;
+    }
+
+    template<typename Key, typename Less>
+    member_hook* lower_bound_hook(const Key& key, Less& less) const {
+        auto prefix = prefix_of(key, less);
+        return partition_point_hook([&] (const member_hook* h, uint64_t k) {
+            return k < prefix || (k == prefix && less(*to_value(h), key));
+        });
+    }
+
+    template<typename Key, typename Less>
+    member_hook* upper_bound_hook(const Key& key, Less& less) const {
+        auto prefix = prefix_of(key, less);
+        return partition_point_hook([&] (const member_hook* h, uint64_t k) {
+            return k < prefix || (k == prefix && !less(key, *to_value(h)));
+        });
+    }
+
+    iterator make_iterator(member_hook* h) noexcept { return iterator(h, &_header); }
+    const_iterator make_iterator(member_hook* h) const noexcept { return const_iterator(h, &_header); }
+
+    static void destroy_subtree(node_base* n) noexcept {
+        if (n->_kind == internal::node_kind::inner) {
+            auto in = static_cast<inner*>(n);
+            for (unsigned i = 0; i < in->_count; ++i) {
+                destroy_subtree(in->_children[i]);
+            }
+            in->_count = 0;
+        } else {
+            static_cast<leaf*>(n)->_count = 0;
+        }
+        internal::destroy_node(n);
+    }
+
+    template<typename Disposer>
+    void unlink_all(Disposer&& disposer) noexcept {
+        for (auto l = _header._leftmost; l; l = l->_next) {
+            for (unsigned i = 0; i < l->_count; ++i) {
+                l->_slots[i]->_leaf = nullptr;
+                disposer(l->_slots[i]);
+            }
+        }
+        if (_header._root) {
+            destroy_subtree(_header._root);
+        }
+        _header._root = nullptr;
+        _header._leftmost = _header._rightmost = nullptr;
+    }
+public:
+    tree() noexcept = default;
+    tree(tree&& o) noexcept = default;
+    tree(const tree&) = delete;
+    ~tree() { clear(); }
+
+    static iterator iterator_to(Elem& e) noexcept { return iterator(&(e.*Hook), nullptr); }
+    // Returns container of e, assuming is_only_member(e).
+    static tree& container_of_only_member(Elem& e) noexcept {
+        auto hdr = static_cast<header*>((e.*Hook)._leaf->_parent);
+        return *boost::intrusive::get_parent_from_member(hdr, &tree::_header);
+    }
+    // Returns the container of e. Logarithmic in the size of the tree.
+    static tree& container_of(Elem& e) noexcept {
+        internal::node_base* n = (e.*Hook)._leaf;
+        while (n->_kind != internal::node_kind::header) {
+            n = n->_parent;
+        }
+        return *boost::intrusive::get_parent_from_member(static_cast<header*>(n), &tree::_header);
+    }
+    // Returns true if and only if e is the only member of the tree.
+    static bool is_only_member(Elem& e) noexcept {
+        auto l = (e.*Hook)._leaf;
+        return l->_count == 1 && l->_parent->_kind == internal::node_kind::header;
+    }
+
+    iterator begin() noexcept { return make_iterator(_header._leftmost ? _header._leftmost->_slots[0] : nullptr); }
+    const_iterator begin() const noexcept { return make_iterator(_header._leftmost ? _header._leftmost->_slots[0] : nullptr); }
+    iterator end() noexcept { return make_iterator(nullptr); }
+    const_iterator end() const noexcept { return make_iterator(nullptr); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    bool empty() const noexcept { return !_header._root; }
+
+    // WARNING: this method has O(N) time complexity, use with care
+    size_t calculate_size() const noexcept {
+        size_t size = 0;
+        for (auto l = _header._leftmost; l; l = l->_next) {
+            size += l->_count;
+        }
+        return size;
+    }
+
+    // Memory used by the nodes of the tree, not including the elements.
+    size_t external_memory_usage() const noexcept {
+        size_t size = 0;
+        for (auto l = _header._leftmost; l; l = l->_next) {
+            size += sizeof(leaf_type);
+            // Count each inner node once, from the leftmost leaf below it.
+            for (const node_base* n = l; n->_parent->_kind == internal::node_kind::inner && internal::index_in_parent(n) == 0; ) {
+                n = n->_parent;
+                size += sizeof(inner_type);
+            }
+        }
+        return size;
+    }
+
+    // Unlinks all elements.
+    void clear() noexcept {
+        unlink_all([] (member_hook*) { });
+    }
+
+    template<class Disposer>
+    void clear_and_dispose(Disposer disposer) noexcept {
+        unlink_all([&disposer] (member_hook* h) { disposer(to_value(h)); });
+    }
+
+    iterator erase(const_iterator i) noexcept {
+        auto next = std::next(i);
+        auto h = i._hook;
+        internal::erase(h, std::exchange(h->_leaf, nullptr));
+        return next.unconst();
+    }
+    iterator erase(const_iterator b, const_iterator e) noexcept {
+        while (b != e) {
+            erase(b++);
+        }
+        return b.unconst();
+    }
+    template<class Disposer>
+    iterator erase_and_dispose(const_iterator i, Disposer disposer) noexcept {
+        auto h = i._hook;
+        iterator ret(erase(i));
+        disposer(to_value(h));
+        return ret;
+    }
+    template<class Disposer>
+    iterator erase_and_dispose(const_iterator b, const_iterator e, Disposer disposer) noexcept {
+        while (b != e) {
+            erase_and_dispose(b++, disposer);
+        }
+        return b.unconst();
+    }
+
+    template <class Cloner, class Disposer>
+    void clone_from(const tree& src, Cloner cloner, Disposer disposer) {
+        clear_and_dispose(disposer);
+        try {
+            for (const Elem& e : src) {
+                Elem* clone = cloner(e);
+                try {
+                    insert_before(end(), *clone);
+                } catch (...) {
+                    disposer(clone);
+                    throw;
+                }
+            }
+        } catch (...) {
+            clear_and_dispose(disposer);
+            throw;
+        }
+    }
+
+    Elem* unlink_leftmost_without_rebalance() noexcept {
+        if (!_header._leftmost) {
+            return nullptr;
+        }
+        auto h = _header._leftmost->_slots[0];
+        internal::erase(h, std::exchange(h->_leaf, nullptr));
+        return to_value(h);
+    }
+
+    // Allocates the nodes which inserting before pos needs.
+    // The tree must not be modified before the insertion.
+    reservation reserve_for_insert_before(const_iterator pos) {
+        auto [leaves, inners] = nodes_needed(pos);
+        return reservation(leaves, inners, keyed);
+    }
+
+    // Inserts value before pos, using the nodes reserved for pos.
+    iterator insert_before(const_iterator pos, Elem& value, reservation& spare) noexcept {
+        auto h = &(value.*Hook);
+        auto key = prefix_of(value);
+        if (!_header._root) {
+            auto l = spare.take_leaf();
+            l->_parent = &_header;
+            _header._root = _header._leftmost = _header._rightmost = l;
+            internal::insert_into_leaf(l, 0, h, key);
+            return make_iterator(h);
+        }
+        auto [l, i] = locate(pos);
+        if (l->_count == node_capacity && internal::can_spill(l, i)) {
+            // Rather than splitting l, move an element to a sibling.
+            internal::spill(l, i);
+        }
+        if (l->_count < node_capacity) {
+            internal::insert_into_leaf(l, i, h, key);
+            if (i == 0) {
+                internal::update_first(l);
+            }
+            return make_iterator(h);
+        }
+        auto nl = spare.take_leaf();
+        nl->_prev = l;
+        nl->_next = l->_next;
+        if (l->_next) {
+            l->_next->_prev = nl;
+        } else {
+            _header._rightmost = nl;
+        }
+        l->_next = nl;
+        if (i == node_capacity) {
+            // Appending, keep l full so that sequential insertion packs leaves.
+            internal::insert_into_leaf(nl, 0, h, key);
+        } else {
+            constexpr unsigned mid = node_capacity / 2;
+            for (unsigned j = mid; j < node_capacity; ++j) {
+                l->_slots[j]->_leaf = nl;
+            }
+            internal::for_each_array(nl, l, [&] (auto d, auto s) {
+                std::copy(s + mid, s + node_capacity, d);
+            });
+            nl->_count = node_capacity - mid;
+            l->_count = mid;
+            if (i <= mid) {
+                internal::insert_into_leaf(l, i, h, key);
+                if (i == 0) {
+                    internal::update_first(l);
+                }
+            } else {
+                internal::insert_into_leaf(nl, i - mid, h, key);
+            }
+        }
+        internal::insert_child(l, nl, spare);
+        return make_iterator(h);
+    }
+
+    // Has strong exception guarantees.
+    iterator insert_before(const_iterator pos, Elem& value) {
+        auto spare = reserve_for_insert_before(pos);
+        return insert_before(pos, value, spare);
+    }
+
+    template<class KeyType, class KeyTypeKeyCompare>
+    iterator upper_bound(const KeyType& key, KeyTypeKeyCompare comp) {
+        return make_iterator(upper_bound_hook(key, comp));
+    }
+    template<class KeyType, class KeyTypeKeyCompare>
+    const_iterator upper_bound(const KeyType& key, KeyTypeKeyCompare comp) const {
+        return make_iterator(upper_bound_hook(key, comp));
+    }
+    template<class KeyType, class KeyTypeKeyCompare>
+    iterator lower_bound(const KeyType& key, KeyTypeKeyCompare comp) {
+        return make_iterator(lower_bound_hook(key, comp));
+    }
+    template<class KeyType, class KeyTypeKeyCompare>
+    const_iterator lower_bound(const KeyType& key, KeyTypeKeyCompare comp) const {
+        return make_iterator(lower_bound_hook(key, comp));
+    }
+    template<class KeyType, class KeyTypeKeyCompare>
+    iterator find(const KeyType& key, KeyTypeKeyCompare comp) {
+        return std::as_const(*this).find(key, std::move(comp)).unconst();
+    }
+    template<class KeyType, class KeyTypeKeyCompare>
+    const_iterator find(const KeyType& key, KeyTypeKeyCompare comp) const {
+        auto h = lower_bound_hook(key, comp);
+        if (h && comp(key, *to_value(h))) {
+            h = nullptr;
+        }
+        return make_iterator(h);
+    }
+
+    template<class ElemCompare>
+    iterator insert(const_iterator hint, Elem& value, ElemCompare cmp) {
+        return insert_check(hint, value, std::move(cmp)).first;
+    }
+    // Inserts value unless an equal element is already present.
+    // Uses hint as the position if value belongs right before it.
+    template<class ElemCompare>
+    std::pair<iterator, bool> insert_check(const_iterator hint, Elem& value, ElemCompare cmp) {
+        if (hint == end() || cmp(value, *hint)) {
+            if (hint == begin() || cmp(*std::prev(hint), value)) {
+                return {insert_before(hint, value), true};
+            }
+        }
+        auto h = lower_bound_hook(value, cmp);
+        if (h && !cmp(value, *to_value(h))) {
+            return {make_iterator(h), false};
+        }
+        return {insert_before(make_iterator(h), value), true};
+    }
+};
+
+}
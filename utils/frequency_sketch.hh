@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019 ScyllaDB
+ */
+
+/*
+ * This file is part of Scylla.
+ *
+ * Scylla is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Scylla is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Scylla.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace utils {
+
+// Estimates how often keys were accessed recently, as TinyLFU does
+// (Einziger, Friedman, Manes: "TinyLFU: A Highly Efficient Cache Admission Policy").
+//
+// Keys are identified by a hash. The first access to a key since the last
+// reset only sets its bits in the doorkeeper, a bloom filter, so that keys
+// which are accessed once don't take up room in the count-min sketch of
+// 4-bit counters. After sample_size() accesses all counters are halved and
+// the doorkeeper is cleared, which makes estimates follow the workload.
+//
+// Estimates never undercount, and saturate at max_frequency.
+class frequency_sketch {
+    static constexpr unsigned depth = 4;
+    static constexpr unsigned counters_per_word = 16;
+    static constexpr uint64_t counter_mask = 0xf;
+    static constexpr uint64_t halving_mask = 0x7777777777777777;
+public:
+    // The largest counter value, plus the doorkeeper.
+    static constexpr unsigned max_frequency = counter_mask + 1;
+private:
+
+    // depth rows of _width counters each.
+    std::vector<uint64_t> _counters;
+    // 4 bits per access in the sample, so that it doesn't fill up.
+    std::vector<uint64_t> _doorkeeper;
+    size_t _width;
+    size_t _doorkeeper_mask;
+    size_t _sample_size;
+    size_t _accesses = 0;
+private:
+    static uint64_t spread(uint64_t h) noexcept {
+        // Keys may come with poorly distributed hashes, e.g. tokens of
+        // the byte-ordered partitioner, so mix them first.
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+    size_t index_of(uint64_t h, unsigned row) const noexcept {
+        auto h1 = h;
+        auto h2 = (h >> 32) | 1;
+        return row * _width + ((h1 + row * h2) & (_width - 1));
+    }
+    unsigned counter_at(size_t i) const noexcept {
+        return (_counters[i / counters_per_word] >> (i % counters_per_word * 4)) & counter_mask;
+    }
+    void increment_at(size_t i) noexcept {
+        _counters[i / counters_per_word] += uint64_t(1) << (i % counters_per_word * 4);
+    }
+    bool doorkeeper_contains(uint64_t h) const noexcept {
+        auto b1 = h & _doorkeeper_mask;
+        auto b2 = (h >> 32) & _doorkeeper_mask;
+        return (_doorkeeper[b1 / 64] >> (b1 % 64) & 1) && (_doorkeeper[b2 / 64] >> (b2 % 64) & 1);
+    }
+    void doorkeeper_insert(uint64_t h) noexcept {
+        auto b1 = h & _doorkeeper_mask;
+        auto b2 = (h >> 32) & _doorkeeper_mask;
+        _doorkeeper[b1 / 64] |= uint64_t(1) << (b1 % 64);
+        _doorkeeper[b2 / 64] |= uint64_t(1) << (b2 % 64);
+    }
+    void age() noexcept {
+        for (auto& w : _counters) {
+            w = (w >> 1) & halving_mask;
+        }
+        std::fill(_doorkeeper.begin(), _doorkeeper.end(), 0);
+        _accesses /= 2;
+    }
+public:
+    // Sized for tracking about capacity keys.
+    explicit frequency_sketch(size_t capacity)
+        : _width(std::max<size_t>(64, size_t(1) << (64 - __builtin_clzll(std::max<size_t>(capacity, 2) - 1))))
+        , _doorkeeper_mask(_width * 32 - 1)
+        , _sample_size(_width * 8)
+    {
+        _counters.resize(depth * _width / counters_per_word);
+        _doorkeeper.resize(_width * 32 / 64);
+    }
+
+    size_t width() const noexcept {
+        return _width;
+    }
+
+    size_t sample_size() const noexcept {
+        return _sample_size;
+    }
+
+    // Returns true iff the sketch aged as a result.
+    bool record(uint64_t hash) noexcept {
+        auto h = spread(hash);
+        if (!doorkeeper_contains(h)) {
+            doorkeeper_insert(h);
+        } else {
+            // Conservative update: increment only the smallest counters,
+            // the others already overcount.
+            unsigned min = counter_mask;
+            for (unsigned row = 0; row < depth; ++row) {
+                min = std::min(min, counter_at(index_of(h, row)));
+            }
+            if (min < counter_mask) {
+                for (unsigned row = 0; row < depth; ++row) {
+                    auto i = index_of(h, row);
+                    if (counter_at(i) == min) {
+                        increment_at(i);
+                    }
+                }
+            }
+        }
+        if (++_accesses >= _sample_size) {
+            age();
+            return true;
+        }
+        return false;
+    }
+
+    unsigned estimate(uint64_t hash) const noexcept {
+        auto h = spread(hash);
+        unsigned min = counter_mask;
+        for (unsigned row = 0; row < depth; ++row) {
+            min = std::min(min, counter_at(index_of(h, row)));
+        }
+        return min + doorkeeper_contains(h);
+    }
+
+    size_t memory_usage() const noexcept {
+        return (_counters.size() + _doorkeeper.size()) * sizeof(uint64_t);
+    }
+};
+
+}
@@ -43,6 +43,7 @@
 #include "bytes.hh"
 #include "bloom_calculations.hh"
 
+
 namespace utils {
 
 struct i_filter;
@@ -51,6 +52,9 @@ using filter_ptr = std::unique_ptr<i_filter>;
 enum class filter_format {
     k_l_format,
     m_format,
+    // All the probes of a key land on a single cache-line sized block.
+    // Scylla-specific, only written when the cluster supports it.
+    blocked_format,
 };
 
 class hashed_key {
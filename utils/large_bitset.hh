@@ -79,4 +79,14 @@ class large_bitset {
     const utils::chunked_vector<int_type>& get_storage() const {
         return _storage;
     }
+
+    // Direct access to the storage words, starting at word idx. A run of
+    // words is contiguous in memory as long as it is a naturally aligned
+    // power of two, no longer than 16k words.
+    int_type* words(size_t idx) {
+        return &_storage[idx];
+    }
+    const int_type* words(size_t idx) const {
+        return &_storage[idx];
+    }
 };